@@ -18,6 +18,8 @@
 */
 
 #include <kernel/kstd/unix_types.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
 #include "BlockDevice.h"
 
 BlockDevice::BlockDevice(unsigned major, unsigned minor): Device(major, minor) {
@@ -39,6 +41,41 @@ Result BlockDevice::write_blocks(uint32_t block, uint32_t count, const uint8_t *
 	return -EIO;
 }
 
+Result BlockDevice::write_blocks_deferred(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	//Devices without a cache can't hold on to writes, so they just write them immediately
+	return write_blocks(block, count, buffer);
+}
+
+Result BlockDevice::flush_blocks(uint32_t block, uint32_t count) {
+	return SUCCESS;
+}
+
+Result BlockDevice::zero_range(size_t offset, size_t length) {
+	//Devices without a cache of their own have to zero one block at a time through a buffer
+	size_t end = offset + length;
+	auto* block_buf = new uint8_t[block_size()];
+	Result res = SUCCESS;
+	while(offset < end) {
+		size_t block = offset / block_size();
+		size_t block_start = offset % block_size();
+		size_t nzero = min(block_size() - block_start, end - offset);
+		if(nzero == block_size()) {
+			memset(block_buf, 0, block_size());
+		} else {
+			res = read_block(block, block_buf);
+			if(res.is_error())
+				break;
+			memset(block_buf + block_start, 0, nzero);
+		}
+		res = write_block(block, block_buf);
+		if(res.is_error())
+			break;
+		offset += nzero;
+	}
+	delete[] block_buf;
+	return res;
+}
+
 size_t BlockDevice::block_size() {
 	return 0;
 }
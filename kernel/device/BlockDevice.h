@@ -31,6 +31,9 @@ public:
 
 	virtual Result read_blocks(uint32_t block, uint32_t count, uint8_t *buffer);
 	virtual Result write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer);
+	virtual Result write_blocks_deferred(uint32_t block, uint32_t count, const uint8_t *buffer);
+	virtual Result flush_blocks(uint32_t block, uint32_t count);
+	virtual Result zero_range(size_t offset, size_t length);
 	virtual size_t block_size();
 
 	bool is_block_device() override;
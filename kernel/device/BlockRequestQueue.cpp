@@ -0,0 +1,270 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "BlockRequestQueue.h"
+#include "DiskDevice.h"
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Thread.h>
+#include <kernel/kstd/cstring.h>
+
+kstd::vector<BlockRequestQueue*> BlockRequestQueue::_queues;
+SpinLock BlockRequestQueue::_queues_lock;
+
+BlockRequest::BlockRequest(Operation op, uint32_t block, uint32_t count, uint8_t* buffer):
+	op(op), block(block), count(count), buffer(buffer) {}
+
+BlockRequestQueue::BlockRequestQueue(DiskDevice& device): _device(device) {
+	memset(&_stats, 0, sizeof(Stats));
+	LOCK(_queues_lock);
+	_queues.push_back(this);
+}
+
+BlockRequestQueue::~BlockRequestQueue() {
+	LOCK(_queues_lock);
+	for(size_t i = 0; i < _queues.size(); i++) {
+		if(_queues[i] == this) {
+			_queues.erase(i);
+			break;
+		}
+	}
+}
+
+void BlockRequestQueue::submit(BlockRequest* request) {
+	LOCK(_lock);
+	request->_done = false;
+	request->_should_dispatch = false;
+	request->_has_waiter = false;
+	request->_blocker.set_ready(false);
+	request->_submit_time = Time::now();
+	long deadline_ms = request->op == BlockRequest::READ ? BLOCK_QUEUE_READ_DEADLINE_MS : BLOCK_QUEUE_WRITE_DEADLINE_MS;
+	request->_deadline = request->_submit_time + Time(deadline_ms / 1000, (deadline_ms % 1000) * 1000);
+
+	//Insert the request in block order (after any requests starting at the same block, to keep their order)
+	BlockRequest* prev = nullptr;
+	BlockRequest* cur = _head;
+	while(cur && cur->block <= request->block) {
+		prev = cur;
+		cur = cur->_next;
+	}
+	request->_next = cur;
+	if(prev)
+		prev->_next = request;
+	else
+		_head = request;
+
+	_stats.requests++;
+	_stats.depth++;
+	if(_stats.depth > _stats.max_depth)
+		_stats.max_depth = _stats.depth;
+}
+
+Result BlockRequestQueue::wait(BlockRequest* request) {
+	while(true) {
+		bool should_dispatch = false;
+		{
+			LOCK(_lock);
+			if(request->_done)
+				return request->_result;
+			request->_has_waiter = true;
+			request->_blocker.set_ready(false);
+			if(request->_should_dispatch || !_dispatching) {
+				request->_should_dispatch = false;
+				_dispatching = true;
+				should_dispatch = true;
+			}
+		}
+
+		if(should_dispatch)
+			run_dispatcher(request);
+		else
+			TaskManager::current_thread()->block(request->_blocker);
+	}
+}
+
+void BlockRequestQueue::kick() {
+	{
+		LOCK(_lock);
+		if(_dispatching || !_head)
+			return;
+		_dispatching = true;
+	}
+	run_dispatcher(nullptr);
+}
+
+Result BlockRequestQueue::read(uint32_t block, uint32_t count, uint8_t* buffer) {
+	BlockRequest request(BlockRequest::READ, block, count, buffer);
+	submit(&request);
+	return wait(&request);
+}
+
+Result BlockRequestQueue::write(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	BlockRequest request(BlockRequest::WRITE, block, count, (uint8_t*) buffer);
+	submit(&request);
+	return wait(&request);
+}
+
+BlockRequestQueue::Stats BlockRequestQueue::stats() {
+	LOCK(_lock);
+	return _stats;
+}
+
+kstd::vector<BlockRequestQueue*> BlockRequestQueue::queues() {
+	LOCK(_queues_lock);
+	return _queues;
+}
+
+void BlockRequestQueue::run_dispatcher(BlockRequest* own_request) {
+	while(true) {
+		BlockRequest* first;
+		size_t num_requests = 1;
+		uint32_t num_blocks;
+		{
+			LOCK(_lock);
+			if(own_request && own_request->_done) {
+				//Our request is done, so hand off dispatching to a thread waiting on another request
+				for(auto* request = _head; request; request = request->_next) {
+					if(request->_has_waiter) {
+						request->_should_dispatch = true;
+						request->_blocker.set_ready(true);
+						return;
+					}
+				}
+
+				//Nobody else is waiting, so dispatch whatever async requests are left ourselves
+				own_request = nullptr;
+			}
+
+			if(!_head) {
+				_dispatching = false;
+				return;
+			}
+
+			//Merge requests that directly follow the one we picked
+			first = pick_next();
+			auto* last = first;
+			num_blocks = first->count;
+			while(last->_next && last->_next->op == first->op && last->_next->block == first->block + num_blocks
+				  && num_blocks + last->_next->count <= BLOCK_QUEUE_MAX_MERGE_BLOCKS) {
+				last = last->_next;
+				num_blocks += last->count;
+				num_requests++;
+			}
+
+			//Unlink the run of requests from the queue
+			if(_head == first) {
+				_head = last->_next;
+			} else {
+				auto* prev = _head;
+				while(prev->_next != first)
+					prev = prev->_next;
+				prev->_next = last->_next;
+			}
+			last->_next = nullptr;
+
+			_next_block = first->block + num_blocks;
+			_stats.dispatches++;
+			_stats.merges += num_requests - 1;
+		}
+
+		dispatch(first, num_requests, num_blocks);
+	}
+}
+
+BlockRequest* BlockRequestQueue::pick_next() {
+	//If any requests are past their deadline, dispatch the one with the earliest deadline
+	Time now = Time::now();
+	BlockRequest* expired = nullptr;
+	for(auto* request = _head; request; request = request->_next) {
+		if(request->_deadline <= now && (!expired || request->_deadline < expired->_deadline))
+			expired = request;
+	}
+	if(expired)
+		return expired;
+
+	//Otherwise, continue on in block order from where the last dispatch ended, wrapping around to the start (C-LOOK)
+	for(auto* request = _head; request; request = request->_next) {
+		if(request->block >= _next_block)
+			return request;
+	}
+	return _head;
+}
+
+void BlockRequestQueue::dispatch(BlockRequest* first, size_t num_requests, uint32_t num_blocks) {
+	Result res = SUCCESS;
+	if(num_requests == 1) {
+		if(first->op == BlockRequest::READ)
+			res = _device.read_uncached_blocks(first->block, first->count, first->buffer);
+		else
+			res = _device.write_uncached_blocks(first->block, first->count, first->buffer);
+	} else {
+		//Gather the merged requests into one buffer so the device only has to be accessed once
+		size_t block_size = _device.block_size();
+		auto* buffer = new uint8_t[num_blocks * block_size];
+		if(first->op == BlockRequest::WRITE) {
+			for(auto* request = first; request; request = request->_next)
+				memcpy(buffer + (request->block - first->block) * block_size, request->buffer, request->count * block_size);
+			res = _device.write_uncached_blocks(first->block, num_blocks, buffer);
+		} else {
+			res = _device.read_uncached_blocks(first->block, num_blocks, buffer);
+			if(res.is_success()) {
+				for(auto* request = first; request; request = request->_next)
+					memcpy(request->buffer, buffer + (request->block - first->block) * block_size, request->count * block_size);
+			}
+		}
+		delete[] buffer;
+	}
+
+	while(first) {
+		auto* next = first->_next;
+		complete(first, res);
+		first = next;
+	}
+}
+
+void BlockRequestQueue::complete(BlockRequest* request, Result result) {
+	//The request was already unlinked from the queue by the dispatcher, so only the stats and the waiter need the lock
+	BlockRequest::Callback callback;
+	void* callback_data;
+	{
+		LOCK(_lock);
+
+		//Record the latency in the histogram
+		Time latency = Time::now() - request->_submit_time;
+		long latency_ms = latency.sec() * 1000 + latency.usec() / 1000;
+		size_t bucket = 0;
+		while(latency_ms && bucket < BLOCK_QUEUE_LATENCY_BUCKETS - 1) {
+			latency_ms >>= 1;
+			bucket++;
+		}
+		_stats.latency_histogram[bucket]++;
+		_stats.depth--;
+
+		request->_result = result;
+		callback = request->callback;
+		callback_data = request->callback_data;
+		if(!callback)
+			request->_blocker.set_ready(true);
+		request->_done = true;
+	}
+
+	//Requests with callbacks aren't waited on, and may be freed by the callback. Call it without holding the lock so
+	//that it can submit new requests or take other locks.
+	if(callback)
+		callback(request, callback_data);
+}
@@ -0,0 +1,142 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_BLOCKREQUESTQUEUE_H
+#define DUCKOS_BLOCKREQUESTQUEUE_H
+
+#include <kernel/kstd/types.h>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/Result.hpp>
+#include <kernel/time/Time.h>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
+
+//How long a request may wait before it's dispatched ahead of the elevator order
+#define BLOCK_QUEUE_READ_DEADLINE_MS 500
+#define BLOCK_QUEUE_WRITE_DEADLINE_MS 5000
+
+//The maximum number of blocks adjacent requests will be merged into
+#define BLOCK_QUEUE_MAX_MERGE_BLOCKS 256
+
+//Latency histogram buckets are powers of two in milliseconds (<1ms, <2ms, <4ms ... and everything above)
+#define BLOCK_QUEUE_LATENCY_BUCKETS 12
+
+class DiskDevice;
+class BlockRequestQueue;
+
+class BlockRequest {
+public:
+	enum Operation { READ, WRITE };
+	typedef void (*Callback)(BlockRequest* request, void* data);
+
+	BlockRequest(Operation op, uint32_t block, uint32_t count, uint8_t* buffer);
+
+	bool is_done() const { return _done; }
+	Result result() const { return _result; }
+
+	Operation op;
+	uint32_t block;
+	uint32_t count;
+	uint8_t* buffer;
+
+	//If set, this will be called (from whichever thread dispatched the request, without the queue locked) when the
+	//request completes.
+	Callback callback = nullptr;
+	void* callback_data = nullptr;
+
+private:
+	friend class BlockRequestQueue;
+
+	Result _result = SUCCESS;
+	volatile bool _done = false;
+	volatile bool _should_dispatch = false;
+	bool _has_waiter = false;
+	Time _submit_time;
+	Time _deadline;
+	BooleanBlocker _blocker;
+	BlockRequest* _next = nullptr;
+};
+
+/**
+ * A per-device queue of block requests. Requests are kept sorted by block and dispatched in C-LOOK elevator order,
+ * unless a request has passed its deadline. Adjacent requests with the same operation are merged into one call to the
+ * device.
+ *
+ * There is no dedicated dispatcher thread. Instead, a thread waiting on a request dispatches requests until its own
+ * completes, and then hands the dispatcher role to another waiting thread (or keeps going if nobody else is waiting).
+ */
+class BlockRequestQueue {
+public:
+	struct Stats {
+		size_t depth;
+		size_t max_depth;
+		size_t requests;
+		size_t dispatches;
+		size_t merges;
+		size_t latency_histogram[BLOCK_QUEUE_LATENCY_BUCKETS];
+	};
+
+	explicit BlockRequestQueue(DiskDevice& device);
+	~BlockRequestQueue();
+
+	/**
+	 * Adds a request to the queue. The request must stay valid until it completes. This doesn't dispatch anything;
+	 * either wait() on the request or call kick() afterwards.
+	 */
+	void submit(BlockRequest* request);
+
+	/**
+	 * Waits for a request to complete, dispatching requests if no other thread is.
+	 * @return The result of the request.
+	 */
+	Result wait(BlockRequest* request);
+
+	/**
+	 * Dispatches every queued request if no other thread is dispatching. Used for requests with only a callback.
+	 */
+	void kick();
+
+	//Convenience functions that submit a request and wait for it.
+	Result read(uint32_t block, uint32_t count, uint8_t* buffer);
+	Result write(uint32_t block, uint32_t count, const uint8_t* buffer);
+
+	DiskDevice& device() const { return _device; }
+	Stats stats();
+
+	static kstd::vector<BlockRequestQueue*> queues();
+
+private:
+	void run_dispatcher(BlockRequest* own_request);
+	BlockRequest* pick_next();
+	void dispatch(BlockRequest* first, size_t num_requests, uint32_t num_blocks);
+	void complete(BlockRequest* request, Result result);
+
+	DiskDevice& _device;
+	SpinLock _lock;
+	BlockRequest* _head = nullptr;
+	uint32_t _next_block = 0;
+	bool _dispatching = false;
+	Stats _stats;
+
+	static kstd::vector<BlockRequestQueue*> _queues;
+	static SpinLock _queues_lock;
+};
+
+
+#endif //DUCKOS_BLOCKREQUESTQUEUE_H
@@ -99,6 +99,10 @@ void Device::remove_device(unsigned major, unsigned minor) {
 	}
 }
 
+bool Device::is_device() {
+	return true;
+}
+
 bool Device::is_block_device() {
 	return false;
 }
@@ -37,6 +37,7 @@ public:
 	unsigned minor();
 	kstd::shared_ptr<Device> shared_ptr();
 
+	bool is_device() override;
 	virtual bool is_block_device();
 	virtual bool is_character_device();
 
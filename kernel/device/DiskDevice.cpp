@@ -21,10 +21,17 @@
 #include <kernel/kstd/cstring.h>
 #include <kernel/memory/MemoryManager.h>
 #include "DiskDevice.h"
+#include <kernel/filesystem/FileDescriptor.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Thread.h>
 
 size_t DiskDevice::_used_cache_memory = 0;
 
 Result DiskDevice::read_blocks(uint32_t start_block, uint32_t count, uint8_t* buffer) {
+	Result res = load_cache_regions(start_block, count);
+	if(res.is_error())
+		return res;
+
 	LOCK(_cache_lock);
 	BlockCacheRegion* cache_region = nullptr;
 	for(size_t i = 0; i < count; i++) {
@@ -38,6 +45,21 @@ Result DiskDevice::read_blocks(uint32_t start_block, uint32_t count, uint8_t* bu
 }
 
 Result DiskDevice::write_blocks(uint32_t start_block, uint32_t count, const uint8_t* buffer) {
+	//Copy into the cache, and then write the blocks back from it
+	Result res = write_blocks_deferred(start_block, count, buffer);
+	if(res.is_error())
+		return res;
+
+	return write_back_blocks(start_block, count);
+}
+
+Result DiskDevice::write_blocks_deferred(uint32_t start_block, uint32_t count, const uint8_t* buffer) {
+	//Partially written regions have to be read in first
+	Result res = load_cache_regions(start_block, count);
+	if(res.is_error())
+		return res;
+
+	//Only update the cache; the blocks are written to the disk by flush_blocks() (or the next write to them)
 	LOCK(_cache_lock);
 	BlockCacheRegion* cache_region = nullptr;
 	for(size_t i = 0; i < count; i++) {
@@ -49,35 +71,243 @@ Result DiskDevice::write_blocks(uint32_t start_block, uint32_t count, const uint
 		memcpy(cache_region->block_data(block), buffer + i * block_size(), block_size());
 	}
 
-	//TODO: Flush cached writes to disk periodically instead of on every write
-	return write_uncached_blocks(start_block, count, buffer);
+	return SUCCESS;
+}
+
+Result DiskDevice::flush_blocks(uint32_t start_block, uint32_t count) {
+	Result res = load_cache_regions(start_block, count);
+	if(res.is_error())
+		return res;
+	return write_back_blocks(start_block, count);
+}
+
+Result DiskDevice::zero_range(size_t offset, size_t length) {
+	if(!length)
+		return SUCCESS;
+
+	size_t start_block = offset / block_size();
+	size_t end_block = (offset + length + block_size() - 1) / block_size();
+	if(end_block - 1 > max_addressable_block())
+		return -ENOSPC;
+
+	//Regions that are zeroed entirely don't need to be read in first, since new regions start out zeroed
+	size_t full_start = (offset + block_size() - 1) / block_size();
+	size_t full_end = (offset + length) / block_size();
+	Result res = load_cache_regions(start_block, end_block - start_block, full_start, full_end);
+	if(res.is_error())
+		return res;
+
+	{
+		LOCK(_cache_lock);
+		BlockCacheRegion* cache_region = nullptr;
+		for(size_t block = start_block; block < end_block; block++) {
+			if(!cache_region || !cache_region->has_block(block))
+				cache_region = get_cache_region(block);
+			cache_region->last_used = Time::now();
+			cache_region->dirty = true;
+			size_t block_start = block * block_size();
+			size_t zero_start = max(offset, block_start);
+			size_t zero_end = min(offset + length, block_start + block_size());
+			memset(cache_region->block_data(block) + (zero_start - block_start), 0, zero_end - zero_start);
+		}
+	}
+
+	return write_back_blocks(start_block, end_block - start_block);
+}
+
+ssize_t DiskDevice::read(FileDescriptor &fd, size_t offset, uint8_t *buffer, size_t count) {
+	size_t first_block = offset / block_size();
+	size_t first_block_start = offset % block_size();
+	size_t bytes_left = count;
+	size_t block = first_block;
+	ssize_t nread = 0;
+
+	auto block_buf = new uint8_t[block_size()];
+	while(bytes_left) {
+		if(block > max_addressable_block())
+			break;
+
+		Result res = read_block(block, block_buf);
+		if(res.is_error()) {
+			delete[] block_buf;
+			return res.code();
+		}
+
+		if(block == first_block) {
+			if(count < block_size() - first_block_start) {
+				memcpy(buffer, block_buf + first_block_start, count);
+				nread += count;
+				bytes_left = 0;
+			} else {
+				memcpy(buffer, block_buf + first_block_start, block_size() - first_block_start);
+				nread += block_size() - first_block_start;
+				bytes_left -= block_size() - first_block_start;
+			}
+		} else {
+			if(bytes_left < block_size()) {
+				memcpy(buffer + (count - bytes_left), block_buf, bytes_left);
+				nread += bytes_left;
+				bytes_left = 0;
+			} else {
+				memcpy(buffer + (count - bytes_left), block_buf, block_size());
+				nread += block_size();
+				bytes_left -= block_size();
+			}
+		}
+		block++;
+	}
+
+	delete[] block_buf;
+	return nread;
 }
 
-DiskDevice::~DiskDevice() {
-	for(auto i = 0; i < _cache_regions.leaves().size(); i++)
-		if(_cache_regions.leaves()[i])
-			delete _cache_regions.leaves()[i];
+ssize_t DiskDevice::write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) {
+	size_t first_block = offset / block_size();
+	size_t last_block = (offset + count) / block_size();
+	size_t first_block_start = offset % block_size();
+	size_t bytes_left = count;
+	size_t block = first_block;
+
+	if(last_block > max_addressable_block())
+		return -ENOSPC;
+
+	auto block_buf = new uint8_t[block_size()];
+	while(bytes_left) {
+		//Read the block into a buffer
+		Result res = read_block(block, block_buf);
+		if(res.is_error()) {
+			delete[] block_buf;
+			return res.code();
+		}
+
+		//Copy the appropriate portion of the buffer into the appropriate portion of the block buffer
+		if(block == first_block) {
+			if(count < block_size() - first_block_start) {
+				memcpy(block_buf + first_block_start, buffer, count);
+				bytes_left = 0;
+			} else {
+				memcpy(block_buf + first_block_start, buffer, block_size() - first_block_start);
+				bytes_left -= block_size() - first_block_start;
+			}
+		} else {
+			if(bytes_left < block_size()) {
+				memcpy(block_buf, buffer + (count - bytes_left), bytes_left);
+				bytes_left = 0;
+			} else {
+				memcpy(block_buf, buffer + (count - bytes_left), block_size());
+				bytes_left -= block_size();
+			}
+		}
+
+		res = write_block(block, block_buf);
+		if(res.is_error()) {
+			delete[] block_buf;
+			return res.code();
+		}
+		block++;
+	}
+
+	delete[] block_buf;
+	return count;
 }
 
+DiskDevice::~DiskDevice() = default;
+
 size_t DiskDevice::used_cache_memory() {
 	return _used_cache_memory;
 }
 
-DiskDevice::BlockCacheRegion* DiskDevice::get_cache_region(size_t block) {
-	//See if we already have the block
-	auto& reg = _cache_regions[block_cache_region_start(block)];
-	if(reg)
-		return reg;
+Result DiskDevice::load_cache_regions(uint32_t start_block, uint32_t count, uint32_t no_read_start, uint32_t no_read_end) {
+	kstd::vector<kstd::shared_ptr<BlockCacheRegion>> regions;
+	kstd::vector<kstd::shared_ptr<BlockCacheRegion>> new_regions;
+	kstd::vector<BlockRequest*> requests;
+
+	//Find the regions with the blocks we need, creating the ones that don't exist yet
+	{
+		LOCK(_cache_lock);
+		for(size_t block = block_cache_region_start(start_block); block < start_block + count; block += blocks_per_cache_region()) {
+			auto& reg = _cache_regions[block];
+			if(!reg) {
+				reg = kstd::make_shared<BlockCacheRegion>(block, block_size());
+				_used_cache_memory += PAGE_SIZE;
+				if(block >= no_read_start && block + blocks_per_cache_region() <= no_read_end) {
+					//The caller is going to overwrite the whole region, so there's no need to read it
+					reg->loaded.set_ready(true);
+					regions.push_back(reg);
+					continue;
+				}
+				new_regions.push_back(reg);
+				requests.push_back(new BlockRequest(BlockRequest::READ, block, blocks_per_cache_region(), (uint8_t*) reg->region.virt->start));
+			}
+			regions.push_back(reg);
+		}
+	}
 
-	//Create a new cache region
-	reg = new BlockCacheRegion(block_cache_region_start(block), block_size());
-	_used_cache_memory += PAGE_SIZE;
+	//Queue reads for all of the new regions at once so that they can be merged, and then wait for them
+	for(size_t i = 0; i < requests.size(); i++)
+		_queue.submit(requests[i]);
+	for(size_t i = 0; i < requests.size(); i++) {
+		auto& reg = new_regions[i];
+		reg->load_result = _queue.wait(requests[i]);
+		delete requests[i];
+		if(reg->load_result.is_error()) {
+			//Take the region out of the cache so that it's retried next time. Whoever's waiting on it still has a reference.
+			LOCK(_cache_lock);
+			_cache_regions.erase(reg->start_block);
+		}
+		reg->loaded.set_ready(true);
+	}
 
-	//Read the blocks into it
-	read_uncached_blocks(reg->start_block, blocks_per_cache_region(), (uint8_t*) reg->region.virt->start);
+	//Wait for any regions that were already being read by someone else
+	Result res = SUCCESS;
+	for(size_t i = 0; i < regions.size(); i++) {
+		auto& reg = regions[i];
+		if(!reg->loaded.is_ready())
+			TaskManager::current_thread()->block(reg->loaded);
+		if(reg->load_result.is_error()) {
+			res = reg->load_result;
+			break;
+		}
+	}
 
-	//Return the requested region
-	return reg;
+	//Reference counts aren't atomic, so drop our references with the lock held
+	LOCK(_cache_lock);
+	regions.resize(0);
+	new_regions.resize(0);
+	return res;
+}
+
+Result DiskDevice::write_back_blocks(uint32_t start_block, uint32_t count) {
+	//Queue writes straight from the cache (one request per region; the queue merges them).
+	//Since the data is written from the cache when the request is dispatched, the disk can't end up older than the cache.
+	//TODO: Flush cached writes to disk periodically instead of on every write
+	kstd::vector<BlockRequest*> requests;
+	{
+		LOCK(_cache_lock);
+		for(size_t block = start_block; block < start_block + count;) {
+			auto* cache_region = get_cache_region(block);
+			size_t num_blocks = min(cache_region->start_block + cache_region->num_blocks(), (size_t) start_block + count) - block;
+			requests.push_back(new BlockRequest(BlockRequest::WRITE, block, num_blocks, cache_region->block_data(block)));
+			block += num_blocks;
+		}
+	}
+
+	Result res = SUCCESS;
+	for(size_t i = 0; i < requests.size(); i++)
+		_queue.submit(requests[i]);
+	for(size_t i = 0; i < requests.size(); i++) {
+		Result req_res = _queue.wait(requests[i]);
+		if(req_res.is_error())
+			res = req_res;
+		delete requests[i];
+	}
+
+	return res;
+}
+
+DiskDevice::BlockCacheRegion* DiskDevice::get_cache_region(size_t block) {
+	//The region must have been loaded with load_cache_regions() first
+	return _cache_regions[block_cache_region_start(block)].get();
 }
 
 DiskDevice::BlockCacheRegion::BlockCacheRegion(size_t start_block, size_t block_size):
@@ -85,4 +315,5 @@ DiskDevice::BlockCacheRegion::BlockCacheRegion(size_t start_block, size_t block_
 
 DiskDevice::BlockCacheRegion::~BlockCacheRegion() {
 	PageDirectory::k_free_region(region);
+	_used_cache_memory -= PAGE_SIZE;
 }
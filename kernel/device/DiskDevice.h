@@ -24,18 +24,30 @@
 #include <kernel/memory/LinkedMemoryRegion.h>
 #include <kernel/memory/MemoryManager.h>
 #include "BlockDevice.h"
+#include "BlockRequestQueue.h"
 #include <kernel/kstd/map.hpp>
+#include <kernel/kstd/shared_ptr.hpp>
 
 class DiskDevice: public BlockDevice {
 public:
-	DiskDevice(unsigned major, unsigned minor): BlockDevice(major, minor) {}
+	DiskDevice(unsigned major, unsigned minor): BlockDevice(major, minor), _queue(*this) {}
 	~DiskDevice();
 
 	Result read_blocks(uint32_t block, uint32_t count, uint8_t *buffer) override final;
 	Result write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override final;
+	Result write_blocks_deferred(uint32_t block, uint32_t count, const uint8_t *buffer) override final;
+	Result flush_blocks(uint32_t block, uint32_t count) override final;
+	Result zero_range(size_t offset, size_t length) override final;
 
 	virtual Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) = 0;
 	virtual Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) = 0;
+	virtual size_t max_addressable_block() = 0;
+
+	//File
+	ssize_t read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) override;
+
+	BlockRequestQueue& request_queue() { return _queue; }
 
 	static size_t used_cache_memory();
 
@@ -54,15 +66,21 @@ private:
 		size_t start_block;
 		Time last_used = Time::now();
 		bool dirty = false;
+		BooleanBlocker loaded;
+		Result load_result = SUCCESS;
 	};
 
+	Result load_cache_regions(uint32_t start_block, uint32_t count, uint32_t no_read_start = 0, uint32_t no_read_end = 0);
+	Result write_back_blocks(uint32_t start_block, uint32_t count);
 	BlockCacheRegion* get_cache_region(size_t block);
 	inline size_t blocks_per_cache_region() { return PAGE_SIZE / block_size(); }
 	inline size_t block_cache_region_start(size_t block) { return block - (block % blocks_per_cache_region()); }
 
 	//TODO: Free cache regions when low on memory
-	kstd::map<size_t, BlockCacheRegion*> _cache_regions;
+	//Regions are reference counted so one that failed to load can be dropped from the cache while others wait on it
+	kstd::map<size_t, kstd::shared_ptr<BlockCacheRegion>> _cache_regions;
 	SpinLock _cache_lock;
+	BlockRequestQueue _queue;
 
 	static size_t _used_cache_memory;
 };
@@ -133,4 +133,5 @@ void KeyboardDevice::set_key_state(uint8_t scancode, bool pressed) {
 	LOCK(_lock);
 	if(!_event_buffer.push_back(event))
 		printf("[I8042/Keyboard] Event buffer full!\n");
+	watchers().notify();
 }
\ No newline at end of file
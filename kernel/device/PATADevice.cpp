@@ -342,102 +342,8 @@ size_t PATADevice::block_size() {
 	return 512;
 }
 
-#include <kernel/filesystem/FileDescriptor.h>
-
-ssize_t PATADevice::read(FileDescriptor &fd, size_t offset, uint8_t *buffer, size_t count) {
-	size_t first_block = offset / block_size();
-	size_t first_block_start = offset % block_size();
-	size_t bytes_left = count;
-	size_t block = first_block;
-	ssize_t nread = 0;
-
-	auto block_buf = new uint8_t[block_size()];
-	while(bytes_left) {
-		if(block > _max_addressable_block)
-			break;
-
-		Result res = read_block(block, block_buf);
-		if(res.is_error()) {
-			delete[] block_buf;
-			return res.code();
-		}
-
-		if(block == first_block) {
-			if(count < block_size() - first_block_start) {
-				memcpy(buffer, block_buf + first_block_start, count);
-				nread += count;
-				bytes_left = 0;
-			} else {
-				memcpy(buffer, block_buf + first_block_start, block_size() - first_block_start);
-				nread += block_size() - first_block_start;
-				bytes_left -= block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < block_size()) {
-				memcpy(buffer + (count - bytes_left), block_buf, bytes_left);
-				nread += bytes_left;
-				bytes_left = 0;
-			} else {
-				memcpy(buffer + (count - bytes_left), block_buf, block_size());
-				nread += block_size();
-				bytes_left -= block_size();
-			}
-		}
-		block++;
-	}
-
-	delete[] block_buf;
-	return nread;
-}
-
-ssize_t PATADevice::write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) {
-	size_t first_block = offset / block_size();
-	size_t last_block = (offset + count) / block_size();
-	size_t first_block_start = offset % block_size();
-	size_t bytes_left = count;
-	size_t block = first_block;
-
-	if(last_block > _max_addressable_block)
-		return -ENOSPC;
-
-	auto block_buf = new uint8_t[block_size()];
-	while(bytes_left) {
-		//Read the block into a buffer
-		Result res = read_block(block, block_buf);
-		if(res.is_error()) {
-			delete[] block_buf;
-			return res.code();
-		}
-
-		//Copy the appropriate portion of the buffer into the appropriate portion of the block buffer
-		if(block == first_block) {
-			if(count < block_size() - first_block_start) {
-				memcpy(block_buf + first_block_start, buffer, count);
-				bytes_left = 0;
-			} else {
-				memcpy(block_buf + first_block_start, buffer, block_size() - first_block_start);
-				bytes_left -= block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < block_size()) {
-				memcpy(block_buf, buffer + (count - bytes_left), bytes_left);
-				bytes_left = 0;
-			} else {
-				memcpy(block_buf, buffer + (count - bytes_left), block_size());
-				bytes_left -= block_size();
-			}
-		}
-
-		res = write_block(block, block_buf);
-		if(res.is_error()) {
-			delete[] block_buf;
-			return res.code();
-		}
-		block++;
-	}
-
-	delete[] block_buf;
-	return count;
+size_t PATADevice::max_addressable_block() {
+	return _max_addressable_block;
 }
 
 void PATADevice::handle_irq(Registers *regs) {
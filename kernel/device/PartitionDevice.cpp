@@ -26,11 +26,23 @@ BlockDevice(major, minor), _parent(parent), _offset(offset_blocks * parent->bloc
 }
 
 Result PartitionDevice::read_blocks(uint32_t block, uint32_t count, uint8_t *buffer) {
-	return _parent->read_blocks(block + _offset, count, buffer);
+	return _parent->read_blocks(block + _offset / block_size(), count, buffer);
 }
 
 Result PartitionDevice::write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) {
-	return _parent->write_blocks(block + _offset, count, buffer);
+	return _parent->write_blocks(block + _offset / block_size(), count, buffer);
+}
+
+Result PartitionDevice::write_blocks_deferred(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	return _parent->write_blocks_deferred(block + _offset / block_size(), count, buffer);
+}
+
+Result PartitionDevice::flush_blocks(uint32_t block, uint32_t count) {
+	return _parent->flush_blocks(block + _offset / block_size(), count);
+}
+
+Result PartitionDevice::zero_range(size_t offset, size_t length) {
+	return _parent->zero_range(offset + _offset, length);
 }
 
 ssize_t PartitionDevice::read(FileDescriptor &fd, size_t start, uint8_t *buffer, size_t count) {
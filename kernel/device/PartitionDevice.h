@@ -27,6 +27,9 @@ public:
 	PartitionDevice(unsigned major, unsigned minor, const kstd::shared_ptr<BlockDevice>& parent, size_t offset_blocks);
 	Result read_blocks(uint32_t block, uint32_t count, uint8_t *buffer) override;
 	Result write_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override;
+	Result write_blocks_deferred(uint32_t block, uint32_t count, const uint8_t *buffer) override;
+	Result flush_blocks(uint32_t block, uint32_t count) override;
+	Result zero_range(size_t offset, size_t length) override;
 	ssize_t read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) override;
 	ssize_t write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) override;
 	size_t block_size() override;
@@ -0,0 +1,132 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_VIRTIO_H
+#define DUCKOS_VIRTIO_H
+
+#include <kernel/kstd/types.h>
+
+//PCI IDs
+#define VIRTIO_PCI_VENDOR 0x1AF4
+#define VIRTIO_PCI_LEGACY_DEVICE_MIN 0x1000
+#define VIRTIO_PCI_LEGACY_DEVICE_MAX 0x103F
+#define VIRTIO_PCI_MODERN_DEVICE_BASE 0x1040
+#define VIRTIO_PCI_MODERN_DEVICE_MAX 0x107F
+
+//Device types
+#define VIRTIO_DEVICE_NETWORK 1
+#define VIRTIO_DEVICE_BLOCK 2
+
+//Device status
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x1u
+#define VIRTIO_STATUS_DRIVER 0x2u
+#define VIRTIO_STATUS_DRIVER_OK 0x4u
+#define VIRTIO_STATUS_FEATURES_OK 0x8u
+#define VIRTIO_STATUS_NEEDS_RESET 0x40u
+#define VIRTIO_STATUS_FAILED 0x80u
+
+//Feature bits (Feature bits 32 and up are only accessible through the modern transport)
+#define VIRTIO_F_RING_EVENT_IDX 29
+#define VIRTIO_F_VERSION_1 32
+
+//Legacy PCI registers (In the IO space pointed to by BAR0)
+#define VIRTIO_LEGACY_DEVICE_FEATURES 0x00 //32
+#define VIRTIO_LEGACY_GUEST_FEATURES 0x04 //32
+#define VIRTIO_LEGACY_QUEUE_ADDRESS 0x08 //32
+#define VIRTIO_LEGACY_QUEUE_SIZE 0x0C //16
+#define VIRTIO_LEGACY_QUEUE_SELECT 0x0E //16
+#define VIRTIO_LEGACY_QUEUE_NOTIFY 0x10 //16
+#define VIRTIO_LEGACY_DEVICE_STATUS 0x12 //8
+#define VIRTIO_LEGACY_ISR_STATUS 0x13 //8
+#define VIRTIO_LEGACY_DEVICE_CONFIG 0x14
+
+//Modern PCI capability types
+#define VIRTIO_PCI_CAP_COMMON_CFG 1
+#define VIRTIO_PCI_CAP_NOTIFY_CFG 2
+#define VIRTIO_PCI_CAP_ISR_CFG 3
+#define VIRTIO_PCI_CAP_DEVICE_CFG 4
+#define VIRTIO_PCI_CAP_PCI_CFG 5
+
+//Modern PCI capability fields
+#define VIRTIO_PCI_CAP_CFG_TYPE 3 //8
+#define VIRTIO_PCI_CAP_BAR 4 //8
+#define VIRTIO_PCI_CAP_OFFSET 8 //32
+#define VIRTIO_PCI_CAP_LENGTH 12 //32
+#define VIRTIO_PCI_CAP_NOTIFY_MULTIPLIER 16 //32
+
+//ISR status bits
+#define VIRTIO_ISR_QUEUE 0x1u
+#define VIRTIO_ISR_CONFIG 0x2u
+
+//Virtqueue descriptor flags
+#define VIRTQ_DESC_F_NEXT 0x1u
+#define VIRTQ_DESC_F_WRITE 0x2u
+#define VIRTQ_DESC_F_INDIRECT 0x4u
+
+//Virtqueue ring flags
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 0x1u
+#define VIRTQ_USED_F_NO_NOTIFY 0x1u
+
+//The legacy transport requires the used ring to be page-aligned
+#define VIRTQ_LEGACY_ALIGN 4096
+
+typedef struct __attribute__((packed)) VirtioPCICommonConfig {
+	uint32_t device_feature_select;
+	uint32_t device_feature;
+	uint32_t driver_feature_select;
+	uint32_t driver_feature;
+	uint16_t msix_config;
+	uint16_t num_queues;
+	uint8_t device_status;
+	uint8_t config_generation;
+	uint16_t queue_select;
+	uint16_t queue_size;
+	uint16_t queue_msix_vector;
+	uint16_t queue_enable;
+	uint16_t queue_notify_off;
+	uint64_t queue_desc;
+	uint64_t queue_driver;
+	uint64_t queue_device;
+} VirtioPCICommonConfig;
+
+typedef struct __attribute__((packed)) VirtqDescriptor {
+	uint64_t addr;
+	uint32_t length;
+	uint16_t flags;
+	uint16_t next;
+} VirtqDescriptor;
+
+typedef struct __attribute__((packed)) VirtqAvailable {
+	uint16_t flags;
+	uint16_t index;
+	uint16_t ring[];
+} VirtqAvailable;
+
+typedef struct __attribute__((packed)) VirtqUsedElement {
+	uint32_t id;
+	uint32_t length;
+} VirtqUsedElement;
+
+typedef struct __attribute__((packed)) VirtqUsed {
+	uint16_t flags;
+	uint16_t index;
+	VirtqUsedElement ring[];
+} VirtqUsed;
+
+#endif //DUCKOS_VIRTIO_H
@@ -0,0 +1,172 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "VirtioBlockDevice.h"
+#include <kernel/memory/PageDirectory.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Thread.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+
+#define VIRTIO_BLK_REQUEST_SIZE (VIRTIO_BLK_SECTORS_PER_REQUEST * 512)
+
+VirtioBlockDevice* VirtioBlockDevice::find() {
+	PCI::Address addr = {0, 0, 0};
+	if(!VirtioDevice::find(VIRTIO_DEVICE_BLOCK, addr))
+		return nullptr;
+
+	auto* ret = new VirtioBlockDevice(addr);
+	if(!ret->init()) {
+		delete ret;
+		return nullptr;
+	}
+	return ret;
+}
+
+VirtioBlockDevice::VirtioBlockDevice(PCI::Address addr):
+	IRQHandler(), DiskDevice(3, 0), VirtioDevice(addr) {}
+
+VirtioBlockDevice::~VirtioBlockDevice() {
+	uninstall_irq();
+	delete _queue;
+	if(_slot_region.phys)
+		PageDirectory::k_free_region(_slot_region);
+	if(_dma_region.phys)
+		PageDirectory::k_free_region(_dma_region);
+}
+
+bool VirtioBlockDevice::init() {
+	if(!init_virtio(0))
+		return false;
+
+	//Block devices only have one queue (unless VIRTIO_BLK_F_MQ is negotiated)
+	_queue = setup_queue(0);
+	if(!_queue) {
+		printf("[Virtio] Block device has no request queue!\n");
+		set_device_status(VIRTIO_STATUS_FAILED);
+		return false;
+	}
+
+	_slot_region = PageDirectory::k_alloc_region(sizeof(RequestSlot) * VIRTIO_BLK_MAX_REQUESTS);
+	_slots = (RequestSlot*) _slot_region.virt->start;
+	_dma_region = PageDirectory::k_alloc_region(VIRTIO_BLK_REQUEST_SIZE * VIRTIO_BLK_MAX_REQUESTS);
+	_capacity = read_config64(VIRTIO_BLK_CONFIG_CAPACITY);
+
+	set_irq(irq());
+	reinstall_irq();
+	driver_ok();
+
+	printf("[Virtio] Setup block device using %s transport (%d blocks, queue size %d)\n", is_modern() ? "modern" : "legacy", (uint32_t) _capacity, _queue->size());
+	return true;
+}
+
+Result VirtioBlockDevice::do_requests(uint32_t type, uint32_t block, uint32_t count, uint8_t* buffer) {
+	LOCK(_lock);
+	bool write = type == VIRTIO_BLK_T_OUT;
+
+	while(count) {
+		//Submit as many requests as we can at once
+		size_t num_requests = 0;
+		uint32_t batch_start = block;
+		uint8_t* batch_buffer = buffer;
+		_requests_submitted = 0;
+		_requests_completed = 0;
+		while(count && num_requests < VIRTIO_BLK_MAX_REQUESTS) {
+			uint32_t num_sectors = min((uint32_t) VIRTIO_BLK_SECTORS_PER_REQUEST, count);
+			auto& slot = _slots[num_requests];
+			size_t slot_phys = _slot_region.phys->start + sizeof(RequestSlot) * num_requests;
+			size_t data_offset = VIRTIO_BLK_REQUEST_SIZE * num_requests;
+
+			slot.header = {type, 0, block};
+			slot.status = 0xFF;
+			if(write)
+				memcpy((void*) (_dma_region.virt->start + data_offset), buffer, num_sectors * 512);
+
+			Virtqueue::Buffer chain[3] = {
+				{slot_phys, sizeof(RequestHeader), false},
+				{_dma_region.phys->start + data_offset, num_sectors * 512, !write},
+				{slot_phys + sizeof(RequestHeader), 1, true}
+			};
+
+			if(!_queue->enqueue(chain, 3, &slot))
+				break;
+
+			num_requests++;
+			_requests_submitted = num_requests;
+			block += num_sectors;
+			buffer += num_sectors * 512;
+			count -= num_sectors;
+		}
+
+		//If we couldn't submit anything, the queue must be too small for even one request
+		if(!num_requests)
+			return -EIO;
+
+		//Notify the device once for the whole batch and wait for all of them to complete
+		notify(*_queue);
+		while(_requests_completed != _requests_submitted) {
+			_blocker.set_ready(false);
+			if(_requests_completed != _requests_submitted)
+				TaskManager::current_thread()->block(_blocker);
+		}
+
+		//Check statuses and copy the data out if we read
+		for(size_t i = 0; i < num_requests; i++) {
+			if(_slots[i].status != VIRTIO_BLK_S_OK) {
+				printf("[Virtio] Block request type %d at sector %d failed with status %d\n", type, (uint32_t) _slots[i].header.sector, _slots[i].status);
+				return -EIO;
+			}
+		}
+		if(!write)
+			memcpy(batch_buffer, (void*) _dma_region.virt->start, (block - batch_start) * 512);
+	}
+
+	return SUCCESS;
+}
+
+Result VirtioBlockDevice::read_uncached_blocks(uint32_t block, uint32_t count, uint8_t* buffer) {
+	return do_requests(VIRTIO_BLK_T_IN, block, count, buffer);
+}
+
+Result VirtioBlockDevice::write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	return do_requests(VIRTIO_BLK_T_OUT, block, count, (uint8_t*) buffer);
+}
+
+size_t VirtioBlockDevice::block_size() {
+	return 512;
+}
+
+size_t VirtioBlockDevice::max_addressable_block() {
+	return _capacity - 1;
+}
+
+void VirtioBlockDevice::handle_irq(Registers* regs) {
+	if(!(read_isr() & VIRTIO_ISR_QUEUE))
+		return; //Interrupt wasn't for this queue
+
+	//Complete every request the device is done with
+	uint32_t length;
+	while(_queue->pop_used(length))
+		_requests_completed = _requests_completed + 1;
+
+	if(_requests_completed == _requests_submitted) {
+		_blocker.set_ready(true);
+		TaskManager::yield_if_idle();
+	}
+}
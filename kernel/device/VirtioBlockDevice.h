@@ -0,0 +1,100 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_VIRTIOBLOCKDEVICE_H
+#define DUCKOS_VIRTIOBLOCKDEVICE_H
+
+#include <kernel/interrupt/IRQHandler.h>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
+#include <kernel/memory/LinkedMemoryRegion.h>
+#include <kernel/memory/MemoryManager.h>
+#include "DiskDevice.h"
+#include "VirtioDevice.h"
+
+//Request types
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+#define VIRTIO_BLK_T_FLUSH 4
+
+//Request statuses
+#define VIRTIO_BLK_S_OK 0
+#define VIRTIO_BLK_S_IOERR 1
+#define VIRTIO_BLK_S_UNSUPP 2
+
+//Device config
+#define VIRTIO_BLK_CONFIG_CAPACITY 0x0 //64
+
+//The maximum number of requests we'll have in flight at once, and the maximum size of each one
+#define VIRTIO_BLK_MAX_REQUESTS 8
+#define VIRTIO_BLK_SECTORS_PER_REQUEST (PAGE_SIZE * 4 / 512)
+
+class VirtioBlockDevice: public IRQHandler, public DiskDevice, public VirtioDevice {
+public:
+	static VirtioBlockDevice* find();
+
+	//VirtioBlockDevice
+	~VirtioBlockDevice();
+
+	//BlockDevice
+	Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) override;
+	Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override;
+	size_t block_size() override;
+
+	//DiskDevice
+	size_t max_addressable_block() override;
+
+	//IRQHandler
+	void handle_irq(Registers* regs) override;
+
+private:
+	typedef struct __attribute__((packed)) RequestHeader {
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t sector;
+	} RequestHeader;
+
+	typedef struct __attribute__((packed)) RequestSlot {
+		RequestHeader header;
+		uint8_t status;
+	} RequestSlot;
+
+	explicit VirtioBlockDevice(PCI::Address addr);
+	bool init();
+	Result do_requests(uint32_t type, uint32_t block, uint32_t count, uint8_t* buffer);
+
+	Virtqueue* _queue = nullptr;
+	uint64_t _capacity = 0;
+
+	//Request headers, statuses and data are in DMA-able regions so that each slot can be in flight at once
+	LinkedMemoryRegion _slot_region;
+	LinkedMemoryRegion _dma_region;
+	RequestSlot* _slots = nullptr;
+
+	//Interrupt stuff
+	BooleanBlocker _blocker;
+	volatile size_t _requests_submitted = 0;
+	volatile size_t _requests_completed = 0;
+
+	//Lock
+	SpinLock _lock;
+};
+
+
+#endif //DUCKOS_VIRTIOBLOCKDEVICE_H
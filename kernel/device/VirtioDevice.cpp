@@ -0,0 +1,255 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "VirtioDevice.h"
+#include <kernel/IO.h>
+#include <kernel/memory/PageDirectory.h>
+#include <kernel/kstd/kstdio.h>
+
+struct VirtioFindData {
+	uint16_t type;
+	PCI::Address addr;
+	bool found;
+};
+
+bool VirtioDevice::find(uint16_t device_type, PCI::Address& addr) {
+	VirtioFindData data = {device_type, {0, 0, 0}, false};
+	PCI::enumerate_devices([](PCI::Address addr, PCI::ID id, uint16_t type, void* dataPtr) {
+		auto* data = (VirtioFindData*) dataPtr;
+		if(!data->found && VirtioDevice::device_type(addr, id) == data->type) {
+			data->addr = addr;
+			data->found = true;
+		}
+	}, &data);
+	addr = data.addr;
+	return data.found;
+}
+
+uint16_t VirtioDevice::device_type(PCI::Address addr, PCI::ID id) {
+	if(id.vendor != VIRTIO_PCI_VENDOR)
+		return 0;
+	if(id.device >= VIRTIO_PCI_MODERN_DEVICE_BASE && id.device <= VIRTIO_PCI_MODERN_DEVICE_MAX)
+		return id.device - VIRTIO_PCI_MODERN_DEVICE_BASE;
+	if(id.device >= VIRTIO_PCI_LEGACY_DEVICE_MIN && id.device <= VIRTIO_PCI_LEGACY_DEVICE_MAX)
+		return PCI::read_word(addr, PCI_SUBSYSTEM_ID); //Transitional devices put their type in the subsystem ID
+	return 0;
+}
+
+VirtioDevice::VirtioDevice(PCI::Address addr): _pci_addr(addr) {
+	_irq = PCI::read_byte(addr, PCI_INTERRUPT_LINE);
+	_modern = find_capabilities();
+	if(!_modern)
+		_io_base = PCI::read_word(addr, PCI_BAR0) & (~3u);
+
+	PCI::enable_interrupt(addr);
+	PCI::enable_bus_mastering(addr);
+}
+
+VirtioDevice::~VirtioDevice() {
+	set_device_status(0);
+	unmap_capabilities();
+}
+
+bool VirtioDevice::init_virtio(uint64_t driver_features) {
+	//Reset the device and tell it we know how to drive it
+	set_device_status(0);
+	set_device_status(VIRTIO_STATUS_ACKNOWLEDGE);
+	set_device_status(VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+	//Negotiate features
+	if(_modern) {
+		driver_features |= 1ULL << VIRTIO_F_VERSION_1;
+		_common_cfg->device_feature_select = 0;
+		uint64_t device_features = _common_cfg->device_feature;
+		_common_cfg->device_feature_select = 1;
+		device_features |= ((uint64_t) _common_cfg->device_feature) << 32;
+		_features = device_features & driver_features;
+		_common_cfg->driver_feature_select = 0;
+		_common_cfg->driver_feature = _features & 0xFFFFFFFF;
+		_common_cfg->driver_feature_select = 1;
+		_common_cfg->driver_feature = _features >> 32;
+	} else {
+		_features = IO::inl(_io_base + VIRTIO_LEGACY_DEVICE_FEATURES) & driver_features & 0xFFFFFFFF;
+		IO::outl(_io_base + VIRTIO_LEGACY_GUEST_FEATURES, _features);
+		return true;
+	}
+
+	//Modern devices have to accept the features we chose
+	set_device_status(VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_FEATURES_OK);
+	if(!(device_status() & VIRTIO_STATUS_FEATURES_OK)) {
+		printf("[Virtio] Device did not accept features 0x%x%x\n", (uint32_t) (_features >> 32), (uint32_t) _features);
+		set_device_status(VIRTIO_STATUS_FAILED);
+		return false;
+	}
+
+	return true;
+}
+
+Virtqueue* VirtioDevice::setup_queue(uint16_t index) {
+	if(_modern) {
+		_common_cfg->queue_select = index;
+		uint16_t size = _common_cfg->queue_size;
+		if(!size || _common_cfg->queue_enable)
+			return nullptr;
+
+		auto* queue = new Virtqueue(index, size);
+		queue->notify_offset = _common_cfg->queue_notify_off;
+		_common_cfg->queue_desc = queue->descriptors_phys();
+		_common_cfg->queue_driver = queue->available_phys();
+		_common_cfg->queue_device = queue->used_phys();
+		_common_cfg->queue_enable = 1;
+		return queue;
+	} else {
+		IO::outw(_io_base + VIRTIO_LEGACY_QUEUE_SELECT, index);
+		uint16_t size = IO::inw(_io_base + VIRTIO_LEGACY_QUEUE_SIZE);
+		if(!size)
+			return nullptr;
+
+		auto* queue = new Virtqueue(index, size);
+		IO::outl(_io_base + VIRTIO_LEGACY_QUEUE_ADDRESS, queue->descriptors_phys() / VIRTQ_LEGACY_ALIGN);
+		return queue;
+	}
+}
+
+void VirtioDevice::driver_ok() {
+	set_device_status(device_status() | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void VirtioDevice::notify(Virtqueue& queue) {
+	if(!queue.should_notify())
+		return;
+	if(_modern)
+		*((volatile uint16_t*) (_notify_cfg + queue.notify_offset * _notify_multiplier)) = queue.index();
+	else
+		IO::outw(_io_base + VIRTIO_LEGACY_QUEUE_NOTIFY, queue.index());
+}
+
+uint8_t VirtioDevice::read_isr() {
+	if(_modern)
+		return *_isr_cfg;
+	return IO::inb(_io_base + VIRTIO_LEGACY_ISR_STATUS);
+}
+
+uint8_t VirtioDevice::device_status() {
+	if(_modern)
+		return _common_cfg->device_status;
+	return IO::inb(_io_base + VIRTIO_LEGACY_DEVICE_STATUS);
+}
+
+void VirtioDevice::set_device_status(uint8_t status) {
+	if(_modern)
+		_common_cfg->device_status = status;
+	else
+		IO::outb(_io_base + VIRTIO_LEGACY_DEVICE_STATUS, status);
+}
+
+uint8_t VirtioDevice::read_config8(size_t offset) {
+	if(_modern)
+		return _device_cfg[offset];
+	return IO::inb(_io_base + VIRTIO_LEGACY_DEVICE_CONFIG + offset);
+}
+
+uint16_t VirtioDevice::read_config16(size_t offset) {
+	if(_modern)
+		return *((volatile uint16_t*) (_device_cfg + offset));
+	return IO::inw(_io_base + VIRTIO_LEGACY_DEVICE_CONFIG + offset);
+}
+
+uint32_t VirtioDevice::read_config32(size_t offset) {
+	if(_modern)
+		return *((volatile uint32_t*) (_device_cfg + offset));
+	return IO::inl(_io_base + VIRTIO_LEGACY_DEVICE_CONFIG + offset);
+}
+
+uint64_t VirtioDevice::read_config64(size_t offset) {
+	return read_config32(offset) | ((uint64_t) read_config32(offset + 4) << 32);
+}
+
+bool VirtioDevice::find_capabilities() {
+	if(!(PCI::read_word(_pci_addr, PCI_STATUS) & PCI_STATUS_CAPABILITIES))
+		return false;
+
+	uint8_t cap_ptr = PCI::read_byte(_pci_addr, PCI_CAPABILITIES_POINTER) & (~3u);
+	while(cap_ptr) {
+		if(PCI::read_byte(_pci_addr, cap_ptr) == PCI_CAP_VENDOR_SPECIFIC) {
+			switch(PCI::read_byte(_pci_addr, cap_ptr + VIRTIO_PCI_CAP_CFG_TYPE)) {
+				case VIRTIO_PCI_CAP_COMMON_CFG:
+					if(!_common_cfg)
+						_common_cfg = (volatile VirtioPCICommonConfig*) map_capability(cap_ptr);
+					break;
+				case VIRTIO_PCI_CAP_NOTIFY_CFG:
+					if(!_notify_cfg) {
+						_notify_cfg = map_capability(cap_ptr);
+						_notify_multiplier = PCI::read_dword(_pci_addr, cap_ptr + VIRTIO_PCI_CAP_NOTIFY_MULTIPLIER);
+					}
+					break;
+				case VIRTIO_PCI_CAP_ISR_CFG:
+					if(!_isr_cfg)
+						_isr_cfg = map_capability(cap_ptr);
+					break;
+				case VIRTIO_PCI_CAP_DEVICE_CFG:
+					if(!_device_cfg)
+						_device_cfg = map_capability(cap_ptr);
+					break;
+				default:
+					break;
+			}
+		}
+		cap_ptr = PCI::read_byte(_pci_addr, cap_ptr + 1) & (~3u);
+	}
+
+	if(_common_cfg && _notify_cfg && _isr_cfg && _device_cfg)
+		return true;
+
+	//If we couldn't map all of the structures, unmap what we did map and use the legacy transport
+	unmap_capabilities();
+	return false;
+}
+
+void VirtioDevice::unmap_capabilities() {
+	if(_common_cfg)
+		PageDirectory::k_munmap((void*) _common_cfg);
+	if(_notify_cfg)
+		PageDirectory::k_munmap((void*) _notify_cfg);
+	if(_isr_cfg)
+		PageDirectory::k_munmap((void*) _isr_cfg);
+	if(_device_cfg)
+		PageDirectory::k_munmap((void*) _device_cfg);
+	_common_cfg = nullptr;
+	_notify_cfg = nullptr;
+	_isr_cfg = nullptr;
+	_device_cfg = nullptr;
+}
+
+volatile uint8_t* VirtioDevice::map_capability(uint8_t cap_ptr) {
+	uint8_t bar = PCI::read_byte(_pci_addr, cap_ptr + VIRTIO_PCI_CAP_BAR);
+	if(bar > 5)
+		return nullptr;
+
+	//We can only map memory BARs that are below 4GiB
+	uint32_t bar_value = PCI::read_dword(_pci_addr, PCI_BAR0 + bar * 4);
+	if(bar_value & 1u)
+		return nullptr;
+	if(((bar_value >> 1u) & 3u) == 2 && (bar == 5 || PCI::read_dword(_pci_addr, PCI_BAR0 + (bar + 1) * 4)))
+		return nullptr;
+
+	size_t paddr = (bar_value & (~0xFu)) + PCI::read_dword(_pci_addr, cap_ptr + VIRTIO_PCI_CAP_OFFSET);
+	size_t length = PCI::read_dword(_pci_addr, cap_ptr + VIRTIO_PCI_CAP_LENGTH);
+	return (volatile uint8_t*) PageDirectory::k_mmap(paddr, length, true);
+}
@@ -0,0 +1,110 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_VIRTIODEVICE_H
+#define DUCKOS_VIRTIODEVICE_H
+
+#include <kernel/kstd/types.h>
+#include <kernel/pci/PCI.h>
+#include "Virtio.h"
+#include "Virtqueue.h"
+
+/**
+ * The virtio PCI transport. Drivers for specific virtio devices inherit from this in addition to their Device type.
+ * If the device exposes the virtio 1.0 capabilities (and they're in a BAR we can map), the modern transport is used.
+ * Otherwise, we fall back to the legacy IO port transport.
+ */
+class VirtioDevice {
+public:
+	/**
+	 * Finds the first virtio device of the given type on the PCI bus.
+	 * @param device_type The virtio device type (VIRTIO_DEVICE_*).
+	 * @param addr Will be set to the address of the device if one was found.
+	 * @return Whether or not a device was found.
+	 */
+	static bool find(uint16_t device_type, PCI::Address& addr);
+
+	/**
+	 * Gets the virtio device type of a PCI device.
+	 * @return The device type, or 0 if the device isn't a virtio device.
+	 */
+	static uint16_t device_type(PCI::Address addr, PCI::ID id);
+
+	bool is_modern() const { return _modern; }
+
+protected:
+	explicit VirtioDevice(PCI::Address addr);
+	~VirtioDevice();
+
+	/**
+	 * Resets the device and negotiates features with it.
+	 * @param driver_features The features the driver supports. VIRTIO_F_VERSION_1 is added automatically when modern.
+	 * @return Whether or not the device accepted the features.
+	 */
+	bool init_virtio(uint64_t driver_features);
+
+	/**
+	 * Allocates and registers a virtqueue with the device.
+	 * @return The queue, or nullptr if the queue doesn't exist.
+	 */
+	Virtqueue* setup_queue(uint16_t index);
+
+	//Tells the device the driver is ready. Should be called after all of the queues are set up.
+	void driver_ok();
+
+	//Tells the device that there are new buffers available in the queue.
+	void notify(Virtqueue& queue);
+
+	//Reads and acknowledges the interrupt status.
+	uint8_t read_isr();
+
+	uint8_t device_status();
+	void set_device_status(uint8_t status);
+	uint64_t negotiated_features() const { return _features; }
+	int irq() const { return _irq; }
+
+	uint8_t read_config8(size_t offset);
+	uint16_t read_config16(size_t offset);
+	uint32_t read_config32(size_t offset);
+	uint64_t read_config64(size_t offset);
+
+	PCI::Address _pci_addr;
+
+private:
+	bool find_capabilities();
+	volatile uint8_t* map_capability(uint8_t cap_ptr);
+	void unmap_capabilities();
+
+	bool _modern = false;
+	int _irq = 0;
+	uint64_t _features = 0;
+
+	//Legacy transport
+	uint16_t _io_base = 0;
+
+	//Modern transport
+	volatile VirtioPCICommonConfig* _common_cfg = nullptr;
+	volatile uint8_t* _notify_cfg = nullptr;
+	volatile uint8_t* _isr_cfg = nullptr;
+	volatile uint8_t* _device_cfg = nullptr;
+	uint32_t _notify_multiplier = 0;
+};
+
+
+#endif //DUCKOS_VIRTIODEVICE_H
@@ -0,0 +1,122 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "Virtqueue.h"
+#include <kernel/memory/PageDirectory.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/interrupt/interrupt.h>
+
+#define VIRTQ_USED_OFFSET(size) ((sizeof(VirtqDescriptor) * (size) + sizeof(uint16_t) * (3 + (size)) + VIRTQ_LEGACY_ALIGN - 1) & ~(VIRTQ_LEGACY_ALIGN - 1))
+#define VIRTQ_REGION_SIZE(size) (VIRTQ_USED_OFFSET(size) + sizeof(uint16_t) * 3 + sizeof(VirtqUsedElement) * (size))
+
+Virtqueue::Virtqueue(uint16_t index, uint16_t size): _index(index), _size(size), _num_free(size) {
+	_region = PageDirectory::k_alloc_region(VIRTQ_REGION_SIZE(size));
+	_descriptors = (VirtqDescriptor*) _region.virt->start;
+	_available = (VirtqAvailable*) (_region.virt->start + sizeof(VirtqDescriptor) * size);
+	_used = (VirtqUsed*) (_region.virt->start + VIRTQ_USED_OFFSET(size));
+	_tokens = new void*[size];
+
+	//Link all of the descriptors into the free list
+	for(uint16_t i = 0; i < size; i++) {
+		_descriptors[i].next = i + 1;
+		_tokens[i] = nullptr;
+	}
+}
+
+Virtqueue::~Virtqueue() {
+	PageDirectory::k_free_region(_region);
+	delete[] _tokens;
+}
+
+size_t Virtqueue::descriptors_phys() const {
+	return _region.phys->start;
+}
+
+size_t Virtqueue::available_phys() const {
+	return _region.phys->start + sizeof(VirtqDescriptor) * _size;
+}
+
+size_t Virtqueue::used_phys() const {
+	return _region.phys->start + VIRTQ_USED_OFFSET(_size);
+}
+
+bool Virtqueue::enqueue(const Buffer* buffers, size_t count, void* token) {
+	if(!count)
+		return false;
+
+	Interrupt::Disabler disabler;
+	if(count > _num_free)
+		return false;
+
+	//Fill in the chain of descriptors, taking them from the head of the free list
+	uint16_t head = _free_head;
+	uint16_t desc_index = head;
+	for(size_t i = 0; i < count; i++) {
+		auto& desc = _descriptors[desc_index];
+		desc.addr = buffers[i].phys;
+		desc.length = buffers[i].length;
+		desc.flags = (buffers[i].device_writable ? VIRTQ_DESC_F_WRITE : 0) | (i + 1 < count ? VIRTQ_DESC_F_NEXT : 0);
+		if(i + 1 < count)
+			desc_index = desc.next;
+	}
+	_free_head = _descriptors[desc_index].next;
+	_num_free -= count;
+	_tokens[head] = token;
+
+	//Put the head of the chain in the available ring. The index must only be updated after the ring entry is visible.
+	_available->ring[_available->index % _size] = head;
+	asm volatile("" ::: "memory");
+	_available->index++;
+	asm volatile("" ::: "memory");
+	return true;
+}
+
+bool Virtqueue::has_used() const {
+	return _used->index != _last_used;
+}
+
+void* Virtqueue::pop_used(uint32_t& length) {
+	if(!has_used())
+		return nullptr;
+	asm volatile("" ::: "memory");
+
+	auto& elem = _used->ring[_last_used % _size];
+	auto head = (uint16_t) elem.id;
+	length = elem.length;
+	_last_used++;
+
+	//Return the chain to the free list
+	void* token = _tokens[head];
+	_tokens[head] = nullptr;
+	uint16_t desc_index = head;
+	_num_free++;
+	while(_descriptors[desc_index].flags & VIRTQ_DESC_F_NEXT) {
+		desc_index = _descriptors[desc_index].next;
+		_num_free++;
+	}
+	_descriptors[desc_index].next = _free_head;
+	_free_head = head;
+
+	return token;
+}
+
+bool Virtqueue::should_notify() const {
+	asm volatile("" ::: "memory");
+	return !(_used->flags & VIRTQ_USED_F_NO_NOTIFY);
+}
@@ -0,0 +1,95 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_VIRTQUEUE_H
+#define DUCKOS_VIRTQUEUE_H
+
+#include <kernel/kstd/types.h>
+#include <kernel/memory/LinkedMemoryRegion.h>
+#include "Virtio.h"
+
+/**
+ * A split virtqueue. The descriptor table, available ring, and used ring are laid out in one physically contiguous
+ * region using the legacy layout (used ring page-aligned), which is also valid for the modern transport.
+ *
+ * Descriptors are enqueued with interrupts disabled so that used buffers can be reclaimed from an IRQ handler.
+ */
+class Virtqueue {
+public:
+	struct Buffer {
+		size_t phys;
+		size_t length;
+		bool device_writable;
+	};
+
+	Virtqueue(uint16_t index, uint16_t size);
+	~Virtqueue();
+
+	uint16_t index() const { return _index; }
+	uint16_t size() const { return _size; }
+	uint16_t free_descriptors() const { return _num_free; }
+
+	size_t descriptors_phys() const;
+	size_t available_phys() const;
+	size_t used_phys() const;
+
+	/**
+	 * Adds a chain of buffers to the available ring. The device will not see them until the queue is notified.
+	 * @param buffers The buffers making up the chain. Device-readable buffers must come before device-writable ones.
+	 * @param count The number of buffers in the chain.
+	 * @param token A value that will be returned by pop_used() once the device is finished with the chain.
+	 * @return Whether or not there were enough free descriptors to enqueue the chain.
+	 */
+	bool enqueue(const Buffer* buffers, size_t count, void* token);
+
+	/**
+	 * Returns whether or not the device has returned any chains that haven't been popped yet.
+	 */
+	bool has_used() const;
+
+	/**
+	 * Reclaims the next chain the device is finished with. Must be called with interrupts disabled (ie. from an IRQ).
+	 * @param length Will be set to the number of bytes the device wrote into the chain.
+	 * @return The token passed to enqueue() for the chain, or nullptr if there were no used chains.
+	 */
+	void* pop_used(uint32_t& length);
+
+	/**
+	 * Returns whether or not the device wants to be notified about newly available chains.
+	 */
+	bool should_notify() const;
+
+	//The queue's notify offset (modern transport only)
+	uint16_t notify_offset = 0;
+
+private:
+	uint16_t _index;
+	uint16_t _size;
+	LinkedMemoryRegion _region;
+	VirtqDescriptor* _descriptors;
+	VirtqAvailable* _available;
+	volatile VirtqUsed* _used;
+	void** _tokens;
+	uint16_t _free_head = 0;
+	uint16_t _num_free;
+	uint16_t _last_used = 0;
+};
+
+
+#endif //DUCKOS_VIRTQUEUE_H
@@ -0,0 +1,136 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "DirectoryCache.h"
+
+DirectoryCache* DirectoryCache::_inst = nullptr;
+
+DirectoryCache& DirectoryCache::inst() {
+	if(!_inst)
+		_inst = new DirectoryCache();
+	return *_inst;
+}
+
+bool DirectoryCache::lookup(Filesystem* fs, ino_t parent, const kstd::string& name, ino_t& id) {
+	LOCK(_lock);
+	size_t bucket = hash(fs, parent, name);
+	auto** entry_ptr = find_entry(bucket, fs, parent, name);
+	if(!entry_ptr) {
+		_stats.misses++;
+		return false;
+	}
+
+	//Move the entry to the front of its bucket
+	auto* entry = *entry_ptr;
+	*entry_ptr = entry->next;
+	entry->next = _buckets[bucket];
+	_buckets[bucket] = entry;
+
+	if(entry->id)
+		_stats.hits++;
+	else
+		_stats.negative_hits++;
+	id = entry->id;
+	return true;
+}
+
+void DirectoryCache::insert(Filesystem* fs, ino_t parent, const kstd::string& name, ino_t id) {
+	LOCK(_lock);
+	size_t bucket = hash(fs, parent, name);
+
+	//If there's already an entry, update it and move it to the front
+	auto** entry_ptr = find_entry(bucket, fs, parent, name);
+	if(entry_ptr) {
+		auto* entry = *entry_ptr;
+		*entry_ptr = entry->next;
+		entry->id = id;
+		entry->next = _buckets[bucket];
+		_buckets[bucket] = entry;
+		return;
+	}
+
+	_buckets[bucket] = new Entry {fs, parent, name, id, _buckets[bucket]};
+	_stats.entries++;
+
+	//Drop the least recently used entry if the bucket is full
+	size_t depth = 1;
+	for(auto* entry = _buckets[bucket]; entry->next; entry = entry->next) {
+		if(++depth > DIRECTORY_CACHE_BUCKET_DEPTH) {
+			delete entry->next;
+			entry->next = nullptr;
+			_stats.entries--;
+			break;
+		}
+	}
+}
+
+void DirectoryCache::invalidate(Filesystem* fs, ino_t parent, const kstd::string& name) {
+	LOCK(_lock);
+	auto** entry_ptr = find_entry(hash(fs, parent, name), fs, parent, name);
+	if(!entry_ptr)
+		return;
+	auto* entry = *entry_ptr;
+	*entry_ptr = entry->next;
+	delete entry;
+	_stats.entries--;
+}
+
+void DirectoryCache::invalidate_directory(Filesystem* fs, ino_t parent) {
+	//This has to look through the whole cache, but directories aren't removed often
+	LOCK(_lock);
+	for(size_t bucket = 0; bucket < DIRECTORY_CACHE_BUCKETS; bucket++) {
+		auto** entry_ptr = &_buckets[bucket];
+		while(*entry_ptr) {
+			auto* entry = *entry_ptr;
+			if(entry->fs == fs && entry->parent == parent) {
+				*entry_ptr = entry->next;
+				delete entry;
+				_stats.entries--;
+			} else {
+				entry_ptr = &entry->next;
+			}
+		}
+	}
+}
+
+DirectoryCache::Stats DirectoryCache::stats() {
+	LOCK(_lock);
+	return _stats;
+}
+
+size_t DirectoryCache::hash(Filesystem* fs, ino_t parent, const kstd::string& name) {
+	//FNV-1a over the name, mixed with the parent and filesystem
+	uint32_t hash = 2166136261u ^ (uint32_t) parent ^ ((uint32_t) fs >> 4);
+	for(size_t i = 0; i < name.length(); i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619u;
+	}
+	return hash % DIRECTORY_CACHE_BUCKETS;
+}
+
+DirectoryCache::Entry** DirectoryCache::find_entry(size_t bucket, Filesystem* fs, ino_t parent, const kstd::string& name) {
+	auto** entry_ptr = &_buckets[bucket];
+	while(*entry_ptr) {
+		auto* entry = *entry_ptr;
+		if(entry->fs == fs && entry->parent == parent && entry->name == name)
+			return entry_ptr;
+		entry_ptr = &entry->next;
+	}
+	return nullptr;
+}
@@ -0,0 +1,78 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_DIRECTORYCACHE_H
+#define DUCKOS_DIRECTORYCACHE_H
+
+#include <kernel/kstd/unix_types.h>
+#include <kernel/kstd/string.h>
+#include <kernel/tasking/SpinLock.h>
+
+//The number of hash buckets, and the maximum number of entries kept in each one
+#define DIRECTORY_CACHE_BUCKETS 1024
+#define DIRECTORY_CACHE_BUCKET_DEPTH 8
+
+class Filesystem;
+
+/**
+ * A cache of directory lookups keyed by (filesystem, parent inode, name). Lookups that found nothing are cached too
+ * (as negative entries with an inode id of zero). Each bucket is kept in most-recently-used order, and the least
+ * recently used entry in a bucket is dropped when it's full.
+ *
+ * Filesystems that opt into caching (see Filesystem::cache_directory_entries()) must keep it up to date whenever they
+ * add or remove a directory entry.
+ */
+class DirectoryCache {
+public:
+	struct Stats {
+		size_t hits;
+		size_t negative_hits;
+		size_t misses;
+		size_t entries;
+	};
+
+	static DirectoryCache& inst();
+
+	bool lookup(Filesystem* fs, ino_t parent, const kstd::string& name, ino_t& id);
+	void insert(Filesystem* fs, ino_t parent, const kstd::string& name, ino_t id);
+	void invalidate(Filesystem* fs, ino_t parent, const kstd::string& name);
+	void invalidate_directory(Filesystem* fs, ino_t parent);
+	Stats stats();
+
+private:
+	struct Entry {
+		Filesystem* fs;
+		ino_t parent;
+		kstd::string name;
+		ino_t id;
+		Entry* next;
+	};
+
+	DirectoryCache() = default;
+	static size_t hash(Filesystem* fs, ino_t parent, const kstd::string& name);
+	Entry** find_entry(size_t bucket, Filesystem* fs, ino_t parent, const kstd::string& name);
+
+	static DirectoryCache* _inst;
+
+	Entry* _buckets[DIRECTORY_CACHE_BUCKETS] = {nullptr};
+	SpinLock _lock;
+	Stats _stats = {0, 0, 0, 0};
+};
+
+#endif //DUCKOS_DIRECTORYCACHE_H
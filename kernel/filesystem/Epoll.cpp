@@ -0,0 +1,226 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "Epoll.h"
+#include "FileDescriptor.h"
+#include <kernel/interrupt/interrupt.h>
+#include <kernel/tasking/EpollBlocker.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Thread.h>
+
+Epoll::Entry::Entry(Epoll& epoll, int fd_num, FileDescriptor* fd, const struct epoll_event& event):
+	FileWatcher(fd), epoll(epoll), fd_num(fd_num), events(event.events), data(event.data)
+{
+}
+
+uint32_t Epoll::Entry::poll() {
+	uint32_t revents = 0;
+	auto file = fd()->file();
+	if((events & EPOLLIN) && file->can_read(*fd()))
+		revents |= EPOLLIN;
+	if((events & EPOLLOUT) && file->can_write(*fd()))
+		revents |= EPOLLOUT;
+	return revents;
+}
+
+void Epoll::Entry::notify() {
+	if(events & (EPOLLIN | EPOLLOUT))
+		epoll.queue(this);
+}
+
+void Epoll::Entry::fd_closed() {
+	//The file descriptor is going away, so it's removed from the interest list like it was never there
+	epoll.remove(fd_num);
+}
+
+Epoll::Epoll() = default;
+
+Epoll::~Epoll() {
+	LOCK(_lock);
+	for(size_t i = 0; i < _entries.size(); i++) {
+		if(!_entries[i])
+			continue;
+		_entries[i]->unwatch();
+		delete _entries[i];
+		_entries[i] = nullptr;
+	}
+	_ready_head = nullptr;
+	_ready_tail = nullptr;
+}
+
+Result Epoll::add(int fd_num, const kstd::shared_ptr<FileDescriptor>& fd, const struct epoll_event& event) {
+	if(fd->file().get() == this)
+		return -EINVAL;
+
+	LOCK(_lock);
+	if(fd_num < (int) _entries.size() && _entries[fd_num])
+		return -EEXIST;
+	if(fd_num >= (int) _entries.size())
+		_entries.resize(fd_num + 1);
+	auto* entry = new Entry(*this, fd_num, fd.get(), event);
+	_entries[fd_num] = entry;
+
+	//Start watching the file, and check it right away in case it's already ready. This is done with the lock held so
+	//that the entry can't be removed before it's set up.
+	fd->file()->watchers().add(entry);
+	queue(entry);
+	return SUCCESS;
+}
+
+Result Epoll::modify(int fd_num, const struct epoll_event& event) {
+	LOCK(_lock);
+	if(fd_num < 0 || fd_num >= (int) _entries.size() || !_entries[fd_num])
+		return -ENOENT;
+	auto* entry = _entries[fd_num];
+	entry->events = event.events;
+	entry->data = event.data;
+	queue(entry);
+	return SUCCESS;
+}
+
+Result Epoll::remove(int fd_num) {
+	Entry* entry;
+	{
+		LOCK(_lock);
+		if(fd_num < 0 || fd_num >= (int) _entries.size() || !_entries[fd_num])
+			return -ENOENT;
+		entry = _entries[fd_num];
+		_entries[fd_num] = nullptr;
+
+		//Stop watching the file first so that a notification can't queue the entry again after it's unqueued
+		entry->unwatch();
+		unqueue(entry);
+	}
+
+	delete entry;
+	return SUCCESS;
+}
+
+ssize_t Epoll::wait(struct epoll_event* events, int max_events, int timeout) {
+	if(max_events <= 0 || max_events > EPOLL_MAX_EVENTS)
+		return -EINVAL;
+
+	EpollBlocker blocker(*this, Time(0, timeout * 1000));
+	while(true) {
+		int nevents = collect(events, max_events);
+		if(nevents || !timeout || blocker.timed_out())
+			return nevents;
+
+		//Nothing was ready, so wait until one of the files notifies us
+		TaskManager::current_thread()->block(blocker);
+		if(blocker.was_interrupted())
+			return -EINTR;
+	}
+}
+
+bool Epoll::has_ready() {
+	return _ready_head;
+}
+
+bool Epoll::is_epoll() {
+	return true;
+}
+
+bool Epoll::can_read(const FileDescriptor& fd) {
+	return has_ready();
+}
+
+void Epoll::queue(Entry* entry) {
+	{
+		Interrupt::NestedDisabler disabler;
+		if(entry->queued)
+			return;
+		entry->queued = true;
+		entry->next_ready = nullptr;
+		if(_ready_tail)
+			_ready_tail->next_ready = entry;
+		else
+			_ready_head = entry;
+		_ready_tail = entry;
+	}
+
+	//Let anything watching this Epoll know that it might be readable now
+	watchers().notify();
+}
+
+void Epoll::unqueue(Entry* entry) {
+	Interrupt::NestedDisabler disabler;
+	if(!entry->queued)
+		return;
+
+	Entry* prev = nullptr;
+	for(auto* cur = _ready_head; cur; prev = cur, cur = cur->next_ready) {
+		if(cur != entry)
+			continue;
+		if(prev)
+			prev->next_ready = cur->next_ready;
+		else
+			_ready_head = cur->next_ready;
+		if(_ready_tail == cur)
+			_ready_tail = prev;
+		break;
+	}
+
+	entry->queued = false;
+	entry->next_ready = nullptr;
+}
+
+Epoll::Entry* Epoll::pop_ready() {
+	Interrupt::NestedDisabler disabler;
+	auto* entry = _ready_head;
+	if(!entry)
+		return nullptr;
+	_ready_head = entry->next_ready;
+	if(!_ready_head)
+		_ready_tail = nullptr;
+	entry->queued = false;
+	entry->next_ready = nullptr;
+	return entry;
+}
+
+int Epoll::collect(struct epoll_event* events, int max_events) {
+	LOCK(_lock);
+
+	//Only the entries that were notified since the last wait (or are level-triggered and were ready then) are checked
+	kstd::vector<Entry*> still_ready;
+	int nevents = 0;
+	while(nevents < max_events) {
+		auto* entry = pop_ready();
+		if(!entry)
+			break;
+
+		uint32_t revents = entry->poll();
+		if(!revents)
+			continue;
+
+		events[nevents].events = revents;
+		events[nevents].data = entry->data;
+		nevents++;
+
+		if(entry->events & EPOLLONESHOT)
+			entry->events &= ~(EPOLLIN | EPOLLOUT); //Disabled until it's modified again
+		else if(!(entry->events & EPOLLET))
+			still_ready.push_back(entry);
+	}
+
+	for(size_t i = 0; i < still_ready.size(); i++)
+		queue(still_ready[i]);
+
+	return nevents;
+}
@@ -0,0 +1,82 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_EPOLL_H
+#define DUCKOS_EPOLL_H
+
+#include <kernel/kstd/vector.hpp>
+#include <kernel/kstd/shared_ptr.hpp>
+#include <kernel/kstd/unix_types.h>
+#include <kernel/tasking/SpinLock.h>
+#include "File.h"
+
+#define EPOLL_MAX_EVENTS 1024
+
+/**
+ * An interest list of file descriptors. Rather than checking every file descriptor each time, the files themselves
+ * notify the Epoll when their state changes, and only the file descriptors that were notified are checked when
+ * waiting. Level-triggered entries are checked again on every wait until they aren't ready anymore, and edge-triggered
+ * (EPOLLET) entries are only reported again once they're notified again.
+ */
+class Epoll: public File {
+public:
+	Epoll();
+	~Epoll() override;
+
+	Result add(int fd_num, const kstd::shared_ptr<FileDescriptor>& fd, const struct epoll_event& event);
+	Result modify(int fd_num, const struct epoll_event& event);
+	Result remove(int fd_num);
+	ssize_t wait(struct epoll_event* events, int max_events, int timeout);
+	bool has_ready();
+
+	//File
+	bool is_epoll() override;
+	bool can_read(const FileDescriptor& fd) override;
+
+private:
+	class Entry: public FileWatcher {
+	public:
+		Entry(Epoll& epoll, int fd_num, FileDescriptor* fd, const struct epoll_event& event);
+		uint32_t poll();
+
+		//FileWatcher
+		void notify() override;
+		void fd_closed() override;
+
+		Epoll& epoll;
+		int fd_num;
+		uint32_t events;
+		epoll_data_t data;
+		Entry* next_ready = nullptr;
+		bool queued = false;
+	};
+
+	void queue(Entry* entry);
+	void unqueue(Entry* entry);
+	Entry* pop_ready();
+	int collect(struct epoll_event* events, int max_events);
+
+	kstd::vector<Entry*> _entries; //Indexed by file descriptor number
+	Entry* _ready_head = nullptr;
+	Entry* _ready_tail = nullptr;
+	SpinLock _lock;
+};
+
+
+#endif //DUCKOS_EPOLL_H
@@ -52,6 +52,18 @@ bool File::is_fifo() {
 	return false;
 }
 
+bool File::is_device() {
+	return false;
+}
+
+bool File::is_epoll() {
+	return false;
+}
+
+bool File::is_socket() {
+	return false;
+}
+
 ssize_t File::read(FileDescriptor &fd, size_t offset, uint8_t *buffer, size_t count) {
 	return 0;
 }
@@ -85,3 +97,11 @@ bool File::can_write(const FileDescriptor& fd) {
 	return true;
 }
 
+size_t File::max_message_size() {
+	//Zero means the file is a stream; anything else is the largest message a single write can carry
+	return 0;
+}
+
+FileWatcherList& File::watchers() {
+	return _watchers;
+}
@@ -22,6 +22,7 @@
 
 #include <kernel/kstd/shared_ptr.hpp>
 #include <kernel/Result.hpp>
+#include "FileWatcher.h"
 
 class FileDescriptor;
 class DirectoryEntry;
@@ -37,13 +38,21 @@ public:
 	virtual bool is_pty_mux();
 	virtual bool is_pty();
 	virtual bool is_fifo();
+	virtual bool is_device();
+	virtual bool is_epoll();
+	virtual bool is_socket();
 	virtual int ioctl(unsigned request, void* argp);
 	virtual void open(FileDescriptor& fd, int options);
 	virtual void close(FileDescriptor& fd);
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	virtual size_t max_message_size();
+	virtual FileWatcherList& watchers();
 protected:
 	File();
+
+private:
+	FileWatcherList _watchers;
 };
 
 
@@ -22,23 +22,36 @@
 #include <kernel/time/Time.h>
 #include "Inode.h"
 #include "FileDescriptor.h"
+#include <kernel/device/BlockDevice.h>
+#include <kernel/CommandLine.h>
+#include <kernel/kstd/kstdlib.h>
+
+FileBasedFilesystem::InodeCacheStats FileBasedFilesystem::_inode_cache_stats = {0, 0, 0, 0};
+SpinLock FileBasedFilesystem::_inode_cache_stats_lock;
 
 FileBasedFilesystem::FileBasedFilesystem(const kstd::shared_ptr<FileDescriptor>& file): _file(file) {
+	_inode_cache_max = inode_cache_max();
 
+	//If we're on a block device, we can zero ranges of it directly instead of writing zeroed buffers
+	auto dev_file = _file->file();
+	if(dev_file->is_device() && ((Device*) dev_file.get())->is_block_device())
+		_block_device = (BlockDevice*) dev_file.get();
 }
 
-FileBasedFilesystem::~FileBasedFilesystem() = default;
+FileBasedFilesystem::~FileBasedFilesystem() {
+	for(auto* entry = _lru_head; entry;) {
+		auto* next = entry->lru_next;
+		delete entry;
+		entry = next;
+	}
+}
 
 Result FileBasedFilesystem::read_logical_block(size_t block, uint8_t *buffer) {
 	return read_logical_blocks(block, 1, buffer);
 }
 
 Result FileBasedFilesystem::read_logical_blocks(size_t block, size_t count, uint8_t *buffer) {
-	LOCK(lock);
-	int code = _file->seek(block * logical_block_size(), SEEK_SET);
-	if(code < 0) return code;
-
-	ssize_t nread = _file->read(buffer, count * logical_block_size());
+	ssize_t nread = _file->pread(buffer, count * logical_block_size(), block * logical_block_size());
 	if(nread < 0) return nread;
 	if(nread != count * logical_block_size()) return -EIO;
 	return SUCCESS;
@@ -49,11 +62,7 @@ Result FileBasedFilesystem::write_logical_block(size_t block, const uint8_t *buf
 }
 
 Result FileBasedFilesystem::write_logical_blocks(size_t block, size_t count, const uint8_t *buffer) {
-	LOCK(lock);
-	int code = _file->seek(block * logical_block_size(), SEEK_SET);
-	if(code < 0) return code;
-
-	ssize_t nwrote = _file->write(buffer, count * logical_block_size());
+	ssize_t nwrote = _file->pwrite(buffer, count * logical_block_size(), block * logical_block_size());
 	if(nwrote < 0) return nwrote;
 	if(nwrote != count * logical_block_size()) return -EIO;
 	return SUCCESS;
@@ -72,97 +81,98 @@ void FileBasedFilesystem::set_block_size(size_t block_size) {
 }
 
 Result FileBasedFilesystem::read_block(size_t block, uint8_t *buffer) {
-	LOCK(lock);
+	return read_blocks(block, 1, buffer);
+}
 
-	int res = _file->seek(block * block_size(), SEEK_SET);
-	if (res < 0)
-		return res;
+Result FileBasedFilesystem::read_blocks(size_t block, size_t count, uint8_t *buffer) {
+	//If we're on a block device, read straight from it instead of going through the file descriptor
+	if(_block_device) {
+		size_t dev_blocks_per_block = block_size() / _block_device->block_size();
+		return _block_device->read_blocks(block * dev_blocks_per_block, count * dev_blocks_per_block, buffer);
+	}
 
-	ssize_t nread = _file->read(buffer, block_size());
-	if (nread == 0)
-		return -EIO;
-	else if(nread < 0)
+	ssize_t nread = _file->pread(buffer, count * block_size(), block * block_size());
+	if (nread < 0)
 		return nread;
+	else if((size_t) nread != count * block_size())
+		return -EIO;
 
 	return SUCCESS;
 }
 
-Result FileBasedFilesystem::read_blocks(size_t block, size_t count, uint8_t *buffer) {
-	Result res = SUCCESS;
-	for(size_t i = 0; i < count; i++) {
-		res = read_block(block + i, buffer + block_size() * i);
-		if(res.is_error()) return res;
-	}
-	return SUCCESS;
+Result FileBasedFilesystem::write_block(size_t block, const uint8_t* buffer) {
+	return write_blocks(block, 1, buffer);
 }
 
 Result FileBasedFilesystem::write_blocks(size_t block, size_t count, const uint8_t* buffer) {
-	Result res = SUCCESS;
-	for(size_t i = 0; i < count; i++) {
-		res = write_block(block + i, buffer + i * block_size());
-		if(res.is_error()) return res;
+	if(_block_device) {
+		size_t dev_blocks_per_block = block_size() / _block_device->block_size();
+		return _block_device->write_blocks(block * dev_blocks_per_block, count * dev_blocks_per_block, buffer);
 	}
-	return SUCCESS;
-}
 
-Result FileBasedFilesystem::write_block(size_t block, const uint8_t* buffer) {
-	LOCK(lock);
+	ssize_t nwrote = _file->pwrite(buffer, count * block_size(), block * block_size());
+	if(nwrote < 0)
+		return nwrote;
+	else if((size_t) nwrote != count * block_size())
+		return -EIO;
 
-	int res = _file->seek(block * block_size(), SEEK_SET);
-	if(res < 0)
-		return res;
+	return SUCCESS;
+}
 
-	ssize_t nwrote = _file->write(buffer, block_size());
-	if(nwrote == 0)
-		return -EIO;
-	else if(nwrote < 0)
-		return nwrote;
+Result FileBasedFilesystem::write_blocks_deferred(size_t block, size_t count, const uint8_t* buffer) {
+	//Only block devices have a cache to hold on to the blocks until they're flushed
+	if(_block_device) {
+		size_t dev_blocks_per_block = block_size() / _block_device->block_size();
+		return _block_device->write_blocks_deferred(block * dev_blocks_per_block, count * dev_blocks_per_block, buffer);
+	}
+	return write_blocks(block, count, buffer);
+}
 
+Result FileBasedFilesystem::flush_blocks(size_t block, size_t count) {
+	if(_block_device) {
+		size_t dev_blocks_per_block = block_size() / _block_device->block_size();
+		return _block_device->flush_blocks(block * dev_blocks_per_block, count * dev_blocks_per_block);
+	}
 	return SUCCESS;
 }
 
 Result FileBasedFilesystem::zero_block(size_t block) {
-	LOCK(lock);
-
-	//TODO: Implementation that doesn't require allocating a buffer
+	return zero_blocks(block, 1);
+}
 
-	int res = _file->seek(block * block_size(), SEEK_SET);
-	if(res < 0)
-		return res;
+Result FileBasedFilesystem::zero_blocks(size_t block, size_t count) {
+	if(_block_device)
+		return _block_device->zero_range(block * block_size(), count * block_size());
 
 	auto* zero_buf = new uint8_t[block_size()];
 	memset(zero_buf, 0, block_size());
-
-	ssize_t nwrote = _file->write(zero_buf, block_size());
+	for(size_t i = 0; i < count; i++) {
+		ssize_t nwrote = _file->pwrite(zero_buf, block_size(), (block + i) * block_size());
+		if(nwrote <= 0) {
+			delete[] zero_buf;
+			return nwrote ? nwrote : -EIO;
+		}
+	}
 	delete[] zero_buf;
 
-	if(nwrote == 0)
-		return -EIO;
-	else if(nwrote < 0)
-		return nwrote;
-
 	return SUCCESS;
 }
 
 Result FileBasedFilesystem::truncate_block(size_t block, size_t new_size) {
 	if(new_size >= block_size()) return -EOVERFLOW;
-	LOCK(lock);
-
-	//TODO: Implementation that doesn't require allocating a buffer
-
-	int res = _file->seek(block * block_size(), SEEK_SET);
-	if(res < 0)
-		return res;
+	if(_block_device)
+		return _block_device->zero_range(block * block_size() + new_size, block_size() - new_size);
 
+	LOCK(lock);
 	auto* buf = new uint8_t[block_size()];
-	res = _file->read(buf, block_size());
+	ssize_t res = _file->pread(buf, block_size(), block * block_size());
 	if(res < 0) {
 		delete[] buf;
 		return res;
 	}
 
 	memset(buf + new_size, 0, (int)(block_size() - new_size));
-	ssize_t nwrote = _file->write(buf, block_size());
+	ssize_t nwrote = _file->pwrite(buf, block_size(), block * block_size());
 	delete[] buf;
 
 	if(nwrote == 0)
@@ -175,25 +185,52 @@ Result FileBasedFilesystem::truncate_block(size_t block, size_t new_size) {
 
 ResultRet<kstd::shared_ptr<Inode>> FileBasedFilesystem::get_cached_inode(ino_t id) {
 	LOCK(_inode_cache_lock);
-	for(size_t i = 0; i < _inode_cache.size(); i++) {
-		if(_inode_cache[i]->id == id) return _inode_cache[i];
-	}
-	return -ENOENT;
+	auto* entry = find_cached_inode(id);
+	if(!entry)
+		return -ENOENT;
+
+	//Move it to the front of the LRU list
+	unlink_cached_inode(entry);
+	link_cached_inode(entry);
+	return entry->inode;
 }
 
 void FileBasedFilesystem::add_cached_inode(const kstd::shared_ptr<Inode> &inode) {
+	//The evicted inodes are freed once the lock is released, since they may write themselves to disk
+	kstd::vector<kstd::shared_ptr<Inode>> evicted;
 	LOCK(_inode_cache_lock);
-	_inode_cache.push_back(inode);
+	insert_cached_inode(inode, evicted);
 }
 
 void FileBasedFilesystem::remove_cached_inode(ino_t id) {
+	kstd::shared_ptr<Inode> removed;
 	LOCK(_inode_cache_lock);
-	for(size_t i = 0; i < _inode_cache.size(); i++) {
-		if(_inode_cache[i]->id == id) {
-			_inode_cache.erase(i);
-			return;
-		}
+	auto* entry = find_cached_inode(id);
+	if(!entry)
+		return;
+
+	auto** entry_ptr = &_inode_cache[id % INODE_CACHE_BUCKETS];
+	while(*entry_ptr != entry)
+		entry_ptr = &(*entry_ptr)->hash_next;
+	*entry_ptr = entry->hash_next;
+	unlink_cached_inode(entry);
+	{
+		LOCK(_inode_cache_stats_lock);
+		_inode_cache_stats.entries--;
 	}
+	removed = entry->inode;
+	delete entry;
+}
+
+FileBasedFilesystem::InodeCacheStats FileBasedFilesystem::inode_cache_stats() {
+	LOCK(_inode_cache_stats_lock);
+	return _inode_cache_stats;
+}
+
+size_t FileBasedFilesystem::inode_cache_max() {
+	if(CommandLine::inst().has_option("inode_cache"))
+		return atoi(CommandLine::inst().get_option_value("inode_cache").c_str());
+	return INODE_CACHE_DEFAULT_MAX;
 }
 
 Inode* FileBasedFilesystem::get_inode_rawptr(ino_t id) {
@@ -201,16 +238,94 @@ Inode* FileBasedFilesystem::get_inode_rawptr(ino_t id) {
 }
 
 ResultRet<kstd::shared_ptr<Inode>> FileBasedFilesystem::get_inode(ino_t id) {
+	kstd::vector<kstd::shared_ptr<Inode>> evicted;
 	LOCK(_inode_cache_lock);
 	auto inode_perhaps = get_cached_inode(id);
 	if(inode_perhaps.is_error()) {
+		{
+			LOCK(_inode_cache_stats_lock);
+			_inode_cache_stats.misses++;
+		}
 		Inode* in = get_inode_rawptr(id);
 		if(in) {
 			auto ins = kstd::shared_ptr<Inode>(in);
-			add_cached_inode(ins);
+			insert_cached_inode(ins, evicted);
 			return ins;
 		} else return -ENOENT;
 	} else {
+		LOCK_N(_inode_cache_stats_lock, stats_locker);
+		_inode_cache_stats.hits++;
 		return inode_perhaps.value();
 	}
 }
+
+FileBasedFilesystem::CachedInode* FileBasedFilesystem::find_cached_inode(ino_t id) {
+	for(auto* entry = _inode_cache[id % INODE_CACHE_BUCKETS]; entry; entry = entry->hash_next) {
+		if(entry->inode->id == id)
+			return entry;
+	}
+	return nullptr;
+}
+
+void FileBasedFilesystem::insert_cached_inode(const kstd::shared_ptr<Inode>& inode, kstd::vector<kstd::shared_ptr<Inode>>& evicted) {
+	auto*& bucket = _inode_cache[inode->id % INODE_CACHE_BUCKETS];
+	auto* entry = new CachedInode {inode, bucket, nullptr, nullptr};
+	bucket = entry;
+	link_cached_inode(entry);
+	{
+		LOCK(_inode_cache_stats_lock);
+		_inode_cache_stats.entries++;
+	}
+	evict_unused_inodes(evicted);
+}
+
+void FileBasedFilesystem::link_cached_inode(CachedInode* entry) {
+	//Puts the entry at the front of the LRU list
+	entry->lru_prev = nullptr;
+	entry->lru_next = _lru_head;
+	if(_lru_head)
+		_lru_head->lru_prev = entry;
+	else
+		_lru_tail = entry;
+	_lru_head = entry;
+	_num_cached_inodes++;
+}
+
+void FileBasedFilesystem::unlink_cached_inode(CachedInode* entry) {
+	//Removes the entry from the LRU list (but not its hash bucket)
+	if(entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		_lru_head = entry->lru_next;
+	if(entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		_lru_tail = entry->lru_prev;
+	entry->lru_prev = nullptr;
+	entry->lru_next = nullptr;
+	_num_cached_inodes--;
+}
+
+void FileBasedFilesystem::evict_unused_inodes(kstd::vector<kstd::shared_ptr<Inode>>& evicted) {
+	//Starting from the least recently used, evict inodes that nothing but the cache is using until we're under the limit
+	auto* entry = _lru_tail;
+	while(entry && _num_cached_inodes > _inode_cache_max) {
+		auto* prev = entry->lru_prev;
+		if(entry->inode.use_count() == 1) {
+			//Write the inode back now, so that it can't be read back into the cache from disk before it's written
+			entry->inode->sync();
+
+			auto** entry_ptr = &_inode_cache[entry->inode->id % INODE_CACHE_BUCKETS];
+			while(*entry_ptr != entry)
+				entry_ptr = &(*entry_ptr)->hash_next;
+			*entry_ptr = entry->hash_next;
+			unlink_cached_inode(entry);
+			evicted.push_back(entry->inode);
+			delete entry;
+			LOCK_N(_inode_cache_stats_lock, stats_locker);
+			_inode_cache_stats.entries--;
+			_inode_cache_stats.evictions++;
+		}
+		entry = prev;
+	}
+}
@@ -26,8 +26,21 @@
 #include <kernel/kstd/vector.hpp>
 #include <kernel/memory/LinkedMemoryRegion.h>
 
+//The number of hash buckets in the inode cache, and the default number of inodes it holds before evicting unused ones
+//(can be changed with the inode_cache= command line option)
+#define INODE_CACHE_BUCKETS 256
+#define INODE_CACHE_DEFAULT_MAX 1024
+
+class BlockDevice;
 class FileBasedFilesystem: public Filesystem {
 public:
+	struct InodeCacheStats {
+		size_t entries;
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+	};
+
 	explicit FileBasedFilesystem(const kstd::shared_ptr<FileDescriptor>& file);
 	~FileBasedFilesystem();
 
@@ -43,12 +56,17 @@ public:
 	Result read_blocks(size_t block, size_t count, uint8_t* buffer);
 	Result write_block(size_t block, const uint8_t* buffer);
 	Result write_blocks(size_t block, size_t count, const uint8_t* buffer);
+	Result write_blocks_deferred(size_t block, size_t count, const uint8_t* buffer);
+	Result flush_blocks(size_t block, size_t count);
 	Result zero_block(size_t block);
+	Result zero_blocks(size_t block, size_t count);
 	Result truncate_block(size_t block, size_t new_size);
 
 	ResultRet<kstd::shared_ptr<Inode>> get_cached_inode(ino_t id);
 	void add_cached_inode(const kstd::shared_ptr<Inode>& inode);
 	void remove_cached_inode(ino_t id);
+	static InodeCacheStats inode_cache_stats();
+	static size_t inode_cache_max();
 
 	virtual Inode* get_inode_rawptr(ino_t id);
 	virtual ResultRet<kstd::shared_ptr<Inode>> get_inode(ino_t id);
@@ -60,10 +78,34 @@ protected:
 	SpinLock lock;
 	kstd::shared_ptr<FileDescriptor> _file;
 	size_t _block_size;
+	BlockDevice* _block_device = nullptr;
 
 private:
-	kstd::vector<kstd::shared_ptr<Inode>> _inode_cache;
+	//Cached inodes are in a hash bucket by id, and in a list ordered from most to least recently used
+	struct CachedInode {
+		kstd::shared_ptr<Inode> inode;
+		CachedInode* hash_next;
+		CachedInode* lru_prev;
+		CachedInode* lru_next;
+	};
+
+	CachedInode* find_cached_inode(ino_t id);
+	void insert_cached_inode(const kstd::shared_ptr<Inode>& inode, kstd::vector<kstd::shared_ptr<Inode>>& evicted);
+	void link_cached_inode(CachedInode* entry);
+	void unlink_cached_inode(CachedInode* entry);
+	void evict_unused_inodes(kstd::vector<kstd::shared_ptr<Inode>>& evicted);
+
+	CachedInode* _inode_cache[INODE_CACHE_BUCKETS] = {nullptr};
+	CachedInode* _lru_head = nullptr;
+	CachedInode* _lru_tail = nullptr;
+	size_t _num_cached_inodes = 0;
 	SpinLock _inode_cache_lock;
+
+	size_t _inode_cache_max;
+
+	//The stats are shared by every filesystem, so they have their own lock
+	static InodeCacheStats _inode_cache_stats;
+	static SpinLock _inode_cache_stats_lock;
 };
 
 
@@ -29,10 +29,17 @@
 #include <kernel/terminal/PTYControllerDevice.h>
 #include <kernel/tasking/Process.h>
 
+#define SPLICE_CHUNK_SIZE ((size_t) 65536)
+#define IOV_BOUNCE_SIZE ((size_t) 65536) //How much of a stream readv reads at once
+
 FileDescriptor::FileDescriptor(const kstd::shared_ptr<File>& file): _file(file) {
 	if(file->is_inode())
 		_inode = kstd::static_pointer_cast<InodeFile>(file)->inode();
 
+	//Sockets are streams, so there's nothing to seek
+	if(file->is_socket())
+		_can_seek = false;
+
 	//If we're opening the pty multiplexer, we should open a new PTY controller instead.
 	if(file->is_pty_mux())
 		_file = ((kstd::shared_ptr<PTYMuxDevice>) _file)->create_new();
@@ -77,6 +84,9 @@ FileDescriptor::FileDescriptor(FileDescriptor& other) {
 }
 
 FileDescriptor::~FileDescriptor() {
+	//Stop anything from watching the file through this file descriptor
+	_file->watchers().fd_closed(this);
+
 	//Decrease pipe reader/writer count if applicable
 	if(_file->is_fifo()) {
 		if (_is_fifo_writer) {
@@ -109,6 +119,10 @@ void FileDescriptor::unset_options(int options) {
 	set_options(_options & (~options));
 }
 
+int FileDescriptor::options() const {
+	return _options;
+}
+
 bool FileDescriptor::readable() const {
 	return _readable;
 }
@@ -252,6 +266,198 @@ ssize_t FileDescriptor::write(const uint8_t *buffer, size_t count) {
 	return ret;
 }
 
+ssize_t FileDescriptor::pread(uint8_t* buffer, size_t count, off_t offset) {
+	if(!_readable) return -EBADF;
+	if(!_can_seek || _file->is_fifo()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	return _file->read(*this, offset, buffer, count);
+}
+
+ssize_t FileDescriptor::pwrite(const uint8_t* buffer, size_t count, off_t offset) {
+	if(!_writable) return -EBADF;
+	if(!_can_seek || _file->is_fifo()) return -ESPIPE;
+	if(offset < 0) return -EINVAL;
+	return _file->write(*this, offset, buffer, count);
+}
+
+ssize_t FileDescriptor::readv(const struct iovec* iov, int iovcnt, off_t offset) {
+	if(!_readable) return -EBADF;
+	ssize_t length = iov_length(iov, iovcnt);
+	if(length <= 0) return length;
+	bool positional = offset >= 0;
+	if(positional && (!_can_seek || _file->is_fifo())) return -ESPIPE;
+
+	LOCK(lock);
+	size_t pos = positional ? offset : _seek;
+	ssize_t nread = 0;
+	if(iovcnt == 1 || metadata().is_simple_file()) {
+		//Regular files are read straight into each buffer in turn
+		for(int i = 0; i < iovcnt; i++) {
+			if(!iov[i].iov_len) continue;
+			ssize_t res = _file->read(*this, pos + nread, (uint8_t*) iov[i].iov_base, iov[i].iov_len);
+			if(res < 0 && !nread) return res;
+			if(res <= 0) break;
+			nread += res;
+			if((size_t) res < iov[i].iov_len) break;
+		}
+	} else {
+		//Everything else may care about message boundaries (eg. sockets), so read at once and scatter it. Reading more
+		//could block after a partial read, so only read what fits in the bounce buffer; a short read is fine here.
+		size_t max_message = _file->max_message_size();
+		size_t buffer_size = min((size_t) length, max_message ? max_message : IOV_BOUNCE_SIZE);
+		auto* buffer = new uint8_t[buffer_size];
+		nread = _file->read(*this, pos, buffer, buffer_size);
+		size_t copied = 0;
+		for(int i = 0; i < iovcnt && nread > 0 && copied < (size_t) nread; i++) {
+			size_t ncopy = min(iov[i].iov_len, nread - copied);
+			memcpy(iov[i].iov_base, buffer + copied, ncopy);
+			copied += ncopy;
+		}
+		delete[] buffer;
+	}
+
+	if(!positional && _can_seek && nread > 0) _seek += nread;
+	return nread;
+}
+
+ssize_t FileDescriptor::writev(const struct iovec* iov, int iovcnt, off_t offset) {
+	if(!_writable) return -EBADF;
+	ssize_t length = iov_length(iov, iovcnt);
+	if(length <= 0) return length;
+	bool positional = offset >= 0;
+	if(positional && (!_can_seek || _file->is_fifo())) return -ESPIPE;
+
+	LOCK(lock);
+	if(!positional && _append && _can_seek && metadata().exists()) _seek = metadata().size;
+	size_t pos = positional ? offset : _seek;
+	ssize_t nwrote = 0;
+	if(iovcnt == 1 || metadata().is_simple_file()) {
+		//Regular files are written from each buffer in turn
+		for(int i = 0; i < iovcnt; i++) {
+			if(!iov[i].iov_len) continue;
+			ssize_t res = _file->write(*this, pos + nwrote, (const uint8_t*) iov[i].iov_base, iov[i].iov_len);
+			if(res < 0 && !nwrote) return res;
+			if(res <= 0) break;
+			nwrote += res;
+			if((size_t) res < iov[i].iov_len) break;
+		}
+	} else {
+		//Everything else gets the data gathered through a bounce buffer. Files with message boundaries get exactly one
+		//write so the message arrives whole, and streams are written one chunk at a time.
+		size_t max_message = _file->max_message_size();
+		if(max_message && (size_t) length > max_message)
+			return -EMSGSIZE;
+		size_t buffer_size = max_message ? length : min((size_t) length, IOV_BOUNCE_SIZE);
+		auto* buffer = new uint8_t[buffer_size];
+		int iov_index = 0;
+		size_t iov_offset = 0;
+		while(nwrote < length) {
+			size_t chunk = min((size_t) (length - nwrote), buffer_size);
+			size_t copied = 0;
+			while(copied < chunk) {
+				size_t ncopy = min(iov[iov_index].iov_len - iov_offset, chunk - copied);
+				memcpy(buffer + copied, (const uint8_t*) iov[iov_index].iov_base + iov_offset, ncopy);
+				copied += ncopy;
+				iov_offset += ncopy;
+				if(iov_offset == iov[iov_index].iov_len) {
+					iov_index++;
+					iov_offset = 0;
+				}
+			}
+
+			ssize_t res = _file->write(*this, pos + nwrote, buffer, chunk);
+			if(res < 0 && !nwrote) {
+				nwrote = res;
+				break;
+			}
+			if(res <= 0)
+				break;
+			nwrote += res;
+			if((size_t) res < chunk)
+				break;
+		}
+		delete[] buffer;
+	}
+
+	if(!positional && _can_seek && nwrote > 0) _seek += nwrote;
+	return nwrote;
+}
+
+ssize_t FileDescriptor::iov_length(const struct iovec* iov, int iovcnt) {
+	if(iovcnt < 0 || iovcnt > IOV_MAX) return -EINVAL;
+	size_t length = 0;
+	for(int i = 0; i < iovcnt; i++) {
+		if(iov[i].iov_len > (size_t) SSIZE_MAX - length) return -EINVAL;
+		length += iov[i].iov_len;
+	}
+	return length;
+}
+
+ssize_t FileDescriptor::splice_to(FileDescriptor& out, off_t* in_offset, off_t* out_offset, size_t count) {
+	if(!_readable || !out._writable) return -EBADF;
+	if(count == 0) return 0;
+
+	//Data is moved through a kernel buffer in large chunks, so that block-aligned runs go straight between the caches
+	size_t buffer_size = min(count, SPLICE_CHUNK_SIZE);
+	auto* buffer = new uint8_t[buffer_size];
+	ssize_t total = 0;
+	ssize_t error = 0;
+	while(count) {
+		size_t chunk = min(count, buffer_size);
+
+		//Whatever is read from an unseekable input (like a pipe) is consumed, so it has to be written in full. Blocking
+		//outputs keep taking writes until they're done, but a nonblocking output could stop partway through. So only read
+		//as much as it's guaranteed to take at once: PIPE_BUF bytes when it says it can be written to.
+		if(!in_offset && !_can_seek && out.nonblock()) {
+			if(!out._file->can_write(out)) {
+				error = -EAGAIN;
+				break;
+			}
+			chunk = min(chunk, (size_t) PIPE_BUF);
+		}
+
+		ssize_t nread;
+		{
+			LOCK(lock);
+			nread = _file->read(*this, in_offset ? *in_offset : _seek, buffer, chunk);
+		}
+		if(nread <= 0) {
+			error = nread;
+			break;
+		}
+
+		ssize_t nwrote = 0;
+		{
+			LOCK_N(out.lock, out_locker);
+			if(!out_offset && out._append && out._can_seek && out.metadata().exists()) out._seek = out.metadata().size;
+			off_t write_pos = out_offset ? *out_offset : out._seek;
+			while(nwrote < nread) {
+				ssize_t res = out._file->write(out, write_pos + nwrote, buffer + nwrote, nread - nwrote);
+				if(res <= 0) {
+					error = res;
+					break;
+				}
+				nwrote += res;
+			}
+			if(out_offset) *out_offset += nwrote;
+			else if(out._can_seek) out._seek += nwrote;
+		}
+
+		//Only consume what actually made it to the output
+		{
+			LOCK(lock);
+			if(in_offset) *in_offset += nwrote;
+			else if(_can_seek) _seek += nwrote;
+		}
+
+		total += nwrote;
+		count -= nwrote;
+		if(error || nread < (ssize_t) chunk) break; //Error, EOF, or nothing more buffered in a pipe
+	}
+	delete[] buffer;
+	return total ? total : error;
+}
+
 int FileDescriptor::ioctl(unsigned request, void* argp) {
 	return _file->ioctl(request, argp);
 }
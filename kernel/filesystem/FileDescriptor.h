@@ -38,6 +38,7 @@ public:
 
 	void set_options(int options);
 	void unset_options(int options);
+	int options() const;
 	bool readable() const;
 	bool writable() const;
 	bool append_mode() const;
@@ -58,6 +59,11 @@ public:
 	ssize_t read_dir_entry(DirectoryEntry *buffer);
 	ssize_t read_dir_entries(char *buffer, size_t len);
 	ssize_t write(const uint8_t* buffer, size_t count);
+	ssize_t pread(uint8_t* buffer, size_t count, off_t offset);
+	ssize_t pwrite(const uint8_t* buffer, size_t count, off_t offset);
+	ssize_t readv(const struct iovec* iov, int iovcnt, off_t offset = -1);
+	ssize_t writev(const struct iovec* iov, int iovcnt, off_t offset = -1);
+	ssize_t splice_to(FileDescriptor& out, off_t* in_offset, off_t* out_offset, size_t count);
 	size_t offset() const;
 	int ioctl(unsigned request, void* argp);
 
@@ -81,6 +87,8 @@ private:
 	off_t _seek {0};
 	bool _is_fifo_writer = false;
 
+	ssize_t iov_length(const struct iovec* iov, int iovcnt);
+
 	SpinLock lock;
 };
 
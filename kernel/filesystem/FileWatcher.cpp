@@ -0,0 +1,116 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "FileWatcher.h"
+#include <kernel/interrupt/interrupt.h>
+#include <kernel/tasking/TaskManager.h>
+
+FileWatcher::FileWatcher(FileDescriptor* fd): _fd(fd) {
+
+}
+
+FileWatcher::~FileWatcher() {
+	unwatch();
+}
+
+FileDescriptor* FileWatcher::fd() const {
+	return _fd;
+}
+
+void FileWatcher::unwatch() {
+	Interrupt::NestedDisabler disabler;
+	if(_list)
+		_list->remove(this);
+}
+
+FileWatcherList::~FileWatcherList() {
+	Interrupt::NestedDisabler disabler;
+	while(_head) {
+		auto* watcher = _head;
+		_head = watcher->_next;
+		watcher->_list = nullptr;
+		watcher->_prev = nullptr;
+		watcher->_next = nullptr;
+	}
+}
+
+void FileWatcherList::add(FileWatcher* watcher) {
+	Interrupt::NestedDisabler disabler;
+	if(watcher->_list)
+		return;
+	watcher->_list = this;
+	watcher->_prev = nullptr;
+	watcher->_next = _head;
+	if(_head)
+		_head->_prev = watcher;
+	_head = watcher;
+}
+
+void FileWatcherList::remove(FileWatcher* watcher) {
+	Interrupt::NestedDisabler disabler;
+	if(watcher->_list != this)
+		return;
+	if(watcher->_prev)
+		watcher->_prev->_next = watcher->_next;
+	else
+		_head = watcher->_next;
+	if(watcher->_next)
+		watcher->_next->_prev = watcher->_prev;
+	watcher->_list = nullptr;
+	watcher->_prev = nullptr;
+	watcher->_next = nullptr;
+}
+
+void FileWatcherList::notify() {
+	{
+		Interrupt::NestedDisabler disabler;
+		if(!_head)
+			return;
+		for(auto* watcher = _head; watcher; watcher = watcher->_next)
+			watcher->notify();
+	}
+
+	//If the CPU is idle, switch tasks now so that a waiting thread doesn't have to wait for the next tick
+	TaskManager::yield_if_idle();
+}
+
+void FileWatcherList::fd_closed(FileDescriptor* fd) {
+	//Unlink the watchers of the file descriptor first, and then tell them once interrupts are back on
+	FileWatcher* closed = nullptr;
+	{
+		Interrupt::NestedDisabler disabler;
+		auto* watcher = _head;
+		while(watcher) {
+			auto* next = watcher->_next;
+			if(watcher->_fd == fd) {
+				remove(watcher);
+				watcher->_next = closed;
+				closed = watcher;
+			}
+			watcher = next;
+		}
+	}
+
+	while(closed) {
+		auto* next = closed->_next;
+		closed->_next = nullptr;
+		closed->fd_closed();
+		closed = next;
+	}
+}
@@ -0,0 +1,71 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_FILEWATCHER_H
+#define DUCKOS_FILEWATCHER_H
+
+class FileDescriptor;
+class FileWatcherList;
+
+/**
+ * Something that wants to be told when a file it's watching through a file descriptor may have become readable or
+ * writable. Files notify their watchers with interrupts disabled (sometimes from an interrupt handler), so notify()
+ * must not block, take locks, or allocate memory.
+ */
+class FileWatcher {
+public:
+	explicit FileWatcher(FileDescriptor* fd);
+	virtual ~FileWatcher();
+
+	FileDescriptor* fd() const;
+	//Stops watching the file. Once this returns, notify() won't be called again.
+	void unwatch();
+
+	//Called when the state of the watched file changes.
+	virtual void notify() = 0;
+	//Called after the watcher has been removed because the file descriptor it was watching is being destroyed.
+	virtual void fd_closed() = 0;
+
+private:
+	friend class FileWatcherList;
+	FileDescriptor* _fd;
+	FileWatcherList* _list = nullptr;
+	FileWatcher* _prev = nullptr;
+	FileWatcher* _next = nullptr;
+};
+
+/**
+ * The watchers of a file. This is an intrusive list so that adding, removing, and notifying watchers never allocates.
+ */
+class FileWatcherList {
+public:
+	FileWatcherList() = default;
+	~FileWatcherList();
+
+	void add(FileWatcher* watcher);
+	void remove(FileWatcher* watcher);
+	void notify();
+	void fd_closed(FileDescriptor* fd);
+
+private:
+	FileWatcher* _head = nullptr;
+};
+
+
+#endif //DUCKOS_FILEWATCHER_H
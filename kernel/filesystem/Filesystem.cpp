@@ -37,4 +37,8 @@ ino_t Filesystem::root_inode_id() {
 
 uint8_t Filesystem::fsid() {
 	return _fsid;
+}
+
+bool Filesystem::cache_directory_entries() {
+	return false;
 }
\ No newline at end of file
@@ -33,6 +33,7 @@ public:
 	virtual ResultRet<kstd::shared_ptr<Inode>> get_inode(ino_t id);
 	virtual ino_t root_inode_id();
 	virtual uint8_t fsid();
+	virtual bool cache_directory_entries();
 
 protected:
 	uint8_t _fsid;
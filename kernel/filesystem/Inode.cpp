@@ -20,6 +20,7 @@
 #include "Inode.h"
 #include "Filesystem.h"
 #include "VFS.h"
+#include "DirectoryCache.h"
 #include <kernel/kstd/string.h>
 
 Inode::Inode(Filesystem& fs, ino_t id): fs(fs), id(id) {
@@ -31,7 +32,20 @@ Inode::~Inode() {
 
 ResultRet<kstd::shared_ptr<Inode>> Inode::find(const kstd::string& name) {
 	if(metadata().exists() && !metadata().is_directory()) return -EISDIR;
-	ino_t id  = find_id(name);
+	if(!name.length()) return -ENOENT;
+
+	//Check the directory cache first, and then cache whatever we find (including nothing)
+	ino_t id;
+	bool cache = fs.cache_directory_entries();
+	if(!cache) {
+		id = find_id(name);
+	} else if(!DirectoryCache::inst().lookup(&fs, this->id, name, id)) {
+		//Hold the directory's lock until the result is cached, so an entry added in the meantime can't be replaced by it
+		LOCK(lock);
+		id = find_id(name);
+		DirectoryCache::inst().insert(&fs, this->id, name, id);
+	}
+
 	if(id != 0) {
 		auto ret = fs.get_inode(id);
 		return ret;
@@ -76,3 +90,15 @@ bool Inode::can_read(const FileDescriptor& fd) {
 bool Inode::can_write(const FileDescriptor& fd) {
 	return true;
 }
+
+size_t Inode::max_message_size() {
+	return 0;
+}
+
+Result Inode::sync() {
+	return SUCCESS;
+}
+
+FileWatcherList& Inode::watchers() {
+	return _watchers;
+}
@@ -25,6 +25,7 @@
 #include <kernel/Result.hpp>
 #include <kernel/tasking/SpinLock.h>
 #include "InodeMetadata.h"
+#include "FileWatcher.h"
 #include <kernel/kstd/string.h>
 
 class DirectoryEntry;
@@ -58,13 +59,17 @@ public:
 	virtual void close(FileDescriptor& fd) = 0;
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	virtual size_t max_message_size();
+	virtual Result sync();
 
 	virtual InodeMetadata metadata();
+	FileWatcherList& watchers();
 
 protected:
 	InodeMetadata _metadata;
 	SpinLock lock;
 	bool _exists = true;
+	FileWatcherList _watchers;
 };
 
 
@@ -62,3 +62,10 @@ bool InodeFile::can_write(const FileDescriptor& fd) {
 	return _inode->can_write(fd);
 }
 
+size_t InodeFile::max_message_size() {
+	return _inode->max_message_size();
+}
+
+FileWatcherList& InodeFile::watchers() {
+	return _inode->watchers();
+}
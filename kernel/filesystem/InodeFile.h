@@ -36,6 +36,8 @@ public:
 	void close(FileDescriptor& fd) override;
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	size_t max_message_size() override;
+	FileWatcherList& watchers() override;
 
 private:
 	kstd::shared_ptr<Inode> _inode;
@@ -0,0 +1,445 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "LocalSocket.h"
+#include "VFS.h"
+#include "Inode.h"
+#include "LinkedInode.h"
+#include "InodeMetadata.h"
+#include "FileDescriptor.h"
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/AcceptBlocker.h>
+#include <kernel/tasking/Signal.h>
+
+kstd::vector<LocalSocket::Binding> LocalSocket::_bindings;
+SpinLock LocalSocket::_bindings_lock;
+
+void LocalSocket::Channel::notify_reader() {
+	if(reader)
+		reader->watchers().notify();
+}
+
+void LocalSocket::Channel::notify_writer() {
+	if(writer)
+		writer->watchers().notify();
+}
+
+LocalSocket::Rights::~Rights() {
+	for(size_t i = 0; i < shms.size(); i++)
+		shms[i].region->shm_deref();
+}
+
+LocalSocket::LocalSocket(int type): _type(type) {
+	//Datagram sockets can be sent to as soon as they're bound, so they always have somewhere to receive into
+	if(_type == SOCK_DGRAM) {
+		_recv = kstd::make_shared<Channel>(LOCALSOCKET_BUFFER_SIZE);
+		_recv->reader = this;
+	}
+}
+
+LocalSocket::~LocalSocket() {
+	if(_bound) {
+		LOCK(_bindings_lock);
+		for(size_t i = 0; i < _bindings.size(); i++) {
+			if(_bindings[i].socket == this) {
+				_bindings.erase(i);
+				break;
+			}
+		}
+	}
+
+	if(_send) {
+		LOCK(_send->lock);
+		if(_send->writer == this)
+			_send->writer = nullptr;
+		if(_type == SOCK_STREAM) {
+			_send->write_closed = true;
+			_send->read_blocker.set_ready(true);
+			_send->notify_reader();
+		}
+	}
+
+	//Anything still waiting to be received gets dropped once we're no longer holding the lock, since dropping a file
+	//descriptor can end up closing another socket
+	kstd::vector<kstd::shared_ptr<Rights>> dropped;
+	if(_recv) {
+		LOCK(_recv->lock);
+		_recv->reader = nullptr;
+		_recv->read_closed = true;
+		while(!_recv->ancillary.empty())
+			dropped.push_back(_recv->ancillary.pop_front().rights);
+		_recv->write_blocker.set_ready(true);
+		_recv->notify_writer();
+	}
+}
+
+void LocalSocket::connect_pair(LocalSocket& a, LocalSocket& b) {
+	if(a._type == SOCK_STREAM) {
+		a._recv = kstd::make_shared<Channel>(LOCALSOCKET_BUFFER_SIZE);
+		b._recv = kstd::make_shared<Channel>(LOCALSOCKET_BUFFER_SIZE);
+		a._recv->reader = &a;
+		b._recv->reader = &b;
+	}
+	a._send = b._recv;
+	b._send = a._recv;
+	a._send->writer = &a;
+	b._send->writer = &b;
+}
+
+int LocalSocket::type() const {
+	return _type;
+}
+
+Result LocalSocket::bind(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, mode_t umask) {
+	if(_bound)
+		return -EINVAL;
+
+	//Create the socket file. If something's already there, the address is in use (even if it's a stale socket)
+	auto file_or_err = VFS::inst().open(path, O_CREAT | O_EXCL | O_WRONLY, MODE_SOCKET | (0777 & ~umask), user, cwd);
+	if(file_or_err.is_error())
+		return file_or_err.code() == -EEXIST ? -EADDRINUSE : file_or_err.code();
+
+	Binding binding;
+	auto res = resolve(path, user, cwd, binding);
+	if(res.is_error())
+		return res;
+	binding.socket = this;
+
+	LOCK(_bindings_lock);
+	_bindings.push_back(binding);
+	_bound = true;
+	return SUCCESS;
+}
+
+Result LocalSocket::listen(int backlog) {
+	if(_type != SOCK_STREAM)
+		return -EOPNOTSUPP;
+	if(!_bound || _send)
+		return -EINVAL;
+
+	LOCK(_lock);
+	if(backlog <= 0)
+		backlog = 1;
+	_backlog = backlog > SOMAXCONN ? SOMAXCONN : backlog;
+	_listening = true;
+	return SUCCESS;
+}
+
+ResultRet<kstd::shared_ptr<LocalSocket>> LocalSocket::accept(bool nonblock) {
+	if(_type != SOCK_STREAM)
+		return -EOPNOTSUPP;
+	if(!_listening)
+		return -EINVAL;
+
+	AcceptBlocker blocker(*this);
+	while(true) {
+		{
+			LOCK(_lock);
+			if(!_pending.empty())
+				return _pending.pop_front();
+			if(nonblock)
+				return -EAGAIN;
+		}
+
+		//Wait for something to connect, or for a signal
+		TaskManager::current_thread()->block(blocker);
+		if(blocker.was_interrupted())
+			return -EINTR;
+	}
+}
+
+bool LocalSocket::has_pending() {
+	return !_pending.empty();
+}
+
+Result LocalSocket::connect(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd) {
+	if(_listening || (_type == SOCK_STREAM && _send))
+		return -EISCONN;
+
+	Binding binding;
+	auto res = resolve(path, user, cwd, binding);
+	if(res.is_error())
+		return res;
+
+	LOCK(_bindings_lock);
+	auto* target = find_bound(binding);
+	if(!target)
+		return -ECONNREFUSED;
+	if(target->_type != _type)
+		return -EPROTOTYPE;
+
+	//Connecting a datagram socket just sets where its data goes by default
+	if(_type == SOCK_DGRAM) {
+		if(_send) {
+			LOCK_N(_send->lock, send_locker);
+			if(_send->writer == this)
+				_send->writer = nullptr;
+		}
+		_send = target->_recv;
+		return SUCCESS;
+	}
+
+	LOCK_N(target->_lock, target_locker);
+	if(!target->_listening || target->_pending.size() >= target->_backlog)
+		return -ECONNREFUSED;
+
+	//Make the socket the listener will get back from accept() and queue it up
+	auto server = kstd::make_shared<LocalSocket>(SOCK_STREAM);
+	connect_pair(*this, *server);
+	target->_pending.push_back(server);
+	target->watchers().notify();
+	return SUCCESS;
+}
+
+ssize_t LocalSocket::send(const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock) {
+	if(!_send)
+		return _type == SOCK_DGRAM ? -EDESTADDRREQ : -ENOTCONN;
+	if(_type == SOCK_DGRAM)
+		return send_datagram(*_send, buffer, count, rights, nonblock);
+	return send_stream(buffer, count, rights, nonblock);
+}
+
+ssize_t LocalSocket::send_to(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock) {
+	if(_type != SOCK_DGRAM)
+		return _send ? -EISCONN : -ENOTCONN;
+
+	Binding binding;
+	auto res = resolve(path, user, cwd, binding);
+	if(res.is_error())
+		return res.code();
+
+	kstd::shared_ptr<Channel> channel;
+	{
+		LOCK(_bindings_lock);
+		auto* target = find_bound(binding);
+		if(!target)
+			return -ECONNREFUSED;
+		if(target->_type != SOCK_DGRAM)
+			return -EPROTOTYPE;
+		channel = target->_recv;
+	}
+
+	return send_datagram(*channel, buffer, count, rights, nonblock);
+}
+
+ssize_t LocalSocket::recv(uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>* rights, bool nonblock, int& flags) {
+	if(_listening)
+		return -EINVAL;
+	if(!_recv)
+		return -ENOTCONN;
+
+	//The rights we take are only handed over (or dropped) after we let go of the lock
+	auto& channel = *_recv;
+	kstd::shared_ptr<Rights> received;
+	ssize_t ret;
+	while(true) {
+		{
+			LOCK(channel.lock);
+			if(!channel.data.empty()) {
+				if(_type == SOCK_DGRAM)
+					ret = read_datagram(channel, buffer, count, received, flags);
+				else
+					ret = read_stream(channel, buffer, count, received);
+				channel.write_blocker.set_ready(true);
+				channel.notify_writer();
+				break;
+			}
+
+			if(channel.write_closed) {
+				ret = 0;
+				break;
+			}
+			if(nonblock) {
+				ret = -EAGAIN;
+				break;
+			}
+			channel.read_blocker.set_ready(false);
+		}
+
+		//Wait for something to be sent or for the other end to close
+		TaskManager::current_thread()->block(channel.read_blocker);
+	}
+
+	if(rights)
+		*rights = received;
+	return ret;
+}
+
+ssize_t LocalSocket::read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) {
+	int flags = 0;
+	return recv(buffer, count, nullptr, fd.nonblock(), flags);
+}
+
+ssize_t LocalSocket::write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) {
+	auto ret = send(buffer, count, kstd::shared_ptr<Rights>(nullptr), fd.nonblock());
+	if(ret == -EPIPE)
+		TaskManager::current_process()->kill(SIGPIPE);
+	return ret;
+}
+
+bool LocalSocket::is_socket() {
+	return true;
+}
+
+bool LocalSocket::can_read(const FileDescriptor& fd) {
+	if(_listening)
+		return !_pending.empty();
+	if(!_recv)
+		return false;
+	return !_recv->data.empty() || _recv->write_closed;
+}
+
+bool LocalSocket::can_write(const FileDescriptor& fd) {
+	if(!_send)
+		return false;
+	if(_type == SOCK_DGRAM)
+		return _send->data.space() >= sizeof(size_t) || _send->read_closed;
+	return _send->data.space() || _send->read_closed;
+}
+
+size_t LocalSocket::max_message_size() {
+	if(_type != SOCK_DGRAM)
+		return 0;
+	return LOCALSOCKET_BUFFER_SIZE - sizeof(size_t);
+}
+
+Result LocalSocket::resolve(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, Binding& binding) {
+	auto inode_or_err = VFS::inst().resolve_path(path, cwd, user);
+	if(inode_or_err.is_error())
+		return inode_or_err.code();
+	auto inode = inode_or_err.value()->inode();
+	if(!IS_SOCKET(inode->metadata().mode))
+		return -ECONNREFUSED;
+	binding.fs = &inode->fs;
+	binding.id = inode->id;
+	binding.socket = nullptr;
+	return SUCCESS;
+}
+
+LocalSocket* LocalSocket::find_bound(const Binding& binding) {
+	for(size_t i = 0; i < _bindings.size(); i++) {
+		if(_bindings[i].fs == binding.fs && _bindings[i].id == binding.id)
+			return _bindings[i].socket;
+	}
+	return nullptr;
+}
+
+ssize_t LocalSocket::send_stream(const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock) {
+	//Rights have to be attached to at least one byte so the receiver has something to read them with
+	if(rights && !count)
+		return -EINVAL;
+
+	auto& channel = *_send;
+	bool attached = !rights;
+	size_t nwritten = 0;
+	while(nwritten < count) {
+		{
+			LOCK(channel.lock);
+			if(channel.read_closed)
+				break;
+
+			if(channel.data.space()) {
+				if(!attached) {
+					channel.ancillary.push_back({channel.write_pos, rights});
+					attached = true;
+				}
+				size_t pushed = channel.data.push(buffer + nwritten, count - nwritten);
+				nwritten += pushed;
+				channel.write_pos += pushed;
+				channel.read_blocker.set_ready(true);
+				channel.notify_reader();
+				continue;
+			}
+
+			if(nonblock)
+				break;
+			channel.write_blocker.set_ready(false);
+		}
+
+		//Wait for the other end to read or close
+		TaskManager::current_thread()->block(channel.write_blocker);
+	}
+
+	if(nwritten)
+		return nwritten;
+	if(channel.read_closed)
+		return -EPIPE;
+	return count ? -EAGAIN : 0;
+}
+
+ssize_t LocalSocket::send_datagram(Channel& channel, const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock) {
+	size_t record_size = sizeof(size_t) + count;
+	while(true) {
+		{
+			LOCK(channel.lock);
+			if(channel.read_closed)
+				return -ECONNREFUSED;
+			if(record_size > channel.data.capacity())
+				return -EMSGSIZE;
+
+			//Datagrams are written whole, with their length in front of them
+			if(channel.data.space() >= record_size) {
+				if(rights)
+					channel.ancillary.push_back({channel.write_pos, rights});
+				channel.data.push(&count, sizeof(size_t));
+				channel.data.push(buffer, count);
+				channel.write_pos += record_size;
+				channel.read_blocker.set_ready(true);
+				channel.notify_reader();
+				return count;
+			}
+
+			if(nonblock)
+				return -EAGAIN;
+			channel.write_blocker.set_ready(false);
+		}
+
+		//Wait for the receiver to make room
+		TaskManager::current_thread()->block(channel.write_blocker);
+	}
+}
+
+size_t LocalSocket::read_stream(Channel& channel, uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>& rights) {
+	//If there are rights attached to the next byte, take them
+	if(!channel.ancillary.empty() && channel.ancillary.front().position == channel.read_pos)
+		rights = channel.ancillary.pop_front().rights;
+
+	//Don't read past the next byte that has rights attached, so that they're delivered with the data they were sent with
+	if(!channel.ancillary.empty() && channel.ancillary.front().position - channel.read_pos < count)
+		count = channel.ancillary.front().position - channel.read_pos;
+
+	size_t nread = channel.data.pop(buffer, count);
+	channel.read_pos += nread;
+	return nread;
+}
+
+size_t LocalSocket::read_datagram(Channel& channel, uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>& rights, int& flags) {
+	if(!channel.ancillary.empty() && channel.ancillary.front().position == channel.read_pos)
+		rights = channel.ancillary.pop_front().rights;
+
+	//Whatever part of the datagram doesn't fit in the buffer is discarded
+	size_t length;
+	channel.data.pop(&length, sizeof(size_t));
+	size_t nread = channel.data.pop(buffer, length < count ? length : count);
+	channel.data.skip(length - nread);
+	channel.read_pos += sizeof(size_t) + length;
+	if(nread < length)
+		flags |= MSG_TRUNC;
+	return nread;
+}
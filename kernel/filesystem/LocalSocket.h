@@ -0,0 +1,149 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LOCALSOCKET_H
+#define DUCKOS_LOCALSOCKET_H
+
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/filesystem/File.h>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
+#include <kernel/kstd/ring_buffer.hpp>
+#include <kernel/kstd/queue.hpp>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/kstd/string.h>
+#include <kernel/Result.hpp>
+
+#define LOCALSOCKET_BUFFER_SIZE (PAGE_SIZE * 16)
+#define LOCALSOCKET_MAX_RIGHTS 64
+
+class FileDescriptor;
+class LinkedInode;
+class Filesystem;
+class User;
+
+/**
+ * An AF_UNIX socket. Stream sockets are a pair of ring buffers, one for each direction. Datagram sockets each have one
+ * ring buffer that every sender writes records into. File descriptors and shared memory regions can be sent alongside
+ * data, and are handed to the receiver when it reads the data they were sent with.
+ */
+class LocalSocket: public File {
+public:
+	/**
+	 * A shared memory region being sent. The sender's permission to share it is checked when it's sent, and the
+	 * physical region is referenced until the receiver is allowed access to it.
+	 */
+	struct SharedRegion {
+		int id;
+		int perms;
+		MemoryRegion* region;
+	};
+
+	/**
+	 * Rights sent along with some data (SCM_RIGHTS and SCM_SHM).
+	 */
+	class Rights {
+	public:
+		Rights() = default;
+		Rights(const Rights& other) = delete;
+		~Rights();
+
+		kstd::vector<kstd::shared_ptr<FileDescriptor>> fds;
+		kstd::vector<SharedRegion> shms;
+	};
+
+	explicit LocalSocket(int type);
+	~LocalSocket() override;
+
+	static void connect_pair(LocalSocket& a, LocalSocket& b);
+
+	int type() const;
+	Result bind(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, mode_t umask);
+	Result listen(int backlog);
+	ResultRet<kstd::shared_ptr<LocalSocket>> accept(bool nonblock);
+	bool has_pending();
+	Result connect(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd);
+	ssize_t send(const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock);
+	ssize_t send_to(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock);
+	ssize_t recv(uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>* rights, bool nonblock, int& flags);
+
+	//File
+	ssize_t read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) override;
+	bool is_socket() override;
+	bool can_read(const FileDescriptor& fd) override;
+	bool can_write(const FileDescriptor& fd) override;
+	size_t max_message_size() override;
+
+private:
+	struct Ancillary {
+		uint64_t position;
+		kstd::shared_ptr<Rights> rights;
+	};
+
+	/**
+	 * One direction of a connection. Positions count every byte ever written to the buffer, so ancillary data can be
+	 * matched up with the byte it was sent with.
+	 */
+	class Channel {
+	public:
+		explicit Channel(size_t capacity): data(capacity) {}
+		void notify_reader();
+		void notify_writer();
+
+		kstd::ring_buffer data;
+		kstd::queue<Ancillary> ancillary;
+		uint64_t read_pos = 0;
+		uint64_t write_pos = 0;
+		bool write_closed = false;
+		bool read_closed = false;
+		LocalSocket* reader = nullptr;
+		LocalSocket* writer = nullptr;
+		BooleanBlocker read_blocker;
+		BooleanBlocker write_blocker;
+		SpinLock lock;
+	};
+
+	struct Binding {
+		Filesystem* fs;
+		ino_t id;
+		LocalSocket* socket;
+	};
+
+	static Result resolve(const kstd::string& path, const User& user, const kstd::shared_ptr<LinkedInode>& cwd, Binding& binding);
+	static LocalSocket* find_bound(const Binding& binding);
+	ssize_t send_stream(const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock);
+	static ssize_t send_datagram(Channel& channel, const uint8_t* buffer, size_t count, const kstd::shared_ptr<Rights>& rights, bool nonblock);
+	static size_t read_stream(Channel& channel, uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>& rights);
+	static size_t read_datagram(Channel& channel, uint8_t* buffer, size_t count, kstd::shared_ptr<Rights>& rights, int& flags);
+
+	static kstd::vector<Binding> _bindings;
+	static SpinLock _bindings_lock;
+
+	int _type;
+	bool _bound = false;
+	bool _listening = false;
+	size_t _backlog = 0;
+	kstd::shared_ptr<Channel> _send; //For a datagram socket, this is the receive channel of the socket it's connected to
+	kstd::shared_ptr<Channel> _recv;
+	kstd::queue<kstd::shared_ptr<LocalSocket>> _pending;
+	SpinLock _lock;
+};
+
+#endif //DUCKOS_LOCALSOCKET_H
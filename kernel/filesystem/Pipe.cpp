@@ -22,7 +22,7 @@
 #include <kernel/tasking/TaskManager.h>
 #include <kernel/filesystem/FileDescriptor.h>
 
-Pipe::Pipe(): _queue(PIPE_SIZE) {}
+Pipe::Pipe(): _buffer(PIPE_DEFAULT_SIZE) {}
 
 Pipe::~Pipe() = default;
 
@@ -35,50 +35,104 @@ void Pipe::add_writer() {
 }
 
 void Pipe::remove_reader() {
+	LOCK(_lock);
 	_readers--;
+	if(!_readers) {
+		//Wake up any writers so they can get SIGPIPE
+		_write_blocker.set_ready(true);
+		watchers().notify();
+	}
 }
 
 void Pipe::remove_writer() {
+	LOCK(_lock);
 	_writers--;
 	if(!_writers) {
-		_blocker.set_ready(true);
+		_read_blocker.set_ready(true);
+		watchers().notify();
 	}
 }
 
-ssize_t Pipe::read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) {
-	if(!_writers && _queue.empty()) return 0;
-	if(!_blocker.is_ready())
-		TaskManager::current_thread()->block(_blocker);
-	LOCK(_lock);
-	if(count > _queue.size())
-		count = _queue.size();
-	for(size_t i = 0; i < count; i++)
-		buffer[i] = _queue.pop_front();
-	if(_queue.empty() && _writers)
-		_blocker.set_ready(false);
-	return count;
+size_t Pipe::capacity() {
+	return _buffer.capacity();
 }
 
-ssize_t Pipe::write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) {
-	//TODO: Block writes bigger than available space
-	if(_readers == 0) {
-		TaskManager::current_process()->kill(SIGPIPE);
-		return -EPIPE;
-	}
+ResultRet<size_t> Pipe::set_capacity(size_t capacity) {
+	if(capacity > PIPE_MAX_SIZE)
+		return -EPERM;
+	if(capacity < PAGE_SIZE)
+		capacity = PAGE_SIZE;
+	capacity = ((capacity + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
 
 	LOCK(_lock);
+	if(!_buffer.resize(capacity))
+		return -EBUSY;
+
+	_write_blocker.set_ready(_buffer.space());
+	watchers().notify();
+	return capacity;
+}
+
+ssize_t Pipe::read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) {
+	if(!count)
+		return 0;
 
-	size_t nwrote = 0;
-	bool flag = true;
-	while(nwrote < count && flag) {
-		flag = _queue.push_back(buffer[nwrote]);
-		nwrote++;
+	while(true) {
+		{
+			LOCK(_lock);
+			if(!_buffer.empty()) {
+				count = _buffer.pop(buffer, count);
+				_write_blocker.set_ready(true);
+				watchers().notify();
+				return count;
+			}
+
+			if(!_writers)
+				return 0;
+			if(fd.nonblock())
+				return -EAGAIN;
+			_read_blocker.set_ready(false);
+		}
+
+		//Wait for a writer to put something in the pipe or for the writers to close
+		TaskManager::current_thread()->block(_read_blocker);
 	}
+}
 
-	if(nwrote)
-		_blocker.set_ready(true);
+ssize_t Pipe::write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) {
+	size_t nwritten = 0;
+	while(nwritten < count) {
+		{
+			LOCK(_lock);
+			if(!_readers)
+				break;
 
-	return nwrote;
+			//Writes of up to PIPE_BUF bytes have to be written all at once, so wait until there's room for them
+			size_t space = _buffer.space();
+			size_t remaining = count - nwritten;
+			if(space && (count > PIPE_BUF || space >= remaining)) {
+				nwritten += _buffer.push(buffer + nwritten, remaining);
+				_read_blocker.set_ready(true);
+				watchers().notify();
+				continue;
+			}
+
+			if(fd.nonblock())
+				break;
+			_write_blocker.set_ready(false);
+		}
+
+		//Wait for a reader to make room in the pipe or for the readers to close
+		TaskManager::current_thread()->block(_write_blocker);
+	}
+
+	if(nwritten)
+		return nwritten;
+	if(!_readers) {
+		TaskManager::current_process()->kill(SIGPIPE);
+		return -EPIPE;
+	}
+	return count ? -EAGAIN : 0;
 }
 
 bool Pipe::is_fifo() {
@@ -86,5 +140,9 @@ bool Pipe::is_fifo() {
 }
 
 bool Pipe::can_read(const FileDescriptor& fd) {
-	return !_queue.empty() && !fd.is_fifo_writer();
+	return (!_buffer.empty() || !_writers) && !fd.is_fifo_writer();
+}
+
+bool Pipe::can_write(const FileDescriptor& fd) {
+	return (_buffer.space() >= PIPE_BUF || !_readers) && fd.is_fifo_writer();
 }
@@ -22,10 +22,12 @@
 
 #include <kernel/memory/MemoryManager.h>
 #include <kernel/filesystem/File.h>
-#include <kernel/kstd/circular_queue.hpp>
 #include <kernel/tasking/SpinLock.h>
+#include <kernel/Result.hpp>
+#include <kernel/kstd/ring_buffer.hpp>
 
-#define PIPE_SIZE PAGE_SIZE
+#define PIPE_DEFAULT_SIZE (PAGE_SIZE * 16)
+#define PIPE_MAX_SIZE (1024 * 1024)
 
 class Pipe: public File {
 public:
@@ -37,18 +39,22 @@ public:
 	void add_writer();
 	void remove_reader();
 	void remove_writer();
+	size_t capacity();
+	ResultRet<size_t> set_capacity(size_t capacity);
 
 	//File
 	ssize_t read(FileDescriptor& fd, size_t offset, uint8_t* buffer, size_t count) override;
 	ssize_t write(FileDescriptor& fd, size_t offset, const uint8_t* buffer, size_t count) override;
 	bool is_fifo() override;
 	bool can_read(const FileDescriptor& fd) override;
+	bool can_write(const FileDescriptor& fd) override;
 
 private:
-	kstd::circular_queue<uint8_t> _queue;
+	kstd::ring_buffer _buffer;
 	size_t _readers = 0;
 	size_t _writers = 0;
-	BooleanBlocker _blocker;
+	BooleanBlocker _read_blocker;
+	BooleanBlocker _write_blocker;
 	SpinLock _lock;
 };
 
@@ -65,29 +65,27 @@ ResultRet<kstd::shared_ptr<LinkedInode>> VFS::resolve_path(kstd::string path, co
 
 	auto current_inode = path[0] == '/' ? _root_ref : _base;
 	kstd::string part;
-	if(path[0] == '/')
-		path = path.substr(1, path.length() - 1);
 
-	while(path[0] != '\0') {
+	//Walk through the components of the path without copying the rest of the path each time
+	size_t pos = path[0] == '/' ? 1 : 0;
+	while(pos < path.length()) {
 		auto parent = current_inode;
 		if(!parent->inode()->metadata().is_directory()) return -ENOTDIR;
 		if(!parent->inode()->metadata().can_execute(user)) return -EACCES;
 
-		size_t slash_index = path.find('/');
-		if(slash_index != -1) {
-			part = path.substr(0, slash_index);
-			path = path.substr(slash_index + 1, path.length() - slash_index - 1);
-		} else {
-			part = path;
-			path = "";
-		}
+		size_t slash_index = path.find('/', pos);
+		size_t part_end = slash_index == -1 ? path.length() : slash_index;
+		part = path.substr(pos, part_end - pos);
+		pos = slash_index == -1 ? path.length() : slash_index + 1;
+		bool last_part = pos >= path.length();
 
 		if(part == "..") {
 			if(current_inode->parent()) {
 				current_inode = kstd::shared_ptr<LinkedInode>(current_inode->parent());
 			}
 			continue;
-		} else if(part == ".") {
+		} else if(!part.length() || part == ".") {
+			//Skip empty components (from repeated slashes) along with "."
 			continue;
 		}
 
@@ -95,7 +93,7 @@ ResultRet<kstd::shared_ptr<LinkedInode>> VFS::resolve_path(kstd::string path, co
 
 		if(!child_inode_or_err.is_error()) {
 			if(child_inode_or_err.value()->metadata().is_symlink()) {
-				if(!path.length()) {
+				if(last_part) {
 					if (options & O_NOFOLLOW)
 						return -ELOOP;
 					if (options & O_INTERNAL_RETLINK) {
@@ -105,9 +103,9 @@ ResultRet<kstd::shared_ptr<LinkedInode>> VFS::resolve_path(kstd::string path, co
 				}
 
 				auto link_or_err = child_inode_or_err.value()->resolve_link(current_inode, user, parent_storage, options, recursion_level + 1);
-				if(!path.length()) return link_or_err;
+				if(last_part) return link_or_err;
 				if(link_or_err.is_error()) return link_or_err;
-				return resolve_path(path, link_or_err.value(), user, parent_storage, options, recursion_level + 1);
+				return resolve_path(path.substr(pos, path.length() - pos), link_or_err.value(), user, parent_storage, options, recursion_level + 1);
 			}
 
 			current_inode = kstd::shared_ptr<LinkedInode>(new LinkedInode(child_inode_or_err.value(), part, parent));
@@ -121,7 +119,7 @@ ResultRet<kstd::shared_ptr<LinkedInode>> VFS::resolve_path(kstd::string path, co
 				current_inode = kstd::make_shared<LinkedInode>(guest_inode_or_err.value(), part, parent);
 			}
 		} else {
-			if(parent_storage && path.find('/') == -1) {
+			if(parent_storage && path.find('/', pos) == -1) {
 				*parent_storage = current_inode;
 			}
 			return child_inode_or_err.code();
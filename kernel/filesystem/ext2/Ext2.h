@@ -42,8 +42,13 @@
 #define EXT2_IMMUTABLE 0x10
 #define EXT2_APPEND_ONLY 0x20
 #define EXT2_DUMP_EXCLUDE 0x40
+#define EXT2_INDEX 0x1000
 #define EXT2_JOURNAL_FILE 0x40000
 
+//superblock flags
+#define EXT2_FLAGS_SIGNED_HASH 0x1
+#define EXT2_FLAGS_UNSIGNED_HASH 0x2
+
 #define EXT2_FT_UNKNOWN	0
 #define EXT2_FT_REG_FILE 1
 #define EXT2_FT_DIR	2
@@ -53,6 +58,9 @@
 #define EXT2_FT_SOCK 6
 #define EXT2_FT_SYMLINK 7
 
+//Number of extra blocks reserved past the end of a file when it grows, so that appends stay contiguous
+#define EXT2_PREALLOC_BLOCKS 8
+
 #define ALLOC_BLOCKBUF(buf, blocksize) \
 	bool __alloced_blockbuf = buf == nullptr;\
 	if(__alloced_blockbuf) buf = new uint8_t[blocksize];
@@ -105,7 +113,21 @@ typedef struct __attribute__((packed)) ext2_superblock {
 	uint32_t journal_inode;
 	uint32_t journal_device;
 	uint32_t orphan_inode_head;
-	uint8_t extra[276];
+	uint32_t hash_seed[4];
+	uint8_t default_hash_version;
+	uint8_t journal_backup_type;
+	uint16_t descriptor_size;
+	uint32_t default_mount_options;
+	uint32_t first_meta_block_group;
+	uint32_t mkfs_time;
+	uint32_t journal_blocks[17];
+	uint32_t total_blocks_high;
+	uint32_t superuser_blocks_high;
+	uint32_t free_blocks_high;
+	uint16_t min_extra_inode_size;
+	uint16_t want_extra_inode_size;
+	uint32_t flags;
+	uint8_t extra[156];
 } ext2_superblock;
 
 typedef struct __attribute__((packed)) ext2_block_group_descriptor {
@@ -125,4 +147,9 @@ typedef struct __attribute__((packed)) ext2_directory {
 	uint8_t type;
 } ext2_directory;
 
+//The size a directory entry with a name of the given length takes up (4-byte aligned)
+static inline size_t dir_entry_size(size_t name_length) {
+	return (sizeof(ext2_directory) + name_length + 3) & ~3u;
+}
+
 #endif
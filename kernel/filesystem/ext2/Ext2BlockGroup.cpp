@@ -20,6 +20,8 @@
 #include "Ext2BlockGroup.h"
 #include "Ext2.h"
 #include "Ext2Filesystem.h"
+#include <kernel/kstd/kstdlib.h>
+#include <kernel/kstd/cstring.h>
 
 Ext2BlockGroup::Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num): fs(fs), num(num) {
 	auto* buf = new ext2_block_group_descriptor;
@@ -33,6 +35,11 @@ Ext2BlockGroup::Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num): fs(fs), num(nu
 	delete buf;
 }
 
+Ext2BlockGroup::~Ext2BlockGroup() {
+	delete[] _block_bitmap;
+	delete[] _reserved_bitmap;
+}
+
 void Ext2BlockGroup::write() {
 	auto* buf = new ext2_block_group_descriptor;
 	buf->block_usage_bitmap = block_bitmap_block;
@@ -43,8 +50,118 @@ void Ext2BlockGroup::write() {
 	buf->num_directories = num_directories;
 	fs->write_block_group_raw(num, buf);
 	delete buf;
+	dirty = false;
 }
 
 uint32_t Ext2BlockGroup::first_block() {
 	return num * fs->superblock.blocks_per_group + (fs->block_size() == 1024 ? 1 : 0);
 }
+
+uint32_t Ext2BlockGroup::num_blocks() {
+	//The last group may be smaller than the others
+	return min(fs->superblock.blocks_per_group, fs->superblock.total_blocks - first_block());
+}
+
+ResultRet<uint8_t*> Ext2BlockGroup::block_bitmap() {
+	if(_block_bitmap)
+		return _block_bitmap;
+
+	auto* bitmap = new uint8_t[fs->block_size()];
+	Result res = fs->read_block(block_bitmap_block, bitmap);
+	if(res.is_error()) {
+		delete[] bitmap;
+		return res;
+	}
+	_block_bitmap = bitmap;
+	return _block_bitmap;
+}
+
+void Ext2BlockGroup::set_block_used(uint32_t index, bool used) {
+	//The bitmap must have been loaded with block_bitmap() first
+	Ext2Filesystem::set_bitmap_bit(_block_bitmap, index, used);
+	_block_bitmap_dirty = true;
+}
+
+uint32_t Ext2BlockGroup::find_free_run(uint32_t goal, uint32_t want, uint32_t& run_length) {
+	//Finds the first run of at least want free blocks at or after goal (wrapping around), or the longest run otherwise.
+	//The bitmap must have been loaded with block_bitmap() first
+	uint32_t nblocks = num_blocks();
+	uint32_t best_start = 0;
+	run_length = 0;
+	if(goal >= nblocks)
+		goal = 0;
+
+	uint32_t checked = 0;
+	uint32_t index = goal;
+	while(checked < nblocks) {
+		//Skip over fully used bytes quickly
+		uint8_t used_byte = _block_bitmap[index / 8] | (_reserved_bitmap ? _reserved_bitmap[index / 8] : 0);
+		if(index % 8 == 0 && index + 8 <= nblocks && used_byte == 0xFF) {
+			checked += 8;
+			index = (index + 8) % nblocks;
+			continue;
+		}
+
+		if(!is_block_available(index)) {
+			checked++;
+			index = (index + 1) % nblocks;
+			continue;
+		}
+
+		//Measure the free run starting here (runs don't wrap around the end of the group)
+		uint32_t start = index;
+		uint32_t length = 0;
+		while(index < nblocks && checked < nblocks && is_block_available(index)) {
+			length++;
+			checked++;
+			index++;
+		}
+		index %= nblocks;
+
+		if(length > run_length) {
+			best_start = start;
+			run_length = length;
+			if(run_length >= want)
+				break;
+		}
+	}
+
+	return best_start;
+}
+
+bool Ext2BlockGroup::is_block_available(uint32_t index) {
+	if(Ext2Filesystem::get_bitmap_bit(_block_bitmap, index))
+		return false;
+	return !_reserved_bitmap || !Ext2Filesystem::get_bitmap_bit(_reserved_bitmap, index);
+}
+
+void Ext2BlockGroup::set_block_reserved(uint32_t index, bool reserved) {
+	if(!_reserved_bitmap) {
+		if(!reserved)
+			return;
+		_reserved_bitmap = new uint8_t[fs->block_size()];
+		memset(_reserved_bitmap, 0, fs->block_size());
+	}
+
+	if(Ext2Filesystem::get_bitmap_bit(_reserved_bitmap, index) == reserved)
+		return;
+	Ext2Filesystem::set_bitmap_bit(_reserved_bitmap, index, reserved);
+	if(reserved)
+		reserved_blocks++;
+	else
+		reserved_blocks--;
+}
+
+Result Ext2BlockGroup::flush() {
+	if(_block_bitmap && _block_bitmap_dirty) {
+		Result res = fs->write_metadata_block(block_bitmap_block, _block_bitmap);
+		if(res.is_error())
+			return res;
+		_block_bitmap_dirty = false;
+	}
+
+	if(dirty)
+		write();
+
+	return SUCCESS;
+}
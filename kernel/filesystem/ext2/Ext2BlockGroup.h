@@ -21,13 +21,28 @@
 #define DUCKOS_EXT2BLOCKGROUP_H
 
 #include <kernel/kstd/unix_types.h>
+#include <kernel/Result.hpp>
 
 class Ext2Filesystem;
 class Ext2BlockGroup {
 public:
 	Ext2BlockGroup(Ext2Filesystem* fs, uint32_t num);
+	~Ext2BlockGroup();
 	void write();
 	uint32_t first_block();
+	uint32_t num_blocks();
+
+	//Block bitmap (cached in memory, and only written out by flush() when changed)
+	ResultRet<uint8_t*> block_bitmap();
+	void set_block_used(uint32_t index, bool used);
+	uint32_t find_free_run(uint32_t goal, uint32_t want, uint32_t& run_length);
+	Result flush();
+
+	//Block reservations (only kept in memory, so a crash can't leak them). Reserved blocks are free on disk, but
+	//won't be handed out by find_free_run(). The bitmap must have been loaded with block_bitmap() first.
+	bool is_block_available(uint32_t index);
+	void set_block_reserved(uint32_t index, bool reserved);
+	uint32_t available_blocks() { return free_blocks > reserved_blocks ? free_blocks - reserved_blocks : 0; }
 
 	Ext2Filesystem* fs;
 	uint32_t num;
@@ -37,6 +52,13 @@ public:
 	uint16_t free_blocks;
 	uint16_t free_inodes;
 	uint16_t num_directories;
+	uint16_t reserved_blocks = 0;
+	bool dirty = false;
+
+private:
+	uint8_t* _block_bitmap = nullptr;
+	uint8_t* _reserved_bitmap = nullptr;
+	bool _block_bitmap_dirty = false;
 };
 
 
@@ -20,6 +20,7 @@
 #include "Ext2Filesystem.h"
 #include "Ext2Inode.h"
 #include "Ext2BlockGroup.h"
+#include "Ext2Journal.h"
 #include <kernel/filesystem/FileDescriptor.h>
 #include <kernel/kstd/cstring.h>
 
@@ -28,6 +29,12 @@ Ext2Filesystem::Ext2Filesystem(const kstd::shared_ptr<FileDescriptor>& file) : F
 }
 
 Ext2Filesystem::~Ext2Filesystem() {
+	if(journal) {
+		//Once everything in the log makes it to its home location, the journal clears the RECOVER flag itself
+		journal->checkpoint();
+		delete journal;
+		journal = nullptr;
+	}
 	if(block_groups) {
 		for(uint32_t i = 0; i < num_block_groups; i++) {
 			if (block_groups[i]) delete block_groups[i];
@@ -47,6 +54,11 @@ void Ext2Filesystem::init() {
 	inodes_per_block = block_size()/superblock.inode_size;
 	block_pointers_per_block = block_size() / sizeof(uint32_t);
 	block_groups = new Ext2BlockGroup*[num_block_groups] {nullptr};
+
+	//Replay and start using the ext3 journal, if there is one
+	journal = Ext2Journal::load(*this);
+	if(journal)
+		printf("[ext2] Journaling enabled.\n");
 }
 
 bool Ext2Filesystem::probe(FileDescriptor& file){
@@ -66,7 +78,25 @@ void Ext2Filesystem::read_superblock(ext2_superblock *sb){
 }
 
 void Ext2Filesystem::write_superblock() {
-	write_logical_block(2, (uint8_t*)&superblock);
+	if(!journal) {
+		write_logical_block(2, (uint8_t*)&superblock);
+		return;
+	}
+
+	//The superblock is 1024 bytes into the disk, so patch it into the filesystem block it's in and journal that
+	auto* block_buf = new uint8_t[block_size()];
+	uint32_t block = 1024 / block_size();
+	if(read_block(block, block_buf).is_success()) {
+		memcpy(block_buf + 1024 % block_size(), &superblock, logical_block_size());
+		write_metadata_block(block, block_buf);
+	}
+	delete[] block_buf;
+}
+
+Result Ext2Filesystem::write_metadata_block(uint32_t block, const uint8_t* buffer) {
+	if(journal)
+		return journal->write_block(block, buffer);
+	return write_block(block, buffer);
 }
 
 Inode* Ext2Filesystem::get_inode_rawptr(ino_t id) {
@@ -74,6 +104,7 @@ Inode* Ext2Filesystem::get_inode_rawptr(ino_t id) {
 }
 
 ResultRet<kstd::shared_ptr<Ext2Inode>> Ext2Filesystem::allocate_inode(mode_t mode, uid_t uid, gid_t gid, size_t size, ino_t parent) {
+	Ext2Transaction transaction(*this);
 	ext2lock.acquire();
 
 	//Find a block group to house the inode
@@ -113,7 +144,7 @@ ResultRet<kstd::shared_ptr<Ext2Inode>> Ext2Filesystem::allocate_inode(mode_t mod
 	}
 
 	//Write the inode bitmap
-	write_block(group.inode_bitmap_block, inode_bitmap);
+	write_metadata_block(group.inode_bitmap_block, inode_bitmap);
 	delete[] inode_bitmap;
 
 	//Didn't find a free inode, so the free inode count was wrong
@@ -161,6 +192,7 @@ ResultRet<kstd::shared_ptr<Ext2Inode>> Ext2Filesystem::allocate_inode(mode_t mod
 }
 
 Result Ext2Filesystem::free_inode(Ext2Inode& ino) {
+	Ext2Transaction transaction(*this);
 	ext2lock.acquire();
 
 	//Update the inode bitmap and free inodes in the block group
@@ -175,7 +207,7 @@ Result Ext2Filesystem::free_inode(Ext2Inode& ino) {
 	}
 
 	set_bitmap_bit(block_buf, ino.index(), false);
-	res = write_block(bg->inode_bitmap_block, block_buf);
+	res = write_metadata_block(bg->inode_bitmap_block, block_buf);
 	if(res.is_error()) {
 		delete[] block_buf;
 		printf("WARNING: Error while writing bitmap for block group %d!\n", ino.block_group());
@@ -197,7 +229,7 @@ Result Ext2Filesystem::free_inode(Ext2Inode& ino) {
 	auto* inodeRaw = (Ext2Inode::Raw*) block_buf;
 	inodeRaw += ino.index() % inodes_per_block;
 	inodeRaw->dtime = 0x42069;
-	write_block(bg->inode_table_block + ino.block(), block_buf);
+	write_metadata_block(bg->inode_table_block + ino.block(), block_buf);
 
 	//Update superblock
 	superblock.free_inodes++;
@@ -210,6 +242,10 @@ Result Ext2Filesystem::free_inode(Ext2Inode& ino) {
 	return SUCCESS;
 }
 
+bool Ext2Filesystem::cache_directory_entries() {
+	return true;
+}
+
 char *Ext2Filesystem::name() {
 	return "EXT2";
 }
@@ -240,86 +276,97 @@ Result Ext2Filesystem::write_block_group_raw(uint32_t block_group, const ext2_bl
 	auto* d = (ext2_block_group_descriptor*) block_buf;
 	d += block_group % (block_size() / sizeof(ext2_block_group_descriptor));
 	memcpy(d, buffer, sizeof(ext2_block_group_descriptor));
-	auto write_successful = write_block(2 + (block_group * sizeof(ext2_block_group_descriptor)) / block_size(), block_buf);
+	auto write_successful = write_metadata_block(2 + (block_group * sizeof(ext2_block_group_descriptor)) / block_size(), block_buf);
 
 	FREE_BLOCKBUF(block_buf);
 	return write_successful;
 }
 
-ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out) {
-	if(group->free_blocks < num_blocks) return -ENOSPC;
+ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out, uint32_t goal_index) {
+	if(group->available_blocks() < num_blocks) return -ENOSPC;
 	if(num_blocks == 0) return kstd::vector<uint32_t>(0);
 
+	Ext2Transaction transaction(*this);
 	LOCK(ext2lock);
-	auto* block_buf = new uint8_t[block_size()];
-
-	Result res = read_block(group->block_bitmap_block, block_buf);
-	if(res.is_error()) {
-		delete[] block_buf;
-		printf("WARNING: Error %d reading block bitmap for group %d\n", res.code(), group->num);
-		return res.code();
+	auto bitmap_res = group->block_bitmap();
+	if(bitmap_res.is_error()) {
+		printf("WARNING: Error %d reading block bitmap for group %d\n", bitmap_res.code(), group->num);
+		return bitmap_res.code();
 	}
 
-
-	uint32_t num_allocated = 0;
 	kstd::vector<uint32_t> ret;
 	ret.reserve(num_blocks);
 
-	for(size_t bi = 0; bi < superblock.blocks_per_group; bi++) {
-		if(!get_bitmap_bit(block_buf, bi)) {
-			set_bitmap_bit(block_buf, bi, true);
+	//Take the first free run starting at the goal that's big enough, or the biggest run there is, until we have enough blocks
+	uint32_t num_allocated = 0;
+	while(num_allocated < num_blocks) {
+		uint32_t run_length;
+		uint32_t run_start = group->find_free_run(goal_index, num_blocks - num_allocated, run_length);
+		if(!run_length)
+			break;
+
+		run_length = min(run_length, num_blocks - num_allocated);
+		for(uint32_t bi = run_start; bi < run_start + run_length; bi++) {
+			group->set_block_used(bi, true);
 			ret.push_back(bi + group->first_block());
-			if(zero_out) zero_block(bi + group->first_block());
-			group->free_blocks--;
-			superblock.free_blocks--;
-			if(++num_allocated == num_blocks) break;
 		}
+		num_allocated += run_length;
+		goal_index = run_start + run_length;
 	}
 
+	group->free_blocks -= num_allocated;
+	superblock.free_blocks -= num_allocated;
+	group->dirty = true;
+	superblock_dirty = true;
+
 	if(num_allocated != num_blocks) {
 		printf("WARNING: Free block count in block group %d was incorrect!\n", group->num);
-		group->free_blocks = 0;
+		group->free_blocks = group->reserved_blocks;
 	}
 
-	write_superblock();
-	group->write();
-	res = write_block(group->block_bitmap_block, block_buf);
-	delete[] block_buf;
+	Result res = write_dirty_metadata();
 	if(res.is_error()) {
 		printf("WARNING: Error writing block bitmap for block group %d!\n", group->num);
 		return res.code();
 	}
 
+	if(zero_out)
+		zero_block_list(ret);
+
 	return kstd::move(ret);
 }
 
-ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_blocks, bool zero_out) {
+ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_blocks, bool zero_out, uint32_t goal) {
+	Ext2Transaction transaction(*this);
 	LOCK(ext2lock);
 	if(num_blocks == 0) {
 		printf("WARNING: Tried to allocate zero ext2 blocks!\n");
 		return -EINVAL;
 	}
 
-	//First, find a block group that can fit all the blocks, or at least the most spacious block group
+	//First, find a block group that can fit all the blocks (preferring the goal's group), or at least the most spacious block group
+	uint32_t goal_bg = block_group_of(goal);
 	Ext2BlockGroup* target_bg = nullptr;
 	Ext2BlockGroup* most_spacious_bg = nullptr;
 
-	for(uint32_t bgi = 0; bgi < num_block_groups; bgi++) {
+	for(uint32_t i = 0; i < num_block_groups; i++) {
+		uint32_t bgi = (goal_bg + i) % num_block_groups;
 		Ext2BlockGroup *bg = get_block_group(bgi);
 		if (!bg) {
 			printf("WARNING: Error getting block group %d!\n", bgi);
 			break;
 		}
-		if (bg->free_blocks >= num_blocks) {
+		if (bg->available_blocks() >= num_blocks) {
 			target_bg = bg;
 			break;
 		}
-		if (!most_spacious_bg || bg->free_blocks > most_spacious_bg->free_blocks) most_spacious_bg = bg;
+		if (!most_spacious_bg || bg->available_blocks() > most_spacious_bg->available_blocks()) most_spacious_bg = bg;
 	}
 
 	if(target_bg) {
 		//We found a block group that will house all of the blocks we need to allocate
-		return kstd::move(allocate_blocks_in_group(target_bg, num_blocks, zero_out));
+		uint32_t goal_index = target_bg->num == goal_bg && goal ? goal - target_bg->first_block() : 0;
+		return kstd::move(allocate_blocks_in_group(target_bg, num_blocks, zero_out, goal_index));
 	} else {
 		//If we couldn't find one bg to fit all the blocks, allocate the blocks in multiple groups
 		kstd::vector<uint32_t> ret;
@@ -330,14 +377,14 @@ ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_b
 			for(uint32_t bgi = 0; bgi < num_block_groups; bgi++) {
 				Ext2BlockGroup *bg = get_block_group(bgi);
 				if(!bg) continue; //This error would have been printed out above presumably
-				if (!most_spacious_bg || bg->free_blocks > most_spacious_bg->free_blocks) most_spacious_bg = bg;
+				if (!most_spacious_bg || bg->available_blocks() > most_spacious_bg->available_blocks()) most_spacious_bg = bg;
 			}
 
 			//If the most spacious bg has no free blocks, return ENOSPC
-			if(most_spacious_bg->free_blocks == 0) return -ENOSPC;
+			if(most_spacious_bg->available_blocks() == 0) return -ENOSPC;
 
 			//Allocate the needed amount of blocks in that group
-			auto res = allocate_blocks_in_group(most_spacious_bg, min(most_spacious_bg->free_blocks, num_blocks), zero_out);
+			auto res = allocate_blocks_in_group(most_spacious_bg, min(most_spacious_bg->available_blocks(), num_blocks), zero_out);
 			if(res.is_error()) return res.code();
 
 			//Push the blocks allocated into the return vector
@@ -348,22 +395,93 @@ ResultRet<kstd::vector<uint32_t>> Ext2Filesystem::allocate_blocks(uint32_t num_b
 	}
 }
 
-uint32_t Ext2Filesystem::allocate_block(bool zero_out) {
-	auto ret_or_err = allocate_blocks(1, zero_out);
+uint32_t Ext2Filesystem::allocate_block(bool zero_out, uint32_t goal) {
+	auto ret_or_err = allocate_blocks(1, zero_out, goal);
 	if(ret_or_err.is_error()) return 0;
 	if(ret_or_err.value().empty()) return 0;
 	return ret_or_err.value().at(0);
 }
 
+void Ext2Filesystem::zero_block_list(const kstd::vector<uint32_t>& blocks) {
+	//Zero out the blocks a contiguous run at a time
+	size_t run_start = 0;
+	for(size_t i = 1; i <= blocks.size(); i++) {
+		if(i == blocks.size() || blocks[i] != blocks[i - 1] + 1) {
+			zero_blocks(blocks[run_start], i - run_start);
+			run_start = i;
+		}
+	}
+}
+
+uint32_t Ext2Filesystem::reserve_blocks(uint32_t start, uint32_t max_blocks) {
+	//Reserves up to max_blocks free blocks in a row starting at start (and within its block group). This only happens
+	//in memory, so nothing has to be cleaned up on disk if we crash before they're claimed or unreserved.
+	LOCK(ext2lock);
+	Ext2BlockGroup* bg = get_block_group(block_group_of(start));
+	if(!bg || start < bg->first_block() || bg->block_bitmap().is_error())
+		return 0;
+
+	uint32_t index = start - bg->first_block();
+	uint32_t num_reserved = 0;
+	while(num_reserved < max_blocks && index + num_reserved < bg->num_blocks() && bg->is_block_available(index + num_reserved)) {
+		bg->set_block_reserved(index + num_reserved, true);
+		num_reserved++;
+	}
+	return num_reserved;
+}
+
+Result Ext2Filesystem::claim_reserved_blocks(uint32_t start, uint32_t num_blocks) {
+	//Marks blocks previously reserved with reserve_blocks() as used
+	Ext2Transaction transaction(*this);
+	LOCK(ext2lock);
+	Ext2BlockGroup* bg = get_block_group(block_group_of(start));
+	if(!bg || bg->block_bitmap().is_error())
+		return -EIO;
+
+	uint32_t index = start - bg->first_block();
+	for(uint32_t i = 0; i < num_blocks; i++) {
+		bg->set_block_reserved(index + i, false);
+		bg->set_block_used(index + i, true);
+	}
+	bg->free_blocks -= num_blocks;
+	bg->dirty = true;
+	superblock.free_blocks -= num_blocks;
+	superblock_dirty = true;
+	return write_dirty_metadata();
+}
+
+void Ext2Filesystem::unreserve_blocks(uint32_t start, uint32_t num_blocks) {
+	LOCK(ext2lock);
+	Ext2BlockGroup* bg = get_block_group(block_group_of(start));
+	if(!bg)
+		return;
+	uint32_t index = start - bg->first_block();
+	for(uint32_t i = 0; i < num_blocks; i++)
+		bg->set_block_reserved(index + i, false);
+}
+
 void Ext2Filesystem::free_block(uint32_t block) {
+	Ext2Transaction transaction(*this);
+	LOCK(ext2lock);
+	free_block_locked(block);
+	write_dirty_metadata();
+}
+
+void Ext2Filesystem::free_blocks(kstd::vector<uint32_t>& blocks) {
+	Ext2Transaction transaction(*this);
 	LOCK(ext2lock);
+	for(size_t i = 0; i < blocks.size(); i++)
+		free_block_locked(blocks[i]);
+	write_dirty_metadata();
+}
 
+void Ext2Filesystem::free_block_locked(uint32_t block) {
 	if(block == 0) {
 		printf("WARNING: Tried to free ext2 block 0!\n");
 		return;
 	}
 
-	uint32_t group_index = (block - 1) / superblock.blocks_per_group;
+	uint32_t group_index = block_group_of(block);
 	Ext2BlockGroup* bg = get_block_group(group_index);
 	if(!bg) {
 		printf("WARNING: Error getting block group %d!\n", group_index);
@@ -371,24 +489,51 @@ void Ext2Filesystem::free_block(uint32_t block) {
 	}
 
 	//Update blockgroup
-	auto* block_buf = new uint8_t[block_size()];
-	read_block(bg->block_bitmap_block, block_buf);
-	set_bitmap_bit(block_buf, block - bg->first_block(), false);
-	write_block(bg->block_bitmap_block, block_buf);
+	if(bg->block_bitmap().is_error()) {
+		printf("WARNING: Error reading block bitmap for group %d!\n", group_index);
+		return;
+	}
+	bg->set_block_used(block - bg->first_block(), false);
 	bg->free_blocks++;
+	bg->dirty = true;
+
+	//Make sure an old copy of the block in the journal can't be replayed over whatever it gets reused for
+	if(journal)
+		journal->revoke(block);
 
 	//Update superblock
 	superblock.free_blocks++;
+	superblock_dirty = true;
+}
 
-	delete[] block_buf;
+Result Ext2Filesystem::write_dirty_metadata() {
+	//Write out any block bitmaps, group descriptors, and the superblock if they were changed
+	LOCK(ext2lock);
+	Result ret = SUCCESS;
+	for(uint32_t i = 0; i < num_block_groups; i++) {
+		if(!block_groups[i])
+			continue;
+		Result res = block_groups[i]->flush();
+		if(res.is_error())
+			ret = res;
+	}
+
+	if(superblock_dirty) {
+		write_superblock();
+		superblock_dirty = false;
+	}
+
+	return ret;
 }
 
-void Ext2Filesystem::free_blocks(kstd::vector<uint32_t>& blocks) {
-	for(size_t i = 0; i < blocks.size(); i++) free_block(blocks[i]);
+uint32_t Ext2Filesystem::block_group_of(uint32_t block) {
+	if(block < superblock.superblock_block)
+		return 0;
+	return (block - superblock.superblock_block) / superblock.blocks_per_group;
 }
 
 Ext2BlockGroup *Ext2Filesystem::get_block_group(uint32_t block_group) {
-	if(!block_groups || block_group > num_block_groups) return nullptr;
+	if(!block_groups || block_group >= num_block_groups) return nullptr;
 	if(!block_groups[block_group]) {
 		block_groups[block_group] = new Ext2BlockGroup(this, block_group);
 	}
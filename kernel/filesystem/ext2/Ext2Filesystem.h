@@ -28,6 +28,7 @@
 
 class Ext2Filesystem;
 class Ext2BlockGroup;
+class Ext2Journal;
 class Ext2Inode;
 class Ext2Filesystem: public FileBasedFilesystem {
 public:
@@ -39,21 +40,28 @@ public:
 	ino_t root_inode_id() override;
 	char* name() override;
 	Inode * get_inode_rawptr(ino_t id) override;
+	bool cache_directory_entries() override;
 
 	//Reading/writing
 	ResultRet<kstd::shared_ptr<Ext2Inode>> allocate_inode(mode_t mode, uid_t uid, gid_t gid, size_t size, ino_t parent);
 	Result free_inode(Ext2Inode& inode);
 	void read_superblock(ext2_superblock *sb);
 	void write_superblock();
+	Result write_metadata_block(uint32_t block, const uint8_t* buffer);
 
 	//Block stuff
-	ResultRet<kstd::vector<uint32_t>> allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out);
-	ResultRet<kstd::vector<uint32_t>> allocate_blocks(uint32_t num_blocks, bool zero_out = true);
-	uint32_t allocate_block(bool zero_out = true);
+	ResultRet<kstd::vector<uint32_t>> allocate_blocks_in_group(Ext2BlockGroup* group, uint32_t num_blocks, bool zero_out, uint32_t goal_index = 0);
+	ResultRet<kstd::vector<uint32_t>> allocate_blocks(uint32_t num_blocks, bool zero_out = true, uint32_t goal = 0);
+	uint32_t allocate_block(bool zero_out = true, uint32_t goal = 0);
+	void zero_block_list(const kstd::vector<uint32_t>& blocks);
+	uint32_t reserve_blocks(uint32_t start, uint32_t max_blocks);
+	Result claim_reserved_blocks(uint32_t start, uint32_t num_blocks);
+	void unreserve_blocks(uint32_t start, uint32_t num_blocks);
 
 	void free_block(uint32_t block);
 	void free_blocks(kstd::vector<uint32_t>& blocks);
 	Ext2BlockGroup* get_block_group(uint32_t block_group);
+	uint32_t block_group_of(uint32_t block);
 	Result read_block_group_raw(uint32_t block_group, ext2_block_group_descriptor* buffer, uint8_t* block_buf = nullptr);
 	Result write_block_group_raw(uint32_t block_group, const ext2_block_group_descriptor* buffer, uint8_t* block_buf = nullptr);
 
@@ -80,9 +88,14 @@ public:
 	uint32_t num_block_groups;
 	uint32_t inodes_per_block;
 	size_t block_pointers_per_block;
+	Ext2Journal* journal = nullptr;
 
 private:
+	void free_block_locked(uint32_t block);
+	Result write_dirty_metadata();
+
 	SpinLock ext2lock;
+	bool superblock_dirty = false;
 
 	//Block stuff
 	Ext2BlockGroup** block_groups = nullptr;
@@ -0,0 +1,172 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "Ext2HTree.h"
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint32_t legacy_hash(const char* name, size_t length, bool is_signed) {
+	uint32_t hash0 = 0x12a3fe2d;
+	uint32_t hash1 = 0x37abe8f9;
+	for(size_t i = 0; i < length; i++) {
+		int c = is_signed ? (int) (signed char) name[i] : (int) (unsigned char) name[i];
+		uint32_t hash = hash1 + (hash0 ^ (uint32_t) (c * 7152373));
+		if(hash & 0x80000000)
+			hash -= 0x7fffffff;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+	return hash0 << 1;
+}
+
+//Packs up to num * 4 bytes of the name into num words, padding with a value derived from the length
+static void str_to_hash_buf(const char* name, size_t length, uint32_t* buf, int num, bool is_signed) {
+	uint32_t pad = (uint32_t) length | ((uint32_t) length << 8);
+	pad |= pad << 16;
+
+	uint32_t val = pad;
+	if(length > (size_t) num * 4)
+		length = num * 4;
+	for(size_t i = 0; i < length; i++) {
+		int c = is_signed ? (int) (signed char) name[i] : (int) (unsigned char) name[i];
+		val = (uint32_t) c + (val << 8);
+		if((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if(--num >= 0)
+		*buf++ = val;
+	while(--num >= 0)
+		*buf++ = pad;
+}
+
+#define MD4_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD4_G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define MD4_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD4_ROUND(f, a, b, c, d, x, s) (a += f(b, c, d) + (x), a = ROL32(a, s))
+#define MD4_K1 0
+#define MD4_K2 013240474631u
+#define MD4_K3 015666365641u
+
+static void half_md4_transform(uint32_t buf[4], const uint32_t in[8]) {
+	uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	MD4_ROUND(MD4_F, a, b, c, d, in[0] + MD4_K1, 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[1] + MD4_K1, 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[2] + MD4_K1, 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[3] + MD4_K1, 19);
+	MD4_ROUND(MD4_F, a, b, c, d, in[4] + MD4_K1, 3);
+	MD4_ROUND(MD4_F, d, a, b, c, in[5] + MD4_K1, 7);
+	MD4_ROUND(MD4_F, c, d, a, b, in[6] + MD4_K1, 11);
+	MD4_ROUND(MD4_F, b, c, d, a, in[7] + MD4_K1, 19);
+
+	MD4_ROUND(MD4_G, a, b, c, d, in[1] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[3] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[5] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[7] + MD4_K2, 13);
+	MD4_ROUND(MD4_G, a, b, c, d, in[0] + MD4_K2, 3);
+	MD4_ROUND(MD4_G, d, a, b, c, in[2] + MD4_K2, 5);
+	MD4_ROUND(MD4_G, c, d, a, b, in[4] + MD4_K2, 9);
+	MD4_ROUND(MD4_G, b, c, d, a, in[6] + MD4_K2, 13);
+
+	MD4_ROUND(MD4_H, a, b, c, d, in[3] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[7] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[2] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[6] + MD4_K3, 15);
+	MD4_ROUND(MD4_H, a, b, c, d, in[1] + MD4_K3, 3);
+	MD4_ROUND(MD4_H, d, a, b, c, in[5] + MD4_K3, 9);
+	MD4_ROUND(MD4_H, c, d, a, b, in[0] + MD4_K3, 11);
+	MD4_ROUND(MD4_H, b, c, d, a, in[4] + MD4_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+static void tea_transform(uint32_t buf[4], const uint32_t in[4]) {
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0], b1 = buf[1];
+	uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+	for(int n = 0; n < 16; n++) {
+		sum += 0x9E3779B9;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	}
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+uint32_t ext2_dir_hash(const char* name, size_t length, uint8_t version, const uint32_t seed[4]) {
+	uint32_t buf[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+	uint32_t in[8];
+	uint32_t hash;
+
+	//A seed of all zeroes means the default one above is used
+	if(seed[0] || seed[1] || seed[2] || seed[3]) {
+		for(int i = 0; i < 4; i++)
+			buf[i] = seed[i];
+	}
+
+	switch(version) {
+		case EXT2_HASH_LEGACY:
+		case EXT2_HASH_LEGACY_UNSIGNED:
+			hash = legacy_hash(name, length, version == EXT2_HASH_LEGACY);
+			break;
+
+		case EXT2_HASH_HALF_MD4:
+		case EXT2_HASH_HALF_MD4_UNSIGNED: {
+			const char* p = name;
+			ssize_t left = length;
+			do {
+				str_to_hash_buf(p, left, in, 8, version == EXT2_HASH_HALF_MD4);
+				half_md4_transform(buf, in);
+				left -= 32;
+				p += 32;
+			} while(left > 0);
+			hash = buf[1];
+			break;
+		}
+
+		case EXT2_HASH_TEA:
+		case EXT2_HASH_TEA_UNSIGNED: {
+			const char* p = name;
+			ssize_t left = length;
+			do {
+				str_to_hash_buf(p, left, in, 4, version == EXT2_HASH_TEA);
+				tea_transform(buf, in);
+				left -= 16;
+				p += 16;
+			} while(left > 0);
+			hash = buf[0];
+			break;
+		}
+
+		default:
+			return 0;
+	}
+
+	//The lowest bit is used to mark hash collisions in the index, and the highest hash is reserved
+	hash &= ~1u;
+	if(hash == (0x7fffffffu << 1))
+		hash = (0x7fffffffu - 1) << 1;
+	return hash;
+}
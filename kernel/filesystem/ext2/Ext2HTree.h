@@ -0,0 +1,79 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_EXT2HTREE_H
+#define DUCKOS_EXT2HTREE_H
+
+#include <kernel/kstd/types.h>
+
+//Hash versions used by indexed (dir_index) directories
+#define EXT2_HASH_LEGACY 0
+#define EXT2_HASH_HALF_MD4 1
+#define EXT2_HASH_TEA 2
+#define EXT2_HASH_LEGACY_UNSIGNED 3
+#define EXT2_HASH_HALF_MD4_UNSIGNED 4
+#define EXT2_HASH_TEA_UNSIGNED 5
+
+//The maximum depth of the index we know how to read
+#define EXT2_HTREE_MAX_LEVELS 2
+
+//Set in the superblock's optional features if directories may be indexed
+#define EXT2_FEATURE_COMPAT_DIR_INDEX 0x20
+
+typedef struct __attribute__((packed)) ext2_dx_root_info {
+	uint32_t reserved_zero;
+	uint8_t hash_version;
+	uint8_t info_length;
+	uint8_t indirect_levels;
+	uint8_t unused_flags;
+} ext2_dx_root_info;
+
+typedef struct __attribute__((packed)) ext2_dx_entry {
+	uint32_t hash;
+	uint32_t block;
+} ext2_dx_entry;
+
+//Overlays the hash of the first entry in each index block
+typedef struct __attribute__((packed)) ext2_dx_countlimit {
+	uint16_t limit;
+	uint16_t count;
+} ext2_dx_countlimit;
+
+//Where a lookup went at each level of a directory's index, so that new index entries can be inserted after it
+typedef struct ext2_htree_path {
+	uint32_t hash;
+	uint8_t hash_version;
+	size_t levels;
+	uint32_t blocks[EXT2_HTREE_MAX_LEVELS]; //The directory block index of the index block at each level
+	size_t entries_offsets[EXT2_HTREE_MAX_LEVELS];
+	size_t positions[EXT2_HTREE_MAX_LEVELS]; //The index of the entry that was followed at each level
+} ext2_htree_path;
+
+//The root index is stored in the first block of the directory, after the "." and ".." entries
+#define EXT2_DX_ROOT_INFO_OFFSET 24
+//Other index blocks start with an empty directory entry spanning the whole block
+#define EXT2_DX_NODE_ENTRIES_OFFSET 8
+
+/**
+ * Computes the hash of a directory entry name as used by indexed directories.
+ * @param seed The filesystem's hash seed, or all zeroes for the default.
+ */
+uint32_t ext2_dir_hash(const char* name, size_t length, uint8_t version, const uint32_t seed[4]);
+
+#endif //DUCKOS_EXT2HTREE_H
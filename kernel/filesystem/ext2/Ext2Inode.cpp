@@ -22,6 +22,9 @@
 #include "Ext2BlockGroup.h"
 #include "Ext2Filesystem.h"
 #include <kernel/filesystem/DirectoryEntry.h>
+#include <kernel/filesystem/DirectoryCache.h>
+#include "Ext2HTree.h"
+#include "Ext2Journal.h"
 
 Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t id): Inode(filesystem, id) {
 	//Get the block group
@@ -58,10 +61,20 @@ Ext2Inode::Ext2Inode(Ext2Filesystem& filesystem, ino_t i, const Raw &raw, kstd::
 }
 
 Ext2Inode::~Ext2Inode() {
+	Ext2Transaction transaction(ext2fs());
+	discard_preallocation();
 	if(_dirty && exists())
 		write_to_disk();
 }
 
+Result Ext2Inode::sync() {
+	Ext2Transaction transaction(ext2fs());
+	LOCK(lock);
+	if(_dirty && exists())
+		return write_to_disk();
+	return SUCCESS;
+}
+
 uint32_t Ext2Inode::block_group(){
 	return (id - 1) / ext2fs().superblock.inodes_per_group;
 }
@@ -106,11 +119,20 @@ bool Ext2Inode::set_block_pointer(uint32_t block_index, uint32_t block) {
 	} else return false;
 }
 
+size_t Ext2Inode::contiguous_blocks(uint32_t block_index, size_t max_blocks, uint32_t& first_block) {
+	first_block = get_block_pointer(block_index);
+	size_t length = 1;
+	while(length < max_blocks && get_block_pointer(block_index + length) == first_block + length)
+		length++;
+	return length;
+}
+
 kstd::vector<uint32_t>& Ext2Inode::get_block_pointers() {
 	return block_pointers;
 }
 
 void Ext2Inode::free_all_blocks() {
+	discard_preallocation();
 	ext2fs().free_blocks(block_pointers);
 	ext2fs().free_blocks(pointer_blocks);
 }
@@ -134,32 +156,38 @@ ssize_t Ext2Inode::read(size_t start, size_t length, uint8_t* buf, FileDescripto
 	if(start + length > _metadata.size) length = _metadata.size - start;
 
 	//TODO: symlinks
-	size_t first_block = start / ext2fs().block_size();
-	size_t first_block_start = start % ext2fs().block_size();
-	size_t bytes_left = length;
-	size_t block_index = first_block;
-
-	auto block_buf = new uint8_t[ext2fs().block_size()];
-	while(bytes_left) {
-		ext2fs().read_block(get_block_pointer(block_index), block_buf);
-		if(block_index == first_block) {
-			if(length < ext2fs().block_size() - first_block_start) {
-				memcpy(buf, block_buf + first_block_start, length);
-				bytes_left = 0;
-			} else {
-				memcpy(buf, block_buf + first_block_start, ext2fs().block_size() - first_block_start);
-				bytes_left -= ext2fs().block_size() - first_block_start;
-			}
-		} else {
-			if(bytes_left < ext2fs().block_size()) {
-				memcpy(buf + (length - bytes_left), block_buf, bytes_left);
-				bytes_left = 0;
-			} else {
-				memcpy(buf + (length - bytes_left), block_buf, ext2fs().block_size());
-				bytes_left -= ext2fs().block_size();
+	size_t block_size = ext2fs().block_size();
+	size_t offset = start;
+	size_t end = start + length;
+	uint8_t* block_buf = nullptr;
+	while(offset < end) {
+		size_t block_index = offset / block_size;
+		size_t block_start = offset % block_size;
+
+		//Partial blocks have to be read into a buffer first
+		if(block_start || end - offset < block_size) {
+			if(!block_buf)
+				block_buf = new uint8_t[block_size];
+			Result res = ext2fs().read_block(get_block_pointer(block_index), block_buf);
+			if(res.is_error()) {
+				delete[] block_buf;
+				return res.code();
 			}
+			size_t nread = min(block_size - block_start, end - offset);
+			memcpy(buf + (offset - start), block_buf + block_start, nread);
+			offset += nread;
+			continue;
 		}
-		block_index++;
+
+		//Read runs of physically contiguous whole blocks straight into the buffer
+		uint32_t run_start;
+		size_t run_length = contiguous_blocks(block_index, (end - offset) / block_size, run_start);
+		Result res = ext2fs().read_blocks(run_start, run_length, buf + (offset - start));
+		if(res.is_error()) {
+			delete[] block_buf;
+			return res.code();
+		}
+		offset += run_length * block_size;
 	}
 	delete[] block_buf;
 	return length;
@@ -170,6 +198,8 @@ ssize_t Ext2Inode::write(size_t start, size_t length, const uint8_t* buf, FileDe
 	if(length == 0) return 0;
 	if(!exists()) return -ENOENT; //Inode was deleted
 
+	//Data is written straight to disk before the metadata pointing to it is committed (like ext3's ordered mode)
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 
 	//If it's a symlink and less than 60 characters, use the block pointers to store the link
@@ -180,108 +210,110 @@ ssize_t Ext2Inode::write(size_t start, size_t length, const uint8_t* buf, FileDe
 		return length;
 	}
 
-	size_t first_block = start / ext2fs().block_size();
-	size_t first_block_start = start % ext2fs().block_size();
-	size_t bytes_left = length;
-	size_t block_index = first_block;
-
 	//If this write is going to expand the file, resize it
 	if(start + length > _metadata.size) {
 		auto res = truncate((off_t)start + (off_t)length);
 		if(res.is_error()) return res.code();
 	}
 
-	auto block_buf = new uint8_t[ext2fs().block_size()];
-	while(bytes_left) {
-		uint32_t block = get_block_pointer(block_index);
+	size_t block_size = ext2fs().block_size();
+	size_t offset = start;
+	size_t end = start + length;
+	uint8_t* block_buf = nullptr;
+	while(offset < end) {
+		size_t block_index = offset / block_size;
+		size_t block_start = offset % block_size;
 
 		//The block isn't allocated, no space
-		if(!block) return -ENOSPC;
-
-		//Read the block into a buffer
-		ext2fs().read_block(block, block_buf);
-
-		//Copy the appropriate portion of the buffer into the appropriate portion of the block buffer
-		if(block_index == first_block) {
-			if(length < ext2fs().block_size() - first_block_start) {
-				memcpy(block_buf + first_block_start, buf, length);
-				bytes_left = 0;
-			} else {
-				memcpy(block_buf + first_block_start, buf, ext2fs().block_size() - first_block_start);
-				bytes_left -= ext2fs().block_size() - first_block_start;
+		uint32_t block = get_block_pointer(block_index);
+		if(!block) {
+			delete[] block_buf;
+			return -ENOSPC;
+		}
+
+		//Partial blocks have to be read in, modified, and written back
+		if(block_start || end - offset < block_size) {
+			if(!block_buf)
+				block_buf = new uint8_t[block_size];
+			Result res = ext2fs().read_block(block, block_buf);
+			if(res.is_error()) {
+				delete[] block_buf;
+				return res.code();
 			}
-		} else {
-			if(bytes_left < ext2fs().block_size()) {
-				memcpy(block_buf, buf + (length - bytes_left), bytes_left);
-				bytes_left = 0;
-			} else {
-				memcpy(block_buf, buf + (length - bytes_left), ext2fs().block_size());
-				bytes_left -= ext2fs().block_size();
+			size_t nwrite = min(block_size - block_start, end - offset);
+			memcpy(block_buf + block_start, buf + (offset - start), nwrite);
+			res = ext2fs().write_block(block, block_buf);
+			if(res.is_error()) {
+				delete[] block_buf;
+				return res.code();
 			}
+			offset += nwrite;
+			continue;
 		}
 
-		//Write the block to disk/cache
-		ext2fs().write_block(block, block_buf);
-		block_index++;
+		//Write runs of physically contiguous whole blocks straight from the buffer
+		uint32_t run_start;
+		size_t run_length = contiguous_blocks(block_index, (end - offset) / block_size, run_start);
+		Result res = ext2fs().write_blocks(run_start, run_length, buf + (offset - start));
+		if(res.is_error()) {
+			delete[] block_buf;
+			return res.code();
+		}
+		offset += run_length * block_size;
 	}
 
 	delete[] block_buf;
-
 	return length;
 }
 
 ssize_t Ext2Inode::read_dir_entry(size_t start, DirectoryEntry* buffer, FileDescriptor* fd) {
 	LOCK(lock);
 
-	auto* buf = new uint8_t[ext2fs().block_size()];
-	size_t block = start / ext2fs().block_size();
-	size_t start_in_block = start % ext2fs().block_size();
-	if(read(block * ext2fs().block_size(), ext2fs().block_size(), buf, fd) == 0) {
-		delete[] buf;
-		return 0;
-	}
-	auto* dir = (ext2_directory*)(buf + start_in_block);
+	//Skip over empty entries (removed entries, the rest of a block, and index blocks) until we find a used one
+	size_t block_size = ext2fs().block_size();
+	auto* buf = new uint8_t[block_size];
+	size_t offset = start;
+	size_t loaded_block = -1;
+	while(offset < _metadata.size) {
+		size_t block = offset / block_size;
+		if(block != loaded_block) {
+			if(read(block * block_size, block_size, buf, fd) != (ssize_t) block_size)
+				break;
+			loaded_block = block;
+		}
 
-	size_t name_length = dir->name_length;
-	if(name_length > NAME_MAXLEN - 1) name_length = NAME_MAXLEN - 1;
+		auto* dir = (ext2_directory*)(buf + offset % block_size);
+		if(dir->size < sizeof(ext2_directory))
+			break;
+		if(dir->inode == 0) {
+			offset += dir->size;
+			continue;
+		}
 
-	if(dir->inode == 0) {
+		size_t name_length = dir->name_length;
+		if(name_length > NAME_MAXLEN - 1) name_length = NAME_MAXLEN - 1;
+		buffer->name_length = name_length;
+		buffer->id = dir->inode;
+		buffer->type = dir->type;
+		memcpy(buffer->name, &dir->type+1, name_length);
+
+		offset += dir->size;
 		delete[] buf;
-		return 0;
+		return offset - start;
 	}
 
-	buffer->name_length = name_length;
-	buffer->id = dir->inode;
-	buffer->type = dir->type;
-	memcpy(buffer->name, &dir->type+1, name_length);
-
 	delete[] buf;
-	return dir->size;
+	return 0;
 }
 
 ino_t Ext2Inode::find_id(const kstd::string& find_name) {
 	if(!metadata().is_directory()) return 0;
 	LOCK(lock);
-	ino_t ret = 0;
-	auto* buf = static_cast<uint8_t *>(kmalloc(ext2fs().block_size()));
-	for(size_t i = 0; i < num_blocks(); i++) {
-		uint32_t block = get_block_pointer(i);
-		ext2fs().read_block(block, buf);
-		auto* dir = reinterpret_cast<ext2_directory*>(buf);
-		uint32_t add = 0;
-		char name_buf[257];
-		while(dir->inode != 0 && add < ext2fs().block_size()) {
-			memcpy(name_buf, &dir->type+1, dir->name_length);
-			name_buf[dir->name_length] = '\0';
-			if(find_name == name_buf){
-				ret = dir->inode;
-				break;
-			}
-			add += dir->size;
-			dir = (ext2_directory*)((size_t)dir + dir->size);
-		}
-	}
-	kfree(buf);
+	auto* buf = new uint8_t[ext2fs().block_size()];
+	uint32_t block_index;
+	size_t entry_offset, prev_offset;
+	ino_t ret = find_entry(find_name, buf, block_index, entry_offset, prev_offset);
+	delete[] buf;
 	return ret;
 }
 
@@ -290,24 +322,9 @@ Result Ext2Inode::add_entry(const kstd::string &name, Inode &inode) {
 	if(!metadata().is_directory()) return -ENOTDIR;
 	if(!name.length() || name.length() > NAME_MAXLEN) return -ENAMETOOLONG;
 
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 
-	//Read entries into a vector
-	kstd::vector<DirectoryEntry> entries;
-	size_t offset = 0;
-	ssize_t nread;
-	auto* buf = new DirectoryEntry;
-	while((nread = read_dir_entry(offset, buf, nullptr))) {
-		offset += nread;
-		buf->name[buf->name_length] = '\0';
-		if(name == buf->name) {
-			delete buf;
-			return -EEXIST;
-		}
-		entries.push_back(*buf);
-	}
-	delete buf;
-
 	//Determine filetype
 	uint8_t type = EXT2_FT_UNKNOWN;
 	if(inode.metadata().is_simple_file()) type = EXT2_FT_REG_FILE;
@@ -316,24 +333,22 @@ Result Ext2Inode::add_entry(const kstd::string &name, Inode &inode) {
 	else if(inode.metadata().is_block_device()) type = EXT2_FT_BLKDEV;
 	else if(inode.metadata().is_character_device()) type = EXT2_FT_CHRDEV;
 
+	//Insert the entry into a single block of the directory (this fails with EEXIST if the name is taken)
+	DirectoryCache::inst().invalidate(&fs, id, name);
+	auto res = insert_entry(name, inode.id, type);
+	if(res.is_error()) return res;
+	DirectoryCache::inst().insert(&fs, id, name, inode.id);
+
 	//Increase hardlink count of new inode
 	((Ext2Inode&) inode).increase_hardlink_count();
 
-	//Push new entry into vector and write to disk
-	entries.push_back({inode.id, type, name});
-	auto res = write_directory_entries(entries);
-	if(res.is_error()) return res;
-	if(_dirty) { //We changed the amount of blocks
-		res = write_to_disk();
-		if(res.is_error()) return res;
-	}
-
 	return SUCCESS;
 }
 
 ResultRet<kstd::shared_ptr<Inode>> Ext2Inode::create_entry(const kstd::string& name, mode_t mode, uid_t uid, gid_t gid) {
 	if(!name.length() || name.length() > NAME_MAXLEN) return -ENAMETOOLONG;
 
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 
 	//Create the inode
@@ -363,32 +378,23 @@ Result Ext2Inode::remove_entry(const kstd::string &name) {
 	if(!metadata().is_directory()) return -ENOTDIR;
 	if(!name.length() || name.length() > NAME_MAXLEN) return -ENAMETOOLONG;
 
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 
-	//Read entries into vector and find the child we need
-	kstd::vector<DirectoryEntry> entries;
-	size_t offset = 0;
-	ssize_t nread;
-	size_t entry_index;
-	bool found = false;
-	size_t i = 0;
-	auto* buf = new DirectoryEntry;
-	while((nread = read_dir_entry(offset, buf, nullptr))) {
-		offset += nread;
-		buf->name[buf->name_length] = '\0';
-		if(name == buf->name) {
-			entry_index = i;
-			found = true;
-		}
-		entries.push_back(*buf);
-		i++;
+	//Find the block with the entry in it
+	auto* buf = new uint8_t[ext2fs().block_size()];
+	uint32_t block_index;
+	size_t entry_offset, prev_offset;
+	ino_t child_id = find_entry(name, buf, block_index, entry_offset, prev_offset);
+	if(!child_id) {
+		delete[] buf;
+		return -ENOENT;
 	}
-	delete buf;
 
-	//If we didn't find it or the inode doesn't exist for some reason, return with an error
-	if(!found) return -ENOENT;
-	auto child_or_err = ext2fs().get_inode(entries[entry_index].id);
+	//If the inode doesn't exist for some reason, return with an error
+	auto child_or_err = ext2fs().get_inode(child_id);
 	if(child_or_err.is_error()){
+		delete[] buf;
 		printf("WARNING: Orphaned directory entry in inode %d\n", id);
 		return child_or_err.code();
 	}
@@ -397,32 +403,38 @@ Result Ext2Inode::remove_entry(const kstd::string &name) {
 	auto ext2ino = (kstd::shared_ptr<Ext2Inode>) child_or_err.value();
 	if(ext2ino->metadata().is_directory()) {
 		auto result = ext2ino->try_remove_dir();
-		if(result.is_error()) return result.code();
+		if(result.is_error()) {
+			delete[] buf;
+			return result.code();
+		}
 	} else {
 		ext2ino->reduce_hardlink_count();
 	}
 
-	//Erase the entry and write the entries to disk
-	entries.erase(entry_index);
-	auto res = write_directory_entries(entries);
-	if(res.is_error()) return res;
-	if(_dirty) { //We changed the amount of blocks
-		res = write_to_disk();
-		if(res.is_error()) return res;
-	}
-	return SUCCESS;
+	//Remove the entry by merging it into the previous one, or by marking it as unused if it's first in the block.
+	//This doesn't change which hashes go in which block, so the index (if there is one) stays valid.
+	DirectoryCache::inst().invalidate(&fs, id, name);
+	auto* entry = (ext2_directory*) (buf + entry_offset);
+	if(prev_offset != (size_t) -1)
+		((ext2_directory*) (buf + prev_offset))->size += entry->size;
+	else
+		entry->inode = 0;
+	Result res = ext2fs().write_metadata_block(get_block_pointer(block_index), buf);
+	delete[] buf;
+	return res;
 }
 
 Result Ext2Inode::truncate(off_t length) {
 	if(length < 0) return -EINVAL;
 	if((size_t)length == _metadata.size) return SUCCESS;
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 
 	uint32_t new_num_blocks = (length + ext2fs().block_size() - 1) / ext2fs().block_size();
 
 	if(new_num_blocks > num_blocks()) {
 		//We're expanding the file, allocate new blocks
-		auto new_blocks_res = ext2fs().allocate_blocks(new_num_blocks - num_blocks(), true);
+		auto new_blocks_res = allocate_data_blocks(new_num_blocks - num_blocks());
 		if(new_blocks_res.is_error()) return new_blocks_res.code();
 
 		//If we didn't get the amount of blocks we wanted, return ENOSPC
@@ -438,6 +450,7 @@ Result Ext2Inode::truncate(off_t length) {
 		write_to_disk();
 	} else if(new_num_blocks < num_blocks()) {
 		//We're shrinking the file, free old blocks
+		discard_preallocation();
 		for(size_t i = num_blocks(); i > new_num_blocks; i--)
 			ext2fs().free_block(get_block_pointer(i - 1));
 		block_pointers.resize(new_num_blocks);
@@ -465,6 +478,7 @@ Result Ext2Inode::truncate(off_t length) {
 }
 
 Result Ext2Inode::chmod(mode_t mode) {
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 	_metadata.mode = mode;
 	write_inode_entry();
@@ -472,6 +486,7 @@ Result Ext2Inode::chmod(mode_t mode) {
 }
 
 Result Ext2Inode::chown(uid_t uid, gid_t gid) {
+	Ext2Transaction transaction(ext2fs());
 	LOCK(lock);
 	_metadata.uid = uid;
 	_metadata.gid = gid;
@@ -573,7 +588,7 @@ Result Ext2Inode::write_block_pointers(uint8_t* block_buf) {
 
 	if(num_blocks() > 12) {
 		if (!raw.s_pointer) {
-			raw.s_pointer = ext2fs().allocate_block();
+			raw.s_pointer = ext2fs().allocate_block(true, allocation_goal());
 			if (!raw.s_pointer) return -ENOSPC; //Block allocation failed
 		}
 		pointer_blocks.push_back(raw.s_pointer);
@@ -583,13 +598,13 @@ Result Ext2Inode::write_block_pointers(uint8_t* block_buf) {
 		for (uint32_t block_index = 12; block_index < 12 + ext2fs().block_pointers_per_block; block_index++) {
 			((uint32_t *) block_buf)[block_index - 12] = get_block_pointer(block_index);
 		}
-		ext2fs().write_block(raw.s_pointer, block_buf);
+		ext2fs().write_metadata_block(raw.s_pointer, block_buf);
 	} else raw.s_pointer = 0;
 
 	if(num_blocks() > 12 + ext2fs().block_pointers_per_block) {
 		//Allocate doubly indirect block if needed and read
 		if(!raw.d_pointer) {
-			raw.d_pointer = ext2fs().allocate_block();
+			raw.d_pointer = ext2fs().allocate_block(true, allocation_goal());
 			if(!raw.d_pointer) return -ENOSPC; //Block allocation failed
 			ext2fs().read_block(raw.d_pointer, block_buf);
 			memset(block_buf, 0, ext2fs().block_size());
@@ -606,7 +621,7 @@ Result Ext2Inode::write_block_pointers(uint8_t* block_buf) {
 			uint32_t dblock = ((uint32_t*)block_buf)[dindex];
 			//If the block isn't allocated, allocate it
 			if(!dblock) {
-				dblock = ext2fs().allocate_block();
+				dblock = ext2fs().allocate_block(true, allocation_goal());
 				((uint32_t*)block_buf)[dindex] = dblock;
 				if(!dblock) return -ENOSPC; //Allocation failed
 			}
@@ -618,12 +633,12 @@ Result Ext2Inode::write_block_pointers(uint8_t* block_buf) {
 				((uint32_t *) dblock_buf)[dblock_index] = get_block_pointer(cur_block);
 				cur_block++;
 			}
-			ext2fs().write_block(dblock, dblock_buf);
+			ext2fs().write_metadata_block(dblock, dblock_buf);
 		}
 
 		//Write doubly-indirect block to disk
 		delete[] dblock_buf;
-		ext2fs().write_block(raw.d_pointer, block_buf);
+		ext2fs().write_metadata_block(raw.d_pointer, block_buf);
 	} else raw.d_pointer = 0;
 
 	if(num_blocks() > 12 + ext2fs().block_pointers_per_block * ext2fs().block_pointers_per_block) {
@@ -655,7 +670,7 @@ Result Ext2Inode::write_inode_entry(uint8_t* block_buf) {
 	memcpy(inodeRaw, &raw, sizeof(Ext2Inode::Raw));
 
 	//Write the inode table to disk
-	ext2fs().write_block(bg->inode_table_block + block(), block_buf);
+	ext2fs().write_metadata_block(bg->inode_table_block + block(), block_buf);
 	_dirty = false;
 
 	FREE_BLOCKBUF(block_buf);
@@ -698,7 +713,7 @@ Result Ext2Inode::write_directory_entries(kstd::vector<DirectoryEntry> &entries)
 		raw_ent.size += raw_ent.size % 4 ? 4 - raw_ent.size % 4 : 0; //4-byte align
 
 		if(raw_ent.size + cur_byte_in_block >= ext2fs().block_size()) {
-			ext2fs().write_block(get_block_pointer(cur_block), block_buf);
+			ext2fs().write_metadata_block(get_block_pointer(cur_block), block_buf);
 			memset(block_buf, 0, ext2fs().block_size());
 			cur_block++;
 			cur_byte_in_block = 0;
@@ -712,7 +727,7 @@ Result Ext2Inode::write_directory_entries(kstd::vector<DirectoryEntry> &entries)
 
 	//We need to write the null entry at the end, and if we're already at the end of the block, we need to allocate a new one
 	if(cur_byte_in_block >= ext2fs().block_size()) {
-		ext2fs().write_block(get_block_pointer(cur_block), block_buf);
+		ext2fs().write_metadata_block(get_block_pointer(cur_block), block_buf);
 		memset(block_buf, 0, ext2fs().block_size());
 		cur_block++;
 		cur_byte_in_block = 0;
@@ -727,7 +742,7 @@ Result Ext2Inode::write_directory_entries(kstd::vector<DirectoryEntry> &entries)
 	memcpy(block_buf + cur_byte_in_block, &end_ent, sizeof(end_ent));
 
 	//Write the last block
-	ext2fs().write_block(get_block_pointer(cur_block), block_buf);
+	ext2fs().write_metadata_block(get_block_pointer(cur_block), block_buf);
 
 	return SUCCESS;
 }
@@ -798,6 +813,7 @@ Result Ext2Inode::try_remove_dir() {
 
 	raw.hard_links = 0;
 	write_inode_entry();
+	DirectoryCache::inst().invalidate_directory(&fs, id);
 	ext2fs().remove_cached_inode(id);
 	ext2fs().free_inode(*this);
 
@@ -826,11 +842,606 @@ uint32_t Ext2Inode::calculate_num_ptr_blocks(uint32_t num_blocks) {
 	return ret;
 }
 
+uint32_t Ext2Inode::allocation_goal() {
+	//Try to put new blocks right after the last block of the file, or at the start of our block group if we have none
+	if(!block_pointers.empty() && block_pointers[block_pointers.size() - 1])
+		return block_pointers[block_pointers.size() - 1] + 1;
+	return ext2fs().get_block_group(block_group())->first_block();
+}
+
+ResultRet<kstd::vector<uint32_t>> Ext2Inode::allocate_data_blocks(uint32_t count) {
+	LOCK(lock);
+	kstd::vector<uint32_t> ret;
+	ret.reserve(count);
+
+	//Use up the reserved blocks first, as long as they still follow the end of the file
+	uint32_t goal = allocation_goal();
+	if(_prealloc_count && _prealloc_start != goal)
+		discard_preallocation();
+	if(_prealloc_count) {
+		uint32_t num_claimed = min(count, _prealloc_count);
+		if(ext2fs().claim_reserved_blocks(_prealloc_start, num_claimed).is_success()) {
+			for(uint32_t i = 0; i < num_claimed; i++)
+				ret.push_back(_prealloc_start + i);
+			_prealloc_start += num_claimed;
+			_prealloc_count -= num_claimed;
+			goal = _prealloc_start;
+		} else {
+			discard_preallocation();
+		}
+	}
+
+	if(ret.size() < count) {
+		auto blocks_res = ext2fs().allocate_blocks(count - ret.size(), false, goal);
+		if(blocks_res.is_error())
+			return blocks_res.code();
+		auto& blocks = blocks_res.value();
+		for(size_t i = 0; i < blocks.size(); i++)
+			ret.push_back(blocks[i]);
+
+		//For regular files, reserve the blocks that follow so that further appends stay contiguous
+		if(_metadata.is_simple_file() && !_prealloc_count && !ret.empty()) {
+			_prealloc_start = ret[ret.size() - 1] + 1;
+			_prealloc_count = ext2fs().reserve_blocks(_prealloc_start, EXT2_PREALLOC_BLOCKS);
+		}
+	}
+
+	ext2fs().zero_block_list(ret);
+	return kstd::move(ret);
+}
+
+void Ext2Inode::discard_preallocation() {
+	LOCK(lock);
+	if(!_prealloc_count)
+		return;
+	ext2fs().unreserve_blocks(_prealloc_start, _prealloc_count);
+	_prealloc_count = 0;
+}
+
+bool Ext2Inode::is_indexed_directory() {
+	return _metadata.is_directory() && (raw.flags & EXT2_INDEX);
+}
+
+ino_t Ext2Inode::find_in_block(uint8_t* block_buf, const kstd::string& name, size_t& entry_offset, size_t& prev_offset) {
+	size_t block_size = ext2fs().block_size();
+	size_t offset = 0;
+	prev_offset = -1;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* dir = (ext2_directory*) (block_buf + offset);
+		if(dir->size < sizeof(ext2_directory) || offset + dir->size > block_size)
+			break;
+		if(dir->inode && dir->name_length == name.length()) {
+			auto* dir_name = (char*) (&dir->type + 1);
+			size_t i = 0;
+			while(i < name.length() && dir_name[i] == name[i])
+				i++;
+			if(i == name.length()) {
+				entry_offset = offset;
+				return dir->inode;
+			}
+		}
+		prev_offset = offset;
+		offset += dir->size;
+	}
+	return 0;
+}
+
+ino_t Ext2Inode::find_entry(const kstd::string& name, uint8_t* block_buf, uint32_t& block_index, size_t& entry_offset, size_t& prev_offset) {
+	//If the directory is indexed, only the leaf block(s) for the name's hash need to be searched
+	if(is_indexed_directory()) {
+		uint32_t leaves[2];
+		auto num_leaves_or_err = htree_find_leaves(name, leaves);
+		if(!num_leaves_or_err.is_error()) {
+			for(size_t i = 0; i < num_leaves_or_err.value(); i++) {
+				block_index = leaves[i];
+				if(ext2fs().read_block(get_block_pointer(block_index), block_buf).is_error())
+					return 0;
+				ino_t ret = find_in_block(block_buf, name, entry_offset, prev_offset);
+				if(ret)
+					return ret;
+			}
+			return 0;
+		}
+	}
+
+	//Otherwise, look through every block
+	for(block_index = 0; block_index < num_blocks(); block_index++) {
+		if(ext2fs().read_block(get_block_pointer(block_index), block_buf).is_error())
+			return 0;
+		ino_t ret = find_in_block(block_buf, name, entry_offset, prev_offset);
+		if(ret)
+			return ret;
+	}
+	return 0;
+}
+
+ResultRet<size_t> Ext2Inode::htree_find_leaves(const kstd::string& name, uint32_t leaves[2], ext2_htree_path* path) {
+	//Returns the leaf block the name's hash belongs in, plus the next leaf if the hash continues into it
+	size_t block_size = ext2fs().block_size();
+	auto* buf = new uint8_t[block_size];
+	if(ext2fs().read_block(get_block_pointer(0), buf).is_error()) {
+		delete[] buf;
+		return -EIO;
+	}
+
+	auto* info = (ext2_dx_root_info*) (buf + EXT2_DX_ROOT_INFO_OFFSET);
+	uint8_t hash_version = info->hash_version;
+	if(hash_version <= EXT2_HASH_TEA && (ext2fs().superblock.flags & EXT2_FLAGS_UNSIGNED_HASH))
+		hash_version += EXT2_HASH_LEGACY_UNSIGNED;
+	if(info->reserved_zero || hash_version > EXT2_HASH_TEA_UNSIGNED || info->indirect_levels >= EXT2_HTREE_MAX_LEVELS) {
+		//We don't understand this index, so we'll have to search the directory linearly
+		delete[] buf;
+		return -EINVAL;
+	}
+
+	uint32_t hash = htree_hash(name.c_str(), name.length(), hash_version);
+	size_t levels = info->indirect_levels + 1;
+	size_t entries_offset = EXT2_DX_ROOT_INFO_OFFSET + info->info_length;
+	size_t num_leaves = 0;
+	uint32_t index_block = 0;
+	if(path) {
+		path->hash = hash;
+		path->hash_version = hash_version;
+		path->levels = levels;
+	}
+	for(size_t level = 0; level < levels; level++) {
+		auto* countlimit = (ext2_dx_countlimit*) (buf + entries_offset);
+		auto* entries = (ext2_dx_entry*) (buf + entries_offset);
+		size_t count = countlimit->count;
+		if(!count || entries_offset + count * sizeof(ext2_dx_entry) > block_size) {
+			delete[] buf;
+			return -EINVAL;
+		}
+
+		//Find the last entry with a hash less than or equal to ours (the first entry has no hash and covers everything below the second)
+		size_t lo = 1, hi = count;
+		while(lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if(entries[mid].hash > hash)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		size_t index = lo - 1;
+		uint32_t block = entries[index].block & 0x0FFFFFFF;
+		if(path) {
+			path->blocks[level] = index_block;
+			path->entries_offsets[level] = entries_offset;
+			path->positions[level] = index;
+		}
+
+		if(level == levels - 1) {
+			leaves[num_leaves++] = block;
+			//If the next block's range starts with the same hash (marked by the low bit), the hash may continue into it
+			if(index + 1 < count && (entries[index + 1].hash & ~1u) == hash && (entries[index + 1].hash & 1))
+				leaves[num_leaves++] = entries[index + 1].block & 0x0FFFFFFF;
+		} else {
+			if(block >= num_blocks() || ext2fs().read_block(get_block_pointer(block), buf).is_error()) {
+				delete[] buf;
+				return -EIO;
+			}
+			entries_offset = EXT2_DX_NODE_ENTRIES_OFFSET;
+			index_block = block;
+		}
+	}
+
+	delete[] buf;
+	for(size_t i = 0; i < num_leaves; i++)
+		if(leaves[i] >= num_blocks())
+			return -EINVAL;
+	return num_leaves;
+}
+
+bool Ext2Inode::insert_into_block(uint8_t* block_buf, const kstd::string& name, ino_t entry_id, uint8_t type) {
+	size_t block_size = ext2fs().block_size();
+	size_t needed = dir_entry_size(name.length());
+	size_t offset = 0;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* dir = (ext2_directory*) (block_buf + offset);
+		if(dir->size < sizeof(ext2_directory) || offset + dir->size > block_size)
+			return false;
+
+		//Use the slack at the end of an entry, or an unused entry
+		size_t used = dir->inode ? dir_entry_size(dir->name_length) : 0;
+		if(dir->size - used >= needed) {
+			auto* new_dir = (ext2_directory*) (block_buf + offset + used);
+			if(used) {
+				new_dir->size = dir->size - used;
+				dir->size = used;
+			}
+			new_dir->inode = entry_id;
+			new_dir->name_length = name.length();
+			new_dir->type = type;
+			memcpy(&new_dir->type + 1, name.c_str(), name.length());
+			return true;
+		}
+
+		offset += dir->size;
+	}
+	return false;
+}
+
+Result Ext2Inode::insert_entry(const kstd::string& name, ino_t entry_id, uint8_t type) {
+	size_t block_size = ext2fs().block_size();
+
+	if(is_indexed_directory()) {
+		Result res = htree_insert_entry(name, entry_id, type, true);
+		if(res.code() != -EINVAL)
+			return res;
+
+		//We don't understand the index, so stop using it. The directory is still a valid unindexed directory since
+		//index blocks look like empty directory blocks.
+		raw.flags &= ~EXT2_INDEX;
+		write_inode_entry();
+	}
+
+	//Make sure the name isn't taken
+	auto* buf = new uint8_t[block_size];
+	uint32_t found_block;
+	size_t found_offset, found_prev_offset;
+	if(find_entry(name, buf, found_block, found_offset, found_prev_offset)) {
+		delete[] buf;
+		return -EEXIST;
+	}
+
+	//Try to fit the entry in the last block
+	if(num_blocks()) {
+		uint32_t last_block = get_block_pointer(num_blocks() - 1);
+		Result res = ext2fs().read_block(last_block, buf);
+		if(res.is_error()) {
+			delete[] buf;
+			return res;
+		}
+		if(insert_into_block(buf, name, entry_id, type)) {
+			res = ext2fs().write_metadata_block(last_block, buf);
+			delete[] buf;
+			return res;
+		}
+	}
+
+	//If the directory is outgrowing its first block, index it so that it doesn't have to be searched linearly
+	if(num_blocks() == 1 && (ext2fs().superblock.optional_features & EXT2_FEATURE_COMPAT_DIR_INDEX)) {
+		Result res = htree_create();
+		if(res.is_success()) {
+			delete[] buf;
+			return htree_insert_entry(name, entry_id, type, false);
+		}
+	}
+
+	//Add a new block with an entry spanning all of it
+	Result res = truncate((off_t) (num_blocks() + 1) * block_size);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+	auto* dir = (ext2_directory*) buf;
+	dir->inode = 0;
+	dir->size = block_size;
+	insert_into_block(buf, name, entry_id, type);
+	res = ext2fs().write_metadata_block(get_block_pointer(num_blocks() - 1), buf);
+	delete[] buf;
+	return res;
+}
+
+uint32_t Ext2Inode::htree_hash(const char* name, size_t length, uint8_t hash_version) {
+	uint32_t seed[4];
+	memcpy(seed, (void*) ext2fs().superblock.hash_seed, sizeof(seed));
+	return ext2_dir_hash(name, length, hash_version, seed);
+}
+
+//Copies the entries at the given offsets in src into dest one after another, with the last one spanning the rest of the block
+static void pack_dir_entries(uint8_t* dest, const uint8_t* src, const kstd::vector<size_t>& offsets, size_t block_size) {
+	size_t dest_offset = 0;
+	ext2_directory* last = nullptr;
+	for(size_t i = 0; i < offsets.size(); i++) {
+		auto* entry = (ext2_directory*) (src + offsets[i]);
+		size_t entry_size = dir_entry_size(entry->name_length);
+		last = (ext2_directory*) (dest + dest_offset);
+		memcpy(last, entry, entry_size);
+		last->size = entry_size;
+		dest_offset += entry_size;
+	}
+
+	if(last) {
+		last->size += block_size - dest_offset;
+	} else {
+		last = (ext2_directory*) dest;
+		last->inode = 0;
+		last->size = block_size;
+		last->name_length = 0;
+		last->type = EXT2_FT_UNKNOWN;
+	}
+}
+
+//Inserts an index entry before the given position in a list of index entries
+static void insert_dx_entry(ext2_dx_entry* entries, size_t position, uint32_t hash, uint32_t block) {
+	auto* countlimit = (ext2_dx_countlimit*) entries;
+	for(size_t i = countlimit->count; i > position; i--)
+		entries[i] = entries[i - 1];
+	entries[position].hash = hash;
+	entries[position].block = block;
+	countlimit->count++;
+}
+
+Result Ext2Inode::htree_insert_entry(const kstd::string& name, ino_t entry_id, uint8_t type, bool check_exists) {
+	size_t block_size = ext2fs().block_size();
+	auto* buf = new uint8_t[block_size];
+	Result res = SUCCESS;
+
+	//If the leaf the name hashes to is full, it's split and we try again (the name may hash into the full half again if
+	//most of the leaf has the same hash, so we try a few times)
+	for(int attempt = 0; attempt < 3; attempt++) {
+		ext2_htree_path path;
+		uint32_t leaves[2];
+		auto num_leaves_or_err = htree_find_leaves(name, leaves, &path);
+		if(num_leaves_or_err.is_error()) {
+			res = num_leaves_or_err.code();
+			break;
+		}
+
+		//Make sure the name isn't taken by looking in the leaves it could be in (the first one is read last so we can insert into it)
+		for(size_t i = check_exists ? num_leaves_or_err.value() : 1; i > 0; i--) {
+			res = ext2fs().read_block(get_block_pointer(leaves[i - 1]), buf);
+			if(res.is_error())
+				break;
+			size_t entry_offset, prev_offset;
+			if(check_exists && find_in_block(buf, name, entry_offset, prev_offset)) {
+				res = -EEXIST;
+				break;
+			}
+		}
+		if(res.is_error())
+			break;
+		check_exists = false;
+
+		if(insert_into_block(buf, name, entry_id, type)) {
+			res = ext2fs().write_metadata_block(get_block_pointer(leaves[0]), buf);
+			break;
+		}
+
+		res = htree_split_leaf(path, leaves[0], buf);
+		if(res.is_error())
+			break;
+		res = -ENOSPC;
+	}
+
+	delete[] buf;
+	return res;
+}
+
+Result Ext2Inode::htree_split_leaf(const ext2_htree_path& path, uint32_t leaf, uint8_t* leaf_buf) {
+	size_t block_size = ext2fs().block_size();
+
+	//Hash all of the entries in the leaf and sort them by hash
+	kstd::vector<uint32_t> hashes;
+	kstd::vector<size_t> offsets;
+	size_t offset = 0;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* dir = (ext2_directory*) (leaf_buf + offset);
+		if(dir->size < sizeof(ext2_directory) || offset + dir->size > block_size)
+			return -EIO;
+		if(dir->inode) {
+			uint32_t hash = htree_hash((char*) (&dir->type + 1), dir->name_length, path.hash_version);
+			size_t i = hashes.size();
+			hashes.push_back(hash);
+			offsets.push_back(offset);
+			for(; i > 0 && hashes[i - 1] > hash; i--) {
+				hashes[i] = hashes[i - 1];
+				offsets[i] = offsets[i - 1];
+			}
+			hashes[i] = hash;
+			offsets[i] = offset;
+		}
+		offset += dir->size;
+	}
+	if(hashes.size() < 2)
+		return -ENOSPC;
+
+	//Move the upper half of the hashes into a new leaf. If the hash at the split continues from the lower half, mark
+	//the new leaf's index entry with the low bit so lookups for that hash search both leaves.
+	size_t split = hashes.size() / 2;
+	uint32_t split_hash = hashes[split];
+	if(hashes[split - 1] == split_hash)
+		split_hash |= 1;
+
+	kstd::vector<size_t> low_offsets;
+	kstd::vector<size_t> high_offsets;
+	for(size_t i = 0; i < offsets.size(); i++)
+		(i < split ? low_offsets : high_offsets).push_back(offsets[i]);
+
+	Result res = truncate((off_t) (num_blocks() + 1) * block_size);
+	if(res.is_error())
+		return res;
+	uint32_t new_leaf = num_blocks() - 1;
+
+	auto* new_buf = new uint8_t[block_size];
+	pack_dir_entries(new_buf, leaf_buf, high_offsets, block_size);
+	res = ext2fs().write_metadata_block(get_block_pointer(new_leaf), new_buf);
+	if(res.is_success()) {
+		memcpy(new_buf, leaf_buf, block_size);
+		pack_dir_entries(leaf_buf, new_buf, low_offsets, block_size);
+		res = ext2fs().write_metadata_block(get_block_pointer(leaf), leaf_buf);
+	}
+	delete[] new_buf;
+	if(res.is_error())
+		return res;
+
+	return htree_insert_index(path, split_hash, new_leaf);
+}
+
+Result Ext2Inode::htree_insert_index(const ext2_htree_path& path, uint32_t hash, uint32_t block) {
+	size_t block_size = ext2fs().block_size();
+	size_t level = path.levels - 1;
+	size_t position = path.positions[level] + 1;
+	auto* buf = new uint8_t[block_size];
+	Result res = ext2fs().read_block(get_block_pointer(path.blocks[level]), buf);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	auto* entries = (ext2_dx_entry*) (buf + path.entries_offsets[level]);
+	auto* countlimit = (ext2_dx_countlimit*) entries;
+
+	//If there's room in the index block above the leaf, just add the entry there
+	if(countlimit->count < countlimit->limit) {
+		insert_dx_entry(entries, position, hash, block);
+		res = ext2fs().write_metadata_block(get_block_pointer(path.blocks[level]), buf);
+		delete[] buf;
+		return res;
+	}
+
+	//Otherwise, we'll need a new index block
+	res = truncate((off_t) (num_blocks() + 1) * block_size);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+	uint32_t new_node = num_blocks() - 1;
+	auto* node_buf = new uint8_t[block_size];
+	memset(node_buf, 0, block_size);
+	auto* node_dir = (ext2_directory*) node_buf;
+	node_dir->size = block_size;
+	auto* node_entries = (ext2_dx_entry*) (node_buf + EXT2_DX_NODE_ENTRIES_OFFSET);
+	auto* node_countlimit = (ext2_dx_countlimit*) node_entries;
+
+	if(path.levels == 1) {
+		//The root is full, so move its entries into a new index block below it
+		for(size_t i = 1; i < countlimit->count; i++)
+			node_entries[i] = entries[i];
+		node_entries[0].block = entries[0].block;
+		node_countlimit->limit = (block_size - EXT2_DX_NODE_ENTRIES_OFFSET) / sizeof(ext2_dx_entry);
+		node_countlimit->count = countlimit->count;
+		insert_dx_entry(node_entries, position, hash, block);
+
+		countlimit->count = 1;
+		entries[0].block = new_node;
+		((ext2_dx_root_info*) (buf + EXT2_DX_ROOT_INFO_OFFSET))->indirect_levels = 1;
+
+		res = ext2fs().write_metadata_block(get_block_pointer(new_node), node_buf);
+		if(res.is_success())
+			res = ext2fs().write_metadata_block(get_block_pointer(0), buf);
+		delete[] node_buf;
+		delete[] buf;
+		return res;
+	}
+
+	//A lower index block is full, so move the upper half of it into a new index block and add that to the root
+	auto* root_buf = new uint8_t[block_size];
+	res = ext2fs().read_block(get_block_pointer(path.blocks[0]), root_buf);
+	auto* root_entries = (ext2_dx_entry*) (root_buf + path.entries_offsets[0]);
+	auto* root_countlimit = (ext2_dx_countlimit*) root_entries;
+	if(res.is_success() && root_countlimit->count >= root_countlimit->limit) {
+		printf("WARNING: The index of directory inode %d is full\n", id);
+		res = -ENOSPC;
+	}
+
+	if(res.is_success()) {
+		size_t count = countlimit->count;
+		size_t split = count / 2;
+		uint32_t split_hash = entries[split].hash;
+		for(size_t i = split; i < count; i++)
+			node_entries[i - split] = entries[i];
+		node_countlimit->limit = countlimit->limit;
+		node_countlimit->count = count - split;
+		countlimit->count = split;
+		insert_dx_entry(root_entries, path.positions[0] + 1, split_hash, new_node);
+
+		//Then add the new entry to whichever half it belongs in
+		if(position <= split)
+			insert_dx_entry(entries, position, hash, block);
+		else
+			insert_dx_entry(node_entries, position - split, hash, block);
+
+		res = ext2fs().write_metadata_block(get_block_pointer(new_node), node_buf);
+		if(res.is_success())
+			res = ext2fs().write_metadata_block(get_block_pointer(path.blocks[level]), buf);
+		if(res.is_success())
+			res = ext2fs().write_metadata_block(get_block_pointer(path.blocks[0]), root_buf);
+	}
+
+	delete[] root_buf;
+	delete[] node_buf;
+	delete[] buf;
+	return res;
+}
+
+Result Ext2Inode::htree_create() {
+	//Turns a directory with a single block into an indexed directory with the root index in the first block, and every
+	//entry besides "." and ".." moved into one leaf
+	size_t block_size = ext2fs().block_size();
+	auto* buf = new uint8_t[block_size];
+	Result res = ext2fs().read_block(get_block_pointer(0), buf);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	//The root index has to come right after "." and "..", so make sure they're where we expect them to be
+	auto* dot = (ext2_directory*) buf;
+	auto* dotdot = (ext2_directory*) (buf + dir_entry_size(1));
+	if(dot->size != dir_entry_size(1) || dot->name_length != 1 || dotdot->name_length != 2
+	   || dotdot->size < dir_entry_size(2) || dir_entry_size(1) + dotdot->size > block_size) {
+		delete[] buf;
+		return -EINVAL;
+	}
+
+	kstd::vector<size_t> offsets;
+	size_t offset = dir_entry_size(1) + dotdot->size;
+	while(offset + sizeof(ext2_directory) <= block_size) {
+		auto* dir = (ext2_directory*) (buf + offset);
+		if(dir->size < sizeof(ext2_directory) || offset + dir->size > block_size)
+			break;
+		if(dir->inode)
+			offsets.push_back(offset);
+		offset += dir->size;
+	}
+
+	res = truncate((off_t) 2 * block_size);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	auto* leaf_buf = new uint8_t[block_size];
+	pack_dir_entries(leaf_buf, buf, offsets, block_size);
+	res = ext2fs().write_metadata_block(get_block_pointer(1), leaf_buf);
+	delete[] leaf_buf;
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	//Make ".." span the rest of the block, and put the root index in its slack
+	dotdot->size = block_size - dir_entry_size(1);
+	memset(buf + EXT2_DX_ROOT_INFO_OFFSET, 0, block_size - EXT2_DX_ROOT_INFO_OFFSET);
+	auto* info = (ext2_dx_root_info*) (buf + EXT2_DX_ROOT_INFO_OFFSET);
+	uint8_t hash_version = ext2fs().superblock.default_hash_version;
+	info->hash_version = hash_version <= EXT2_HASH_TEA ? hash_version : EXT2_HASH_HALF_MD4;
+	info->info_length = sizeof(ext2_dx_root_info);
+	size_t entries_offset = EXT2_DX_ROOT_INFO_OFFSET + sizeof(ext2_dx_root_info);
+	auto* entries = (ext2_dx_entry*) (buf + entries_offset);
+	auto* countlimit = (ext2_dx_countlimit*) entries;
+	countlimit->limit = (block_size - entries_offset) / sizeof(ext2_dx_entry);
+	countlimit->count = 1;
+	entries[0].block = 1;
+	res = ext2fs().write_metadata_block(get_block_pointer(0), buf);
+	delete[] buf;
+	if(res.is_error())
+		return res;
+
+	raw.flags |= EXT2_INDEX;
+	return write_inode_entry();
+}
+
 void Ext2Inode::open(FileDescriptor& fd, int options) {
 
 }
 
 void Ext2Inode::close(FileDescriptor& fd) {
+	//Give back any blocks we reserved for appending
+	Ext2Transaction transaction(ext2fs());
+	discard_preallocation();
 
 }
 
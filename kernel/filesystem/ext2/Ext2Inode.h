@@ -22,6 +22,7 @@
 
 #include <kernel/filesystem/Inode.h>
 #include <kernel/kstd/vector.hpp>
+#include "Ext2HTree.h"
 
 class Ext2Filesystem;
 class Ext2Inode: public Inode {
@@ -62,6 +63,7 @@ public:
 
 	uint32_t get_block_pointer(uint32_t block_index);
 	bool set_block_pointer(uint32_t block_index, uint32_t block);
+	size_t contiguous_blocks(uint32_t block_index, size_t max_blocks, uint32_t& first_block);
 	kstd::vector<uint32_t>& get_block_pointers();
 	void free_all_blocks();
 
@@ -77,6 +79,7 @@ public:
 	Result chown(uid_t uid, gid_t gid) override;
 	void open(FileDescriptor& fd, int options) override;
 	void close(FileDescriptor& fd) override;
+	Result sync() override;
 
 private:
 	void read_singly_indirect(uint32_t singly_indirect_block, uint32_t& block_index, uint8_t* block_buf);
@@ -92,12 +95,28 @@ private:
 	void increase_hardlink_count();
 	Result try_remove_dir();
 	uint32_t calculate_num_ptr_blocks(uint32_t num_blocks);
+	bool is_indexed_directory();
+	ino_t find_in_block(uint8_t* block_buf, const kstd::string& name, size_t& entry_offset, size_t& prev_offset);
+	ino_t find_entry(const kstd::string& name, uint8_t* block_buf, uint32_t& block_index, size_t& entry_offset, size_t& prev_offset);
+	ResultRet<size_t> htree_find_leaves(const kstd::string& name, uint32_t leaves[2], ext2_htree_path* path = nullptr);
+	bool insert_into_block(uint8_t* block_buf, const kstd::string& name, ino_t entry_id, uint8_t type);
+	Result insert_entry(const kstd::string& name, ino_t entry_id, uint8_t type);
+	uint32_t htree_hash(const char* name, size_t length, uint8_t hash_version);
+	Result htree_insert_entry(const kstd::string& name, ino_t entry_id, uint8_t type, bool check_exists);
+	Result htree_split_leaf(const ext2_htree_path& path, uint32_t leaf, uint8_t* leaf_buf);
+	Result htree_insert_index(const ext2_htree_path& path, uint32_t hash, uint32_t block);
+	Result htree_create();
+	uint32_t allocation_goal();
+	ResultRet<kstd::vector<uint32_t>> allocate_data_blocks(uint32_t count);
+	void discard_preallocation();
 
 	kstd::vector<uint32_t> block_pointers;
 	kstd::vector<uint32_t> pointer_blocks;
 
 	Raw raw;
 	bool _dirty = false;
+	uint32_t _prealloc_start = 0;
+	uint32_t _prealloc_count = 0;
 };
 
 #endif //DUCKOS_EXT2INODE_H
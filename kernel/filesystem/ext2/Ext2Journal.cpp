@@ -0,0 +1,643 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "Ext2Journal.h"
+#include "Ext2Filesystem.h"
+#include "Ext2Inode.h"
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Thread.h>
+#include <kernel/tasking/SleepBlocker.h>
+
+#define PASS_SCAN 0
+#define PASS_REVOKE 1
+#define PASS_REPLAY 2
+
+kstd::vector<Ext2Journal*> Ext2Journal::_journals;
+SpinLock Ext2Journal::_journals_lock;
+
+static inline uint32_t be32(uint32_t val) {
+	return __builtin_bswap32(val);
+}
+
+static bool remove_block(kstd::vector<uint32_t>& list, uint32_t block) {
+	for(size_t i = 0; i < list.size(); i++) {
+		if(list[i] == block) {
+			list.erase(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void add_block(kstd::vector<uint32_t>& list, uint32_t block) {
+	for(size_t i = 0; i < list.size(); i++)
+		if(list[i] == block)
+			return;
+	list.push_back(block);
+}
+
+Ext2Journal* Ext2Journal::load(Ext2Filesystem& fs) {
+	if(!(fs.superblock.optional_features & EXT3_FEATURE_COMPAT_HAS_JOURNAL))
+		return nullptr;
+
+	if((fs.superblock.required_features & EXT3_FEATURE_INCOMPAT_JOURNAL_DEV) || !fs.superblock.journal_inode) {
+		printf("[ext2] External journals aren't supported. Mounting without journaling.\n");
+		return nullptr;
+	}
+
+	auto inode_or_err = fs.get_inode(fs.superblock.journal_inode);
+	if(inode_or_err.is_error()) {
+		printf("[ext2] Error %d reading the journal inode. Mounting without journaling.\n", inode_or_err.code());
+		return nullptr;
+	}
+
+	auto inode = kstd::static_pointer_cast<Ext2Inode>(inode_or_err.value());
+	auto* journal = new Ext2Journal(fs, inode->get_block_pointers());
+	Result res = journal->init();
+	if(res.is_error()) {
+		printf("[ext2] Error %d loading the journal. Mounting without journaling.\n", res.code());
+		delete journal;
+		return nullptr;
+	}
+
+	LOCK(_journals_lock);
+	_journals.push_back(journal);
+	return journal;
+}
+
+Ext2Journal::Ext2Journal(Ext2Filesystem& fs, kstd::vector<uint32_t>& blocks): _fs(fs), _blocks(blocks) {
+
+}
+
+Ext2Journal::~Ext2Journal() {
+	LOCK(_journals_lock);
+	for(size_t i = 0; i < _journals.size(); i++) {
+		if(_journals[i] == this) {
+			_journals.erase(i);
+			break;
+		}
+	}
+}
+
+void Ext2Journal::begin() {
+	LOCK(_lock);
+
+	//Nothing is half-written when there are no open handles, so this is the time to make room in the log if it's getting full
+	if(!_handles && _start && free_space() < (_max_length - _first) / 2) {
+		commit();
+		flush_checkpoint();
+	}
+
+	_handles++;
+}
+
+Result Ext2Journal::end() {
+	LOCK(_lock);
+	if(!_handles) {
+		printf("WARNING: Ended an ext2 journal transaction that wasn't started!\n");
+		return -EINVAL;
+	}
+
+	//Once the last handle on the transaction closes, everything in it is consistent and it can be committed. To batch
+	//operations together, that only happens once it's big or old enough (otherwise, kjournal will commit it).
+	if(--_handles || _transaction_blocks.empty())
+		return SUCCESS;
+	if(_transaction_blocks.size() < max_transaction_blocks(0) / 2 && Time::now() - _transaction_start < Time(JBD_CHECKPOINT_INTERVAL, 0))
+		return SUCCESS;
+	return commit();
+}
+
+Result Ext2Journal::write_block(uint32_t block, const uint8_t* buffer) {
+	LOCK(_lock);
+	begin();
+
+	//The log has to be marked as needing recovery before anything is committed to it
+	Result res = SUCCESS;
+	if(!_needs_recovery)
+		res = set_needs_recovery(true);
+
+	//If a committed transaction has the block and it hasn't been checkpointed yet, write the committed copy home
+	//first. Otherwise, checkpointing it later would write our uncommitted changes home.
+	if(res.is_success() && remove_block(_checkpoint_blocks, block))
+		res = _fs.flush_blocks(block, 1);
+
+	//The superblock may have been copied into the buffer before the flag was set, and it needs to stay set in the
+	//copy that gets checkpointed
+	uint8_t* superblock_buf = nullptr;
+	if(res.is_success() && block == 1024 / _fs.block_size()) {
+		superblock_buf = new uint8_t[_fs.block_size()];
+		memcpy(superblock_buf, buffer, _fs.block_size());
+		((ext2_superblock*) (superblock_buf + 1024 % _fs.block_size()))->required_features |= EXT3_FEATURE_INCOMPAT_RECOVER;
+		buffer = superblock_buf;
+	}
+
+	//Keep the block in the disk cache until it's committed and checkpointed
+	if(res.is_success())
+		res = _fs.write_blocks_deferred(block, 1, buffer);
+	delete[] superblock_buf;
+	if(res.is_success()) {
+		if(_transaction_blocks.empty())
+			_transaction_start = Time::now();
+		add_block(_transaction_blocks, block);
+		remove_block(_revoked_blocks, block);
+	}
+
+	Result end_res = end();
+	return res.is_error() ? res : end_res;
+}
+
+void Ext2Journal::revoke(uint32_t block) {
+	LOCK(_lock);
+	remove_block(_transaction_blocks, block);
+
+	//If a committed transaction has the block, replaying it could overwrite whatever the block gets reused for
+	if(remove_block(_checkpoint_blocks, block))
+		add_block(_revoked_blocks, block);
+}
+
+Result Ext2Journal::checkpoint() {
+	LOCK(_lock);
+	if(_handles)
+		return SUCCESS;
+
+	Result res = commit();
+	if(res.is_error())
+		return res;
+	return flush_checkpoint();
+}
+
+void Ext2Journal::kjournal() {
+	while(true) {
+		SleepBlocker blocker(Time(JBD_CHECKPOINT_INTERVAL, 0));
+		TaskManager::current_thread()->block(blocker);
+
+		kstd::vector<Ext2Journal*> journals;
+		{
+			LOCK(_journals_lock);
+			journals = _journals;
+		}
+
+		for(size_t i = 0; i < journals.size(); i++) {
+			Result res = journals[i]->checkpoint();
+			if(res.is_error())
+				printf("[kjournal] Error %d checkpointing journal!\n", res.code());
+		}
+	}
+}
+
+Result Ext2Journal::init() {
+	if(_blocks.empty())
+		return -EINVAL;
+
+	auto* buf = new uint8_t[_fs.block_size()];
+	Result res = read_journal_block(0, buf);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	auto* sb = (jbd_superblock*) buf;
+	uint32_t type = be32(sb->header.block_type);
+	uint32_t incompat = be32(sb->incompat_features);
+	if(be32(sb->header.magic) != JBD_MAGIC || (type != JBD_SUPERBLOCK_V1 && type != JBD_SUPERBLOCK_V2)) {
+		printf("[ext2] The journal superblock is invalid.\n");
+		delete[] buf;
+		return -EINVAL;
+	} else if(type == JBD_SUPERBLOCK_V1) {
+		printf("[ext2] Version 1 journals aren't supported.\n");
+		delete[] buf;
+		return -EINVAL;
+	} else if(incompat & ~JBD_FEATURE_INCOMPAT_REVOKE) {
+		printf("[ext2] The journal has unsupported features 0x%x.\n", incompat);
+		delete[] buf;
+		return -EINVAL;
+	} else if(be32(sb->block_size) != _fs.block_size()) {
+		printf("[ext2] The journal's block size doesn't match the filesystem's.\n");
+		delete[] buf;
+		return -EINVAL;
+	}
+
+	_first = be32(sb->first);
+	_max_length = min(be32(sb->max_length), (uint32_t) _blocks.size());
+	_sequence = be32(sb->sequence);
+	_start = be32(sb->start);
+	memcpy(_uuid, sb->uuid, sizeof(_uuid));
+	delete[] buf;
+
+	if(!_first || _first + 2 >= _max_length)
+		return -EINVAL;
+
+	//If the log isn't empty, the filesystem wasn't unmounted cleanly and the transactions in it have to be replayed
+	if(_start) {
+		res = recover();
+		if(res.is_error())
+			return res;
+
+		//The replay may have written the superblock, so the copy read before it is out of date
+		_fs.read_superblock(&_fs.superblock);
+	}
+
+	_start = 0;
+	_head = _first;
+	res = write_journal_superblock();
+	if(res.is_error())
+		return res;
+
+	//The log is empty, so it doesn't need to be recovered. The flag is set again before anything is written to it.
+	_needs_recovery = _fs.superblock.required_features & EXT3_FEATURE_INCOMPAT_RECOVER;
+	return set_needs_recovery(false);
+}
+
+Result Ext2Journal::recover() {
+	printf("[ext2] Recovering journal...\n");
+
+	//Find the end of the log, then find revoked blocks, then write everything that wasn't revoked to its home location
+	kstd::map<uint32_t, uint32_t> revoked;
+	uint32_t end_sequence = _sequence;
+	for(int pass = PASS_SCAN; pass <= PASS_REPLAY; pass++) {
+		Result res = scan_log(pass, end_sequence, revoked);
+		if(res.is_error()) {
+			printf("[ext2] Error %d recovering journal!\n", res.code());
+			return res;
+		}
+	}
+
+	printf("[ext2] Replayed %d transaction(s) from the journal.\n", end_sequence - _sequence);
+	_sequence = end_sequence;
+	return SUCCESS;
+}
+
+Result Ext2Journal::scan_log(int pass, uint32_t& end_sequence, kstd::map<uint32_t, uint32_t>& revoked) {
+	size_t block_size = _fs.block_size();
+	auto* buf = new uint8_t[block_size];
+	auto* data_buf = new uint8_t[block_size];
+	uint32_t sequence = _sequence;
+	uint32_t index = _start;
+	Result res = SUCCESS;
+
+	for(uint32_t num_scanned = 0; num_scanned < _max_length && res.is_success();) {
+		//Only committed transactions (found by the scan pass) get revoked and replayed
+		if(pass != PASS_SCAN && sequence == end_sequence)
+			break;
+
+		res = read_journal_block(index, buf);
+		if(res.is_error())
+			break;
+
+		//The log ends at the first block that doesn't belong to the transaction we expect next
+		auto* header = (jbd_header*) buf;
+		if(be32(header->magic) != JBD_MAGIC || be32(header->sequence) != sequence)
+			break;
+		index = next_index(index);
+		num_scanned++;
+
+		uint32_t type = be32(header->block_type);
+		if(type == JBD_DESCRIPTOR_BLOCK) {
+			//Each tag describes one of the blocks following the descriptor
+			size_t offset = sizeof(jbd_header);
+			while(offset + sizeof(jbd_block_tag) <= block_size) {
+				auto* tag = (jbd_block_tag*) (buf + offset);
+				uint32_t block = be32(tag->block);
+				uint32_t flags = be32(tag->flags);
+
+				if(pass == PASS_REPLAY && !(revoked.contains(block) && revoked[block] >= sequence)) {
+					res = read_journal_block(index, data_buf);
+					if(res.is_error())
+						break;
+					if(flags & JBD_FLAG_ESCAPE)
+						*((uint32_t*) data_buf) = be32(JBD_MAGIC);
+					res = _fs.write_block(block, data_buf);
+					if(res.is_error())
+						break;
+				}
+
+				index = next_index(index);
+				num_scanned++;
+				offset += sizeof(jbd_block_tag);
+				if(!(flags & JBD_FLAG_SAME_UUID))
+					offset += sizeof(_uuid);
+				if(flags & JBD_FLAG_LAST_TAG)
+					break;
+			}
+		} else if(type == JBD_COMMIT_BLOCK) {
+			sequence++;
+			if(pass == PASS_SCAN)
+				end_sequence = sequence;
+		} else if(type == JBD_REVOKE_BLOCK) {
+			if(pass == PASS_REVOKE) {
+				auto* revoke_header = (jbd_revoke_header*) buf;
+				size_t count = min((size_t) be32(revoke_header->count), block_size);
+				for(size_t offset = sizeof(jbd_revoke_header); offset + sizeof(uint32_t) <= count; offset += sizeof(uint32_t)) {
+					uint32_t block = be32(*((uint32_t*) (buf + offset)));
+					if(!revoked.contains(block) || revoked[block] < sequence)
+						revoked[block] = sequence;
+				}
+			}
+		} else {
+			break;
+		}
+	}
+
+	delete[] buf;
+	delete[] data_buf;
+	return res;
+}
+
+Result Ext2Journal::commit() {
+	//Must be called with the lock held and no open handles
+	if(_transaction_blocks.empty())
+		return SUCCESS;
+
+	//If the transaction is too big for the log, it's split into pieces that fit. Every block still goes through the
+	//log before it's written home, but a crash between the pieces will only replay the ones before it.
+	size_t num_written = 0;
+	while(num_written < _transaction_blocks.size()) {
+		size_t num_revoked = num_written ? 0 : _revoked_blocks.size();
+		size_t num_blocks = min(_transaction_blocks.size() - num_written, max_transaction_blocks(num_revoked));
+		if(!num_blocks)
+			return -ENOSPC;
+		if(!num_written && num_blocks < _transaction_blocks.size())
+			printf("[ext2] A transaction of %d blocks doesn't fit in the journal. Splitting it.\n", _transaction_blocks.size());
+
+		//Make room in the log if needed by writing everything in it home
+		Result res = SUCCESS;
+		if(log_blocks_needed(num_blocks, num_revoked) > free_space())
+			res = flush_checkpoint();
+		if(res.is_success())
+			res = write_transaction(num_written, num_blocks, !num_written);
+		if(res.is_error()) {
+			printf("[ext2] Error %d committing transaction %d to the journal!\n", res.code(), _sequence);
+			return res;
+		}
+		num_written += num_blocks;
+	}
+
+	_transaction_blocks.resize(0);
+	_revoked_blocks.resize(0);
+	return SUCCESS;
+}
+
+Result Ext2Journal::write_transaction(size_t first_block, size_t num_blocks, bool with_revokes) {
+	//Writes part of the running transaction to the log as one transaction. The caller makes sure it fits.
+	size_t block_size = _fs.block_size();
+	size_t num_tags = tags_per_descriptor();
+	size_t num_revoked = with_revokes ? _revoked_blocks.size() : 0;
+
+	//If the log was empty, it starts with this transaction
+	Result res = SUCCESS;
+	if(!_start) {
+		_start = _head;
+		res = write_journal_superblock();
+		if(res.is_error())
+			return res;
+	}
+
+	auto* buf = new uint8_t[block_size * (num_tags + 1)];
+	uint32_t index = _head;
+
+	//First, write the revoke records
+	for(size_t i = 0; i < num_revoked && res.is_success();) {
+		memset(buf, 0, block_size);
+		auto* revoke_header = (jbd_revoke_header*) buf;
+		revoke_header->header.magic = be32(JBD_MAGIC);
+		revoke_header->header.block_type = be32(JBD_REVOKE_BLOCK);
+		revoke_header->header.sequence = be32(_sequence);
+
+		size_t offset = sizeof(jbd_revoke_header);
+		for(; i < num_revoked && offset + sizeof(uint32_t) <= block_size; i++, offset += sizeof(uint32_t))
+			*((uint32_t*) (buf + offset)) = be32(_revoked_blocks[i]);
+		revoke_header->count = be32(offset);
+
+		res = write_journal_blocks(index, 1, buf);
+		index = next_index(index);
+	}
+
+	//Then, write a descriptor followed by the blocks it describes, for as many descriptors as we need
+	for(size_t i = 0; i < num_blocks && res.is_success();) {
+		size_t group_size = min(num_tags, num_blocks - i);
+		memset(buf, 0, block_size);
+		auto* header = (jbd_header*) buf;
+		header->magic = be32(JBD_MAGIC);
+		header->block_type = be32(JBD_DESCRIPTOR_BLOCK);
+		header->sequence = be32(_sequence);
+
+		size_t offset = sizeof(jbd_header);
+		for(size_t j = 0; j < group_size && res.is_success(); j++) {
+			uint32_t block = _transaction_blocks[first_block + i + j];
+			uint8_t* data = buf + (j + 1) * block_size;
+			res = _fs.read_block(block, data);
+
+			//Blocks that look like the start of a journal block have to be escaped
+			uint32_t flags = j ? JBD_FLAG_SAME_UUID : 0;
+			if(*((uint32_t*) data) == be32(JBD_MAGIC)) {
+				flags |= JBD_FLAG_ESCAPE;
+				*((uint32_t*) data) = 0;
+			}
+			if(j == group_size - 1)
+				flags |= JBD_FLAG_LAST_TAG;
+
+			auto* tag = (jbd_block_tag*) (buf + offset);
+			tag->block = be32(block);
+			tag->flags = be32(flags);
+			offset += sizeof(jbd_block_tag);
+			if(!j) {
+				memcpy(buf + offset, _uuid, sizeof(_uuid));
+				offset += sizeof(_uuid);
+			}
+		}
+
+		if(res.is_success())
+			res = write_journal_blocks(index, group_size + 1, buf);
+		for(size_t j = 0; j < group_size + 1; j++)
+			index = next_index(index);
+		i += group_size;
+	}
+
+	//Finally, the commit block makes the transaction valid
+	if(res.is_success()) {
+		memset(buf, 0, block_size);
+		auto* header = (jbd_header*) buf;
+		header->magic = be32(JBD_MAGIC);
+		header->block_type = be32(JBD_COMMIT_BLOCK);
+		header->sequence = be32(_sequence);
+		res = write_journal_blocks(index, 1, buf);
+		index = next_index(index);
+	}
+	delete[] buf;
+	if(res.is_error())
+		return res;
+
+	//The blocks are safe in the log now, so they can be written home whenever we checkpoint
+	for(size_t i = 0; i < num_blocks; i++)
+		add_block(_checkpoint_blocks, _transaction_blocks[first_block + i]);
+	_head = index;
+	_sequence++;
+
+	return SUCCESS;
+}
+
+Result Ext2Journal::flush_checkpoint() {
+	//Must be called with the lock held and no open handles, so that the disk cache only holds committed changes
+	if(!_start)
+		return SUCCESS;
+
+	Result res = SUCCESS;
+	for(size_t i = 0; i < _checkpoint_blocks.size(); i++) {
+		Result flush_res = _fs.flush_blocks(_checkpoint_blocks[i], 1);
+		if(flush_res.is_error())
+			res = flush_res;
+	}
+	if(res.is_error())
+		return res;
+
+	_checkpoint_blocks.resize(0);
+	_start = 0;
+	_head = _first;
+	res = write_journal_superblock();
+	if(res.is_error())
+		return res;
+
+	//If nothing's waiting to be committed either, the filesystem is consistent without the journal
+	if(_transaction_blocks.empty())
+		return set_needs_recovery(false);
+	return SUCCESS;
+}
+
+Result Ext2Journal::set_needs_recovery(bool needs_recovery) {
+	//Sets or clears the RECOVER flag in the superblock on disk. This is only called when the running transaction is
+	//empty, so the cached copy of the superblock's block has no uncommitted changes and can be written straight home.
+	if(_needs_recovery == needs_recovery)
+		return SUCCESS;
+
+	if(needs_recovery)
+		_fs.superblock.required_features |= EXT3_FEATURE_INCOMPAT_RECOVER;
+	else
+		_fs.superblock.required_features &= ~EXT3_FEATURE_INCOMPAT_RECOVER;
+
+	auto* buf = new uint8_t[_fs.block_size()];
+	uint32_t block = 1024 / _fs.block_size();
+	Result res = _fs.read_block(block, buf);
+	if(res.is_success()) {
+		auto* sb = (ext2_superblock*) (buf + 1024 % _fs.block_size());
+		sb->required_features = _fs.superblock.required_features;
+		res = _fs.write_block(block, buf);
+	}
+	delete[] buf;
+	if(res.is_error())
+		return res;
+
+	//The superblock's block is home now, so it doesn't need to be checkpointed anymore
+	remove_block(_checkpoint_blocks, block);
+	_needs_recovery = needs_recovery;
+	return SUCCESS;
+}
+
+Result Ext2Journal::write_journal_superblock() {
+	auto* buf = new uint8_t[_fs.block_size()];
+	Result res = read_journal_block(0, buf);
+	if(res.is_error()) {
+		delete[] buf;
+		return res;
+	}
+
+	auto* sb = (jbd_superblock*) buf;
+	sb->sequence = be32(_sequence);
+	sb->start = be32(_start);
+	sb->incompat_features |= be32(JBD_FEATURE_INCOMPAT_REVOKE);
+	res = write_journal_blocks(0, 1, buf);
+	delete[] buf;
+	return res;
+}
+
+Result Ext2Journal::read_journal_block(uint32_t index, uint8_t* buffer) {
+	if(index >= _blocks.size())
+		return -EINVAL;
+	return _fs.read_block(_blocks[index], buffer);
+}
+
+Result Ext2Journal::write_journal_blocks(uint32_t index, uint32_t count, const uint8_t* buffer) {
+	//Write runs of blocks that are contiguous on the disk at once, wrapping around the end of the log
+	size_t block_size = _fs.block_size();
+	for(uint32_t i = 0; i < count;) {
+		uint32_t run_end = index;
+		uint32_t run_length = 1;
+		while(i + run_length < count && next_index(run_end) == run_end + 1 && _blocks[run_end + 1] == _blocks[run_end] + 1) {
+			run_end++;
+			run_length++;
+		}
+
+		Result res = _fs.write_blocks(_blocks[index], run_length, buffer + i * block_size);
+		if(res.is_error())
+			return res;
+
+		i += run_length;
+		index = next_index(run_end);
+	}
+	return SUCCESS;
+}
+
+uint32_t Ext2Journal::next_index(uint32_t index) {
+	return index + 1 >= _max_length ? _first : index + 1;
+}
+
+uint32_t Ext2Journal::free_space() {
+	//One block is always left free so that a full log can't be mistaken for an empty one
+	uint32_t usable = _max_length - _first;
+	if(!_start)
+		return usable - 1;
+	uint32_t used = _head >= _start ? _head - _start : usable - (_start - _head);
+	return usable - used - 1;
+}
+
+uint32_t Ext2Journal::log_blocks_needed(size_t num_blocks, size_t num_revoked) {
+	//The blocks, their descriptors, the revoke records, and the commit block
+	size_t num_tags = tags_per_descriptor();
+	size_t num_revokes = revokes_per_block();
+	return num_blocks + (num_blocks + num_tags - 1) / num_tags + (num_revoked + num_revokes - 1) / num_revokes + 1;
+}
+
+size_t Ext2Journal::max_transaction_blocks(size_t num_revoked) {
+	//The most blocks a transaction can have and still fit in an empty log
+	uint32_t usable = _max_length - _first - 1;
+	size_t num_blocks = usable * tags_per_descriptor() / (tags_per_descriptor() + 1);
+	while(num_blocks && log_blocks_needed(num_blocks, num_revoked) > usable)
+		num_blocks--;
+	return num_blocks;
+}
+
+size_t Ext2Journal::tags_per_descriptor() {
+	//The first tag in each descriptor is followed by the journal's UUID
+	return min((_fs.block_size() - sizeof(jbd_header) - sizeof(_uuid)) / sizeof(jbd_block_tag), (size_t) JBD_MAX_DESCRIPTOR_TAGS);
+}
+
+size_t Ext2Journal::revokes_per_block() {
+	return (_fs.block_size() - sizeof(jbd_revoke_header)) / sizeof(uint32_t);
+}
+
+Ext2Transaction::Ext2Transaction(Ext2Filesystem& fs): _fs(fs) {
+	if(_fs.journal)
+		_fs.journal->begin();
+}
+
+Ext2Transaction::~Ext2Transaction() {
+	if(_fs.journal)
+		_fs.journal->end();
+}
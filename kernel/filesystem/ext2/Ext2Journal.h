@@ -0,0 +1,155 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_EXT2JOURNAL_H
+#define DUCKOS_EXT2JOURNAL_H
+
+#include <kernel/kstd/types.h>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/kstd/map.hpp>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/Result.hpp>
+#include <kernel/time/Time.h>
+
+//ext3 journal features in the ext2 superblock
+#define EXT3_FEATURE_COMPAT_HAS_JOURNAL 0x4
+#define EXT3_FEATURE_INCOMPAT_RECOVER 0x4
+#define EXT3_FEATURE_INCOMPAT_JOURNAL_DEV 0x8
+
+//JBD block types (everything in the journal is big-endian)
+#define JBD_MAGIC 0xC03B3998
+#define JBD_DESCRIPTOR_BLOCK 1
+#define JBD_COMMIT_BLOCK 2
+#define JBD_SUPERBLOCK_V1 3
+#define JBD_SUPERBLOCK_V2 4
+#define JBD_REVOKE_BLOCK 5
+
+//JBD descriptor tag flags
+#define JBD_FLAG_ESCAPE 0x1
+#define JBD_FLAG_SAME_UUID 0x2
+#define JBD_FLAG_DELETED 0x4
+#define JBD_FLAG_LAST_TAG 0x8
+
+//JBD journal superblock features
+#define JBD_FEATURE_INCOMPAT_REVOKE 0x1
+
+//How often (in seconds) kjournal commits the running transaction and checkpoints committed ones to their home locations.
+//The running transaction is also committed once all handles on it are closed if it's been running for this long.
+#define JBD_CHECKPOINT_INTERVAL 5
+//The most blocks described by one descriptor block (they're buffered in memory while being written to the log)
+#define JBD_MAX_DESCRIPTOR_TAGS 32
+
+typedef struct __attribute__((packed)) jbd_header {
+	uint32_t magic;
+	uint32_t block_type;
+	uint32_t sequence;
+} jbd_header;
+
+typedef struct __attribute__((packed)) jbd_superblock {
+	jbd_header header;
+	uint32_t block_size;
+	uint32_t max_length; //Total number of blocks in the journal
+	uint32_t first; //The first block of log information
+	uint32_t sequence; //The first expected transaction ID in the log
+	uint32_t start; //The block of the start of the log (0 if the log is empty)
+	int32_t error;
+	uint32_t compat_features;
+	uint32_t incompat_features;
+	uint32_t ro_compat_features;
+	uint8_t uuid[16];
+} jbd_superblock;
+
+typedef struct __attribute__((packed)) jbd_block_tag {
+	uint32_t block;
+	uint32_t flags;
+} jbd_block_tag;
+
+typedef struct __attribute__((packed)) jbd_revoke_header {
+	jbd_header header;
+	uint32_t count; //Bytes used in the block, including this header
+} jbd_revoke_header;
+
+class Ext2Filesystem;
+class Ext2Journal {
+public:
+	///Loads the journal of the filesystem and replays it if needed. Returns nullptr if there's no usable journal.
+	static Ext2Journal* load(Ext2Filesystem& fs);
+	~Ext2Journal();
+
+	//Transactions
+	void begin();
+	Result end();
+	Result write_block(uint32_t block, const uint8_t* buffer);
+	void revoke(uint32_t block);
+	Result checkpoint();
+
+	///The entry point of the kjournal kernel process, which periodically checkpoints all journals.
+	static void kjournal();
+
+private:
+	Ext2Journal(Ext2Filesystem& fs, kstd::vector<uint32_t>& blocks);
+
+	Result init();
+	Result recover();
+	Result scan_log(int pass, uint32_t& end_sequence, kstd::map<uint32_t, uint32_t>& revoked);
+	Result commit();
+	Result write_transaction(size_t first_block, size_t num_blocks, bool with_revokes);
+	Result flush_checkpoint();
+	Result set_needs_recovery(bool needs_recovery);
+	uint32_t log_blocks_needed(size_t num_blocks, size_t num_revoked);
+	size_t max_transaction_blocks(size_t num_revoked);
+	Result write_journal_superblock();
+	Result read_journal_block(uint32_t index, uint8_t* buffer);
+	Result write_journal_blocks(uint32_t index, uint32_t count, const uint8_t* buffer);
+	uint32_t next_index(uint32_t index);
+	uint32_t free_space();
+	size_t tags_per_descriptor();
+	size_t revokes_per_block();
+
+	Ext2Filesystem& _fs;
+	kstd::vector<uint32_t> _blocks; //The filesystem blocks the journal occupies
+	SpinLock _lock;
+	uint8_t _uuid[16];
+	uint32_t _first;
+	uint32_t _max_length;
+	uint32_t _sequence; //The ID of the next transaction to be committed
+	uint32_t _start = 0; //The journal block the oldest transaction that hasn't been checkpointed starts at (0 if none)
+	uint32_t _head; //The journal block the next transaction will be written to
+	size_t _handles = 0;
+	bool _needs_recovery = true; //Whether the RECOVER flag is set in the superblock on disk
+	Time _transaction_start; //When the first block was added to the running transaction
+	kstd::vector<uint32_t> _transaction_blocks;
+	kstd::vector<uint32_t> _revoked_blocks;
+	kstd::vector<uint32_t> _checkpoint_blocks; //Blocks in committed transactions that haven't been written home yet
+
+	static kstd::vector<Ext2Journal*> _journals;
+	static SpinLock _journals_lock;
+};
+
+///Makes sure all of the metadata writes made while it's alive end up in the same journal transaction.
+class Ext2Transaction {
+public:
+	explicit Ext2Transaction(Ext2Filesystem& fs);
+	~Ext2Transaction();
+
+private:
+	Ext2Filesystem& _fs;
+};
+
+#endif //DUCKOS_EXT2JOURNAL_H
@@ -75,6 +75,24 @@ ProcFSEntry::ProcFSEntry(ProcFSInodeType type, pid_t pid): type(type), pid(pid)
 			parent = 1;
 			break;
 
+		case RootDiskStats:
+			name = "diskstats";
+			dirent_type = TYPE_FILE;
+			parent = 1;
+			break;
+
+		case RootDCache:
+			name = "dcache";
+			dirent_type = TYPE_FILE;
+			parent = 1;
+			break;
+
+		case RootICache:
+			name = "icache";
+			dirent_type = TYPE_FILE;
+			parent = 1;
+			break;
+
 		case ProcCwd:
 			name = "cwd";
 			dirent_type = TYPE_SYMLINK;
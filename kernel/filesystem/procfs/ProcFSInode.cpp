@@ -31,6 +31,10 @@
 #include <kernel/tasking/Process.h>
 #include <kernel/memory/PageDirectory.h>
 #include <kernel/device/DiskDevice.h>
+#include <kernel/device/BlockRequestQueue.h>
+#include <kernel/filesystem/DirectoryCache.h>
+#include <kernel/filesystem/FileBasedFilesystem.h>
+#include <kernel/filesystem/tmpfs/TmpFS.h>
 
 const char* PROC_STATE_NAMES[] = {"Running", "Zombie", "Dead", "Sleeping"};
 
@@ -130,6 +134,10 @@ ssize_t ProcFSInode::read(size_t start, size_t length, uint8_t* buffer, FileDesc
 			str += "\nkcache = ";
 			itoa((int) DiskDevice::used_cache_memory(), numbuf, 10);
 			str += numbuf;
+
+			str += "\nktmpfs = ";
+			itoa((int) TmpFS::used_memory(), numbuf, 10);
+			str += numbuf;
 			str += "\n";
 
 			if(start + length > str.length())
@@ -178,6 +186,129 @@ ssize_t ProcFSInode::read(size_t start, size_t length, uint8_t* buffer, FileDesc
 			return length;
 		}
 
+		case RootDiskStats: {
+			char numbuf[12];
+			kstd::string str;
+
+			auto queues = BlockRequestQueue::queues();
+			for(size_t i = 0; i < queues.size(); i++) {
+				auto stats = queues[i]->stats();
+
+				str += "[";
+				itoa((int) queues[i]->device().major(), numbuf, 10);
+				str += numbuf;
+				str += ",";
+				itoa((int) queues[i]->device().minor(), numbuf, 10);
+				str += numbuf;
+
+				str += "]\ndepth = ";
+				itoa((int) stats.depth, numbuf, 10);
+				str += numbuf;
+
+				str += "\nmax_depth = ";
+				itoa((int) stats.max_depth, numbuf, 10);
+				str += numbuf;
+
+				str += "\nrequests = ";
+				itoa((int) stats.requests, numbuf, 10);
+				str += numbuf;
+
+				str += "\ndispatches = ";
+				itoa((int) stats.dispatches, numbuf, 10);
+				str += numbuf;
+
+				str += "\nmerges = ";
+				itoa((int) stats.merges, numbuf, 10);
+				str += numbuf;
+
+				//Each latency bucket holds the requests that took less than the given number of milliseconds
+				for(size_t bucket = 0; bucket < BLOCK_QUEUE_LATENCY_BUCKETS; bucket++) {
+					if(bucket == BLOCK_QUEUE_LATENCY_BUCKETS - 1) {
+						str += "\nlatency_inf = ";
+					} else {
+						str += "\nlatency_";
+						itoa(1 << bucket, numbuf, 10);
+						str += numbuf;
+						str += "ms = ";
+					}
+					itoa((int) stats.latency_histogram[bucket], numbuf, 10);
+					str += numbuf;
+				}
+				str += "\n";
+			}
+
+			if(start + length > str.length())
+				length = str.length() - start;
+			memcpy(buffer, str.c_str() + start, length);
+			return length;
+		}
+
+		case RootDCache: {
+			char numbuf[12];
+			kstd::string str;
+			auto stats = DirectoryCache::inst().stats();
+
+			str += "[dcache]\nentries = ";
+			itoa((int) stats.entries, numbuf, 10);
+			str += numbuf;
+
+			str += "\nhits = ";
+			itoa((int) stats.hits, numbuf, 10);
+			str += numbuf;
+
+			str += "\nnegative_hits = ";
+			itoa((int) stats.negative_hits, numbuf, 10);
+			str += numbuf;
+
+			str += "\nmisses = ";
+			itoa((int) stats.misses, numbuf, 10);
+			str += numbuf;
+
+			//Hit rate as a whole percentage
+			size_t lookups = stats.hits + stats.negative_hits + stats.misses;
+			str += "\nhit_percent = ";
+			itoa(lookups ? (int) ((stats.hits + stats.negative_hits) * 100 / lookups) : 0, numbuf, 10);
+			str += numbuf;
+			str += "\n";
+
+			if(start + length > str.length())
+				length = str.length() - start;
+			memcpy(buffer, str.c_str() + start, length);
+			return length;
+		}
+
+		case RootICache: {
+			char numbuf[12];
+			kstd::string str;
+			auto stats = FileBasedFilesystem::inode_cache_stats();
+
+			str += "[icache]\nentries = ";
+			itoa((int) stats.entries, numbuf, 10);
+			str += numbuf;
+
+			str += "\nmax_entries = ";
+			itoa((int) FileBasedFilesystem::inode_cache_max(), numbuf, 10);
+			str += numbuf;
+
+			str += "\nhits = ";
+			itoa((int) stats.hits, numbuf, 10);
+			str += numbuf;
+
+			str += "\nmisses = ";
+			itoa((int) stats.misses, numbuf, 10);
+			str += numbuf;
+
+			str += "\nevictions = ";
+			itoa((int) stats.evictions, numbuf, 10);
+			str += numbuf;
+			str += "\n";
+
+			if(start + length > str.length())
+				length = str.length() - start;
+			memcpy(buffer, str.c_str() + start, length);
+			return length;
+		}
+
 		case ProcStatus: {
 			auto proc = TaskManager::process_for_pid(pid);
 			if(proc.is_error())
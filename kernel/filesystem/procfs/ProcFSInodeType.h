@@ -31,6 +31,9 @@ enum ProcFSInodeType {
 	RootCmdLine,
 	RootUptime,
 	RootCpuInfo,
+	RootDiskStats,
+	RootDCache,
+	RootICache,
 
 	//Process entries
 	ProcExe,
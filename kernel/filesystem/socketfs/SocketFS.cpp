@@ -46,6 +46,55 @@ unsigned int SocketFS::client_hash(const void* fd_pointer) {
 	return hash;
 }
 
+uint16_t SocketFS::name_hash(const kstd::string& name) {
+	uint16_t hash = 7;
+	for(size_t i = 0; i < name.length(); i++)
+		hash = hash * 31 + name[i];
+	return hash;
+}
+
+kstd::shared_ptr<SocketFSInode> SocketFS::find_socket(const kstd::string& name) {
+	auto& bucket = socket_buckets[name_hash(name) % SOCKETFS_SOCKET_BUCKETS];
+	for(size_t i = 0; i < bucket.size(); i++) {
+		if(bucket[i]->name == name)
+			return bucket[i];
+	}
+	return kstd::shared_ptr<SocketFSInode>();
+}
+
+kstd::shared_ptr<SocketFSInode> SocketFS::find_socket(ino_t id) {
+	//The low bits of a socket's id are the hash of its name, so it'll be in the same bucket
+	auto& bucket = socket_buckets[get_fileno(id) % SOCKETFS_SOCKET_BUCKETS];
+	for(size_t i = 0; i < bucket.size(); i++) {
+		if(bucket[i]->id == id)
+			return bucket[i];
+	}
+	return kstd::shared_ptr<SocketFSInode>();
+}
+
+void SocketFS::add_socket(const kstd::shared_ptr<SocketFSInode>& socket) {
+	sockets.push_back(socket);
+	socket_buckets[name_hash(socket->name) % SOCKETFS_SOCKET_BUCKETS].push_back(socket);
+}
+
+bool SocketFS::remove_socket(SocketFSInode* socket) {
+	auto& bucket = socket_buckets[name_hash(socket->name) % SOCKETFS_SOCKET_BUCKETS];
+	for(size_t i = 0; i < bucket.size(); i++) {
+		if(bucket[i].get() == socket) {
+			bucket.erase(i);
+			break;
+		}
+	}
+
+	for(size_t i = 0; i < sockets.size(); i++) {
+		if(sockets[i].get() == socket) {
+			sockets.erase(i);
+			return true;
+		}
+	}
+	return false;
+}
+
 char* SocketFS::name() {
 	return "socketfs";
 }
@@ -55,12 +104,10 @@ ResultRet<kstd::shared_ptr<Inode>> SocketFS::get_inode(ino_t id) {
 		return static_cast<kstd::shared_ptr<Inode>>(root_entry);
 
 	LOCK(lock);
-	for(size_t i = 0; i < sockets.size(); i++) {
-		if(sockets[i]->id == id)
-			return static_cast<kstd::shared_ptr<Inode>>(sockets[i]);
-	}
-
-	return -ENOENT;
+	auto socket = find_socket(id);
+	if(!socket)
+		return -ENOENT;
+	return static_cast<kstd::shared_ptr<Inode>>(socket);
 }
 
 ino_t SocketFS::root_inode_id() {
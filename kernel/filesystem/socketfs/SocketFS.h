@@ -23,9 +23,11 @@
 #include <kernel/filesystem/Filesystem.h>
 #include "socketfs_defines.h"
 #include <kernel/kstd/vector.hpp>
+#include <kernel/kstd/string.h>
 #include <kernel/tasking/SpinLock.h>
 
 #define SOCKETFS_FSID 3
+#define SOCKETFS_SOCKET_BUCKETS 64
 
 struct SocketFSPacket {
 	int type;
@@ -53,6 +55,7 @@ public:
 	static pid_t get_pid(ino_t inode);
 	static uint16_t get_fileno(ino_t inode);
 	static sockid_t client_hash(const void* fd_pointer);
+	static uint16_t name_hash(const kstd::string& name);
 
 	//Filesystem
 	char* name() override;
@@ -62,7 +65,13 @@ public:
 
 protected:
 	friend class SocketFSInode;
+	kstd::shared_ptr<SocketFSInode> find_socket(const kstd::string& name);
+	kstd::shared_ptr<SocketFSInode> find_socket(ino_t id);
+	void add_socket(const kstd::shared_ptr<SocketFSInode>& socket);
+	bool remove_socket(SocketFSInode* socket);
+
 	kstd::vector<kstd::shared_ptr<SocketFSInode>> sockets;
+	kstd::vector<kstd::shared_ptr<SocketFSInode>> socket_buckets[SOCKETFS_SOCKET_BUCKETS]; //Sockets by the hash of their name
 	kstd::shared_ptr<SocketFSInode> root_entry;
 	SpinLock lock;
 
@@ -21,14 +21,13 @@
 #define DUCKOS_SOCKETFSCLIENT_H
 
 #include <kernel/kstd/shared_ptr.hpp>
-#include <kernel/kstd/queue.hpp>
 #include <kernel/kstd/unix_types.h>
-#include <kernel/tasking/SpinLock.h>
+#include "SocketFSQueue.h"
 
 class Process;
 class SocketFSClient {
 public:
-	explicit SocketFSClient(sockid_t id): id(id), data_queue(kstd::make_shared<kstd::queue<uint8_t>>()) {}
+	explicit SocketFSClient(sockid_t id, size_t slot = 0): id(id), slot(slot), data_queue(kstd::make_shared<SocketFSQueue>()) {}
 
 	explicit operator bool() const {
 		return id;
@@ -47,9 +46,13 @@ public:
 	}
 
 	sockid_t id;
-	kstd::shared_ptr<kstd::queue<uint8_t>> data_queue;
-	BooleanBlocker _blocker;
-	SpinLock _lock;
+	pid_t pid = 0;
+	size_t slot; //The index of the client in the socket's list of clients
+	kstd::shared_ptr<SocketFSQueue> data_queue; //Packets waiting to be read by the client
+	kstd::shared_ptr<SocketFSQueue> host_queue; //Packets from the client waiting to be read by the host
+	SocketFSClient* next_in_bucket = nullptr;
+	bool disconnected = false;
+	bool disconnect_queued = false;
 };
 
 #endif //DUCKOS_SOCKETFSCLIENT_H
@@ -43,6 +43,8 @@ Inode(fs, id), fs(fs), id(id), name(name), host(0)
 	size_t len = name.length() > NAME_MAXLEN ? NAME_MAXLEN : name.length();
 	dir_entry.name_length = len;
 	memcpy(dir_entry.name, name.c_str(), len + 1);
+
+	client_buckets.resize(SOCKETFS_MIN_CLIENT_BUCKETS);
 }
 
 SocketFSInode::~SocketFSInode() {
@@ -62,11 +64,11 @@ InodeMetadata SocketFSInode::metadata() {
 }
 
 ino_t SocketFSInode::find_id(const kstd::string& find_name) {
-	for(size_t i = 0; i < fs.sockets.size(); i++) {
-		if(fs.sockets[i]->name == find_name)
-			return fs.sockets[i]->id;
-	}
-	return -ENOENT;
+	LOCK(fs.lock);
+	auto socket = fs.find_socket(find_name);
+	if(!socket)
+		return -ENOENT;
+	return socket->id;
 }
 
 ssize_t SocketFSInode::read(size_t start, size_t length, uint8_t* buffer, FileDescriptor* fd) {
@@ -75,41 +77,31 @@ ssize_t SocketFSInode::read(size_t start, size_t length, uint8_t* buffer, FileDe
 	if(!fd)
 		return -EINVAL;
 
-	LOCK(lock);
-
-	//Find the client that is reading
-	SocketFSClient* reader = nullptr;
-	auto client_hash = SocketFS::client_hash(fd);
-
-	if(host == client_hash) {
-		reader = &host;
-	} else {
-		for(size_t i = 0; i < clients.size(); i++) {
-			if(clients[i] == client_hash) {
-				reader = &clients[i];
-				break;
+	ssize_t nread;
+	kstd::shared_ptr<SocketFSQueue> queue;
+	{
+		LOCK(lock);
+		auto client_hash = SocketFS::client_hash(fd);
+		if(host == client_hash) {
+			//The host reads from its clients' queues in turn
+			nread = read_host(buffer, length);
+		} else {
+			//Find the queue of the client that is reading
+			auto* reader = get_client(client_hash);
+			if(!reader) {
+				//Couldn't find the client reading...
+				return -EIO;
 			}
+			queue = reader->data_queue;
 		}
 	}
 
-	if(!reader) {
-		//Couldn't find the client reading...
-		return -EIO;
-	}
-
-	if(length > reader->data_queue->size())
-		length = reader->data_queue->size();
-
-	//Read into the buffer from the queue
-	auto& queue = reader->data_queue;
-	for(size_t i = 0; i < length; i++) {
-		*buffer++ = queue->front();
-		queue->pop_front();
-	}
-
-	reader->_blocker.set_ready(true);
-
-	return length;
+	//Read (at most) one packet from the queue
+	if(queue)
+		nread = queue->read(buffer, length);
+	if(nread > 0)
+		watchers().notify();
+	return nread;
 }
 
 ResultRet<kstd::shared_ptr<LinkedInode>> SocketFSInode::resolve_link(const kstd::shared_ptr<LinkedInode>& base, const User& user, kstd::shared_ptr<LinkedInode>* parent_storage, int options, int recursion_level) {
@@ -153,59 +145,90 @@ ssize_t SocketFSInode::write(size_t start, size_t length, const uint8_t* buf, Fi
 	if(!fd)
 		return -EINVAL;
 
-	LOCK(lock);
 	auto* packet = (const SocketFSPacket*) buf;
+	if(length < sizeof(SocketFSPacket) || packet->length > length - sizeof(SocketFSPacket))
+		return -EINVAL;
 
-	SocketFSClient* recipient = nullptr;
-	SocketFSClient* sender = nullptr;
-	bool is_broadcast = packet->type == SOCKETFS_TYPE_BROADCAST;
-
-	//Find the client that the packet is coming from
-	auto client_hash = SocketFS::client_hash(fd);
-	if(host == client_hash) {
-		sender = &host;
-	} else {
-		for(size_t i = 0; i < clients.size(); i++) {
-			if(clients[i] == client_hash) {
-				sender = &clients[i];
-				break;
+	kstd::shared_ptr<SocketFSClient> sender_client;
+	kstd::shared_ptr<SocketFSQueue> recipient_queue;
+	kstd::vector<kstd::shared_ptr<SocketFSQueue>> broadcast_queues;
+	sockid_t sender_id;
+	{
+		LOCK(lock);
+
+		//Find the client that the packet is coming from
+		auto client_hash = SocketFS::client_hash(fd);
+		bool from_host = host == client_hash;
+		SocketFSClient* sender = from_host ? &host : get_client(client_hash);
+		if(!sender) {
+			//Couldn't find the client it came from...
+			return -EIO;
+		}
+		sender_id = sender->id;
+
+		if(packet->type == SOCKETFS_TYPE_SET_BUFFER_SIZE) {
+			//Resize the sender's own queue (or for the host, the queues of packets waiting for it)
+			if(packet->length != sizeof(size_t))
+				return -EINVAL;
+			size_t size = *((const size_t*) packet->data);
+			if(!from_host)
+				return sender->data_queue->set_capacity(size).code();
+			if(size < sizeof(SocketFSPacket) || size > SOCKETFS_MAX_BUFFER_SIZE)
+				return -EINVAL;
+			host_buffer_size = size;
+			for(size_t i = 0; i < clients.size(); i++) {
+				if(clients[i])
+					clients[i]->host_queue->set_capacity(size);
+			}
+			return SUCCESS;
+		} else if(packet->type == SOCKETFS_TYPE_BROADCAST && from_host) {
+			//If it's a broadcast, send it to all clients
+			broadcast_queues.reserve(num_clients);
+			for(size_t i = 0; i < clients.size(); i++) {
+				if(clients[i] && !clients[i]->disconnected)
+					broadcast_queues.push_back(clients[i]->data_queue);
 			}
+		} else if(from_host) {
+			//Find the client this packet has to go to
+			auto* recipient = get_client(packet->recipient);
+			if(!recipient)
+				return -EINVAL; //No such recipient
+			recipient_queue = recipient->data_queue;
+		} else {
+			//Clients can only send packets to the host
+			if(packet->recipient != SOCKETFS_RECIPIENT_HOST)
+				return -EINVAL;
+			sender_client = clients[sender->slot];
+			recipient_queue = sender->host_queue;
 		}
 	}
 
-	if(!sender) {
-		//Couldn't find the client it came from...
-		return -EIO;
-	}
-
-	if(is_broadcast && sender == &host) {
-		//If it's a broadcast, send it to all clients
-		for(size_t i = 0; i < clients.size(); i++) {
+	//Write the packet to the correct queue(s) without holding the socket lock, since writing might block
+	if(!recipient_queue) {
+		//Every client's queue shares one copy of the broadcast's body
+		auto payload = kstd::make_shared<SocketFSPayload>(packet->data, packet->length);
+		SocketFSPacket header = {SOCKETFS_TYPE_MSG, sender_id, TaskManager::current_process()->pid(), packet->length};
+		for(size_t i = 0; i < broadcast_queues.size(); i++) {
 			//We don't care about errors here, we should just continue sending it to the rest of the clients
-			write_packet(clients[i], SOCKETFS_TYPE_MSG, sender->id, packet->length, packet->data, fd->nonblock());
+			broadcast_queues[i]->push(header, payload, fd->nonblock());
 		}
+		watchers().notify();
 		return SUCCESS;
-	} else if(sender == &host) {
-		//Find the client this packet has to go to
-		for(size_t i = 0; i < clients.size(); i++) {
-			if(clients[i] == packet->recipient) {
-				recipient = &clients[i];
-				break;
-			}
-		}
-	} else if(sender != &host) {
-		//Clients can only send packets to the host
-		if(packet->recipient != SOCKETFS_RECIPIENT_HOST)
-			return -EINVAL;
-		recipient = &host;
 	}
 
-	if(!recipient)
-		return -EINVAL; //No such recipient
+	auto res = write_packet(*recipient_queue, SOCKETFS_TYPE_MSG, sender_id, packet->length, packet->data, fd->nonblock());
+	if(res.is_error())
+		return res.code();
 
-	//Finally, write the packet to the correct queue
-	auto res = write_packet(*recipient, SOCKETFS_TYPE_MSG, sender->id, packet->length, packet->data, fd->nonblock());
-	return res.code();
+	//If this was sent to the host, mark the client as having something for the host to read
+	if(sender_client) {
+		LOCK(lock);
+		if(clients[sender_client->slot] == sender_client)
+			set_client_ready(sender_client->slot, true);
+	}
+
+	watchers().notify();
+	return SUCCESS;
 }
 
 Result SocketFSInode::add_entry(const kstd::string& add_name, Inode& inode) {
@@ -219,24 +242,16 @@ ResultRet<kstd::shared_ptr<Inode>> SocketFSInode::create_entry(const kstd::strin
 
 	mode = (mode & 0x0FFFu) | MODE_SOCKET;
 
-	//Hash the name for use in the unique identifier
-	uint16_t hash = 7;
-	for (int i = 0; i < create_name.length(); i++) {
-		hash = hash * 31 + create_name[i];
-	}
-
 	Process* proc = TaskManager::current_process();
-	ino_t create_id = SocketFS::get_inode_id(proc->pid(), hash);
+	ino_t create_id = SocketFS::get_inode_id(proc->pid(), SocketFS::name_hash(create_name));
 
 	//Make sure that nothing exists with the same name / id
-	for(size_t i = 0; i < fs.sockets.size(); i++) {
-		if(fs.sockets[i]->name == create_name || fs.sockets[i]->id == create_id)
-			return -EEXIST;
-	}
+	if(fs.find_socket(create_name) || fs.find_socket(create_id))
+		return -EEXIST;
 
 	//Create the socket and return it
 	auto new_inode = kstd::make_shared<SocketFSInode>(fs, create_id, create_name, mode, uid, gid);
-	fs.sockets.push_back(new_inode);
+	fs.add_socket(new_inode);
 	return static_cast<kstd::shared_ptr<Inode>>(new_inode);
 }
 
@@ -273,8 +288,11 @@ void SocketFSInode::open(FileDescriptor& fd, int options) {
 	}
 
 	//Add the client and send the connect message to the host
-	clients.push_back(SocketFSClient(client_hash));
-	write_packet(host, SOCKETFS_TYPE_MSG_CONNECT, client_hash, 0, nullptr, true);
+	auto client = add_client(client_hash);
+	client->pid = TaskManager::current_process()->pid();
+	write_packet(*client->host_queue, SOCKETFS_TYPE_MSG_CONNECT, client_hash, 0, nullptr, true);
+	set_client_ready(client->slot, true);
+	watchers().notify();
 }
 
 void SocketFSInode::close(FileDescriptor& fd) {
@@ -283,66 +301,187 @@ void SocketFSInode::close(FileDescriptor& fd) {
 	auto client_hash = SocketFS::client_hash(&fd);
 
 	if(host == client_hash) {
+		//Wake up anything waiting to write to the host
+		for(size_t i = 0; i < clients.size(); i++) {
+			if(clients[i])
+				clients[i]->host_queue->close();
+		}
+
 		//Remove the socket
 		is_open = false;
 		ScopedLocker __locker2(fs.lock);
-		for(size_t i = 0; i < fs.sockets.size(); i++) {
-			if(fs.sockets[i].get() == this) {
-				fs.sockets.erase(i);
-				return;
-			}
-		}
-		printf("[SocketFS] Warning: Socket %d was closed by host but couldn't find an entry to remove!\n", id);
+		if(!fs.remove_socket(this))
+			printf("[SocketFS] Warning: Socket %d was closed by host but couldn't find an entry to remove!\n", id);
 		return;
 	}
 
-	for(size_t i = 0; i < clients.size(); i++) {
-		if(clients[i] == client_hash) {
-			write_packet(host, SOCKETFS_TYPE_MSG_DISCONNECT, client_hash, 0, nullptr, true);
-			clients.erase(i);
-			break;
-		}
-	}
+	//The client stays around until the host has read everything it sent and the disconnect message
+	auto* client = get_client(client_hash);
+	if(!client)
+		return;
+	unhash_client(client);
+	client->disconnected = true;
+	client->data_queue->close();
+	set_client_ready(client->slot, true);
+	watchers().notify();
+}
+
+size_t SocketFSInode::max_message_size() {
+	//Every write is one packet, which can't be bigger than a queue
+	return SOCKETFS_MAX_BUFFER_SIZE;
 }
 
 bool SocketFSInode::can_read(const FileDescriptor& fd) {
+	LOCK(lock);
 	auto client_hash = SocketFS::client_hash(&fd);
+	if(host == client_hash) {
+		if(host_reading)
+			return true;
+		for(size_t i = 0; i < ready_clients.size(); i++) {
+			if(ready_clients[i])
+				return true;
+		}
+		return false;
+	}
+
+	auto* client = get_client(client_hash);
+	return client && !client->data_queue->empty();
+}
+
+SocketFSClient* SocketFSInode::get_client(sockid_t client_id) {
+	for(auto* client = client_buckets[client_id & (client_buckets.size() - 1)]; client; client = client->next_in_bucket) {
+		if(client->id == client_id)
+			return client;
+	}
+	return nullptr;
+}
+
+kstd::shared_ptr<SocketFSClient> SocketFSInode::add_client(sockid_t client_id) {
+	//Reuse a slot if we can
+	size_t slot;
+	if(!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.erase(free_slots.size() - 1);
+	} else {
+		slot = clients.size();
+		clients.push_back(kstd::shared_ptr<SocketFSClient>());
+		ready_clients.resize((clients.size() + 31) / 32);
+	}
+
+	auto client = kstd::make_shared<SocketFSClient>(client_id, slot);
+	client->host_queue = kstd::make_shared<SocketFSQueue>(host_buffer_size);
+	clients[slot] = client;
+	num_clients++;
+
+	//Grow the hash table if it's getting full
+	if(num_clients > client_buckets.size()) {
+		kstd::vector<SocketFSClient*> old_buckets = client_buckets;
+		client_buckets = kstd::vector<SocketFSClient*>();
+		client_buckets.resize(old_buckets.size() * 2);
+		for(size_t i = 0; i < old_buckets.size(); i++) {
+			auto* cur = old_buckets[i];
+			while(cur) {
+				auto* next = cur->next_in_bucket;
+				auto& bucket = client_buckets[cur->id & (client_buckets.size() - 1)];
+				cur->next_in_bucket = bucket;
+				bucket = cur;
+				cur = next;
+			}
+		}
+	}
 
-	if(host == client_hash)
-		return !host.data_queue->empty();
+	auto& bucket = client_buckets[client_id & (client_buckets.size() - 1)];
+	client->next_in_bucket = bucket;
+	bucket = client.get();
+	return client;
+}
 
-	for(size_t i = 0; i < clients.size(); i++) {
-		if(clients[i] == client_hash)
-			return !clients[i].data_queue->empty();
+void SocketFSInode::unhash_client(SocketFSClient* client) {
+	auto* cur = &client_buckets[client->id & (client_buckets.size() - 1)];
+	while(*cur) {
+		if(*cur == client) {
+			*cur = client->next_in_bucket;
+			client->next_in_bucket = nullptr;
+			return;
+		}
+		cur = &(*cur)->next_in_bucket;
 	}
+}
 
-	return false;
+void SocketFSInode::free_client(const kstd::shared_ptr<SocketFSClient>& client) {
+	size_t slot = client->slot;
+	set_client_ready(slot, false);
+	clients[slot].reset();
+	free_slots.push_back(slot);
+	num_clients--;
 }
 
-Result SocketFSInode::write_packet(SocketFSClient& client, int type, sockid_t sender, size_t length, const void* buffer, bool nonblock) {
-	//If there's room in the buffer, block (if O_NONBLOCK isn't set)
-	while(sizeof(SocketFSPacket) + length + client.data_queue->size() > SOCKETFS_MAX_BUFFER_SIZE) {
-		if(!nonblock) {
-			client._blocker.set_ready(false);
-			TaskManager::current_thread()->block(client._blocker);
-		} else {
-			return -ENOSPC;
+void SocketFSInode::set_client_ready(size_t slot, bool ready) {
+	if(ready)
+		ready_clients[slot / 32] |= 1u << (slot % 32);
+	else
+		ready_clients[slot / 32] &= ~(1u << (slot % 32));
+}
+
+kstd::shared_ptr<SocketFSClient> SocketFSInode::next_ready_client() {
+	//Look for the next client with something for us after the last one we read from, wrapping around if needed
+	size_t start = next_ready < clients.size() ? next_ready : 0;
+	for(int pass = 0; pass < 2; pass++) {
+		size_t from = pass ? 0 : start;
+		size_t to = pass ? start : clients.size();
+		for(size_t word = from / 32; word * 32 < to; word++) {
+			uint32_t bits = ready_clients[word];
+			if(word == from / 32)
+				bits &= ~0u << (from % 32);
+			if(!bits)
+				continue;
+			size_t slot = word * 32 + __builtin_ctz(bits);
+			if(slot < to)
+				return clients[slot];
+			break;
 		}
 	}
+	return kstd::shared_ptr<SocketFSClient>();
+}
 
-	//Acquire the lock
-	LOCK(client._lock);
+ssize_t SocketFSInode::read_host(uint8_t* buffer, size_t length) {
+	while(true) {
+		//Finish reading the packet we're partway through, or else move on to the next client that sent something
+		auto client = host_reading;
+		if(!client)
+			client = next_ready_client();
+		if(!client)
+			return 0;
+
+		auto nread = client->host_queue->read(buffer, length);
+		if(nread > 0) {
+			if(client->host_queue->in_packet()) {
+				host_reading = client;
+			} else {
+				host_reading.reset();
+				next_ready = client->slot + 1;
+			}
+			return nread;
+		}
 
-	//Write the packet header
-	SocketFSPacket packet_header = {type, sender, TaskManager::current_process()->pid(), length};
-	auto* data = (const uint8_t*) &packet_header;
-	for(size_t i = 0; i < sizeof(SocketFSPacket); i++)
-		client.data_queue->push_back(*data++);
+		//There's nothing left from this client. If it disconnected, tell the host and then get rid of it
+		host_reading.reset();
+		if(client->disconnected && !client->disconnect_queued) {
+			SocketFSPacket header = {SOCKETFS_TYPE_MSG_DISCONNECT, client->id, client->pid, 0};
+			client->host_queue->push(header, nullptr, true);
+			client->disconnect_queued = true;
+			continue;
+		}
 
-	//Write the packet body
-	data = (uint8_t*) buffer;
-	for(size_t i = 0; i < length; i++)
-		client.data_queue->push_back(*data++);
+		if(client->disconnected)
+			free_client(client);
+		else
+			set_client_ready(client->slot, false);
+	}
+}
 
-	return SUCCESS;
+Result SocketFSInode::write_packet(SocketFSQueue& queue, int type, sockid_t sender, size_t length, const void* buffer, bool nonblock) {
+	//Write the packet, blocking until there's room for it (if O_NONBLOCK isn't set)
+	SocketFSPacket packet_header = {type, sender, TaskManager::current_process()->pid(), length};
+	return queue.push(packet_header, buffer, nonblock);
 }
@@ -27,6 +27,7 @@
 #include <kernel/filesystem/DirectoryEntry.h>
 
 #define SOCKETFS_CDIR_ENTRY_SIZE (sizeof(DirectoryEntry::id) + sizeof(DirectoryEntry::type) + sizeof(DirectoryEntry::name_length) + sizeof(char))
+#define SOCKETFS_MIN_CLIENT_BUCKETS 16
 #define SOCKETFS_PDIR_ENTRY_SIZE (sizeof(DirectoryEntry::id) + sizeof(DirectoryEntry::type) + sizeof(DirectoryEntry::name_length) + sizeof(char) * 2)
 
 class SocketFS;
@@ -55,15 +56,30 @@ public:
 	void open(FileDescriptor& fd, int options) override;
 	void close(FileDescriptor& fd) override;
 	bool can_read(const FileDescriptor& fd) override;
+	size_t max_message_size() override;
 
 	SocketFS& fs;
 	ino_t id;
 	kstd::string name;
 
 private:
-	static Result write_packet(SocketFSClient& recipient, int type, sockid_t sender, size_t size, const void* buffer, bool nonblock);
+	SocketFSClient* get_client(sockid_t client_id);
+	kstd::shared_ptr<SocketFSClient> add_client(sockid_t client_id);
+	void unhash_client(SocketFSClient* client);
+	void free_client(const kstd::shared_ptr<SocketFSClient>& client);
+	void set_client_ready(size_t slot, bool ready);
+	kstd::shared_ptr<SocketFSClient> next_ready_client();
+	ssize_t read_host(uint8_t* buffer, size_t length);
+	Result write_packet(SocketFSQueue& queue, int type, sockid_t sender, size_t size, const void* buffer, bool nonblock);
 
-	kstd::vector<SocketFSClient> clients;
+	kstd::vector<kstd::shared_ptr<SocketFSClient>> clients; //Indexed by slot
+	kstd::vector<size_t> free_slots;
+	kstd::vector<SocketFSClient*> client_buckets; //Hash table of the connected clients by id
+	size_t num_clients = 0;
+	kstd::vector<uint32_t> ready_clients; //Bitmap of the slots of clients with packets waiting for the host
+	size_t next_ready = 0;
+	kstd::shared_ptr<SocketFSClient> host_reading;
+	size_t host_buffer_size = SOCKETFS_DEFAULT_BUFFER_SIZE;
 	SocketFSClient host;
 	SpinLock lock;
 	DirectoryEntry dir_entry;
@@ -0,0 +1,174 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "SocketFSQueue.h"
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+
+SocketFSPayload::SocketFSPayload(const void* data, size_t length): data(new uint8_t[length]), length(length) {
+	memcpy(this->data, data, length);
+}
+
+SocketFSPayload::~SocketFSPayload() {
+	delete[] data;
+}
+
+SocketFSQueue::SocketFSQueue(size_t capacity): _capacity(capacity) {
+
+}
+
+SocketFSQueue::~SocketFSQueue() {
+	delete _buffer;
+}
+
+Result SocketFSQueue::push(const SocketFSPacket& header, const void* data, bool nonblock) {
+	LOCK(_lock);
+	auto res = wait_for_space(sizeof(Record) + header.length, nonblock);
+	if(res.is_error())
+		return res;
+
+	Record record;
+	memcpy(record.header, &header, sizeof(SocketFSPacket));
+	record.shared = false;
+	_buffer->push(&record, sizeof(Record));
+	_buffer->push(data, header.length);
+	return SUCCESS;
+}
+
+Result SocketFSQueue::push(const SocketFSPacket& header, const kstd::shared_ptr<SocketFSPayload>& payload, bool nonblock) {
+	LOCK(_lock);
+	auto res = wait_for_space(sizeof(Record) + header.length, nonblock);
+	if(res.is_error())
+		return res;
+
+	//Only the record goes in the buffer, but the payload still counts towards the capacity of the queue
+	Record record;
+	memcpy(record.header, &header, sizeof(SocketFSPacket));
+	record.shared = true;
+	_buffer->push(&record, sizeof(Record));
+	_payloads.push_back(payload);
+	_shared_size += header.length;
+	return SUCCESS;
+}
+
+ssize_t SocketFSQueue::read(uint8_t* buffer, size_t length) {
+	LOCK(_lock);
+
+	//If we're not in the middle of a packet, take the record of the next one out of the buffer
+	if(!_in_packet) {
+		if(!buffered_size())
+			return 0;
+		_buffer->pop(&_current, sizeof(Record));
+		if(_current.shared) {
+			_current_payload = _payloads.pop_front();
+			_shared_size -= _current.length();
+		}
+		_current_offset = 0;
+		_in_packet = true;
+	}
+
+	size_t packet_size = sizeof(SocketFSPacket) + _current.length();
+	if(length > packet_size - _current_offset)
+		length = packet_size - _current_offset;
+
+	//Copy the header, and then the body from wherever it's stored
+	size_t nread = 0;
+	if(_current_offset < sizeof(SocketFSPacket)) {
+		nread = min(length, sizeof(SocketFSPacket) - _current_offset);
+		memcpy(buffer, _current.header + _current_offset, nread);
+	}
+	if(nread < length) {
+		size_t data_offset = _current_offset + nread - sizeof(SocketFSPacket);
+		if(_current.shared)
+			memcpy(buffer + nread, _current_payload->data + data_offset, length - nread);
+		else
+			_buffer->pop(buffer + nread, length - nread);
+		nread = length;
+	}
+
+	_current_offset += nread;
+	if(_current_offset == packet_size) {
+		_in_packet = false;
+		_current_payload.reset();
+	}
+
+	_blocker.set_ready(true);
+	return nread;
+}
+
+bool SocketFSQueue::empty() {
+	return !buffered_size() && !_in_packet;
+}
+
+bool SocketFSQueue::in_packet() {
+	return _in_packet;
+}
+
+void SocketFSQueue::close() {
+	LOCK(_lock);
+	_closed = true;
+	_blocker.set_ready(true);
+}
+
+size_t SocketFSQueue::capacity() {
+	return _capacity;
+}
+
+Result SocketFSQueue::set_capacity(size_t capacity) {
+	if(capacity < sizeof(Record) || capacity > SOCKETFS_MAX_BUFFER_SIZE)
+		return -EINVAL;
+
+	LOCK(_lock);
+	if(capacity < buffered_size() + _shared_size)
+		return -EBUSY;
+	if(_buffer)
+		_buffer->resize(capacity);
+
+	_capacity = capacity;
+	_blocker.set_ready(true);
+	return SUCCESS;
+}
+
+Result SocketFSQueue::wait_for_space(size_t length, bool nonblock) {
+	//Must be called with the lock held. It'll be released while waiting.
+	if(length > _capacity)
+		return -EMSGSIZE;
+
+	while(!_closed && _capacity - buffered_size() - _shared_size < length) {
+		if(nonblock)
+			return -ENOSPC;
+		_blocker.set_ready(false);
+		_lock.release();
+		TaskManager::current_thread()->block(_blocker);
+		_lock.acquire();
+	}
+
+	if(_closed)
+		return -EPIPE;
+
+	if(!_buffer)
+		_buffer = new kstd::ring_buffer(_capacity);
+
+	return SUCCESS;
+}
+
+size_t SocketFSQueue::buffered_size() {
+	return _buffer ? _buffer->size() : 0;
+}
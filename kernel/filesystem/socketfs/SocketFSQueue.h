@@ -0,0 +1,88 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_SOCKETFSQUEUE_H
+#define DUCKOS_SOCKETFSQUEUE_H
+
+#include <kernel/kstd/types.h>
+#include <kernel/kstd/queue.hpp>
+#include <kernel/kstd/ring_buffer.hpp>
+#include <kernel/kstd/shared_ptr.hpp>
+#include <kernel/tasking/SpinLock.h>
+#include <kernel/tasking/BooleanBlocker.h>
+#include <kernel/Result.hpp>
+#include "SocketFS.h"
+
+/**
+ * The body of a packet that's shared between several queues (ie. a broadcast), so it only has to be copied once.
+ */
+class SocketFSPayload {
+public:
+	SocketFSPayload(const void* data, size_t length);
+	~SocketFSPayload();
+
+	uint8_t* data;
+	size_t length;
+};
+
+/**
+ * A queue of packets waiting to be read by a SocketFS client or host. Packets are stored back to back in a ring buffer
+ * with their headers in front of them, and a single read never returns data from more than one packet.
+ */
+class SocketFSQueue {
+public:
+	explicit SocketFSQueue(size_t capacity = SOCKETFS_DEFAULT_BUFFER_SIZE);
+	~SocketFSQueue();
+
+	Result push(const SocketFSPacket& header, const void* data, bool nonblock);
+	Result push(const SocketFSPacket& header, const kstd::shared_ptr<SocketFSPayload>& payload, bool nonblock);
+	ssize_t read(uint8_t* buffer, size_t length);
+	bool empty();
+	bool in_packet();
+	void close();
+	size_t capacity();
+	Result set_capacity(size_t capacity);
+
+private:
+	struct Record {
+		uint8_t header[sizeof(SocketFSPacket)];
+		bool shared;
+		size_t length() const { return ((const SocketFSPacket*) header)->length; }
+	};
+
+	Result wait_for_space(size_t length, bool nonblock);
+	size_t buffered_size();
+
+	kstd::ring_buffer* _buffer = nullptr; //Not allocated until something is put in it
+	size_t _capacity;
+	size_t _shared_size = 0;
+	kstd::queue<kstd::shared_ptr<SocketFSPayload>> _payloads;
+	bool _closed = false;
+
+	//The packet currently being read
+	bool _in_packet = false;
+	Record _current;
+	size_t _current_offset = 0;
+	kstd::shared_ptr<SocketFSPayload> _current_payload;
+
+	BooleanBlocker _blocker;
+	SpinLock _lock;
+};
+
+#endif //DUCKOS_SOCKETFSQUEUE_H
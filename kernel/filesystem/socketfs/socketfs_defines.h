@@ -20,12 +20,14 @@
 #ifndef DUCKOS_SOCKETFS_DEFINES_H
 #define DUCKOS_SOCKETFS_DEFINES_H
 
-#define SOCKETFS_MAX_BUFFER_SIZE 16384
+#define SOCKETFS_DEFAULT_BUFFER_SIZE 16384
+#define SOCKETFS_MAX_BUFFER_SIZE (1024 * 1024)
 #define SOCKETFS_TYPE_MSG 0
 #define SOCKETFS_RECIPIENT_HOST 0
 #define SOCKETFS_TYPE_BROADCAST -1
 #define SOCKETFS_TYPE_MSG_CONNECT -2
 #define SOCKETFS_TYPE_MSG_DISCONNECT -3
+#define SOCKETFS_TYPE_SET_BUFFER_SIZE -4
 
 typedef unsigned int sockid_t;
 
@@ -0,0 +1,108 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "TmpFS.h"
+#include "TmpFSInode.h"
+#include <kernel/filesystem/InodeMetadata.h>
+#include <kernel/memory/MemoryManager.h>
+
+uint8_t TmpFS::_next_fsid = TMPFS_FSID_BASE;
+size_t TmpFS::_used_memory = 0;
+
+TmpFS::TmpFS(mode_t root_mode, size_t max_size) {
+	_fsid = _next_fsid++;
+	_root_inode_id = 1;
+	if(!max_size)
+		max_size = MemoryManager::inst().get_usable_mem() / 2;
+	_max_pages = max_size / PAGE_SIZE;
+
+	auto root = kstd::make_shared<TmpFSInode>(*this, 1, MODE_DIRECTORY | (root_mode & 07777u), 0, 0, 1);
+	_inodes[1 % TMPFS_INODE_BUCKETS].push_back(root);
+}
+
+TmpFS::~TmpFS() {
+	//Free the inodes (and their pages) while we can still account for them
+	for(size_t i = 0; i < TMPFS_INODE_BUCKETS; i++)
+		_inodes[i].resize(0);
+}
+
+char* TmpFS::name() {
+	return "tmpfs";
+}
+
+ResultRet<kstd::shared_ptr<Inode>> TmpFS::get_inode(ino_t id) {
+	LOCK(_lock);
+	auto& bucket = _inodes[id % TMPFS_INODE_BUCKETS];
+	for(size_t i = 0; i < bucket.size(); i++) {
+		if(bucket[i]->id == id)
+			return static_cast<kstd::shared_ptr<Inode>>(bucket[i]);
+	}
+	return -ENOENT;
+}
+
+ino_t TmpFS::root_inode_id() {
+	return 1;
+}
+
+ResultRet<kstd::shared_ptr<TmpFSInode>> TmpFS::create_inode(mode_t mode, uid_t uid, gid_t gid, ino_t parent) {
+	LOCK(_lock);
+	ino_t id = _next_id++;
+	auto inode = kstd::make_shared<TmpFSInode>(*this, id, mode, uid, gid, parent);
+	_inodes[id % TMPFS_INODE_BUCKETS].push_back(inode);
+	return inode;
+}
+
+void TmpFS::remove_inode(ino_t id) {
+	//The inode's pages are freed once nothing has it open anymore
+	LOCK(_lock);
+	auto& bucket = _inodes[id % TMPFS_INODE_BUCKETS];
+	for(size_t i = 0; i < bucket.size(); i++) {
+		if(bucket[i]->id == id) {
+			bucket.erase(i);
+			return;
+		}
+	}
+}
+
+Result TmpFS::reserve_pages(size_t num_pages) {
+	LOCK(_lock);
+	if(_used_pages + num_pages > _max_pages)
+		return -ENOSPC;
+	_used_pages += num_pages;
+	_used_memory += num_pages * PAGE_SIZE;
+	return SUCCESS;
+}
+
+void TmpFS::release_pages(size_t num_pages) {
+	LOCK(_lock);
+	_used_pages -= num_pages;
+	_used_memory -= num_pages * PAGE_SIZE;
+}
+
+size_t TmpFS::max_size() {
+	return _max_pages * PAGE_SIZE;
+}
+
+size_t TmpFS::used_size() {
+	return _used_pages * PAGE_SIZE;
+}
+
+size_t TmpFS::used_memory() {
+	return _used_memory;
+}
@@ -0,0 +1,66 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_TMPFS_H
+#define DUCKOS_TMPFS_H
+
+#include <kernel/filesystem/Filesystem.h>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/tasking/SpinLock.h>
+
+//Every TmpFS gets its own fsid (starting at this one) so that several can be mounted at once
+#define TMPFS_FSID_BASE 16
+#define TMPFS_INODE_BUCKETS 64
+
+class TmpFSInode;
+class TmpFS: public Filesystem {
+public:
+	/**
+	 * Creates a TmpFS that can hold up to max_size bytes of file data (or half of usable memory if max_size is 0).
+	 * @param root_mode The permissions of the root directory.
+	 */
+	explicit TmpFS(mode_t root_mode = 01777u, size_t max_size = 0);
+	~TmpFS();
+
+	//Filesystem
+	char* name() override;
+	ResultRet<kstd::shared_ptr<Inode>> get_inode(ino_t id) override;
+	ino_t root_inode_id() override;
+
+	//TmpFS
+	ResultRet<kstd::shared_ptr<TmpFSInode>> create_inode(mode_t mode, uid_t uid, gid_t gid, ino_t parent);
+	void remove_inode(ino_t id);
+	Result reserve_pages(size_t num_pages);
+	void release_pages(size_t num_pages);
+	size_t max_size();
+	size_t used_size();
+	static size_t used_memory();
+
+private:
+	kstd::vector<kstd::shared_ptr<TmpFSInode>> _inodes[TMPFS_INODE_BUCKETS];
+	ino_t _next_id = 2;
+	size_t _max_pages;
+	size_t _used_pages = 0;
+	SpinLock _lock;
+
+	static uint8_t _next_fsid;
+	static size_t _used_memory;
+};
+
+#endif //DUCKOS_TMPFS_H
@@ -0,0 +1,295 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "TmpFSInode.h"
+#include "TmpFS.h"
+#include <kernel/filesystem/DirectoryEntry.h>
+#include <kernel/memory/PageDirectory.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+
+TmpFSInode::TmpFSInode(TmpFS& fs, ino_t id, mode_t mode, uid_t uid, gid_t gid, ino_t parent): Inode(fs, id), _parent(parent) {
+	_metadata.mode = mode;
+	_metadata.uid = uid;
+	_metadata.gid = gid;
+	_metadata.size = 0;
+	_metadata.inode_id = id;
+}
+
+TmpFSInode::~TmpFSInode() {
+	for(size_t i = 0; i < _pages.size(); i++)
+		PageDirectory::k_free_region(_pages[i]);
+	tmpfs().release_pages(_pages.size());
+}
+
+InodeMetadata TmpFSInode::metadata() {
+	if(!_metadata.is_directory())
+		return _metadata;
+
+	//A directory's size is the size of the entries read_dir_entry() gives out
+	LOCK(lock);
+	InodeMetadata ret = _metadata;
+	ret.size = entry_length(".") + entry_length("..");
+	for(size_t i = 0; i < _entries.size(); i++)
+		ret.size += entry_length(_entries[i].name);
+	return ret;
+}
+
+ino_t TmpFSInode::find_id(const kstd::string& name) {
+	LOCK(lock);
+	int index = find_entry(name);
+	return index == -1 ? 0 : _entries[index].id;
+}
+
+ssize_t TmpFSInode::read(size_t start, size_t length, uint8_t* buffer, FileDescriptor* fd) {
+	if(_metadata.is_directory())
+		return -EISDIR;
+
+	LOCK(lock);
+	if(start >= _metadata.size)
+		return 0;
+	length = min(length, _metadata.size - start);
+
+	for(size_t offset = start; offset < start + length;) {
+		size_t page_offset = offset % PAGE_SIZE;
+		size_t nread = min((size_t) PAGE_SIZE - page_offset, start + length - offset);
+		memcpy(buffer + (offset - start), (uint8_t*) _pages[offset / PAGE_SIZE].virt->start + page_offset, nread);
+		offset += nread;
+	}
+
+	return length;
+}
+
+ssize_t TmpFSInode::read_dir_entry(size_t start, DirectoryEntry* buffer, FileDescriptor* fd) {
+	if(!_metadata.is_directory())
+		return -ENOTDIR;
+
+	LOCK(lock);
+
+	//Entries are found by their byte offset, with "." and ".." first
+	if(start == 0) {
+		DirectoryEntry ent(id, TYPE_DIR, ".");
+		memcpy(buffer, &ent, sizeof(DirectoryEntry));
+		return ent.entry_length();
+	}
+
+	size_t cur_index = entry_length(".");
+	if(start == cur_index) {
+		DirectoryEntry ent(_parent, TYPE_DIR, "..");
+		memcpy(buffer, &ent, sizeof(DirectoryEntry));
+		return ent.entry_length();
+	}
+
+	cur_index += entry_length("..");
+	for(size_t i = 0; i < _entries.size(); i++) {
+		auto& entry = _entries[i];
+		if(cur_index >= start) {
+			DirectoryEntry ent(entry.id, entry.type, entry.name);
+			memcpy(buffer, &ent, sizeof(DirectoryEntry));
+			return ent.entry_length();
+		}
+		cur_index += entry_length(entry.name);
+	}
+
+	return 0;
+}
+
+ssize_t TmpFSInode::write(size_t start, size_t length, const uint8_t* buf, FileDescriptor* fd) {
+	if(_metadata.is_directory())
+		return -EISDIR;
+	if(!exists())
+		return -ENOENT;
+
+	LOCK(lock);
+	if(start + length > _metadata.size) {
+		Result res = resize(start + length);
+		if(res.is_error())
+			return res.code();
+	}
+
+	for(size_t offset = start; offset < start + length;) {
+		size_t page_offset = offset % PAGE_SIZE;
+		size_t nwrite = min((size_t) PAGE_SIZE - page_offset, start + length - offset);
+		memcpy((uint8_t*) _pages[offset / PAGE_SIZE].virt->start + page_offset, buf + (offset - start), nwrite);
+		offset += nwrite;
+	}
+
+	return length;
+}
+
+Result TmpFSInode::add_entry(const kstd::string& name, Inode& inode) {
+	if(!_metadata.is_directory())
+		return -ENOTDIR;
+	if(&inode.fs != &fs)
+		return -EXDEV;
+	if(!name.length() || name.length() > NAME_MAXLEN)
+		return -ENAMETOOLONG;
+
+	LOCK(lock);
+	if(find_entry(name) != -1)
+		return -EEXIST;
+
+	_entries.push_back({name, inode.id, entry_type(inode.metadata().mode)});
+	((TmpFSInode&) inode)._hard_links++;
+	return SUCCESS;
+}
+
+ResultRet<kstd::shared_ptr<Inode>> TmpFSInode::create_entry(const kstd::string& name, mode_t mode, uid_t uid, gid_t gid) {
+	if(!_metadata.is_directory())
+		return -ENOTDIR;
+	if(!name.length() || name.length() > NAME_MAXLEN)
+		return -ENAMETOOLONG;
+
+	LOCK(lock);
+	if(find_entry(name) != -1)
+		return -EEXIST;
+
+	auto inode_or_err = tmpfs().create_inode(mode, uid, gid, id);
+	if(inode_or_err.is_error())
+		return inode_or_err.code();
+
+	auto inode = inode_or_err.value();
+	_entries.push_back({name, inode->id, entry_type(mode)});
+	inode->_hard_links++;
+	return static_cast<kstd::shared_ptr<Inode>>(inode);
+}
+
+Result TmpFSInode::remove_entry(const kstd::string& name) {
+	if(!_metadata.is_directory())
+		return -ENOTDIR;
+
+	LOCK(lock);
+	int index = find_entry(name);
+	if(index == -1)
+		return -ENOENT;
+
+	auto child_or_err = tmpfs().get_inode(_entries[index].id);
+	if(child_or_err.is_error())
+		return child_or_err.code();
+	auto child = kstd::static_pointer_cast<TmpFSInode>(child_or_err.value());
+
+	if(child->_metadata.is_directory()) {
+		LOCK_N(child->lock, child_locker);
+		if(!child->_entries.empty())
+			return -ENOTEMPTY;
+	}
+
+	//Once nothing links to the inode it's removed, and its pages are freed once it's not open anymore either
+	_entries.erase(index);
+	if(--child->_hard_links == 0) {
+		tmpfs().remove_inode(child->id);
+		child->mark_deleted();
+	}
+
+	return SUCCESS;
+}
+
+Result TmpFSInode::truncate(off_t length) {
+	if(length < 0)
+		return -EINVAL;
+	if(_metadata.is_directory())
+		return -EISDIR;
+
+	LOCK(lock);
+	return resize(length);
+}
+
+Result TmpFSInode::chmod(mode_t mode) {
+	LOCK(lock);
+	_metadata.mode = mode;
+	return SUCCESS;
+}
+
+Result TmpFSInode::chown(uid_t uid, gid_t gid) {
+	LOCK(lock);
+	_metadata.uid = uid;
+	_metadata.gid = gid;
+	return SUCCESS;
+}
+
+void TmpFSInode::open(FileDescriptor& fd, int options) {
+
+}
+
+void TmpFSInode::close(FileDescriptor& fd) {
+
+}
+
+TmpFS& TmpFSInode::tmpfs() {
+	return (TmpFS&) fs;
+}
+
+Result TmpFSInode::resize(size_t new_size) {
+	size_t num_pages = (new_size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	if(num_pages > _pages.size()) {
+		//Make sure there's room for the new pages before allocating them
+		Result res = tmpfs().reserve_pages(num_pages - _pages.size());
+		if(res.is_error())
+			return res;
+		_pages.reserve(num_pages);
+		while(_pages.size() < num_pages)
+			_pages.push_back(PageDirectory::k_alloc_region(PAGE_SIZE));
+	} else if(num_pages < _pages.size()) {
+		for(size_t i = num_pages; i < _pages.size(); i++)
+			PageDirectory::k_free_region(_pages[i]);
+		tmpfs().release_pages(_pages.size() - num_pages);
+		_pages.resize(num_pages);
+	}
+
+	//New pages start out zeroed, so just zero what's cut off of the last page in case the file grows again
+	if(new_size < _metadata.size && new_size % PAGE_SIZE)
+		memset((uint8_t*) _pages[num_pages - 1].virt->start + new_size % PAGE_SIZE, 0, PAGE_SIZE - new_size % PAGE_SIZE);
+
+	_metadata.size = new_size;
+	return SUCCESS;
+}
+
+int TmpFSInode::find_entry(const kstd::string& name) {
+	for(size_t i = 0; i < _entries.size(); i++)
+		if(_entries[i].name == name)
+			return (int) i;
+	return -1;
+}
+
+uint8_t TmpFSInode::entry_type(mode_t mode) {
+	switch(mode & 0xF000u) {
+		case MODE_DIRECTORY:
+			return TYPE_DIR;
+		case MODE_FILE:
+			return TYPE_FILE;
+		case MODE_SYMLINK:
+			return TYPE_SYMLINK;
+		case MODE_BLOCK_DEVICE:
+			return TYPE_BLOCK_DEVICE;
+		case MODE_CHAR_DEVICE:
+			return TYPE_CHARACTER_DEVICE;
+		case MODE_FIFO:
+			return TYPE_FIFO;
+		case MODE_SOCKET:
+			return TYPE_SOCKET;
+		default:
+			return TYPE_UNKNOWN;
+	}
+}
+
+size_t TmpFSInode::entry_length(const kstd::string& name) {
+	return sizeof(DirectoryEntry::id) + sizeof(DirectoryEntry::type) + sizeof(DirectoryEntry::name_length) + name.length();
+}
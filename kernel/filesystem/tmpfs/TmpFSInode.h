@@ -0,0 +1,67 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_TMPFSINODE_H
+#define DUCKOS_TMPFSINODE_H
+
+#include <kernel/filesystem/Inode.h>
+#include <kernel/kstd/vector.hpp>
+#include <kernel/memory/LinkedMemoryRegion.h>
+
+class TmpFS;
+class TmpFSInode: public Inode {
+public:
+	TmpFSInode(TmpFS& fs, ino_t id, mode_t mode, uid_t uid, gid_t gid, ino_t parent);
+	~TmpFSInode() override;
+
+	//Inode
+	InodeMetadata metadata() override;
+	ino_t find_id(const kstd::string& name) override;
+	ssize_t read(size_t start, size_t length, uint8_t* buffer, FileDescriptor* fd) override;
+	ssize_t read_dir_entry(size_t start, DirectoryEntry* buffer, FileDescriptor* fd) override;
+	ssize_t write(size_t start, size_t length, const uint8_t* buf, FileDescriptor* fd) override;
+	Result add_entry(const kstd::string& name, Inode& inode) override;
+	ResultRet<kstd::shared_ptr<Inode>> create_entry(const kstd::string& name, mode_t mode, uid_t uid, gid_t gid) override;
+	Result remove_entry(const kstd::string& name) override;
+	Result truncate(off_t length) override;
+	Result chmod(mode_t mode) override;
+	Result chown(uid_t uid, gid_t gid) override;
+	void open(FileDescriptor& fd, int options) override;
+	void close(FileDescriptor& fd) override;
+
+private:
+	struct Entry {
+		kstd::string name;
+		ino_t id;
+		uint8_t type;
+	};
+
+	TmpFS& tmpfs();
+	Result resize(size_t new_size);
+	int find_entry(const kstd::string& name);
+	static uint8_t entry_type(mode_t mode);
+	static size_t entry_length(const kstd::string& name);
+
+	kstd::vector<LinkedMemoryRegion> _pages; //The file's data, one page at a time
+	kstd::vector<Entry> _entries; //If we're a directory, the entries in it
+	ino_t _parent;
+	size_t _hard_links = 0;
+};
+
+#endif //DUCKOS_TMPFSINODE_H
@@ -39,6 +39,23 @@ namespace Interrupt {
 		}
 	};
 
+	//Like Disabler, but puts the interrupt flag back the way it was instead of always enabling interrupts afterwards, so
+	//it can be used from code that may run inside of an interrupt handler.
+	class NestedDisabler {
+	public:
+		inline NestedDisabler() {
+			asm volatile("pushf; pop %0; cli" : "=r"(_flags));
+		}
+
+		inline ~NestedDisabler() {
+			if(_flags & 0x200)
+				asm volatile("sti");
+		}
+
+	private:
+		uint32_t _flags;
+	};
+
 	class NMIDisabler {
 	public:
 		inline NMIDisabler() {
@@ -104,6 +104,46 @@ int handle_syscall(Registers& regs, uint32_t call, uint32_t arg1, uint32_t arg2,
 			return cur_proc->sys_readlink((char*)arg1, (char*)arg2, (size_t)arg3);
 		case SYS_READLINKAT:
 			return cur_proc->sys_readlinkat((struct readlinkat_args*) arg1);
+		case SYS_SENDFILE:
+			return cur_proc->sys_sendfile((struct sendfile_args*) arg1);
+		case SYS_SPLICE:
+			return cur_proc->sys_splice((struct splice_args*) arg1);
+		case SYS_READV:
+			return cur_proc->sys_readv((int) arg1, (struct iovec*) arg2, (int) arg3);
+		case SYS_WRITEV:
+			return cur_proc->sys_writev((int) arg1, (struct iovec*) arg2, (int) arg3);
+		case SYS_PREAD:
+			return cur_proc->sys_pread((struct pread_args*) arg1);
+		case SYS_PWRITE:
+			return cur_proc->sys_pwrite((struct pread_args*) arg1);
+		case SYS_PREADV:
+			return cur_proc->sys_preadv((struct preadv_args*) arg1);
+		case SYS_PWRITEV:
+			return cur_proc->sys_pwritev((struct preadv_args*) arg1);
+		case SYS_EPOLL_CREATE:
+			return cur_proc->sys_epoll_create((int) arg1);
+		case SYS_EPOLL_CTL:
+			return cur_proc->sys_epoll_ctl((struct epoll_ctl_args*) arg1);
+		case SYS_EPOLL_WAIT:
+			return cur_proc->sys_epoll_wait((struct epoll_wait_args*) arg1);
+		case SYS_FCNTL:
+			return cur_proc->sys_fcntl((int) arg1, (int) arg2, (int) arg3);
+		case SYS_SOCKET:
+			return cur_proc->sys_socket((int) arg1, (int) arg2, (int) arg3);
+		case SYS_SOCKETPAIR:
+			return cur_proc->sys_socketpair((struct socketpair_args*) arg1);
+		case SYS_BIND:
+			return cur_proc->sys_bind((int) arg1, (const struct sockaddr*) arg2, (socklen_t) arg3);
+		case SYS_LISTEN:
+			return cur_proc->sys_listen((int) arg1, (int) arg2);
+		case SYS_ACCEPT:
+			return cur_proc->sys_accept((int) arg1, (int) arg2);
+		case SYS_CONNECT:
+			return cur_proc->sys_connect((int) arg1, (const struct sockaddr*) arg2, (socklen_t) arg3);
+		case SYS_SENDMSG:
+			return cur_proc->sys_sendmsg((int) arg1, (const struct msghdr*) arg2, (int) arg3);
+		case SYS_RECVMSG:
+			return cur_proc->sys_recvmsg((int) arg1, (struct msghdr*) arg2, (int) arg3);
 		case SYS_GETSID:
 			return cur_proc->sys_getsid((pid_t)arg1);
 		case SYS_SETSID:
@@ -93,10 +93,31 @@
 #define SYS_THREADJOIN 72
 #define SYS_THREADEXIT 73
 #define SYS_ISCOMPUTERON 74
+#define SYS_SENDFILE 75
+#define SYS_SPLICE 76
+#define SYS_READV 77
+#define SYS_WRITEV 78
+#define SYS_PREAD 79
+#define SYS_PWRITE 80
+#define SYS_PREADV 81
+#define SYS_PWRITEV 82
+#define SYS_EPOLL_CREATE 83
+#define SYS_EPOLL_CTL 84
+#define SYS_EPOLL_WAIT 85
+#define SYS_FCNTL 86
+#define SYS_SOCKET 87
+#define SYS_SOCKETPAIR 88
+#define SYS_BIND 89
+#define SYS_LISTEN 90
+#define SYS_ACCEPT 91
+#define SYS_CONNECT 92
+#define SYS_SENDMSG 93
+#define SYS_RECVMSG 94
 
 #ifndef DUCKOS_KERNEL
 #include <sys/types.h>
 #else
+#include <kernel/kstd/unix_types.h>
 extern "C" void syscall_handler(Registers& regs);
 int handle_syscall(Registers& regs, uint32_t call, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 #endif
@@ -108,4 +129,55 @@ struct readlinkat_args {
 	size_t bufsize;
 };
 
+struct sendfile_args {
+	int out_fd;
+	int in_fd;
+	off_t* offset;
+	size_t count;
+};
+
+struct splice_args {
+	int in_fd;
+	off_t* in_offset;
+	int out_fd;
+	off_t* out_offset;
+	size_t count;
+	unsigned int flags;
+};
+
+struct pread_args {
+	int fd;
+	void* buf;
+	size_t count;
+	off_t offset;
+};
+
+struct preadv_args {
+	int fd;
+	const struct iovec* iov;
+	int iovcnt;
+	off_t offset;
+};
+
+struct epoll_ctl_args {
+	int epfd;
+	int op;
+	int fd;
+	struct epoll_event* event;
+};
+
+struct epoll_wait_args {
+	int epfd;
+	struct epoll_event* events;
+	int maxevents;
+	int timeout;
+};
+
+struct socketpair_args {
+	int domain;
+	int type;
+	int protocol;
+	int* sv;
+};
+
 #endif
\ No newline at end of file
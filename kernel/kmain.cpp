@@ -31,8 +31,10 @@
 #include <kernel/tasking/Process.h>
 #include <kernel/tasking/Thread.h>
 #include <kernel/device/PATADevice.h>
+#include <kernel/device/VirtioBlockDevice.h>
 #include <kernel/terminal/VirtualTTY.h>
 #include <kernel/filesystem/ext2/Ext2Filesystem.h>
+#include <kernel/filesystem/ext2/Ext2Journal.h>
 #include <kernel/device/PartitionDevice.h>
 #include <kernel/filesystem/FileDescriptor.h>
 #include <kernel/User.h>
@@ -40,6 +42,7 @@
 #include <kernel/filesystem/VFS.h>
 #include <kernel/filesystem/ptyfs/PTYFS.h>
 #include <kernel/filesystem/socketfs/SocketFS.h>
+#include <kernel/filesystem/tmpfs/TmpFS.h>
 #include <kernel/KernelMapper.h>
 #include <kernel/tasking/ProcessArgs.h>
 #include <kernel/filesystem/LinkedInode.h>
@@ -108,14 +111,17 @@ void kmain_late(){
 
 	printf("[kinit] TTY initialized.\n[kinit] Initializing disk...\n");
 
-	//Setup the disk (Assumes we're using primary master drive
-	auto disk = kstd::shared_ptr<PATADevice>(PATADevice::find(
-					PATADevice::PRIMARY,
-					PATADevice::MASTER,
-					CommandLine::inst().has_option("use_pio") //Use PIO if the command line option is present
-				));
+	//Setup the disk (Prefers a virtio block device, otherwise assumes we're using primary master drive)
+	auto disk = kstd::shared_ptr<DiskDevice>(VirtioBlockDevice::find());
 	if(!disk) {
-		printf("[kinit] Couldn't find IDE controller! Hanging...\n");
+		disk = kstd::shared_ptr<DiskDevice>(PATADevice::find(
+				PATADevice::PRIMARY,
+				PATADevice::MASTER,
+				CommandLine::inst().has_option("use_pio") //Use PIO if the command line option is present
+		));
+	}
+	if(!disk) {
+		printf("[kinit] Couldn't find a virtio block device or IDE controller! Hanging...\n");
 		while(1);
 	}
 
@@ -172,6 +178,10 @@ void kmain_late(){
 		while(true);
 	}
 
+	//Start checkpointing the root filesystem's journal in the background
+	if(ext2fs->journal)
+		TaskManager::add_process(Process::create_kernel("kjournal", Ext2Journal::kjournal));
+
 	//Mount SocketFS
 	auto sock_or_err = VFS::inst().resolve_path("/sock", VFS::inst().root_ref(), root_user);
 	if(sock_or_err.is_error()) {
@@ -200,6 +210,22 @@ void kmain_late(){
 		while(true);
 	}
 
+	//Mount a TmpFS at /tmp (which anyone can create files in) and /run (which only root can)
+	const char* tmpfs_paths[] = {"/tmp", "/run"};
+	const mode_t tmpfs_modes[] = {01777u, 0755u};
+	for(size_t i = 0; i < 2; i++) {
+		auto tmpfs_path = tmpfs_paths[i];
+		auto tmp_or_err = VFS::inst().resolve_path(tmpfs_path, VFS::inst().root_ref(), root_user);
+		if(tmp_or_err.is_error()) {
+			printf("[kinit] Failed to mount tmpfs at %s: %d\n", tmpfs_path, tmp_or_err.code());
+			continue;
+		}
+
+		res = VFS::inst().mount(new TmpFS(tmpfs_modes[i]), tmp_or_err.value());
+		if(res.is_error())
+			printf("[kinit] Failed to mount tmpfs at %s: %d\n", tmpfs_path, res.code());
+	}
+
 	//Load the kernel symbols
 	KernelMapper::load_map();
 
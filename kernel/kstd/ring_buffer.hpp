@@ -0,0 +1,117 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_RING_BUFFER_HPP
+#define DUCKOS_RING_BUFFER_HPP
+
+#include "types.h"
+#include "cstring.h"
+
+namespace kstd {
+	/**
+	 * A fixed-capacity ring buffer of bytes that copies data in and out with at most two memcpys.
+	 */
+	class ring_buffer {
+	public:
+		explicit ring_buffer(size_t capacity): _storage(new uint8_t[capacity]), _capacity(capacity) {
+
+		}
+
+		ring_buffer(const ring_buffer& other) = delete;
+		ring_buffer& operator=(const ring_buffer& other) = delete;
+
+		~ring_buffer() {
+			delete[] _storage;
+		}
+
+		size_t push(const void* data, size_t count) {
+			if(count > space())
+				count = space();
+			size_t end = (_start + _size) % _capacity;
+			size_t first = count < _capacity - end ? count : _capacity - end;
+			memcpy(_storage + end, data, first);
+			memcpy(_storage, (const uint8_t*) data + first, count - first);
+			_size += count;
+			return count;
+		}
+
+		size_t peek(void* data, size_t count) const {
+			if(count > _size)
+				count = _size;
+			size_t first = count < _capacity - _start ? count : _capacity - _start;
+			memcpy(data, _storage + _start, first);
+			memcpy((uint8_t*) data + first, _storage, count - first);
+			return count;
+		}
+
+		size_t pop(void* data, size_t count) {
+			count = peek(data, count);
+			skip(count);
+			return count;
+		}
+
+		size_t skip(size_t count) {
+			if(count > _size)
+				count = _size;
+			_start = (_start + count) % _capacity;
+			_size -= count;
+			if(!_size)
+				_start = 0;
+			return count;
+		}
+
+		bool resize(size_t new_capacity) {
+			if(new_capacity < _size)
+				return false;
+			auto* new_storage = new uint8_t[new_capacity];
+			size_t size = _size;
+			pop(new_storage, size);
+			delete[] _storage;
+			_storage = new_storage;
+			_capacity = new_capacity;
+			_start = 0;
+			_size = size;
+			return true;
+		}
+
+		size_t size() const {
+			return _size;
+		}
+
+		size_t capacity() const {
+			return _capacity;
+		}
+
+		size_t space() const {
+			return _capacity - _size;
+		}
+
+		bool empty() const {
+			return !_size;
+		}
+
+	private:
+		uint8_t* _storage;
+		size_t _capacity;
+		size_t _start = 0;
+		size_t _size = 0;
+	};
+}
+
+#endif //DUCKOS_RING_BUFFER_HPP
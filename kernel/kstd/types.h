@@ -47,4 +47,6 @@ typedef  signed  long long int int64_t;
 typedef uint32_t size_t;
 typedef int32_t ssize_t;
 
+#define SSIZE_MAX 0x7FFFFFFF
+
 #endif //DUCKOS_TYPES_H
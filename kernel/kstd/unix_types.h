@@ -67,6 +67,99 @@ public:
 
 typedef size_t nfds_t;
 
+#define EPOLLIN 0x001
+#define EPOLLPRI 0x002
+#define EPOLLOUT 0x004
+#define EPOLLERR 0x008
+#define EPOLLHUP 0x010
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+typedef union epoll_data {
+	void* ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+	uint32_t events;
+	epoll_data_t data;
+} __attribute__((packed));
+
+/// I/O vectors
+struct iovec {
+	void* iov_base;
+	size_t iov_len;
+};
+
+#define IOV_MAX 1024
+
+/// Sockets
+typedef uint16_t sa_family_t;
+typedef uint32_t socklen_t;
+
+struct sockaddr {
+	sa_family_t sa_family;
+	char sa_data[14];
+};
+
+#define UNIX_PATH_MAX 108
+struct sockaddr_un {
+	sa_family_t sun_family;
+	char sun_path[UNIX_PATH_MAX];
+};
+
+struct msghdr {
+	void* msg_name;
+	socklen_t msg_namelen;
+	struct iovec* msg_iov;
+	int msg_iovlen;
+	void* msg_control;
+	socklen_t msg_controllen;
+	int msg_flags;
+};
+
+struct cmsghdr {
+	socklen_t cmsg_len;
+	int cmsg_level;
+	int cmsg_type;
+};
+
+struct scm_shm {
+	int id;
+	int perms;
+};
+
+#define AF_UNSPEC 0
+#define AF_UNIX 1
+#define AF_LOCAL AF_UNIX
+
+#define SOCK_STREAM 1
+#define SOCK_DGRAM 2
+#define SOCK_NONBLOCK O_NONBLOCK
+#define SOCK_CLOEXEC O_CLOEXEC
+
+#define SOL_SOCKET 1
+#define SCM_RIGHTS 1
+#define SCM_SHM 0x100
+
+#define MSG_CTRUNC 0x08
+#define MSG_TRUNC 0x20
+#define MSG_DONTWAIT 0x40
+#define MSG_NOSIGNAL 0x4000
+
+#define SOMAXCONN 128
+
+#define CMSG_ALIGN(len) (((len) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define CMSG_SPACE(len) (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(len))
+#define CMSG_LEN(len) (CMSG_ALIGN(sizeof(struct cmsghdr)) + (len))
+#define CMSG_DATA(cmsg) ((unsigned char*) (cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+
 #define O_RDONLY  	0x000000
 #define O_WRONLY  	0x000001
 #define O_RDWR    	0x000002
@@ -83,6 +176,17 @@ typedef size_t nfds_t;
 #define O_EXEC		0x400000
 #define O_SEARCH	O_EXEC //They're the same
 
+#define F_GETFD 1
+#define F_SETFD 2
+#define F_GETFL 3
+#define F_SETFL 4
+#define F_SETPIPE_SZ 1031
+#define F_GETPIPE_SZ 1032
+
+#define FD_CLOEXEC 1
+
+#define PIPE_BUF 4096
+
 #define SEEK_SET 0
 #define SEEK_CUR 1
 #define SEEK_END 2
@@ -88,6 +88,16 @@ void MemoryRegion::shm_deref() {
 	lock.release();
 }
 
+bool MemoryRegion::shm_allow(pid_t pid, bool write) {
+	LOCK(lock);
+	for(size_t i = 0; i < shm_allowed->size(); i++) {
+		if(shm_allowed->at(i).pid == pid)
+			return false;
+	}
+	shm_allowed->push_back({pid, write});
+	return true;
+}
+
 size_t MemoryRegion::end() {
 	return start + size - 1;
 }
@@ -51,6 +51,9 @@ public:
 	//Used to decrease the number of shared memory references on a physical region & free it if necessary.
 	void shm_deref();
 
+	//Used to give a process access to a physical shared region. Returns false if the process already had access.
+	bool shm_allow(pid_t pid, bool write);
+
 	//Returns the end of the region
 	size_t end();
 
@@ -798,18 +798,25 @@ Result PageDirectory::allow_shared_region(int id, pid_t called_pid, pid_t pid, b
 	if(vreg->related->shm_owner != called_pid)
 		return -EPERM;
 
-	//Make sure we don't already have perms
-	LOCK_N(vreg->related->lock, __related_lock);
-	for(size_t i = 0; i < vreg->related->shm_allowed->size(); i++) {
-		if(vreg->related->shm_allowed->at(i).pid == pid)
-			return -EEXIST;
-	}
-
-	//Update the permissions and return success
-	vreg->related->shm_allowed->push_back({pid, write});
+	//Update the permissions, unless the process already has them
+	if(!vreg->related->shm_allow(pid, write))
+		return -EEXIST;
 	return SUCCESS;
 }
 
+ResultRet<MemoryRegion*> PageDirectory::ref_shared_region(int id, pid_t called_pid) {
+	LOCK(_lock);
+
+	MemoryRegion* vreg = _vmem_map.find_shared_region(id);
+	if(!vreg)
+		return -ENOENT;
+	if(vreg->related->shm_owner != called_pid)
+		return -EPERM;
+
+	vreg->related->shm_ref();
+	return vreg->related;
+}
+
 MemoryMap& PageDirectory::vmem_map() {
 	return _vmem_map;
 }
@@ -279,6 +279,14 @@ public:
 	 */
 	Result allow_shared_region(int id, pid_t called_pid, pid_t pid, bool write);
 
+	/**
+	 * Takes a reference to a shared memory region so that it can be shared with another process later on.
+	 * @param id The ID of the shared memory region. Must be mapped in this page directory.
+	 * @param called_pid The pid of the process that will share the region. Will return -EPERM if not the owner of the region.
+	 * @return The physical region, which must be released with shm_deref(), -ENOENT if it doesn't exist, or -EPERM if not the owner of the region.
+	 */
+	ResultRet<MemoryRegion*> ref_shared_region(int id, pid_t called_pid);
+
 	/**
 	 * @return A pointer to the page directory's vmem map.
 	 */
@@ -45,11 +45,20 @@
 #define PCI_BAR3 0x1C //32
 #define PCI_BAR4 0x20 //32
 #define PCI_BAR5 0x24 //32
+#define PCI_SUBSYSTEM_VENDOR_ID 0x2C //16
+#define PCI_SUBSYSTEM_ID 0x2E //16
+#define PCI_CAPABILITIES_POINTER 0x34 //8
 #define PCI_PRIMARY_BUS 0x18 //8
 #define PCI_SECONDARY_BUS 0x19 //8
 #define PCI_INTERRUPT_LINE 0x3c //8
 #define PCI_INTERRUPT_PIN 0x3d //8
 
+//Status bits
+#define PCI_STATUS_CAPABILITIES 0x10
+
+//Capability IDs
+#define PCI_CAP_VENDOR_SPECIFIC 0x09
+
 //Header types
 #define PCI_MULTIFUNCTION 0x80
 
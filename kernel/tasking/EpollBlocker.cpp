@@ -0,0 +1,38 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "EpollBlocker.h"
+#include <kernel/filesystem/Epoll.h>
+
+EpollBlocker::EpollBlocker(Epoll& epoll, Time timeout):
+	_epoll(epoll), _has_timeout(timeout >= Time()), _end_time(Time::now() + timeout)
+{
+}
+
+bool EpollBlocker::is_ready() {
+	return _epoll.has_ready() || timed_out();
+}
+
+bool EpollBlocker::can_be_interrupted() {
+	return true;
+}
+
+bool EpollBlocker::timed_out() {
+	return _has_timeout && Time::now() >= _end_time;
+}
@@ -21,34 +21,63 @@
 #include <kernel/time/PIT.h>
 #include <kernel/filesystem/FileDescriptor.h>
 
-PollBlocker::PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout):
-	polls(pollfd), has_timeout(timeout >= Time()), start_time(Time::now()), end_time(Time::now() + timeout)
-{
+PollBlocker::Watcher::Watcher(PollBlocker& blocker, FileDescriptor* fd): FileWatcher(fd), _blocker(blocker) {
+
 }
 
-bool PollBlocker::is_ready() {
-	for(size_t i = 0; i < polls.size(); i++) {
-		auto& poll = polls[i];
-
-		if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd)) {
-			polled = poll.fd_num;
-			polled_revent = POLLIN;
-			return true;
-		}
-
-		if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd)) {
-			polled = poll.fd_num;
-			polled_revent = POLLOUT;
-			return true;
-		}
+void PollBlocker::Watcher::notify() {
+	_blocker._notified = true;
+}
+
+void PollBlocker::Watcher::fd_closed() {
+	_blocker._notified = true;
+}
+
+PollBlocker::PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout):
+	_polls(pollfd), _has_timeout(timeout >= Time()), _end_time(Time::now() + timeout)
+{
+	//Watch each file so that we only have to check them again once one of them changes
+	_watchers.reserve(_polls.size());
+	for(size_t i = 0; i < _polls.size(); i++) {
+		auto* watcher = new Watcher(*this, _polls[i].fd.get());
+		_polls[i].fd->file()->watchers().add(watcher);
+		_watchers.push_back(watcher);
 	}
+}
 
-	if(has_timeout && Time::now() >= end_time)
-		return true;
+PollBlocker::~PollBlocker() {
+	for(size_t i = 0; i < _watchers.size(); i++)
+		delete _watchers[i];
+}
 
-	return false;
+bool PollBlocker::is_ready() {
+	return _notified || timed_out();
 }
 
 bool PollBlocker::can_be_interrupted() {
 	return true;
-}
\ No newline at end of file
+}
+
+bool PollBlocker::timed_out() {
+	return _has_timeout && Time::now() >= _end_time;
+}
+
+int PollBlocker::check() {
+	_notified = false;
+	int nready = 0;
+	for(size_t i = 0; i < _polls.size(); i++) {
+		auto& poll = _polls[i];
+		poll.revents = 0;
+		if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd))
+			poll.revents |= POLLIN;
+		if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd))
+			poll.revents |= POLLOUT;
+		if(poll.revents)
+			nready++;
+	}
+	return nready;
+}
+
+kstd::vector<PollBlocker::PollFD>& PollBlocker::polls() {
+	return _polls;
+}
@@ -24,6 +24,7 @@
 #include "Blocker.h"
 #include <kernel/time/Time.h>
 #include <kernel/kstd/shared_ptr.hpp>
+#include <kernel/filesystem/FileWatcher.h>
 
 #define POLLIN 0x01
 #define POLLPRI 0x02
@@ -40,19 +41,33 @@ public:
 		int fd_num;
 		kstd::shared_ptr<FileDescriptor> fd;
 		short events;
+		short revents;
 	};
 
 	PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout);
+	~PollBlocker();
 	bool is_ready() override;
 	bool can_be_interrupted() override;
+	bool timed_out();
+	int check();
+	kstd::vector<PollFD>& polls();
 
-	int polled;
-	short polled_revent;
 private:
-	kstd::vector<PollFD> polls;
-	Time end_time;
-	Time start_time;
-	bool has_timeout;
+	//Watches one of the polled files, and marks the blocker as ready when it changes
+	class Watcher: public FileWatcher {
+	public:
+		Watcher(PollBlocker& blocker, FileDescriptor* fd);
+		void notify() override;
+		void fd_closed() override;
+	private:
+		PollBlocker& _blocker;
+	};
+
+	kstd::vector<PollFD> _polls;
+	kstd::vector<Watcher*> _watchers;
+	volatile bool _notified = false;
+	bool _has_timeout;
+	Time _end_time;
 };
 
 
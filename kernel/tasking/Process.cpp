@@ -36,6 +36,8 @@
 #include "Thread.h"
 #include "JoinBlocker.h"
 #include <kernel/filesystem/Pipe.h>
+#include <kernel/filesystem/Epoll.h>
+#include <kernel/filesystem/LocalSocket.h>
 #include <kernel/kstd/cstring.h>
 
 Process* Process::create_kernel(const kstd::string& name, void (*func)()){
@@ -344,6 +346,65 @@ ssize_t Process::sys_write(int fd, uint8_t *buf, size_t count) {
 	return ret;
 }
 
+void Process::check_iov(const struct iovec* iov, int iovcnt) {
+	check_ptr(iov);
+	for(int i = 0; i < iovcnt && i < IOV_MAX; i++) {
+		check_ptr(&iov[i]);
+		if(iov[i].iov_len)
+			check_ptr(iov[i].iov_base);
+	}
+}
+
+ssize_t Process::sys_readv(int fd, struct iovec* iov, int iovcnt) {
+	check_iov(iov, iovcnt);
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	return _file_descriptors[fd]->readv(iov, iovcnt);
+}
+
+ssize_t Process::sys_writev(int fd, struct iovec* iov, int iovcnt) {
+	check_iov(iov, iovcnt);
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	return _file_descriptors[fd]->writev(iov, iovcnt);
+}
+
+ssize_t Process::sys_pread(struct pread_args* args) {
+	check_ptr(args);
+	check_ptr(args->buf);
+	if(args->fd < 0 || args->fd >= (int) _file_descriptors.size() || !_file_descriptors[args->fd])
+		return -EBADF;
+	return _file_descriptors[args->fd]->pread((uint8_t*) args->buf, args->count, args->offset);
+}
+
+ssize_t Process::sys_pwrite(struct pread_args* args) {
+	check_ptr(args);
+	check_ptr(args->buf);
+	if(args->fd < 0 || args->fd >= (int) _file_descriptors.size() || !_file_descriptors[args->fd])
+		return -EBADF;
+	return _file_descriptors[args->fd]->pwrite((const uint8_t*) args->buf, args->count, args->offset);
+}
+
+ssize_t Process::sys_preadv(struct preadv_args* args) {
+	check_ptr(args);
+	check_iov(args->iov, args->iovcnt);
+	if(args->fd < 0 || args->fd >= (int) _file_descriptors.size() || !_file_descriptors[args->fd])
+		return -EBADF;
+	if(args->offset < 0)
+		return -EINVAL;
+	return _file_descriptors[args->fd]->readv(args->iov, args->iovcnt, args->offset);
+}
+
+ssize_t Process::sys_pwritev(struct preadv_args* args) {
+	check_ptr(args);
+	check_iov(args->iov, args->iovcnt);
+	if(args->fd < 0 || args->fd >= (int) _file_descriptors.size() || !_file_descriptors[args->fd])
+		return -EBADF;
+	if(args->offset < 0)
+		return -EINVAL;
+	return _file_descriptors[args->fd]->writev(args->iov, args->iovcnt, args->offset);
+}
+
 pid_t Process::sys_fork(Registers& regs) {
 	auto* new_proc = new Process(this, regs);
 	TaskManager::add_process(new_proc->_self_ptr);
@@ -762,6 +823,44 @@ int Process::sys_readlinkat(struct readlinkat_args* args) {
 	return -1;
 }
 
+ssize_t Process::sys_sendfile(struct sendfile_args* args) {
+	check_ptr(args);
+	if(args->offset)
+		check_ptr(args->offset);
+	if(args->out_fd < 0 || args->out_fd >= (int) _file_descriptors.size() || !_file_descriptors[args->out_fd])
+		return -EBADF;
+	if(args->in_fd < 0 || args->in_fd >= (int) _file_descriptors.size() || !_file_descriptors[args->in_fd])
+		return -EBADF;
+	auto in_fd = _file_descriptors[args->in_fd];
+	auto out_fd = _file_descriptors[args->out_fd];
+	if(in_fd->file()->is_fifo())
+		return -EINVAL;
+	return in_fd->splice_to(*out_fd, args->offset, nullptr, args->count);
+}
+
+ssize_t Process::sys_splice(struct splice_args* args) {
+	check_ptr(args);
+	if(args->in_offset)
+		check_ptr(args->in_offset);
+	if(args->out_offset)
+		check_ptr(args->out_offset);
+	if(args->out_fd < 0 || args->out_fd >= (int) _file_descriptors.size() || !_file_descriptors[args->out_fd])
+		return -EBADF;
+	if(args->in_fd < 0 || args->in_fd >= (int) _file_descriptors.size() || !_file_descriptors[args->in_fd])
+		return -EBADF;
+	auto in_fd = _file_descriptors[args->in_fd];
+	auto out_fd = _file_descriptors[args->out_fd];
+
+	//One end has to be a pipe, and pipes can't be given an offset
+	bool in_pipe = in_fd->file()->is_fifo();
+	bool out_pipe = out_fd->file()->is_fifo();
+	if(!in_pipe && !out_pipe)
+		return -EINVAL;
+	if((in_pipe && args->in_offset) || (out_pipe && args->out_offset))
+		return -ESPIPE;
+	return in_fd->splice_to(*out_fd, args->in_offset, args->out_offset, args->count);
+}
+
 int Process::sys_getsid(pid_t pid) {
 	if(pid == 0)
 		return _sid;
@@ -1035,22 +1134,445 @@ int Process::sys_poll(struct pollfd* pollfd, nfds_t nfd, int timeout) {
 		}
 	}
 
-	//Block
+	//Check the files, and block until one of them notifies us if none of them are ready
 	PollBlocker blocker(polls, Time(0, timeout * 1000));
-	TaskManager::current_thread()->block(blocker);
+	int nready;
+	while(true) {
+		nready = blocker.check();
+		if(nready || !timeout || blocker.timed_out())
+			break;
+		TaskManager::current_thread()->block(blocker);
+		if(blocker.was_interrupted())
+			return -EINTR;
+	}
 
-	//Set appropriate revent
-	for(nfds_t i = 0; i < nfd; i++) {
+	//Set the revents of every polled fd
+	auto& results = blocker.polls();
+	for(nfds_t i = 0, j = 0; i < nfd && j < results.size(); i++) {
 		auto& poll = pollfd[i];
-		if(poll.fd == blocker.polled) {
-			poll.revents = blocker.polled_revent;
-			break;
+		if(poll.fd == results[j].fd_num && poll.revents != POLLINVAL)
+			poll.revents = results[j++].revents;
+	}
+
+	return nready;
+}
+
+int Process::sys_epoll_create(int flags) {
+	if(flags & ~O_CLOEXEC)
+		return -EINVAL;
+
+	auto epoll_fd = kstd::make_shared<FileDescriptor>(kstd::make_shared<Epoll>());
+	epoll_fd->set_owner(_self_ptr);
+	epoll_fd->set_options(O_RDONLY | flags);
+	_file_descriptors.push_back(epoll_fd);
+	epoll_fd->set_id((int) _file_descriptors.size() - 1);
+	return (int) _file_descriptors.size() - 1;
+}
+
+int Process::sys_epoll_ctl(struct epoll_ctl_args* args) {
+	check_ptr(args);
+	if(args->epfd < 0 || args->epfd >= (int) _file_descriptors.size() || !_file_descriptors[args->epfd])
+		return -EBADF;
+	if(args->fd < 0 || args->fd >= (int) _file_descriptors.size() || !_file_descriptors[args->fd])
+		return -EBADF;
+	auto epoll_file = _file_descriptors[args->epfd]->file();
+	if(!epoll_file->is_epoll())
+		return -EINVAL;
+	auto* epoll = (Epoll*) epoll_file.get();
+
+	switch(args->op) {
+		case EPOLL_CTL_ADD:
+			check_ptr(args->event);
+			return epoll->add(args->fd, _file_descriptors[args->fd], *args->event).code();
+		case EPOLL_CTL_MOD:
+			check_ptr(args->event);
+			return epoll->modify(args->fd, *args->event).code();
+		case EPOLL_CTL_DEL:
+			return epoll->remove(args->fd).code();
+		default:
+			return -EINVAL;
+	}
+}
+
+int Process::sys_epoll_wait(struct epoll_wait_args* args) {
+	check_ptr(args);
+	check_ptr(args->events);
+	if(args->epfd < 0 || args->epfd >= (int) _file_descriptors.size() || !_file_descriptors[args->epfd])
+		return -EBADF;
+	auto epoll_file = _file_descriptors[args->epfd]->file();
+	if(!epoll_file->is_epoll())
+		return -EINVAL;
+	return ((Epoll*) epoll_file.get())->wait(args->events, args->maxevents, args->timeout);
+}
+
+int Process::sys_fcntl(int fd, int cmd, int arg) {
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	auto& desc = _file_descriptors[fd];
+
+	switch(cmd) {
+		case F_GETFD:
+			return desc->cloexec() ? FD_CLOEXEC : 0;
+		case F_SETFD:
+			if(arg & FD_CLOEXEC)
+				desc->set_options(desc->options() | O_CLOEXEC);
+			else
+				desc->unset_options(O_CLOEXEC);
+			return SUCCESS;
+		case F_GETFL:
+			return desc->options() & ~O_CLOEXEC;
+		case F_SETFL:
+			//Only the append and nonblock flags can be changed after opening
+			desc->set_options((desc->options() & ~(O_APPEND | O_NONBLOCK)) | (arg & (O_APPEND | O_NONBLOCK)));
+			return SUCCESS;
+		case F_GETPIPE_SZ:
+			if(!desc->file()->is_fifo())
+				return -EBADF;
+			return (int) ((Pipe*) desc->file().get())->capacity();
+		case F_SETPIPE_SZ: {
+			if(!desc->file()->is_fifo())
+				return -EBADF;
+			if(arg < 0)
+				return -EINVAL;
+			auto res = ((Pipe*) desc->file().get())->set_capacity(arg);
+			if(res.is_error())
+				return res.code();
+			return (int) res.value();
 		}
+		default:
+			return -EINVAL;
 	}
+}
+
+int Process::sys_socket(int domain, int type, int protocol) {
+	if(domain != AF_UNIX)
+		return -EAFNOSUPPORT;
+	int flags = type & (SOCK_NONBLOCK | SOCK_CLOEXEC);
+	type &= ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(type != SOCK_STREAM && type != SOCK_DGRAM)
+		return -EPROTOTYPE;
+	if(protocol)
+		return -EPROTONOSUPPORT;
 
+	return add_socket_fd(kstd::make_shared<LocalSocket>(type), flags);
+}
+
+int Process::sys_socketpair(struct socketpair_args* args) {
+	check_ptr(args);
+	check_ptr(args->sv);
+	if(args->domain != AF_UNIX)
+		return -EAFNOSUPPORT;
+	int flags = args->type & (SOCK_NONBLOCK | SOCK_CLOEXEC);
+	int type = args->type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(type != SOCK_STREAM && type != SOCK_DGRAM)
+		return -EPROTOTYPE;
+	if(args->protocol)
+		return -EPROTONOSUPPORT;
+
+	auto a = kstd::make_shared<LocalSocket>(type);
+	auto b = kstd::make_shared<LocalSocket>(type);
+	LocalSocket::connect_pair(*a, *b);
+	args->sv[0] = add_socket_fd(a, flags);
+	args->sv[1] = add_socket_fd(b, flags);
 	return SUCCESS;
 }
 
+int Process::sys_bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen) {
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	auto path_or_err = socket_path(addr, addrlen);
+	if(path_or_err.is_error())
+		return path_or_err.code();
+	return socket_or_err.value()->bind(path_or_err.value(), _user, _cwd, _umask).code();
+}
+
+int Process::sys_listen(int sockfd, int backlog) {
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	return socket_or_err.value()->listen(backlog).code();
+}
+
+int Process::sys_accept(int sockfd, int flags) {
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	if(flags & ~(SOCK_NONBLOCK | SOCK_CLOEXEC))
+		return -EINVAL;
+
+	auto connection_or_err = socket_or_err.value()->accept(_file_descriptors[sockfd]->nonblock());
+	if(connection_or_err.is_error())
+		return connection_or_err.code();
+	return add_socket_fd(connection_or_err.value(), flags);
+}
+
+int Process::sys_connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen) {
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	auto path_or_err = socket_path(addr, addrlen);
+	if(path_or_err.is_error())
+		return path_or_err.code();
+	return socket_or_err.value()->connect(path_or_err.value(), _user, _cwd).code();
+}
+
+ssize_t Process::sys_sendmsg(int sockfd, const struct msghdr* msg, int flags) {
+	check_ptr(msg);
+	if(msg->msg_iovlen < 0 || msg->msg_iovlen > IOV_MAX)
+		return -EINVAL;
+	if(msg->msg_iovlen)
+		check_iov(msg->msg_iov, msg->msg_iovlen);
+	size_t length = 0;
+	for(int i = 0; i < msg->msg_iovlen; i++) {
+		if(msg->msg_iov[i].iov_len > (size_t) SSIZE_MAX - length)
+			return -EINVAL;
+		length += msg->msg_iov[i].iov_len;
+	}
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	auto socket = socket_or_err.value();
+	bool nonblock = (flags & MSG_DONTWAIT) || _file_descriptors[sockfd]->nonblock();
+
+	//Collect the rights being sent. The file descriptors are copied now, so closing them after sending is fine
+	kstd::shared_ptr<LocalSocket::Rights> rights;
+	if(msg->msg_control && msg->msg_controllen) {
+		check_ptr(msg->msg_control);
+		check_ptr((uint8_t*) msg->msg_control + msg->msg_controllen - 1);
+		rights = kstd::make_shared<LocalSocket::Rights>();
+		size_t offset = 0;
+		while(offset + sizeof(struct cmsghdr) <= msg->msg_controllen) {
+			auto* cmsg = (struct cmsghdr*) ((uint8_t*) msg->msg_control + offset);
+			if(cmsg->cmsg_len < CMSG_LEN(0) || offset + cmsg->cmsg_len > msg->msg_controllen)
+				return -EINVAL;
+			if(cmsg->cmsg_level != SOL_SOCKET)
+				return -EINVAL;
+
+			size_t data_len = cmsg->cmsg_len - CMSG_LEN(0);
+			if(cmsg->cmsg_type == SCM_RIGHTS) {
+				auto* fds = (int*) CMSG_DATA(cmsg);
+				for(size_t i = 0; i < data_len / sizeof(int); i++) {
+					if(fds[i] < 0 || fds[i] >= (int) _file_descriptors.size() || !_file_descriptors[fds[i]])
+						return -EBADF;
+					if(rights->fds.size() >= LOCALSOCKET_MAX_RIGHTS)
+						return -ETOOMANYREFS;
+					rights->fds.push_back(kstd::make_shared<FileDescriptor>(*_file_descriptors[fds[i]]));
+				}
+			} else if(cmsg->cmsg_type == SCM_SHM) {
+				auto* shms = (struct scm_shm*) CMSG_DATA(cmsg);
+				for(size_t i = 0; i < data_len / sizeof(struct scm_shm); i++) {
+					if(!(shms[i].perms & SHM_READ) || (shms[i].perms & ~(SHM_READ | SHM_WRITE)))
+						return -EINVAL;
+					if(rights->shms.size() >= LOCALSOCKET_MAX_RIGHTS)
+						return -ETOOMANYREFS;
+					auto region_or_err = _page_directory->ref_shared_region(shms[i].id, _pid);
+					if(region_or_err.is_error())
+						return region_or_err.code();
+					rights->shms.push_back({shms[i].id, shms[i].perms, region_or_err.value()});
+				}
+			} else {
+				return -EINVAL;
+			}
+			offset += CMSG_ALIGN(cmsg->cmsg_len);
+		}
+		if(rights->fds.empty() && rights->shms.empty())
+			rights.reset();
+	}
+
+	//Gather the data into one buffer so that it's sent as a single message. Nothing bigger than the socket's buffer can
+	//be sent in one go, so that's as big as the buffer gets (a stream socket just sends part of the data)
+	const uint8_t* data;
+	uint8_t* gathered = nullptr;
+	if(msg->msg_iovlen == 1) {
+		data = (const uint8_t*) msg->msg_iov[0].iov_base;
+	} else {
+		if(length > LOCALSOCKET_BUFFER_SIZE) {
+			if(socket->type() == SOCK_DGRAM)
+				return -EMSGSIZE;
+			length = LOCALSOCKET_BUFFER_SIZE;
+		}
+		gathered = new uint8_t[length ? length : 1];
+		size_t copied = 0;
+		for(int i = 0; i < msg->msg_iovlen && copied < length; i++) {
+			size_t count = min(msg->msg_iov[i].iov_len, length - copied);
+			memcpy(gathered + copied, msg->msg_iov[i].iov_base, count);
+			copied += count;
+		}
+		data = gathered;
+	}
+
+	ssize_t ret;
+	if(msg->msg_name && msg->msg_namelen) {
+		auto path_or_err = socket_path((const struct sockaddr*) msg->msg_name, msg->msg_namelen);
+		if(path_or_err.is_error())
+			ret = path_or_err.code();
+		else
+			ret = socket->send_to(path_or_err.value(), _user, _cwd, data, length, rights, nonblock);
+	} else {
+		ret = socket->send(data, length, rights, nonblock);
+	}
+	delete[] gathered;
+
+	if(ret == -EPIPE && !(flags & MSG_NOSIGNAL))
+		kill(SIGPIPE);
+	return ret;
+}
+
+ssize_t Process::sys_recvmsg(int sockfd, struct msghdr* msg, int flags) {
+	check_ptr(msg);
+	if(msg->msg_iovlen < 0 || msg->msg_iovlen > IOV_MAX)
+		return -EINVAL;
+	if(msg->msg_iovlen)
+		check_iov(msg->msg_iov, msg->msg_iovlen);
+	if(msg->msg_control && msg->msg_controllen) {
+		check_ptr(msg->msg_control);
+		check_ptr((uint8_t*) msg->msg_control + msg->msg_controllen - 1);
+	}
+	auto socket_or_err = socket_for_fd(sockfd);
+	if(socket_or_err.is_error())
+		return socket_or_err.code();
+	bool nonblock = (flags & MSG_DONTWAIT) || _file_descriptors[sockfd]->nonblock();
+
+	//Read into one buffer and scatter it afterwards if there's more than one iovec. No more than the socket's buffer can
+	//be read at once, so the buffer doesn't need to be any bigger than that
+	size_t length = 0;
+	for(int i = 0; i < msg->msg_iovlen; i++) {
+		if(msg->msg_iov[i].iov_len > (size_t) SSIZE_MAX - length)
+			return -EINVAL;
+		length += msg->msg_iov[i].iov_len;
+	}
+	uint8_t* data;
+	uint8_t* scattered = nullptr;
+	if(msg->msg_iovlen == 1) {
+		data = (uint8_t*) msg->msg_iov[0].iov_base;
+	} else {
+		length = min(length, (size_t) LOCALSOCKET_BUFFER_SIZE);
+		scattered = new uint8_t[length ? length : 1];
+		data = scattered;
+	}
+
+	int out_flags = 0;
+	kstd::shared_ptr<LocalSocket::Rights> rights;
+	ssize_t ret = socket_or_err.value()->recv(data, length, &rights, nonblock, out_flags);
+	if(scattered) {
+		size_t copied = 0;
+		for(int i = 0; ret > 0 && i < msg->msg_iovlen && copied < (size_t) ret; i++) {
+			size_t count = msg->msg_iov[i].iov_len < ret - copied ? msg->msg_iov[i].iov_len : ret - copied;
+			memcpy(msg->msg_iov[i].iov_base, scattered + copied, count);
+			copied += count;
+		}
+		delete[] scattered;
+	}
+	if(ret < 0)
+		return ret;
+
+	//Install whatever rights came with the data, and write out control messages for the ones that fit
+	size_t control_len = 0;
+	if(rights) {
+		auto* control = (uint8_t*) msg->msg_control;
+		size_t control_space = msg->msg_control ? msg->msg_controllen : 0;
+
+		size_t nfds = rights->fds.size();
+		if(nfds && control_len + CMSG_LEN(sizeof(int)) <= control_space) {
+			size_t max_fds = (control_space - control_len - CMSG_LEN(0)) / sizeof(int);
+			if(max_fds < nfds) {
+				nfds = max_fds;
+				out_flags |= MSG_CTRUNC;
+			}
+			auto* cmsg = (struct cmsghdr*) (control + control_len);
+			cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			auto* fds = (int*) CMSG_DATA(cmsg);
+			for(size_t i = 0; i < nfds; i++) {
+				auto& fd = rights->fds[i];
+				fd->set_owner(_self_ptr);
+				fd->unset_options(O_CLOEXEC);
+				_file_descriptors.push_back(fd);
+				fd->set_id((int) _file_descriptors.size() - 1);
+				fds[i] = (int) _file_descriptors.size() - 1;
+			}
+			control_len += CMSG_SPACE(nfds * sizeof(int));
+		} else if(nfds) {
+			out_flags |= MSG_CTRUNC;
+		}
+
+		//Shared memory is allowed now that we know who received it. The sender was allowed to share it when it was sent.
+		kstd::vector<struct scm_shm> shms;
+		for(size_t i = 0; i < rights->shms.size(); i++) {
+			auto& shm = rights->shms[i];
+			shm.region->shm_allow(_pid, shm.perms & SHM_WRITE);
+			shms.push_back({shm.id, shm.perms});
+		}
+		if(!shms.empty()) {
+			size_t nshms = shms.size();
+			if(control_len + CMSG_LEN(sizeof(struct scm_shm)) <= control_space) {
+				size_t max_shms = (control_space - control_len - CMSG_LEN(0)) / sizeof(struct scm_shm);
+				if(max_shms < nshms) {
+					nshms = max_shms;
+					out_flags |= MSG_CTRUNC;
+				}
+				auto* cmsg = (struct cmsghdr*) (control + control_len);
+				cmsg->cmsg_len = CMSG_LEN(nshms * sizeof(struct scm_shm));
+				cmsg->cmsg_level = SOL_SOCKET;
+				cmsg->cmsg_type = SCM_SHM;
+				memcpy(CMSG_DATA(cmsg), shms.storage(), nshms * sizeof(struct scm_shm));
+				control_len += CMSG_SPACE(nshms * sizeof(struct scm_shm));
+			} else {
+				out_flags |= MSG_CTRUNC;
+			}
+		}
+		if(control_len > control_space)
+			control_len = control_space;
+	}
+
+	msg->msg_controllen = control_len;
+	msg->msg_namelen = 0;
+	msg->msg_flags = out_flags;
+	return ret;
+}
+
+ResultRet<kstd::shared_ptr<LocalSocket>> Process::socket_for_fd(int fd) {
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
+		return -EBADF;
+	auto file = _file_descriptors[fd]->file();
+	if(!file->is_socket())
+		return -ENOTSOCK;
+	return kstd::static_pointer_cast<LocalSocket>(file);
+}
+
+int Process::add_socket_fd(const kstd::shared_ptr<LocalSocket>& socket, int flags) {
+	auto fd = kstd::make_shared<FileDescriptor>(socket);
+	fd->set_owner(_self_ptr);
+	fd->set_options(O_RDWR | flags);
+	_file_descriptors.push_back(fd);
+	fd->set_id((int) _file_descriptors.size() - 1);
+	return (int) _file_descriptors.size() - 1;
+}
+
+ResultRet<kstd::string> Process::socket_path(const struct sockaddr* addr, socklen_t addrlen) {
+	check_ptr(addr);
+	if(addrlen <= sizeof(sa_family_t) || addrlen > sizeof(struct sockaddr_un))
+		return -EINVAL;
+	auto* addr_un = (const struct sockaddr_un*) addr;
+	if(addr_un->sun_family != AF_UNIX)
+		return -EAFNOSUPPORT;
+
+	//The path doesn't have to be null-terminated if it fills the whole address
+	size_t max_length = addrlen - sizeof(sa_family_t);
+	size_t length = 0;
+	while(length < max_length && addr_un->sun_path[length])
+		length++;
+	if(!length)
+		return -EINVAL;
+
+	char path[UNIX_PATH_MAX + 1];
+	memcpy(path, addr_un->sun_path, length);
+	path[length] = '\0';
+	return kstd::string(path);
+}
+
 int Process::sys_ptsname(int fd, char* buf, size_t bufsize) {
 	check_ptr(buf);
 	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd])
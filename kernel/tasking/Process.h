@@ -33,6 +33,7 @@ class TTYDevice;
 class Thread;
 class PageDirectory;
 class LinkedInode;
+class LocalSocket;
 
 namespace ELF {struct elf32_header;};
 
@@ -87,9 +88,16 @@ public:
 
 	//Syscalls
 	void check_ptr(const void* ptr);
+	void check_iov(const struct iovec* iov, int iovcnt);
 	void sys_exit(int status);
 	ssize_t sys_read(int fd, uint8_t* buf, size_t count);
 	ssize_t sys_write(int fd, uint8_t* buf, size_t count);
+	ssize_t sys_readv(int fd, struct iovec* iov, int iovcnt);
+	ssize_t sys_writev(int fd, struct iovec* iov, int iovcnt);
+	ssize_t sys_pread(struct pread_args* args);
+	ssize_t sys_pwrite(struct pread_args* args);
+	ssize_t sys_preadv(struct preadv_args* args);
+	ssize_t sys_pwritev(struct preadv_args* args);
 	pid_t sys_fork(Registers& regs);
 	int exec(const kstd::string& filename, ProcessArgs* args);
 	int sys_execve(char *filename, char **argv, char **envp);
@@ -122,6 +130,8 @@ public:
 	int sys_symlinkat(char* file, int dirfd, char* linkname);
 	int sys_readlink(char* file, char* buf, size_t bufsize);
 	int sys_readlinkat(struct readlinkat_args* args);
+	ssize_t sys_sendfile(struct sendfile_args* args);
+	ssize_t sys_splice(struct splice_args* args);
 	int sys_getsid(pid_t pid);
 	int sys_setsid();
 	int sys_getpgid(pid_t pid);
@@ -151,6 +161,18 @@ public:
 	int sys_shmdetach(int id);
 	int sys_shmallow(int id, pid_t pid, int perms);
 	int sys_poll(struct pollfd* pollfd, nfds_t nfd, int timeout);
+	int sys_epoll_create(int flags);
+	int sys_epoll_ctl(struct epoll_ctl_args* args);
+	int sys_epoll_wait(struct epoll_wait_args* args);
+	int sys_fcntl(int fd, int cmd, int arg);
+	int sys_socket(int domain, int type, int protocol);
+	int sys_socketpair(struct socketpair_args* args);
+	int sys_bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+	int sys_listen(int sockfd, int backlog);
+	int sys_accept(int sockfd, int flags);
+	int sys_connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+	ssize_t sys_sendmsg(int sockfd, const struct msghdr* msg, int flags);
+	ssize_t sys_recvmsg(int sockfd, struct msghdr* msg, int flags);
 	int sys_ptsname(int fd, char* buf, size_t bufsize);
 	int sys_sleep(timespec* time, timespec* remainder);
 	int sys_threadcreate(void* (*entry_func)(void* (*)(void*), void*), void* (*thread_func)(void*), void* arg);
@@ -163,6 +185,11 @@ private:
 	Process(const kstd::string& name, size_t entry_point, bool kernel, ProcessArgs* args, pid_t parent);
 	Process(Process* to_fork, Registers& regs);
 
+	//Sockets
+	ResultRet<kstd::shared_ptr<LocalSocket>> socket_for_fd(int fd);
+	int add_socket_fd(const kstd::shared_ptr<LocalSocket>& socket, int flags);
+	ResultRet<kstd::string> socket_path(const struct sockaddr* addr, socklen_t addrlen);
+
 	//Identifying info and state
 	kstd::string _name = "";
 	kstd::string _exe = "";
@@ -75,6 +75,7 @@ size_t PTYControllerDevice::putchars(const uint8_t* buffer, size_t count) {
 	count = min(count, _output_buffer.capacity());
 	size_t count_loop = count;
 	while(count_loop--) _output_buffer.push_back(*(buffer++));
+	watchers().notify();
 	return count;
 }
 
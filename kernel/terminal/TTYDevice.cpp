@@ -110,6 +110,7 @@ void TTYDevice::emit(uint8_t c) {
 			_input_buffer.push_back('\0');
 			_lines++;
 			_buffer_blocker.set_ready(true);
+			watchers().notify();
 			return;
 		}
 		if(c == '\n' || c == _termios.c_cc[VEOL]) {
@@ -135,6 +136,7 @@ void TTYDevice::emit(uint8_t c) {
 
 	_input_buffer.push_back(c);
 	echo(c);
+	watchers().notify();
 }
 
 bool TTYDevice::can_read(const FileDescriptor& fd) {
@@ -41,6 +41,15 @@ __DECL_BEGIN
 #define O_EXEC		0x400000
 #define O_SEARCH	O_EXEC
 
+#define F_GETFD		1
+#define F_SETFD		2
+#define F_GETFL		3
+#define F_SETFL		4
+#define F_SETPIPE_SZ	1031
+#define F_GETPIPE_SZ	1032
+
+#define FD_CLOEXEC	1
+
 #define S_IXOTH		0000001
 #define S_IWOTH		0000002
 #define S_IROTH		0000004
@@ -62,9 +71,14 @@ __DECL_BEGIN
 #define S_IFSOCK	0140000
 #define S_IFMT		0170000
 
+#define SPLICE_F_MOVE		0x1
+#define SPLICE_F_NONBLOCK	0x2
+#define SPLICE_F_MORE		0x4
+
 int open(const char* pathname, int flags, ...);
 int openat(int dirfd, const char* pathname, int flags);
 int fcntl(int fd, int cmd, ...);
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags);
 
 __DECL_END
 
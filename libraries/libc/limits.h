@@ -48,6 +48,7 @@
 #define ULONG_LONG_MAX	18446744073709551615ULL
 
 #define ARG_MAX 65536
+#define PIPE_BUF 4096
 
 #ifndef PAGE_SIZE
 #define PAGE_SIZE 4096
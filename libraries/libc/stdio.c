@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <sys/syscall.h>
 #include <fcntl.h>
 #include <stdbool.h>
@@ -145,16 +146,47 @@ int fclose(FILE* stream) {
 	return !flush_result && !close_result ? 0 : -1;
 }
 
+//Writes out the data in the buffer followed by len bytes of data with as few syscalls as possible, and empties the buffer
+static ssize_t write_buffer(FILE* stream, const void* data, size_t len) {
+	struct iovec iov[2] = {
+		{stream->buffer, stream->offset},
+		{(void*) data, len}
+	};
+	struct iovec* cur_iov = iov;
+	int iovcnt = len ? 2 : 1;
+	size_t left = stream->offset + len;
+	stream->offset = 0;
+
+	while(left) {
+		ssize_t res = writev(stream->fd, cur_iov, iovcnt);
+		if(res <= 0) {
+			stream->err = res < 0 ? errno : EIO;
+			return -1;
+		}
+		left -= res;
+
+		//Skip past whatever was written
+		while(iovcnt && (size_t) res >= cur_iov->iov_len) {
+			res -= cur_iov->iov_len;
+			cur_iov++;
+			iovcnt--;
+		}
+		if(iovcnt) {
+			cur_iov->iov_base = (char*) cur_iov->iov_base + res;
+			cur_iov->iov_len -= res;
+		}
+	}
+
+	return len;
+}
+
 int fflush(FILE* stream) {
 	if(stream->bufmode == _IONBF)
 		return 0;
 
-	if(can_write(stream) && !stream->bufavail) {
-		//Flush the data written to the buffer
-		int res = write(stream->fd, stream->buffer, stream->offset);
-		if(res < 0)
-			stream->err = errno;
-	}
+	//Flush the data written to the buffer
+	if(can_write(stream) && !stream->bufavail)
+		write_buffer(stream, NULL, 0);
 
 	if(can_read(stream) && stream->bufavail) {
 		//Seek back to where we were in the read buffer so it's where the user expects
@@ -582,6 +614,14 @@ size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream) {
 		size_t bufleft = stream->bufsiz - stream->offset;
 		size_t nbuf = bufleft < len ? bufleft : len;
 
+		//If the rest won't fit in the buffer, write the buffer and the rest together instead of copying it through
+		if(!stream->bufavail && len > bufleft) {
+			if(write_buffer(stream, buf, len) < 0)
+				break;
+			nwrote += len;
+			break;
+		}
+
 		//If there's no space left in the buffer or we had previously used it for reading, flush
 		if(!nbuf || stream->bufavail) {
 			fflush(stream);
@@ -0,0 +1,44 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <errno.h>
+
+int epoll_create1(int flags) {
+	return syscall2(SYS_EPOLL_CREATE, flags);
+}
+
+int epoll_create(int size) {
+	if(size <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	return epoll_create1(0);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+	struct epoll_ctl_args args = {epfd, op, fd, event};
+	return syscall2(SYS_EPOLL_CTL, (int) &args);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout) {
+	struct epoll_wait_args args = {epfd, events, maxevents, timeout};
+	return syscall2(SYS_EPOLL_WAIT, (int) &args);
+}
@@ -0,0 +1,93 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBC_EPOLL_H
+#define DUCKOS_LIBC_EPOLL_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <fcntl.h>
+
+#define EPOLLIN 0x001
+#define EPOLLPRI 0x002
+#define EPOLLOUT 0x004
+#define EPOLLERR 0x008
+#define EPOLLHUP 0x010
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+__DECL_BEGIN
+
+typedef union epoll_data {
+	void* ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+	uint32_t events;
+	epoll_data_t data;
+} __attribute__((packed));
+
+/**
+ * Creates a new epoll instance, which keeps an interest list of file descriptors that can be waited on together.
+ * @param flags 0 or EPOLL_CLOEXEC.
+ * @return A file descriptor referring to the new epoll instance, or -1 if an error occurred.
+ */
+int epoll_create1(int flags);
+
+/**
+ * Creates a new epoll instance.
+ * @param size Ignored, but must be greater than zero.
+ * @return A file descriptor referring to the new epoll instance, or -1 if an error occurred.
+ */
+int epoll_create(int size);
+
+/**
+ * Adds, modifies, or removes a file descriptor in an epoll instance's interest list.
+ * @param epfd The epoll instance.
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD, or EPOLL_CTL_DEL.
+ * @param fd The file descriptor to add, modify, or remove.
+ * @param event The events to wait for (EPOLLIN and/or EPOLLOUT, plus EPOLLET or EPOLLONESHOT) and the data to report
+ *              with them. Ignored for EPOLL_CTL_DEL.
+ * @return 0 if successful, -1 if not.
+ */
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+
+/**
+ * Waits for file descriptors in an epoll instance's interest list to become ready.
+ * @param epfd The epoll instance.
+ * @param events Where the events for every ready file descriptor will be stored.
+ * @param maxevents The maximum number of events to store in events.
+ * @param timeout The maximum time to wait in milliseconds, 0 to return immediately, or -1 to wait forever.
+ * @return The number of events stored in events, or -1 if an error occurred.
+ */
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout);
+
+__DECL_END
+
+#endif //DUCKOS_LIBC_EPOLL_H
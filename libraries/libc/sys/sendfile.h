@@ -0,0 +1,42 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBC_SENDFILE_H
+#define DUCKOS_LIBC_SENDFILE_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+
+__DECL_BEGIN
+
+/**
+ * Copies data from one file descriptor to another inside of the kernel, without passing it through userspace.
+ * @param out_fd The file descriptor to write to.
+ * @param in_fd The file descriptor to read from. May not be a pipe.
+ * @param offset NULL to read from (and advance) in_fd's offset, or a pointer to the offset to read from, which will be
+ *               advanced instead while in_fd's offset is left alone.
+ * @param count The maximum number of bytes to copy.
+ * @return The number of bytes copied, or -1 if an error occurred.
+ */
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+__DECL_END
+
+#endif //DUCKOS_LIBC_SENDFILE_H
@@ -0,0 +1,84 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <errno.h>
+
+int socket(int domain, int type, int protocol) {
+	return syscall4(SYS_SOCKET, domain, type, protocol);
+}
+
+int socketpair(int domain, int type, int protocol, int sv[2]) {
+	struct socketpair_args args = {domain, type, protocol, sv};
+	return syscall2(SYS_SOCKETPAIR, (int) &args);
+}
+
+int bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen) {
+	return syscall4(SYS_BIND, sockfd, (int) addr, (int) addrlen);
+}
+
+int listen(int sockfd, int backlog) {
+	return syscall3(SYS_LISTEN, sockfd, backlog);
+}
+
+int accept(int sockfd, struct sockaddr* addr, socklen_t* addrlen) {
+	return accept4(sockfd, addr, addrlen, 0);
+}
+
+int accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags) {
+	if(addrlen)
+		*addrlen = 0;
+	return syscall3(SYS_ACCEPT, sockfd, flags);
+}
+
+int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen) {
+	return syscall4(SYS_CONNECT, sockfd, (int) addr, (int) addrlen);
+}
+
+ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags) {
+	return syscall4(SYS_SENDMSG, sockfd, (int) msg, flags);
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags) {
+	return syscall4(SYS_RECVMSG, sockfd, (int) msg, flags);
+}
+
+ssize_t send(int sockfd, const void* buf, size_t len, int flags) {
+	return sendto(sockfd, buf, len, flags, NULL, 0);
+}
+
+ssize_t recv(int sockfd, void* buf, size_t len, int flags) {
+	return recvfrom(sockfd, buf, len, flags, NULL, NULL);
+}
+
+ssize_t sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen) {
+	struct iovec iov = {(void*) buf, len};
+	struct msghdr msg = {(void*) dest_addr, addrlen, &iov, 1, NULL, 0, 0};
+	return sendmsg(sockfd, &msg, flags);
+}
+
+ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen) {
+	//Sockets that send datagrams don't have to be bound, so there's no source address to give back
+	if(addrlen)
+		*addrlen = 0;
+	struct iovec iov = {buf, len};
+	struct msghdr msg = {NULL, 0, &iov, 1, NULL, 0, 0};
+	return recvmsg(sockfd, &msg, flags);
+}
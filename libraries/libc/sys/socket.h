@@ -0,0 +1,190 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBC_SOCKET_H
+#define DUCKOS_LIBC_SOCKET_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <stdint.h>
+#include <fcntl.h>
+
+#define AF_UNSPEC 0
+#define AF_UNIX 1
+#define AF_LOCAL AF_UNIX
+#define PF_UNSPEC AF_UNSPEC
+#define PF_UNIX AF_UNIX
+#define PF_LOCAL AF_LOCAL
+
+#define SOCK_STREAM 1
+#define SOCK_DGRAM 2
+#define SOCK_NONBLOCK O_NONBLOCK
+#define SOCK_CLOEXEC O_CLOEXEC
+
+#define SOL_SOCKET 1
+#define SCM_RIGHTS 1
+#define SCM_SHM 0x100
+
+#define MSG_CTRUNC 0x08
+#define MSG_TRUNC 0x20
+#define MSG_DONTWAIT 0x40
+#define MSG_NOSIGNAL 0x4000
+
+#define SOMAXCONN 128
+
+__DECL_BEGIN
+
+typedef uint16_t sa_family_t;
+typedef uint32_t socklen_t;
+
+struct sockaddr {
+	sa_family_t sa_family;
+	char sa_data[14];
+};
+
+struct msghdr {
+	void* msg_name;
+	socklen_t msg_namelen;
+	struct iovec* msg_iov;
+	int msg_iovlen;
+	void* msg_control;
+	socklen_t msg_controllen;
+	int msg_flags;
+};
+
+struct cmsghdr {
+	socklen_t cmsg_len;
+	int cmsg_level;
+	int cmsg_type;
+};
+
+/**
+ * A shared memory region sent with SCM_SHM. The receiver is allowed to attach the region with the given permissions
+ * (SHM_READ, optionally with SHM_WRITE) when it receives the message, so there's no need to call shmallow() first.
+ * Only the creator of a region can send it; sendmsg() fails with EPERM otherwise.
+ */
+struct scm_shm {
+	int id;
+	int perms;
+};
+
+#define CMSG_ALIGN(len) (((len) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define CMSG_SPACE(len) (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(len))
+#define CMSG_LEN(len) (CMSG_ALIGN(sizeof(struct cmsghdr)) + (len))
+#define CMSG_DATA(cmsg) ((unsigned char*) (cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+#define CMSG_FIRSTHDR(msg) \
+	((msg)->msg_controllen >= sizeof(struct cmsghdr) ? (struct cmsghdr*) (msg)->msg_control : (struct cmsghdr*) NULL)
+#define CMSG_NXTHDR(msg, cmsg) \
+	(((unsigned char*) (cmsg) + CMSG_ALIGN((cmsg)->cmsg_len) + sizeof(struct cmsghdr) > \
+		(unsigned char*) (msg)->msg_control + (msg)->msg_controllen) \
+		? (struct cmsghdr*) NULL : (struct cmsghdr*) ((unsigned char*) (cmsg) + CMSG_ALIGN((cmsg)->cmsg_len)))
+
+/**
+ * Creates a new, unconnected socket.
+ * @param domain The address family of the socket. Only AF_UNIX is supported.
+ * @param type SOCK_STREAM or SOCK_DGRAM, optionally OR'd with SOCK_NONBLOCK and/or SOCK_CLOEXEC.
+ * @param protocol Must be 0.
+ * @return A file descriptor referring to the new socket, or -1 if an error occurred.
+ */
+int socket(int domain, int type, int protocol);
+
+/**
+ * Creates a pair of sockets that are connected to each other.
+ * @param domain The address family of the sockets. Only AF_UNIX is supported.
+ * @param type SOCK_STREAM or SOCK_DGRAM, optionally OR'd with SOCK_NONBLOCK and/or SOCK_CLOEXEC.
+ * @param protocol Must be 0.
+ * @param sv Where to put the file descriptors of the two sockets.
+ * @return 0 if successful, -1 if not.
+ */
+int socketpair(int domain, int type, int protocol, int sv[2]);
+
+/**
+ * Binds a socket to an address. For AF_UNIX sockets, this creates a socket file at the given path.
+ * @param sockfd The socket to bind.
+ * @param addr The address to bind to (a struct sockaddr_un).
+ * @param addrlen The size of addr.
+ * @return 0 if successful, -1 if not.
+ */
+int bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+
+/**
+ * Marks a bound stream socket as accepting connections.
+ * @param sockfd The socket to listen on.
+ * @param backlog The maximum number of connections waiting to be accepted (at most SOMAXCONN).
+ * @return 0 if successful, -1 if not.
+ */
+int listen(int sockfd, int backlog);
+
+/**
+ * Accepts a connection on a listening socket, blocking until there is one unless the socket is nonblocking.
+ * @param sockfd The listening socket.
+ * @param addr Ignored, since connecting sockets don't have an address.
+ * @param addrlen If not NULL, set to 0.
+ * @return A file descriptor referring to the connected socket, or -1 if an error occurred.
+ */
+int accept(int sockfd, struct sockaddr* addr, socklen_t* addrlen);
+
+/**
+ * Accepts a connection on a listening socket.
+ * @param sockfd The listening socket.
+ * @param addr Ignored, since connecting sockets don't have an address.
+ * @param addrlen If not NULL, set to 0.
+ * @param flags SOCK_NONBLOCK and/or SOCK_CLOEXEC, applied to the new file descriptor.
+ * @return A file descriptor referring to the connected socket, or -1 if an error occurred.
+ */
+int accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+
+/**
+ * Connects a socket to the socket bound at an address. For datagram sockets, this sets the default destination.
+ * @param sockfd The socket to connect.
+ * @param addr The address to connect to (a struct sockaddr_un).
+ * @param addrlen The size of addr.
+ * @return 0 if successful, -1 if not.
+ */
+int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+
+/**
+ * Sends a message on a socket, along with any file descriptors (SCM_RIGHTS) or shared memory regions (SCM_SHM) in
+ * its control messages.
+ * @param sockfd The socket to send on.
+ * @param msg The message to send.
+ * @param flags MSG_DONTWAIT and/or MSG_NOSIGNAL.
+ * @return The number of bytes sent, or -1 if an error occurred.
+ */
+ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags);
+
+/**
+ * Receives a message from a socket, along with any file descriptors or shared memory regions sent with it.
+ * @param sockfd The socket to receive from.
+ * @param msg Where to put the message. msg_flags is set to MSG_TRUNC if a datagram didn't fit, and MSG_CTRUNC if the
+ *            control messages didn't fit.
+ * @param flags MSG_DONTWAIT.
+ * @return The number of bytes received, 0 if the other end of a stream socket was closed, or -1 if an error occurred.
+ */
+ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags);
+
+ssize_t send(int sockfd, const void* buf, size_t len, int flags);
+ssize_t recv(int sockfd, void* buf, size_t len, int flags);
+ssize_t sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
+ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
+
+__DECL_END
+
+#endif //DUCKOS_LIBC_SOCKET_H
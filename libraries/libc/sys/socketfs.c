@@ -21,36 +21,87 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 struct socketfs_packet* read_packet(int fd) {
-	struct socketfs_packet packet_header;
-	ssize_t nread = read(fd, &packet_header, sizeof(struct socketfs_packet));
-	if(!nread || nread < 0)
+	struct socketfs_packet* packet = NULL;
+	size_t size = 0;
+	if(read_packet_into(fd, &packet, &size) <= 0) {
+		free(packet);
 		return NULL;
+	}
+	return packet;
+}
+
+ssize_t read_packet_into(int fd, struct socketfs_packet** buffer, size_t* size) {
+	//Make sure there's at least room for a header
+	if(!*buffer || *size < SOCKETFS_DEFAULT_READ_SIZE) {
+		struct socketfs_packet* new_buffer = realloc(*buffer, SOCKETFS_DEFAULT_READ_SIZE);
+		if(!new_buffer)
+			return -1;
+		*buffer = new_buffer;
+		*size = SOCKETFS_DEFAULT_READ_SIZE;
+	}
 
-	struct socketfs_packet* ret = malloc(sizeof(struct socketfs_packet) + packet_header.length);
-	ret->type = packet_header.type;
-	ret->sender = packet_header.sender;
-	ret->sender_pid = packet_header.sender_pid;
-	ret->length = packet_header.length;
+	//SocketFS never returns more than one packet per read, so most packets will be read all at once
+	ssize_t nread = read(fd, *buffer, *size);
+	if(nread <= 0)
+		return nread;
+	if((size_t) nread < sizeof(struct socketfs_packet)) {
+		errno = EIO;
+		return -1;
+	}
+
+	//If the packet didn't fit, grow the buffer and read the rest of it
+	size_t packet_size = sizeof(struct socketfs_packet) + (*buffer)->length;
+	if(packet_size > *size) {
+		struct socketfs_packet* new_buffer = realloc(*buffer, packet_size);
+		if(!new_buffer)
+			return -1;
+		*buffer = new_buffer;
+		*size = packet_size;
+	}
 
-	if(packet_header.length) {
-		if(read(fd, ret->data, packet_header.length) < 0) {
-			free(ret);
-			return NULL;
+	while((size_t) nread < packet_size) {
+		ssize_t res = read(fd, ((uint8_t*) *buffer) + nread, packet_size - nread);
+		if(res <= 0) {
+			if(!res)
+				errno = EIO;
+			return -1;
 		}
+		nread += res;
 	}
 
-	return ret;
+	return nread;
+}
+
+int set_packet_buffer_size(int fd, size_t size) {
+	return write_packet_of_type(fd, SOCKETFS_TYPE_SET_BUFFER_SIZE, SOCKETFS_RECIPIENT_HOST, sizeof(size_t), &size);
 }
 
 int write_packet_of_type(int fd, int type, sockid_t id, size_t length, void* data) {
-	struct socketfs_packet* packet = malloc(sizeof(struct socketfs_packet) + length);
-	packet->type = SOCKETFS_TYPE_MSG;
-	packet->recipient = id;
-	packet->length = length;
-	memcpy(packet->data, data, length);
-	int ret = write(fd, packet, length);
-	free(packet);
-	return ret;
-}
\ No newline at end of file
+	struct iovec iov = {data, length};
+	return writev_packet_of_type(fd, type, id, &iov, 1);
+}
+
+int writev_packet_of_type(int fd, int type, sockid_t id, const struct iovec* iov, int iovcnt) {
+	if(iovcnt < 0 || iovcnt >= IOV_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	//The packet header goes in front of the data, which is gathered straight from the caller's buffers
+	struct socketfs_packet packet;
+	packet.type = type;
+	packet.recipient = id;
+	packet.length = 0;
+	struct iovec packet_iov[iovcnt + 1];
+	packet_iov[0].iov_base = &packet;
+	packet_iov[0].iov_len = sizeof(struct socketfs_packet);
+	for(int i = 0; i < iovcnt; i++) {
+		packet_iov[i + 1] = iov[i];
+		packet.length += iov[i].iov_len;
+	}
+
+	return writev(fd, packet_iov, iovcnt + 1);
+}
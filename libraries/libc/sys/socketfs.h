@@ -21,6 +21,7 @@
 #define DUCKOS_LIBC_SOCKETFS_H
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <kernel/filesystem/socketfs/socketfs_defines.h>
 
 struct socketfs_packet {
@@ -46,14 +47,23 @@ struct socketfs_packet {
 
 __DECL_BEGIN
 
+#define SOCKETFS_DEFAULT_READ_SIZE 4096
+
 struct socketfs_packet* read_packet(int fd);
+ssize_t read_packet_into(int fd, struct socketfs_packet** buffer, size_t* size);
+int set_packet_buffer_size(int fd, size_t size);
 
 int write_packet_of_type(int fd, int type, sockid_t id, size_t length, void* data);
+int writev_packet_of_type(int fd, int type, sockid_t id, const struct iovec* iov, int iovcnt);
 
 inline int write_packet(int fd, sockid_t id, size_t length, void* data) {
 	return write_packet_of_type(fd, SOCKETFS_TYPE_MSG, id, length, data);
 }
 
+inline int writev_packet(int fd, sockid_t id, const struct iovec* iov, int iovcnt) {
+	return writev_packet_of_type(fd, SOCKETFS_TYPE_MSG, id, iov, iovcnt);
+}
+
 inline int write_packet_to_host(int fd, size_t length, void* data) {
 	return write_packet_of_type(fd, SOCKETFS_TYPE_MSG, SOCKETFS_RECIPIENT_HOST, length, data);
 }
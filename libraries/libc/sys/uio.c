@@ -0,0 +1,39 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include <sys/uio.h>
+#include <sys/syscall.h>
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt) {
+	return syscall4(SYS_READV, fd, (int) iov, iovcnt);
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
+	return syscall4(SYS_WRITEV, fd, (int) iov, iovcnt);
+}
+
+ssize_t preadv(int fd, const struct iovec* iov, int iovcnt, off_t offset) {
+	struct preadv_args args = {fd, iov, iovcnt, offset};
+	return syscall2(SYS_PREADV, (int) &args);
+}
+
+ssize_t pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset) {
+	struct preadv_args args = {fd, iov, iovcnt, offset};
+	return syscall2(SYS_PWRITEV, (int) &args);
+}
@@ -0,0 +1,65 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBC_UIO_H
+#define DUCKOS_LIBC_UIO_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__DECL_BEGIN
+
+#define IOV_MAX 1024
+
+struct iovec {
+	void* iov_base;
+	size_t iov_len;
+};
+
+/**
+ * Reads from a file descriptor into several buffers in turn, as if by a single read().
+ * @param fd The file descriptor to read from.
+ * @param iov The buffers to read into.
+ * @param iovcnt The number of buffers in iov.
+ * @return The number of bytes read, or -1 if an error occurred.
+ */
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+
+/**
+ * Writes several buffers to a file descriptor in turn, as if by a single write().
+ * @param fd The file descriptor to write to.
+ * @param iov The buffers to write.
+ * @param iovcnt The number of buffers in iov.
+ * @return The number of bytes written, or -1 if an error occurred.
+ */
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+
+/**
+ * Like readv(), but reads from the given offset without using or changing the file descriptor's offset.
+ */
+ssize_t preadv(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+
+/**
+ * Like writev(), but writes at the given offset without using or changing the file descriptor's offset.
+ */
+ssize_t pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+
+__DECL_END
+
+#endif //DUCKOS_LIBC_UIO_H
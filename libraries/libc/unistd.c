@@ -118,7 +118,8 @@ ssize_t read(int fd, void* buf, size_t count) {
 }
 
 ssize_t pread(int fd, void* buf, size_t count, off_t offset) {
-	return -1;
+	struct pread_args args = {fd, buf, count, offset};
+	return syscall2(SYS_PREAD, (int) &args);
 }
 
 ssize_t write(int fd, const void* buf, size_t count) {
@@ -126,7 +127,8 @@ ssize_t write(int fd, const void* buf, size_t count) {
 }
 
 ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) {
-	return -1;
+	struct pread_args args = {fd, (void*) buf, count, offset};
+	return syscall2(SYS_PWRITE, (int) &args);
 }
 
 off_t lseek(int fd, off_t off, int whence) {
@@ -228,6 +228,32 @@ public:
 		};
 	}
 
+	/**
+	 * Splits the part of this rect not covered by another rect into up to four rects that don't overlap.
+	 * @param other The rect to cut out of this one.
+	 * @param out The array to put the remaining rects in.
+	 * @return The number of rects put in out.
+	 */
+	int subtract(const Rect& other, Rect out[4]) const {
+		if(!collides(other)) {
+			out[0] = *this;
+			return 1;
+		}
+
+		//The pieces above and below the overlap span the whole width, and the ones to the sides fill in between
+		Rect overlap = overlapping_area(other);
+		int num_rects = 0;
+		if(overlap.y > y)
+			out[num_rects++] = {x, y, width, overlap.y - y};
+		if(overlap.y + overlap.height < y + height)
+			out[num_rects++] = {x, overlap.y + overlap.height, width, y + height - overlap.y - overlap.height};
+		if(overlap.x > x)
+			out[num_rects++] = {x, overlap.y, overlap.x - x, overlap.height};
+		if(overlap.x + overlap.width < x + width)
+			out[num_rects++] = {overlap.x + overlap.width, overlap.y, x + width - overlap.x - overlap.width, overlap.height};
+		return num_rects;
+	}
+
 	/**
 	 * Returns true if the rect has an area of zero.
 	 */
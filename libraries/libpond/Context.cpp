@@ -38,6 +38,9 @@ auto __msgres_##name = endpoint->set_message_handler<pkt_type>(#name, [&] (pkt_t
 if(__msgres_##name.is_error()) \
 	fprintf(stderr, "libpond: Couldn't set event handler for event %s: %s\n", #name, River::error_str(__msgres_##name.code()));
 
+#define PREFETCH_MSG(name, pkt_type) endpoint->prefetch_message_handler<pkt_type>(#name)
+#define PREFETCH_FUNC(name, ret_type, data_type) endpoint->prefetch_function<ret_type, data_type>(#name)
+
 #define GET_FUNC(name, ret_type, data_type, handler) \
 auto __funcres_##name = endpoint->get_function<ret_type, data_type>(#name); \
 if(__funcres_##name.is_error()) \
@@ -53,6 +56,10 @@ Context* Context::init() {
 	}
 	auto connection = conn_res.value();
 
+	//Input events and window calls are frequent, so send them through shared memory. The socket still works otherwise.
+	if(connection->open_ring().is_error())
+		fprintf(stderr, "libpond: Couldn't open shared memory ring, falling back to the socket\n");
+
 	auto endpoint_res = connection->get_endpoint("pond_server");
 	if(endpoint_res.is_error()) {
 		fprintf(stderr, "libpond: Couldn't get endpoint: %s\n", River::error_str(conn_res.code()));
@@ -64,6 +71,32 @@ Context* Context::init() {
 }
 
 Context::Context(std::shared_ptr<Endpoint> endpt): endpoint(std::move(endpt)) {
+	//Send every lookup at once, so that startup waits for one round trip instead of one for each
+	endpoint->bus()->begin_batch();
+	PREFETCH_MSG(window_moved, WindowMovePkt);
+	PREFETCH_MSG(window_resized, WindowResizedPkt);
+	PREFETCH_MSG(window_destroyed, WindowDestroyPkt);
+	PREFETCH_MSG(mouse_moved, MouseMovePkt);
+	PREFETCH_MSG(mouse_button, MouseButtonPkt);
+	PREFETCH_MSG(mouse_scrolled, MouseScrollPkt);
+	PREFETCH_MSG(mouse_left, MouseLeavePkt);
+	PREFETCH_MSG(key_event, KeyEventPkt);
+	PREFETCH_MSG(window_frame, WindowFramePkt);
+
+	PREFETCH_FUNC(open_window, WindowOpenedPkt, OpenWindowPkt);
+	PREFETCH_FUNC(destroy_window, void, WindowDestroyPkt);
+	PREFETCH_FUNC(move_window, void, WindowMovePkt);
+	PREFETCH_FUNC(resize_window, WindowResizedPkt, WindowResizePkt);
+	PREFETCH_FUNC(damage_window, void, WindowDamagePkt);
+	PREFETCH_FUNC(request_frame, void, RequestFramePkt);
+	PREFETCH_FUNC(get_font, FontResponsePkt, GetFontPkt);
+	PREFETCH_FUNC(set_title, void, SetTitlePkt);
+	PREFETCH_FUNC(reparent, void, WindowReparentPkt);
+	PREFETCH_FUNC(set_hint, void, SetHintPkt);
+	PREFETCH_FUNC(window_to_front, void, WindowToFrontPkt);
+	PREFETCH_FUNC(get_display_info, DisplayInfoPkt, GetDisplayInfoPkt);
+	endpoint->bus()->end_batch();
+
 	MSG_HANDLER(window_moved, WindowMovePkt, PEVENT_WINDOW_MOVE);
 	MSG_HANDLER(window_resized, WindowResizedPkt, PEVENT_WINDOW_RESIZE);
 	MSG_HANDLER(window_destroyed, WindowDestroyPkt, PEVENT_WINDOW_DESTROY);
@@ -72,12 +105,14 @@ Context::Context(std::shared_ptr<Endpoint> endpt): endpoint(std::move(endpt)) {
 	MSG_HANDLER(mouse_scrolled, MouseScrollPkt, PEVENT_MOUSE_SCROLL);
 	MSG_HANDLER(mouse_left, MouseLeavePkt, PEVENT_MOUSE_LEAVE);
 	MSG_HANDLER(key_event, KeyEventPkt, PEVENT_KEY);
+	MSG_HANDLER(window_frame, WindowFramePkt, PEVENT_WINDOW_FRAME);
 
 	GET_FUNC(open_window, WindowOpenedPkt, OpenWindowPkt, open_window);
 	GET_FUNC(destroy_window, void, WindowDestroyPkt, destroy_window);
 	GET_FUNC(move_window, void, WindowMovePkt, move_window);
 	GET_FUNC(resize_window, WindowResizedPkt, WindowResizePkt, resize_window);
-	GET_FUNC(invalidate_window, void, WindowInvalidatePkt, invalidate_window);
+	GET_FUNC(damage_window, void, WindowDamagePkt, damage_window);
+	GET_FUNC(request_frame, void, RequestFramePkt, request_frame);
 	GET_FUNC(get_font, FontResponsePkt, GetFontPkt, get_font);
 	GET_FUNC(set_title, void, SetTitlePkt, set_title);
 	GET_FUNC(reparent, void, WindowReparentPkt, reparent);
@@ -86,8 +121,9 @@ Context::Context(std::shared_ptr<Endpoint> endpt): endpoint(std::move(endpt)) {
 	GET_FUNC(get_display_info, DisplayInfoPkt, GetDisplayInfoPkt, get_display_info);
 }
 
-void Context::read_events(bool block) {
+bool Context::read_events(bool block) {
 	endpoint->bus()->read_and_handle_packets(block);
+	return endpoint->bus()->connected();
 }
 
 bool Context::has_event() {
@@ -124,8 +160,8 @@ Event Context::next_event(int type) {
 	}
 }
 
-Window* Context::create_window(Window* parent, Rect rect, bool hidden) {
-	auto resp = __river_open_window(OpenWindowPkt {parent ? parent->id() : 0, hidden, rect});
+Window* Context::create_window(Window* parent, Rect rect, bool hidden, int buffers) {
+	auto resp = __river_open_window(OpenWindowPkt {parent ? parent->id() : 0, hidden, rect, buffers});
 	Event evt;
 	handle_window_opened(resp, evt);
 	return evt.window_create.window;
@@ -136,7 +172,16 @@ Font* Context::get_font(const char* font) {
 	if(fonts[font])
 		return fonts[font];
 
-	auto resp = __river_get_font({font});
+	//If it was prefetched, wait for that response instead of asking again
+	FontResponsePkt resp;
+	auto request = font_requests.find(font);
+	if(request != font_requests.end()) {
+		resp = request->second.get();
+		font_requests.erase(request);
+	} else {
+		resp = __river_get_font({font});
+	}
+
 	Event event = {PEVENT_FONT_RESPONSE};
 	handle_font_response(resp, event);
 
@@ -145,6 +190,21 @@ Font* Context::get_font(const char* font) {
 	return event.font_response.font;
 }
 
+void Context::commit() {
+	endpoint->bus()->begin_batch();
+	for(auto& window : windows) {
+		if(window.second)
+			window.second->commit();
+	}
+	endpoint->bus()->end_batch();
+}
+
+void Context::prefetch_font(const char* font) {
+	if(fonts[font] || font_requests.find(font) != font_requests.end())
+		return;
+	font_requests[font] = __river_get_font.async({font});
+}
+
 int Context::connection_fd() {
 	return endpoint->bus()->file_descriptor();
 }
@@ -164,7 +224,7 @@ void Context::handle_window_opened(const WindowOpenedPkt& pkt, Event& event) {
 	}
 
 	//Allocate the new window object and put it in the PEvent
-	auto* window = new Window(pkt.window_id, pkt.rect, shm, this);
+	auto* window = new Window(pkt.window_id, pkt.rect, shm, pkt.buffers, this);
 	event.window_create.window = window;
 
 	//Add the window to the map
@@ -180,6 +240,8 @@ void Context::handle_window_destroyed(const WindowDestroyPkt& pkt, Event& event)
 		//Detach the window's shared memory
 		if(shmdetach(pkt.shm_id) < 0)
 			fprintf(stderr, "libpond: WARNING - could not detach destroyed window shm\n");
+		//Don't keep waiting on a frame that will never be shown
+		window_pair->second->_pending_buffer = -1;
 		windows.erase(window_pair);
 	} else
 		fprintf(stderr, "libpond: Failed to find window with id %d in map for removal\n", pkt.window_id);
@@ -216,7 +278,7 @@ void Context::handle_window_resized(const WindowResizedPkt& pkt, Event& event) {
 				event.window_create.window = NULL;
 				return;
 			}
-			window->_framebuffer = {(uint32_t*) shm.ptr, window->_rect.width, window->_rect.height};
+			window->attach_buffers((uint32_t*) shm.ptr, pkt.buffers);
 		}
 	} else {
 		event.type = PEVENT_UNKNOWN;
@@ -313,3 +375,17 @@ void Context::handle_font_response(const FontResponsePkt& pkt, Event& event) {
 Dimensions Context::get_display_dimensions() {
 	return __river_get_display_info({}).dimensions;
 }
+
+void Context::handle_window_frame(const WindowFramePkt& pkt, Event& event) {
+	//Find the window and update the event & window
+	Window* window = windows[pkt.window_id];
+	if(window) {
+		event.window_frame.window = window;
+		window->_front_buffer = pkt.buffer;
+		if(window->_pending_buffer == pkt.buffer)
+			window->_pending_buffer = -1;
+	} else {
+		event.type = PEVENT_UNKNOWN;
+		fprintf(stderr, "libpond: Could not find window for window frame event!\n");
+	}
+}
@@ -67,9 +67,11 @@ namespace Pond {
 		 * @param parent NULL, or the parent window.
 		 * @param rect The rect defining the window.
 		 * @param hidden Whether the window should be hidden.
+		 * @param buffers The number of buffers the window should have, up to POND_MAX_WINDOW_BUFFERS. With more than one,
+		 *                drawing happens in a back buffer that the compositor swaps to when the window is committed.
 		 * @return A PWindow object or NULL if the creation failed.
 		 */
-		Window* create_window(Window* parent, Rect rect, bool hidden);
+		Window* create_window(Window* parent, Rect rect, bool hidden, int buffers = 1);
 
 		/**
 		 * Gets a font from the Pond server.
@@ -78,6 +80,17 @@ namespace Pond {
 		 */
 		Gfx::Font* get_font(const char* font);
 
+		/**
+		 * Commits the damage to every window (see Window::commit()), sending all of it to the compositor at once.
+		 */
+		void commit();
+
+		/**
+		 * Requests a font from the Pond server without waiting for it, so it's ready by the time ::get_font() is called.
+		 * @param font The name of the font to get.
+		 */
+		void prefetch_font(const char* font);
+
 		/**
 		 * Returns the file descriptor for the socket used to listen for events. This can be used to wait on
 		 * events from pond as well as other file descriptors with select(), poll(), or similar.
@@ -95,7 +108,7 @@ namespace Pond {
 		friend class Window;
 		explicit Context(std::shared_ptr<River::Endpoint> endpoint);
 
-		void read_events(bool block);
+		bool read_events(bool block);
 
 		void handle_window_opened(const WindowOpenedPkt& pkt, Event& event);
 		void handle_window_destroyed(const WindowDestroyPkt& pkt, Event& event);
@@ -107,10 +120,12 @@ namespace Pond {
 		void handle_mouse_left(const MouseLeavePkt& pkt, Event& event);
 		void handle_key_event(const KeyEventPkt& pkt, Event& event);
 		void handle_font_response(const FontResponsePkt& pkt, Event& event);
+		void handle_window_frame(const WindowFramePkt& pkt, Event& event);
 
 		std::shared_ptr<River::Endpoint> endpoint;
 		std::map<int, Window*> windows;
 		std::map<std::string, Gfx::Font*> fonts;
+		std::map<std::string, River::Future<FontResponsePkt>> font_requests;
 		std::deque<Event> events;
 
 #define PONDFUNC(name, ret_t, data_t) River::Function<ret_t, data_t> __river_##name = {#name}
@@ -118,7 +133,8 @@ namespace Pond {
 		PONDFUNC(destroy_window, void, WindowDestroyPkt);
 		PONDFUNC(move_window, void, WindowMovePkt);
 		PONDFUNC(resize_window, WindowResizedPkt, WindowResizePkt);
-		PONDFUNC(invalidate_window, void, WindowInvalidatePkt);
+		PONDFUNC(damage_window, void, WindowDamagePkt);
+		PONDFUNC(request_frame, void, RequestFramePkt);
 		PONDFUNC(get_font, FontResponsePkt, GetFontPkt);
 		PONDFUNC(set_title, void, SetTitlePkt);
 		PONDFUNC(reparent, void, WindowReparentPkt);
@@ -35,6 +35,7 @@
 #define PEVENT_MOUSE_BUTTON 8
 #define PEVENT_MOUSE_LEAVE 9
 #define PEVENT_MOUSE_SCROLL 10
+#define PEVENT_WINDOW_FRAME 11
 
 #define POND_MOUSE1 1
 #define POND_MOUSE2 2
@@ -103,6 +104,15 @@ namespace Pond {
 		Window* window; ///< The window the event was triggered on
 	};
 
+	/**
+	 * An event triggered when a frame is shown on the screen, if the window requested one with Window::request_frame()
+	 * or committed a frame with more than one buffer.
+	 */
+	struct WindowFrameEvent {
+		int type; ///< Equal to PEVENT_WINDOW_FRAME
+		Window* window; ///< The window the frame was shown for
+	};
+
 	struct FontResponseEvent {
 		int type; ///< Equal to PEVENT_FONT_RESPONSE
 		Gfx::Font* font;
@@ -120,6 +130,7 @@ namespace Pond {
 		MouseLeaveEvent mouse_leave;
 		KeyEvent key;
 		FontResponseEvent font_response;
+		WindowFrameEvent window_frame;
 	};
 }
 #endif //DUCKOS_LIBPOND_EVENT_H
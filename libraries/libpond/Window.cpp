@@ -24,8 +24,36 @@
 using namespace Pond;
 using namespace Gfx;
 
-Window::Window(int id, Rect rect, struct shm shm, Context* ctx): _id(id), _rect(rect), _context(ctx), _shm_id(shm.id) {
-	_framebuffer = {(uint32_t*) shm.ptr, rect.width, rect.height};
+//Merges an area into a list of damage, so the list stays small
+static void add_damage(std::vector<Rect>& damage, Rect area) {
+	//Growing the area can make it collide with rects that were already passed over, so go until nothing merges
+	bool merged = true;
+	while(merged) {
+		merged = false;
+		for(auto it = damage.begin(); it != damage.end();) {
+			if(it->collides(area)) {
+				area = area.combine(*it);
+				it = damage.erase(it);
+				merged = true;
+			} else {
+				it++;
+			}
+		}
+	}
+	damage.push_back(area);
+
+	//If there's too much damage to send in one go, just send the area around all of it
+	if(damage.size() > POND_MAX_DAMAGE_RECTS) {
+		Rect bounds = damage[0];
+		for(auto& rect : damage)
+			bounds = bounds.combine(rect);
+		damage.clear();
+		damage.push_back(bounds);
+	}
+}
+
+Window::Window(int id, Rect rect, struct shm shm, int buffers, Context* ctx): _id(id), _rect(rect), _context(ctx), _shm_id(shm.id) {
+	attach_buffers((uint32_t*) shm.ptr, buffers);
 }
 
 Window::~Window() = default;
@@ -35,11 +63,92 @@ void Window::destroy() {
 }
 
 void Window::invalidate() {
-	_context->__river_invalidate_window({_id, {-1, -1, -1, -1}});
+	damage({-1, -1, -1, -1});
+	commit();
 }
 
 void Window::invalidate_area(Rect area) {
-	_context->__river_invalidate_window({_id, area});
+	damage(area);
+	commit();
+}
+
+void Window::damage(Rect area) {
+	Rect window_rect = {0, 0, _rect.width, _rect.height};
+	if(area.x < 0 || area.y < 0)
+		area = window_rect;
+	else
+		area = area.overlapping_area(window_rect);
+	if(area.empty())
+		return;
+	add_damage(_damage, area);
+}
+
+void Window::commit() {
+	//If the window went away while waiting for a frame, there's nothing left to commit to
+	if(!_damage.empty() && !send_damage())
+		return;
+	if(_frame_requested) {
+		_frame_requested = false;
+		_context->__river_request_frame({_id});
+	}
+}
+
+void Window::request_frame() {
+	_frame_requested = true;
+}
+
+bool Window::send_damage() {
+	//Only one frame can be waiting on the compositor at a time
+	if(_num_buffers > 1 && !wait_for_frame())
+		return false;
+
+	WindowDamagePkt pkt;
+	pkt.window_id = _id;
+	pkt.buffer = _num_buffers > 1 ? _back_buffer : -1;
+	pkt.num_rects = _damage.size();
+	for(size_t i = 0; i < _damage.size(); i++)
+		pkt.rects[i] = _damage[i];
+
+	if(_num_buffers == 1) {
+		_damage.clear();
+		_context->__river_damage_window(pkt);
+		return true;
+	}
+
+	//Every other buffer is now missing what was drawn in this frame
+	for(int i = 0; i < _num_buffers; i++) {
+		if(i == _back_buffer)
+			continue;
+		for(auto& rect : _damage)
+			add_damage(_stale[i], rect);
+	}
+	_damage.clear();
+	_pending_buffer = _back_buffer;
+	_context->__river_damage_window(pkt);
+
+	//Find a buffer the compositor isn't using to draw the next frame into. With two, this frame has to be shown first
+	int next_buffer = -1;
+	for(int i = 0; i < _num_buffers && next_buffer == -1; i++) {
+		if(i != _front_buffer && i != _pending_buffer)
+			next_buffer = i;
+	}
+	if(next_buffer == -1) {
+		if(!wait_for_frame())
+			return false;
+		for(int i = 0; i < _num_buffers && next_buffer == -1; i++) {
+			if(i != _front_buffer)
+				next_buffer = i;
+		}
+	}
+
+	//Bring the new back buffer up to date with the frame just committed
+	auto latest = buffer(pkt.buffer);
+	_back_buffer = next_buffer;
+	_framebuffer = buffer(_back_buffer);
+	for(auto& rect : _stale[_back_buffer])
+		_framebuffer.copy(latest, rect, rect.position());
+	_stale[_back_buffer].clear();
+	return true;
 }
 
 void Window::resize(Dimensions dims) {
@@ -117,6 +226,10 @@ Framebuffer Window::framebuffer() const {
 	return _framebuffer;
 }
 
+int Window::num_buffers() const {
+	return _num_buffers;
+}
+
 unsigned int Window::mouse_buttons() const {
 	return _mouse_buttons;
 }
@@ -124,3 +237,30 @@ unsigned int Window::mouse_buttons() const {
 Point Window::mouse_pos() const {
 	return _mouse_pos;
 }
+
+void Window::attach_buffers(uint32_t* data, int num_buffers) {
+	_buffers = data;
+	_num_buffers = num_buffers < 1 ? 1 : num_buffers;
+	_front_buffer = 0;
+	_pending_buffer = -1;
+	_back_buffer = _num_buffers > 1 ? 1 : 0;
+	for(auto& stale : _stale)
+		stale.clear();
+	_framebuffer = buffer(_back_buffer);
+}
+
+Framebuffer Window::buffer(int index) const {
+	return {_buffers + (size_t) index * _rect.width * _rect.height, _rect.width, _rect.height};
+}
+
+bool Window::wait_for_frame() {
+	//If the connection to Pond is gone, the frame is never coming
+	while(_pending_buffer != -1) {
+		if(!_context->read_events(true))
+			return false;
+	}
+
+	//If the window was destroyed while we were waiting, its buffers aren't mapped anymore
+	auto window = _context->windows.find(_id);
+	return window != _context->windows.end() && window->second == this;
+}
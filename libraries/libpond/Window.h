@@ -23,8 +23,10 @@
 #include <sys/types.h>
 #include <libgraphics/graphics.h>
 #include "Context.h"
+#include "packet.h"
 #include <libgraphics/Image.h>
 #include <sys/mem.h>
+#include <vector>
 
 #define PWINDOW_HINT_GLOBALMOUSE 0x1
 #define PWINDOW_HINT_DRAGGABLE 0x2
@@ -49,16 +51,40 @@ namespace Pond {
 
 		/**
 		 * Tells the compositor to redraw the entire window.
+		 * This commits any other damage to the window as well.
 		 */
 		void invalidate();
 
 		/**
 		 * Tells the compositor to redraw a portion of a window.
 		 * If given a position with negative coordinates, the entire window will be redrawn.
+		 * This commits any other damage to the window as well.
 		 * @param area The area to invalidate.
 		 */
 		void invalidate_area(Rect area);
 
+		/**
+		 * Marks a portion of the window as needing to be redrawn by the compositor the next time the window is committed.
+		 * If given a position with negative coordinates, the entire window will be redrawn.
+		 * @param area The area to mark as damaged.
+		 */
+		void damage(Rect area);
+
+		/**
+		 * Sends all of the damage to the window since it was last committed to the compositor in one go.
+		 * If the window has more than one buffer, this presents the back buffer and switches framebuffer() to the next
+		 * one. Only one frame can be waiting to be shown at a time, so this may wait for the compositor to show the
+		 * previous one first (with two buffers, it always waits for this one).
+		 */
+		void commit();
+
+		/**
+		 * Asks the compositor for a PEVENT_WINDOW_FRAME event once the next frame is on the screen, which is a good
+		 * time to draw the one after it. The request is sent with the next commit(), so that the frame it waits for
+		 * includes everything drawn before then.
+		 */
+		void request_frame();
+
 		/**
 		 * Resizes a window.
 		 * @param dims The new dimensions of the window.
@@ -157,11 +183,18 @@ namespace Pond {
 		int id() const;
 
 		/**
-		 * Gets the window's framebuffer.
+		 * Gets the window's framebuffer. If the window has more than one buffer, this is the back buffer to draw the
+		 * next frame into, and it changes every time the window is committed.
 		 * @return The framebuffer of the window.
 		 */
 		Gfx::Framebuffer framebuffer() const;
 
+		/**
+		 * Gets the number of buffers the window's framebuffer has.
+		 * @return The number of buffers the window has.
+		 */
+		int num_buffers() const;
+
 		/**
 		 * Gets the current mouse buttons of the window.
 		 * @return The current mouse buttons of the window.
@@ -177,7 +210,30 @@ namespace Pond {
 	private:
 		friend class Context;
 
-		Window(int id, Rect rect, struct shm shm, Context* ctx);
+		Window(int id, Rect rect, struct shm shm, int buffers, Context* ctx);
+
+		/**
+		 * Uses the given memory as the window's buffers, resetting which one is being drawn into.
+		 */
+		void attach_buffers(uint32_t* data, int num_buffers);
+
+		/**
+		 * Gets one of the window's buffers.
+		 */
+		Gfx::Framebuffer buffer(int index) const;
+
+		/**
+		 * Waits until the frame last committed is shown on the screen.
+		 * @return False if the window was destroyed in the meantime, in which case its buffers can't be used, or if the
+		 *         connection to Pond was lost.
+		 */
+		bool wait_for_frame();
+
+		/**
+		 * Sends the damage to the window, presenting the back buffer if there's more than one.
+		 * @return False if waiting for a frame failed (see wait_for_frame()), in which case the window can't be used.
+		 */
+		bool send_damage();
 
 		int _id = -1; ///< The ID of the window.
 		Rect _rect; ///< The rect of the window.
@@ -185,8 +241,16 @@ namespace Pond {
 		Point _mouse_pos = {-1, -1}; ///< The position of the mouse inside the window.
 		unsigned int _mouse_buttons = 0; ///< A bitfield containing the last-known pressed mouse buttons inside the window.
 		bool _hidden = true; ///< Whether or not the window is hidden.
-		Gfx::Framebuffer _framebuffer; ///< The window's framebuffer.
+		Gfx::Framebuffer _framebuffer; ///< The window's framebuffer (the back buffer, if there's more than one).
+		uint32_t* _buffers = nullptr; ///< The start of the window's buffers.
+		int _num_buffers = 1; ///< The number of buffers the window has.
+		int _front_buffer = 0; ///< The buffer the compositor is showing.
+		int _back_buffer = 0; ///< The buffer being drawn into.
+		int _pending_buffer = -1; ///< The buffer committed to the compositor but not shown yet, or -1 if there isn't one.
+		std::vector<Rect> _stale[POND_MAX_WINDOW_BUFFERS]; ///< The areas of each buffer that are older than the last frame committed.
 		Context* _context = nullptr; ///< The context associated with the window.
+		std::vector<Rect> _damage; ///< The areas of the window damaged since the last commit.
+		bool _frame_requested = false; ///< Whether a frame event should be requested on the next commit.
 	};
 }
 
@@ -21,20 +21,26 @@
 #define DUCKOS_LIBPOND_PACKET_H
 
 #include <cstdint>
+#include <cstddef>
 #include <libgraphics/geometry.h>
 #include <libriver/SerializedString.hpp>
 
+#define POND_MAX_DAMAGE_RECTS 32
+#define POND_MAX_WINDOW_BUFFERS 3
+
 namespace Pond {
 	struct OpenWindowPkt {
 		int parent;
 		bool hidden;
 		Rect rect;
+		int buffers;
 	};
 
 	struct WindowOpenedPkt {
 		int window_id;
 		int shm_id;
 		Rect rect;
+		int buffers;
 	};
 
 	struct WindowDestroyPkt {
@@ -56,11 +62,29 @@ namespace Pond {
 		int window_id;
 		int shm_id;
 		Rect rect;
+		int buffers;
+	};
+
+	struct WindowDamagePkt {
+		int window_id;
+		int buffer; ///< The buffer to present, or -1 to keep presenting the current one
+		int num_rects;
+		Rect rects[POND_MAX_DAMAGE_RECTS];
+
+		//Only the rects in use are sent (see River::has_serialized_size)
+		size_t serialized_size() const {
+			size_t used = num_rects > 0 && num_rects <= POND_MAX_DAMAGE_RECTS ? num_rects : 0;
+			return offsetof(WindowDamagePkt, rects) + used * sizeof(Rect);
+		}
+	};
+
+	struct WindowFramePkt {
+		int window_id;
+		int buffer; ///< The buffer being presented
 	};
 
-	struct WindowInvalidatePkt {
+	struct RequestFramePkt {
 		int window_id;
-		Rect area;
 	};
 
 	struct MouseMovePkt {
@@ -66,8 +66,8 @@ ResultRet<std::shared_ptr<Endpoint>> BusConnection::register_endpoint(const std:
 		fprintf(stderr, "[River] Error registering endpoint %s: %s\n", name.c_str(), error_str(packet.error));
 		return Result(packet.error);
 	}
-	auto ret = std::make_shared<Endpoint>(shared_from_this(), name, Endpoint::HOST);
-	_endpoints[name] = ret;
+	auto ret = std::make_shared<Endpoint>(shared_from_this(), name, Endpoint::HOST, packet.endpoint_id);
+	add_endpoint(ret);
 	return ret;
 }
 
@@ -80,21 +80,126 @@ ResultRet<std::shared_ptr<Endpoint>> BusConnection::get_endpoint(const std::stri
 		fprintf(stderr, "[River] Error getting endpoint %s: %s\n", name.c_str(), error_str(packet.error));
 		return Result(packet.error);
 	}
-	auto ret = std::make_shared<Endpoint>(shared_from_this(), name, Endpoint::PROXY);
-	_endpoints[name] = ret;
+	auto ret = std::make_shared<Endpoint>(shared_from_this(), name, Endpoint::PROXY, packet.endpoint_id);
+	add_endpoint(ret);
 	return ret;
 }
 
+Result BusConnection::open_ring(size_t capacity) {
+	if(_send_ring)
+		return Result(SUCCESS);
+
+	RiverPacket request {OPEN_RING};
+	uint32_t requested_capacity = capacity;
+	request.data.resize(sizeof(uint32_t));
+	memcpy(request.data.data(), &requested_capacity, sizeof(uint32_t));
+	send_packet(request);
+
+	auto packet = await_packet(OPEN_RING);
+	if(packet.error || packet.data.size() != sizeof(RingInfo)) {
+		fprintf(stderr, "[River] Error opening shared memory ring: %s\n", error_str(packet.error ? packet.error : MALFORMED_DATA));
+		return Result(packet.error ? packet.error : MALFORMED_DATA);
+	}
+
+	RingInfo info;
+	memcpy(&info, packet.data.data(), sizeof(RingInfo));
+	auto send_res = ShmRing::attach(info.send_shm_id);
+	auto receive_res = ShmRing::attach(info.receive_shm_id);
+	if(send_res.is_error() || receive_res.is_error())
+		return Result(send_res.is_error() ? send_res.code() : receive_res.code());
+
+	//Everything from here on goes through the rings, and the socket is only used for doorbells
+	_send_ring = std::move(send_res.value());
+	_receive_ring = std::move(receive_res.value());
+	return Result(SUCCESS);
+}
+
 void BusConnection::send_packet(const RiverPacket& packet) {
-	River::send_packet(_fd, SOCKETFS_RECIPIENT_HOST, packet);
+	if(!_send_ring || _send_ring_overflowed) {
+		River::send_packet(_fd, SOCKETFS_RECIPIENT_HOST, packet);
+		return;
+	}
+
+	//If the packet doesn't fit in the ring, send it and everything after it through the socket. The server reads the
+	//ring before getting to anything sent on the socket after the doorbell, so nothing arrives out of order.
+	if(!River::send_packet(_fd, SOCKETFS_RECIPIENT_HOST, packet, _send_ring.get(), !_batch_depth)) {
+		fprintf(stderr, "[River] Ring overflowed, switching to the socket\n");
+		_send_ring_overflowed = true;
+		River::send_packet(_fd, SOCKETFS_RECIPIENT_HOST, packet);
+	}
+}
+
+uint32_t BusConnection::send_call(RiverPacket& packet, std::function<void(const RiverPacket&)> callback) {
+	//Zero means "no request", so skip it when wrapping around
+	if(!_next_request_id)
+		_next_request_id++;
+	packet.request_id = _next_request_id++;
+
+	//The reply either goes to the callback when packets are handled, or waits for await_reply()
+	if(callback)
+		_reply_callbacks[packet.request_id] = std::move(callback);
+	else
+		_awaited_replies[packet.request_id] = std::nullopt;
+
+	send_packet(packet);
+	return packet.request_id;
+}
+
+RiverPacket BusConnection::await_reply(uint32_t request_id) {
+	//The reply may have already been read and set aside while handling packets, or be waiting in the queue
+	auto awaited_it = _awaited_replies.find(request_id);
+	if(awaited_it != _awaited_replies.end() && awaited_it->second) {
+		auto ret = *awaited_it->second;
+		_awaited_replies.erase(awaited_it);
+		return ret;
+	}
+	_awaited_replies.erase(request_id);
+
+	for(auto it = _packet_queue.begin(); it != _packet_queue.end(); it++) {
+		if(it->type == FUNCTION_RETURN && it->request_id == request_id) {
+			auto ret = *it;
+			_packet_queue.erase(it);
+			return ret;
+		}
+	}
+
+	while(true) {
+		if(read_packet(true) == PACKET_READ) {
+			auto& packet = _packet_queue.back();
+			if(packet.type == FUNCTION_RETURN && packet.request_id == request_id) {
+				auto ret = _packet_queue.back();
+				_packet_queue.pop_back();
+				return ret;
+			}
+		}
+	}
+}
+
+void BusConnection::cancel_reply(uint32_t request_id) {
+	_awaited_replies.erase(request_id);
+	_reply_callbacks.erase(request_id);
+}
+
+void BusConnection::begin_batch() {
+	_batch_depth++;
+}
+
+void BusConnection::end_batch() {
+	if(!_batch_depth || --_batch_depth)
+		return;
+	if(_send_ring)
+		River::ring_doorbell(_fd, SOCKETFS_RECIPIENT_HOST, _send_ring.get());
 }
 
 void BusConnection::read_all_packets(bool block) {
+	//Reading the first packet blocks instead of polling the socket first, since it might already be waiting in the ring
 	if(block) {
-		struct pollfd pfd = {_fd, POLLIN, 0};
-		poll(&pfd, 1, -1);
+		auto res = read_packet(true);
+		if(res == NO_PACKET || res == CONNECTION_LOST)
+			return;
 	}
-	while(read_packet(false) != NO_PACKET);
+	PacketReadResult res;
+	while((res = read_packet(false)) != NO_PACKET && res != CONNECTION_LOST);
 }
 
 void BusConnection::read_and_handle_packets(bool block) {
@@ -107,6 +212,10 @@ void BusConnection::read_and_handle_packets(bool block) {
 				handle_function_call(pkt);
 				break;
 
+			case FUNCTION_RETURN:
+				handle_function_return(pkt);
+				break;
+
 			case CLIENT_CONNECTED:
 				handle_client_connected(pkt);
 				break;
@@ -119,6 +228,11 @@ void BusConnection::read_and_handle_packets(bool block) {
 				handle_message(pkt);
 				break;
 
+			case GET_FUNCTION:
+			case GET_MESSAGE:
+				handle_prefetched_reply(pkt);
+				break;
+
 			default:
 				fprintf(stderr, "[River] Unhandled packet type %d!\n", pkt.type);
 		}
@@ -127,19 +241,69 @@ void BusConnection::read_and_handle_packets(bool block) {
 	}
 }
 
+bool BusConnection::connected() const {
+	return _connected;
+}
+
 int BusConnection::file_descriptor() {
 	return _fd;
 }
 
 PacketReadResult BusConnection::read_packet(bool block) {
-	auto pkt_res = River::receive_packet(_fd, block);
-	if(pkt_res.is_error())
-		return static_cast<PacketReadResult>(pkt_res.code());
-	_packet_queue.push_back(pkt_res.value());
-	return PACKET_READ;
+	while(true) {
+		//Once the ring is open, everything arrives through it. If it's empty, ask for a doorbell before waiting on the
+		//socket, and check it again in case something was written before the request was seen.
+		if(_receive_ring) {
+			if(read_ring_packet())
+				return PACKET_READ;
+			if(!_receive_ring->prepare_to_sleep() && read_ring_packet())
+				return PACKET_READ;
+		}
+
+		//Don't wait on the other end while it's still waiting on a doorbell we've been holding back
+		if(block && _batch_depth && _send_ring)
+			River::ring_doorbell(_fd, SOCKETFS_RECIPIENT_HOST, _send_ring.get());
+
+		auto pkt_res = River::receive_packet(_fd, block, _read_buffer);
+		if(pkt_res.code() == CONNECTION_LOST)
+			_connected = false;
+		if(pkt_res.is_error())
+			return static_cast<PacketReadResult>(pkt_res.code());
+		if(pkt_res.value().type == RING_DOORBELL)
+			continue;
+		_packet_queue.push_back(pkt_res.value());
+		return PACKET_READ;
+	}
+}
+
+bool BusConnection::read_ring_packet() {
+	while(_receive_ring->read(_ring_buffer)) {
+		auto pkt_res = parse_packet(_ring_buffer.data(), _ring_buffer.size(), SOCKETFS_RECIPIENT_HOST, 0);
+		if(pkt_res.is_error())
+			continue;
+		_packet_queue.push_back(pkt_res.value());
+		return true;
+	}
+	return false;
 }
 
 RiverPacket BusConnection::await_packet(PacketType type, const std::string& endpoint, const std::string& path) {
+	//If the request was sent ahead of time, the reply might already be set aside or waiting in the queue
+	for(auto it = _prefetched_replies.begin(); it != _prefetched_replies.end(); it++) {
+		if(it->type == type && (endpoint.empty() || endpoint == it->endpoint) && (path.empty() || path == it->path)) {
+			auto ret = *it;
+			_prefetched_replies.erase(it);
+			return ret;
+		}
+	}
+	for(auto it = _packet_queue.begin(); it != _packet_queue.end(); it++) {
+		if(it->type == type && (endpoint.empty() || endpoint == it->endpoint) && (path.empty() || path == it->path)) {
+			auto ret = *it;
+			_packet_queue.erase(it);
+			return ret;
+		}
+	}
+
 	while(true) {
 		if(read_packet(true) == PACKET_READ) {
 			auto& packet = _packet_queue.back();
@@ -154,32 +318,74 @@ RiverPacket BusConnection::await_packet(PacketType type, const std::string& endp
 	}
 }
 
+void BusConnection::handle_prefetched_reply(const RiverPacket& packet) {
+	//Hold onto the reply until get_function() or set_message_handler() asks for it
+	auto endpoint_it = _endpoints.find(packet.endpoint);
+	if(endpoint_it == _endpoints.end() || !endpoint_it->second->is_prefetched(packet.type, packet.path)) {
+		fprintf(stderr, "[River] Got unrequested reply for %s:%s!\n", packet.endpoint.c_str(), packet.path.c_str());
+		return;
+	}
+	_prefetched_replies.push_back(packet);
+}
+
+Endpoint* BusConnection::endpoint_for_id(uint32_t id) {
+	return id < _endpoint_ids.size() ? _endpoint_ids[id].get() : nullptr;
+}
+
+void BusConnection::add_endpoint(const std::shared_ptr<Endpoint>& endpoint) {
+	_endpoints[endpoint->name()] = endpoint;
+	if(endpoint->id() >= _endpoint_ids.size())
+		_endpoint_ids.resize(endpoint->id() + 1);
+	_endpoint_ids[endpoint->id()] = endpoint;
+}
+
 void BusConnection::handle_function_call(const RiverPacket& packet) {
-	if(!_endpoints[packet.endpoint]) {
-		fprintf(stderr, "[River] Got function call for unknown endpoint %s!\n", packet.endpoint.c_str());
+	auto* endpoint = endpoint_for_id(packet.endpoint_id);
+	if(!endpoint) {
+		fprintf(stderr, "[River] Got function call for unknown endpoint %u!\n", packet.endpoint_id);
 		return;
 	}
 
-	auto& endpoint = _endpoints[packet.endpoint];
-	auto func = endpoint->get_ifunction(packet.path);
+	auto* func = endpoint->get_ifunction(packet.path_id);
 	if(!func) {
-		fprintf(stderr, "[River] Tried handling unknown function %s:%s!\n", packet.endpoint.c_str(), packet.path.c_str());
+		fprintf(stderr, "[River] Tried handling unknown function %s:%u!\n", endpoint->name().c_str(), packet.path_id);
 		return;
 	}
 
 	func->remote_call(packet);
 }
 
+void BusConnection::handle_function_return(const RiverPacket& packet) {
+	auto callback_it = _reply_callbacks.find(packet.request_id);
+	if(callback_it != _reply_callbacks.end()) {
+		auto callback = std::move(callback_it->second);
+		_reply_callbacks.erase(callback_it);
+		callback(packet);
+		return;
+	}
+
+	//Hold onto it until whoever's waiting for it asks
+	auto awaited_it = _awaited_replies.find(packet.request_id);
+	if(awaited_it != _awaited_replies.end()) {
+		awaited_it->second = packet;
+		return;
+	}
+
+	//A return that nobody was waiting for, which only happens when a call without a return value fails
+	if(packet.error)
+		fprintf(stderr, "[River] Remote function call failed: %s\n", error_str(packet.error));
+}
+
 void BusConnection::handle_message(const RiverPacket& packet) {
-	if(!_endpoints[packet.endpoint]) {
-		fprintf(stderr, "[River] Got message for unknown endpoint %s!\n", packet.endpoint.c_str());
+	auto* endpoint = endpoint_for_id(packet.endpoint_id);
+	if(!endpoint) {
+		fprintf(stderr, "[River] Got message for unknown endpoint %u!\n", packet.endpoint_id);
 		return;
 	}
 
-	auto& endpoint = _endpoints[packet.endpoint];
-	auto message = endpoint->get_imessage(packet.path);
+	auto* message = endpoint->get_imessage(packet.path_id);
 	if(!message) {
-		fprintf(stderr, "[River] Tried handling unknown message %s:%s!\n", packet.endpoint.c_str(), packet.path.c_str());
+		fprintf(stderr, "[River] Tried handling unknown message %s:%u!\n", endpoint->name().c_str(), packet.path_id);
 		return;
 	}
 
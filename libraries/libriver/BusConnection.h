@@ -26,6 +26,8 @@
 #include <map>
 #include <memory>
 #include <utility>
+#include <functional>
+#include <optional>
 #include "packet.h"
 
 namespace River {
@@ -48,10 +50,18 @@ namespace River {
 
 		ResultRet<std::shared_ptr<Endpoint>> register_endpoint(const std::string& name);
 		ResultRet<std::shared_ptr<Endpoint>> get_endpoint(const std::string& name);
+		Result open_ring(size_t capacity = LIBRIVER_RING_DEFAULT_SIZE);
 
 		void send_packet(const RiverPacket& packet);
+		uint32_t send_call(RiverPacket& packet, std::function<void(const RiverPacket&)> callback = nullptr);
+		RiverPacket await_reply(uint32_t request_id);
+		void cancel_reply(uint32_t request_id);
+		void begin_batch();
+		void end_batch();
 		void read_all_packets(bool block);
 		void read_and_handle_packets(bool block);
+		//False once reading from the socket has failed (eg. the server went away)
+		bool connected() const;
 		int file_descriptor();
 
 		PacketReadResult read_packet(bool block);
@@ -59,15 +69,32 @@ namespace River {
 
 	private:
 		void handle_function_call(const RiverPacket& packet);
+		void handle_function_return(const RiverPacket& packet);
 		void handle_message(const RiverPacket& packet);
 		void handle_client_connected(const RiverPacket& packet);
 		void handle_client_disconnected(const RiverPacket& packet);
+		void handle_prefetched_reply(const RiverPacket& packet);
+		bool read_ring_packet();
+		Endpoint* endpoint_for_id(uint32_t id);
+		void add_endpoint(const std::shared_ptr<Endpoint>& endpoint);
 
 		int _fd = 0;
 		BusServer* _server = nullptr;
 		BusType _type;
 		std::map<std::string, std::shared_ptr<Endpoint>> _endpoints;
+		std::vector<std::shared_ptr<Endpoint>> _endpoint_ids;
 		std::deque<RiverPacket> _packet_queue;
+		std::deque<RiverPacket> _prefetched_replies; //Replies to prefetches that were read before they were asked for
+		PacketBuffer _read_buffer;
+		std::unique_ptr<ShmRing> _send_ring;
+		std::unique_ptr<ShmRing> _receive_ring;
+		bool _send_ring_overflowed = false; //Once set, packets go through the socket so they stay in order
+		std::vector<uint8_t> _ring_buffer;
+		uint32_t _next_request_id = 1;
+		std::map<uint32_t, std::function<void(const RiverPacket&)>> _reply_callbacks;
+		std::map<uint32_t, std::optional<RiverPacket>> _awaited_replies; //Filled in if a reply is read before it's awaited
+		int _batch_depth = 0;
+		bool _connected = true;
 	};
 }
 
@@ -21,7 +21,7 @@
 #include <unistd.h>
 #include <cstring>
 #include <memory>
-#include <poll.h>
+#include <sys/epoll.h>
 #include "packet.h"
 #include "Endpoint.h"
 #include "BusConnection.h"
@@ -35,7 +35,7 @@ ResultRet<BusServer*> BusServer::create(const std::string& socket_name) {
 		fprintf(stderr, "[River] Failed to create socket %s for bus connection: %s\n", socket_name.c_str(), strerror(errno));
 		return Result(errno);
 	}
-	return new BusServer(fd, CUSTOM);
+	return create(fd, CUSTOM);
 }
 
 ResultRet<BusServer*> BusServer::create(BusServer::ServerType type) {
@@ -45,79 +45,133 @@ ResultRet<BusServer*> BusServer::create(BusServer::ServerType type) {
 			fprintf(stderr, "[River] Failed to create socket for system bus connection: %s\n", strerror(errno));
 			return Result(errno);
 		}
-		return new BusServer(fd, type);
+		return create(fd, type);
 	} else {
 		fprintf(stderr, "Cannot open custom BusConnection without specifying a socket name!\n");
 		return Result(EINVAL);
 	}
 }
 
+ResultRet<BusServer*> BusServer::create(int fd, ServerType type) {
+	//The socket is registered with an epoll instance so waiting on it doesn't have to re-check it every time
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd < 0) {
+		int err = errno;
+		fprintf(stderr, "[River] Failed to create epoll instance for bus server: %s\n", strerror(err));
+		close(fd);
+		return Result(err);
+	}
+	struct epoll_event event = {EPOLLIN, {.fd = fd}};
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		int err = errno;
+		fprintf(stderr, "[River] Failed to watch bus server socket: %s\n", strerror(err));
+		close(epoll_fd);
+		close(fd);
+		return Result(err);
+	}
+	return new BusServer(fd, epoll_fd, type);
+}
+
+BusServer::BusServer(int fd, int epoll_fd, ServerType type): _fd(fd), _epoll_fd(epoll_fd), _type(type), _self_pid(getpid()) {
+
+}
+
 void BusServer::read_and_handle_packets(bool block) {
 	if(block) {
-		struct pollfd pfd = {_fd, POLLIN, 0};
-		poll(&pfd, 1, -1);
+		struct epoll_event event;
+		epoll_wait(_epoll_fd, &event, 1, -1);
 	}
 
 	ResultRet<RiverPacket> pkt_res(0);
-	while((pkt_res = receive_packet(_fd, false)).code() != NO_PACKET) {
+	while((pkt_res = receive_packet(_fd, false, _read_buffer)).code() != NO_PACKET && pkt_res.code() != CONNECTION_LOST) {
 		if(pkt_res.is_error())
 			continue;
-		auto packet = pkt_res.value();
-
-		switch(packet.type) {
-			case SOCKETFS_CLIENT_CONNECTED:
-				client_connected(packet);
-				return;
-
-			case SOCKETFS_CLIENT_DISCONNECTED:
-				client_disconnected(packet);
-				return;
-
-			case REGISTER_ENDPOINT:
-				register_endpoint(packet);
-				return;
-
-			case GET_ENDPOINT:
-				get_endpoint(packet);
-				return;
-
-			case REGISTER_FUNCTION:
-				register_function(packet);
-				return;
-
-			case GET_FUNCTION:
-				get_function(packet);
-				return;
-
-			case FUNCTION_CALL:
-				call_function(packet);
-				return;
-
-			case FUNCTION_RETURN:
-				function_return(packet);
-				return;
-
-			case REGISTER_MESSAGE:
-				register_message(packet);
-				return;
-
-			case GET_MESSAGE:
-				get_message(packet);
-				return;
-
-			case SEND_MESSAGE:
-				send_message(packet);
-				return;
-
-			default:
-				packet.error = MALFORMED_DATA;
-				packet.data.clear();
-				send_packet(packet.__socketfs_from_id, packet);
-				return;
+		handle_packet(pkt_res.value());
+	}
+}
+
+void BusServer::handle_packet(RiverPacket& packet) {
+	switch(packet.type) {
+		case SOCKETFS_CLIENT_CONNECTED:
+			client_connected(packet);
+			break;
+
+		case SOCKETFS_CLIENT_DISCONNECTED:
+			client_disconnected(packet);
+			break;
+
+		case REGISTER_ENDPOINT:
+			register_endpoint(packet);
+			break;
+
+		case GET_ENDPOINT:
+			get_endpoint(packet);
+			break;
+
+		case REGISTER_FUNCTION:
+			register_function(packet);
+			break;
+
+		case GET_FUNCTION:
+			get_function(packet);
+			break;
+
+		case FUNCTION_CALL:
+			call_function(packet);
+			break;
+
+		case FUNCTION_RETURN:
+			function_return(packet);
+			break;
+
+		case REGISTER_MESSAGE:
+			register_message(packet);
+			break;
+
+		case GET_MESSAGE:
+			get_message(packet);
+			break;
+
+		case SEND_MESSAGE:
+			send_message(packet);
+			break;
+
+		case OPEN_RING:
+			open_ring(packet);
+			break;
+
+		case RING_DOORBELL: {
+			auto client_it = _clients.find(packet.__socketfs_from_id);
+			if(client_it != _clients.end() && client_it->second && client_it->second->receive_ring)
+				read_ring(*client_it->second);
+			break;
 		}
+
+		default:
+			packet.error = MALFORMED_DATA;
+			packet.data.clear();
+			send_packet(packet.__socketfs_from_id, packet);
+			break;
 	}
 }
 
+void BusServer::read_ring(ServerClient& client) {
+	//Handle everything in the ring, then ask for a doorbell for the next packet. If something was written before the
+	//client saw that, keep going.
+	do {
+		while(client.receive_ring->read(_ring_buffer)) {
+			//SocketFS events and ring management can't come through the ring, since handling them here could pull the
+			//ring out from under us
+			auto pkt_res = parse_packet(_ring_buffer.data(), _ring_buffer.size(), client.id, client.pid);
+			if(pkt_res.is_error())
+				continue;
+			auto type = pkt_res.value().type;
+			if(type > 0 && type != OPEN_RING && type != RING_DOORBELL)
+				handle_packet(pkt_res.value());
+		}
+	} while(!client.receive_ring->prepare_to_sleep());
+}
+
 void* river_bus_server_thread(void* arg) {
 	auto* self = (BusServer*) arg;
 	while(true)
@@ -135,7 +189,34 @@ void BusServer::set_allow_new_endpoints(bool allow) {
 }
 
 void BusServer::send_packet(int pid, const RiverPacket& packet) {
-	River::send_packet(_fd, pid, packet);
+	auto client_it = _clients.find(pid);
+	auto* client = client_it != _clients.end() ? client_it->second.get() : nullptr;
+	if(!client || !client->send_ring || client->send_ring_overflowed) {
+		River::send_packet(_fd, pid, packet);
+		return;
+	}
+
+	//Never wait on a client to read its ring, since that would hold up every other client. If it's fallen that far
+	//behind, send everything through the socket from now on; the client reads its ring before the socket, so nothing
+	//arrives out of order.
+	if(!River::send_packet(_fd, pid, packet, client->send_ring.get(), true, false)) {
+		fprintf(stderr, "[River] Ring for client %d overflowed, switching to the socket\n", pid);
+		client->send_ring_overflowed = true;
+		River::send_packet(_fd, pid, packet);
+	}
+}
+
+void BusServer::send_error(const RiverPacket& packet, PacketType type, ErrorType error) {
+	RiverPacket reply {
+		type,
+		packet.endpoint,
+		packet.path,
+		error
+	};
+	reply.endpoint_id = packet.endpoint_id;
+	reply.path_id = packet.path_id;
+	reply.request_id = packet.request_id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 #define VERIFY_ENDPOINT \
@@ -172,8 +253,27 @@ void BusServer::send_packet(int pid, const RiverPacket& packet) {
 		return; \
 	} \
 
+#define VERIFY_ENDPOINT_ID(reply_type) \
+	if(packet.endpoint_id >= _endpoint_ids.size() || !_endpoint_ids[packet.endpoint_id]) { \
+		send_error(packet, reply_type, ENDPOINT_DOES_NOT_EXIST); \
+		return; \
+	} \
+	auto* endpoint = _endpoint_ids[packet.endpoint_id];
+
+#define VERIFY_FUNCTION_ID(reply_type) \
+	if(packet.path_id >= endpoint->function_ids.size()) { \
+		send_error(packet, reply_type, FUNCTION_DOES_NOT_EXIST); \
+		return; \
+	}
+
+#define VERIFY_MESSAGE_ID \
+	if(packet.path_id >= endpoint->message_ids.size()) { \
+		send_error(packet, packet.type, MESSAGE_DOES_NOT_EXIST); \
+		return; \
+	}
+
 void BusServer::client_connected(const RiverPacket& packet) {
-	_clients[packet.__socketfs_from_id] = std::make_unique<ServerClient>(ServerClient {packet.__socketfs_from_id});
+	_clients[packet.__socketfs_from_id] = std::make_unique<ServerClient>(ServerClient {packet.__socketfs_from_id, packet.__socketfs_from_pid});
 }
 
 void BusServer::client_disconnected(const RiverPacket& packet) {
@@ -185,8 +285,14 @@ void BusServer::client_disconnected(const RiverPacket& packet) {
 
 	//Erase the client's registered endpoints
 	auto& client = client_it->second;
-	for(auto& endpoint : client->registered_endpoints)
-		_endpoints.erase(endpoint);
+	for(auto& endpoint_name : client->registered_endpoints) {
+		auto endpoint_it = _endpoints.find(endpoint_name);
+		if(endpoint_it == _endpoints.end())
+			continue;
+		if(endpoint_it->second)
+			_endpoint_ids[endpoint_it->second->endpoint_id] = nullptr;
+		_endpoints.erase(endpoint_it);
+	}
 
 	//Send the disconnect message to all of the client's connected endpoints
 	for(auto& endpoint_name : client->connected_endpoints) {
@@ -227,7 +333,9 @@ void BusServer::register_endpoint(const RiverPacket& packet) {
 		return;
 	}
 
-	_endpoints[packet.endpoint] = std::make_unique<ServerEndpoint>(ServerEndpoint{packet.endpoint, packet.__socketfs_from_id});
+	uint32_t endpoint_id = _endpoint_ids.size();
+	_endpoints[packet.endpoint] = std::make_unique<ServerEndpoint>(ServerEndpoint{packet.endpoint, packet.__socketfs_from_id, endpoint_id});
+	_endpoint_ids.push_back(_endpoints[packet.endpoint].get());
 	printf("[River] Registering endpoint %s\n", packet.endpoint.c_str());
 
 	auto& client = _clients[packet.__socketfs_from_id];
@@ -235,12 +343,14 @@ void BusServer::register_endpoint(const RiverPacket& packet) {
 		client->registered_endpoints.push_back(packet.endpoint);
 	}
 
-	send_packet(packet.__socketfs_from_id, {
+	RiverPacket reply {
 		packet.type,
 		packet.endpoint,
 		packet.path,
 		SUCCESS
-	});
+	};
+	reply.endpoint_id = endpoint_id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::get_endpoint(const RiverPacket& packet) {
@@ -259,12 +369,14 @@ void BusServer::get_endpoint(const RiverPacket& packet) {
 		});
 	}
 
-	send_packet(packet.__socketfs_from_id, {
-			packet.type,
-			packet.endpoint,
-			packet.path,
-			SUCCESS
-	});
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	reply.endpoint_id = endpoint->endpoint_id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::register_function(const RiverPacket& packet) {
@@ -290,32 +402,41 @@ void BusServer::register_function(const RiverPacket& packet) {
 		return;
 	}
 
-	endpoint->functions[packet.path] = std::make_unique<ServerFunction>(ServerFunction {packet.path});
+	uint32_t function_id = endpoint->function_ids.size();
+	endpoint->functions[packet.path] = std::make_unique<ServerFunction>(ServerFunction {packet.path, function_id});
+	endpoint->function_ids.push_back(endpoint->functions[packet.path].get());
 	printf("[River] Registering function %s:%s\n", endpoint->name.c_str(), packet.path.c_str());
 
-	send_packet(packet.__socketfs_from_id, {
-			packet.type,
-			packet.endpoint,
-			packet.path,
-			SUCCESS
-	});
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	reply.endpoint_id = endpoint->endpoint_id;
+	reply.path_id = function_id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::get_function(const RiverPacket& packet) {
 	VERIFY_ENDPOINT
 	VERIFY_FUNCTION
 
-	send_packet(packet.__socketfs_from_id, {
-			packet.type,
-			packet.endpoint,
-			packet.path,
-			SUCCESS
-	});
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	reply.endpoint_id = endpoint->endpoint_id;
+	reply.path_id = endpoint->functions[packet.path]->id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::call_function(const RiverPacket& packet) {
-	VERIFY_ENDPOINT
-	VERIFY_FUNCTION
+	//Failures are reported as a return, since that's what the caller is waiting for
+	VERIFY_ENDPOINT_ID(FUNCTION_RETURN)
+	VERIFY_FUNCTION_ID(FUNCTION_RETURN)
 
 	RiverPacket func_packet = packet;
 	func_packet.sender = packet.__socketfs_from_id;
@@ -324,16 +445,11 @@ void BusServer::call_function(const RiverPacket& packet) {
 }
 
 void BusServer::function_return(const RiverPacket& packet) {
-	VERIFY_ENDPOINT
-	VERIFY_FUNCTION
+	VERIFY_ENDPOINT_ID(packet.type)
+	VERIFY_FUNCTION_ID(packet.type)
 
 	if(endpoint->id != packet.__socketfs_from_id || packet.recipient == SOCKETFS_RECIPIENT_HOST || packet.recipient == _self_pid) {
-		send_packet(packet.__socketfs_from_id, {
-				packet.type,
-				packet.endpoint,
-				packet.path,
-				ILLEGAL_REQUEST
-		});
+		send_error(packet, packet.type, ILLEGAL_REQUEST);
 		return;
 	}
 
@@ -363,35 +479,96 @@ void BusServer::register_message(const RiverPacket& packet) {
 		return;
 	}
 
-	endpoint->messages[packet.path] = std::make_unique<ServerMessage>(ServerMessage {packet.path});
+	uint32_t message_id = endpoint->message_ids.size();
+	endpoint->messages[packet.path] = std::make_unique<ServerMessage>(ServerMessage {packet.path, message_id});
+	endpoint->message_ids.push_back(endpoint->messages[packet.path].get());
 	printf("[River] Registering message %s:%s\n", endpoint->name.c_str(), packet.path.c_str());
 
-	send_packet(packet.__socketfs_from_id, {
-			packet.type,
-			packet.endpoint,
-			packet.path,
-			SUCCESS
-	});
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	reply.endpoint_id = endpoint->endpoint_id;
+	reply.path_id = message_id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::get_message(const RiverPacket& packet) {
 	VERIFY_ENDPOINT
 	VERIFY_MESSAGE
 
-	send_packet(packet.__socketfs_from_id, {
-			packet.type,
-			packet.endpoint,
-			packet.path,
-			SUCCESS
-	});
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	reply.endpoint_id = endpoint->endpoint_id;
+	reply.path_id = endpoint->messages[packet.path]->id;
+	send_packet(packet.__socketfs_from_id, reply);
 }
 
 void BusServer::send_message(const RiverPacket& packet) {
-	VERIFY_ENDPOINT
-	VERIFY_MESSAGE
+	VERIFY_ENDPOINT_ID(packet.type)
+	VERIFY_MESSAGE_ID
 
 	RiverPacket message_packet = packet;
 	message_packet.sender = packet.__socketfs_from_id;
 	message_packet.__socketfs_from_id = 0;
 	send_packet(packet.recipient, message_packet);
 }
+
+void BusServer::open_ring(const RiverPacket& packet) {
+	//Connections from our own process can't use a ring, since both ends would be attached to the same shared memory
+	auto client_it = _clients.find(packet.__socketfs_from_id);
+	if(
+			client_it == _clients.end() || !client_it->second || client_it->second->send_ring ||
+			client_it->second->pid == _self_pid || packet.data.size() != sizeof(uint32_t)
+	) {
+		send_packet(packet.__socketfs_from_id, {
+				packet.type,
+				packet.endpoint,
+				packet.path,
+				ILLEGAL_REQUEST
+		});
+		return;
+	}
+	auto& client = client_it->second;
+
+	uint32_t capacity;
+	memcpy(&capacity, packet.data.data(), sizeof(uint32_t));
+	if(capacity < LIBRIVER_RING_MIN_SIZE)
+		capacity = LIBRIVER_RING_MIN_SIZE;
+	if(capacity > LIBRIVER_RING_MAX_SIZE)
+		capacity = LIBRIVER_RING_MAX_SIZE;
+
+	//Make one ring for each direction, and let the client use them
+	auto receive_res = ShmRing::create(capacity);
+	auto send_res = ShmRing::create(capacity);
+	if(receive_res.is_error() || send_res.is_error() || receive_res.value()->allow(client->pid).is_error() || send_res.value()->allow(client->pid).is_error()) {
+		send_packet(packet.__socketfs_from_id, {
+				packet.type,
+				packet.endpoint,
+				packet.path,
+				UNKNOWN_ERROR
+		});
+		return;
+	}
+
+	//Reply through the socket, and only start using the ring to send after that
+	RiverPacket reply {
+		packet.type,
+		packet.endpoint,
+		packet.path,
+		SUCCESS
+	};
+	RingInfo info = {receive_res.value()->shm_id(), send_res.value()->shm_id()};
+	reply.data.resize(sizeof(RingInfo));
+	memcpy(reply.data.data(), &info, sizeof(RingInfo));
+	send_packet(packet.__socketfs_from_id, reply);
+
+	client->receive_ring = std::move(receive_res.value());
+	client->send_ring = std::move(send_res.value());
+}
@@ -51,28 +51,43 @@ namespace River {
 	private:
 		struct ServerMessage {
 			std::string path;
+			uint32_t id;
 		};
 
 		struct ServerFunction {
 			std::string path;
+			uint32_t id;
 		};
 
+		//Functions and messages are looked up by name when they're registered or requested, and by the IDs handed out
+		//then (their index in function_ids / message_ids) when they're used
 		struct ServerEndpoint {
 			std::string name;
 			sockid_t id;
+			uint32_t endpoint_id;
 			std::map<std::string, std::unique_ptr<ServerFunction>> functions;
 			std::map<std::string, std::unique_ptr<ServerMessage>> messages;
+			std::vector<ServerFunction*> function_ids;
+			std::vector<ServerMessage*> message_ids;
 		};
 
 		struct ServerClient {
 			sockid_t id;
+			pid_t pid;
 			std::vector<std::string> registered_endpoints;
 			std::vector<std::string> connected_endpoints;
+			std::unique_ptr<ShmRing> receive_ring;
+			std::unique_ptr<ShmRing> send_ring;
+			bool send_ring_overflowed = false; //Once set, packets go through the socket so they stay in order
 		};
 
-		BusServer(int fd, ServerType type): _fd(fd), _type(type), _self_pid(getpid()) {}
+		static ResultRet<BusServer*> create(int fd, ServerType type);
+		BusServer(int fd, int epoll_fd, ServerType type);
 
 		void send_packet(int pid, const RiverPacket& packet);
+		void send_error(const RiverPacket& packet, PacketType type, ErrorType error);
+		void handle_packet(RiverPacket& packet);
+		void read_ring(ServerClient& client);
 
 		void client_connected(const RiverPacket& packet);
 		void client_disconnected(const RiverPacket& packet);
@@ -85,14 +100,19 @@ namespace River {
 		void register_message(const RiverPacket& packet);
 		void get_message(const RiverPacket& packet);
 		void send_message(const RiverPacket& packet);
+		void open_ring(const RiverPacket& packet);
 
 		int _fd = 0;
+		int _epoll_fd = -1;
+		PacketBuffer _read_buffer;
+		std::vector<uint8_t> _ring_buffer;
 		ServerType _type;
 		bool _started = false;
 		bool _allow_new_endpoints = true;
 
 		std::map<sockid_t, std::unique_ptr<ServerClient>> _clients;
 		std::map<std::string, std::unique_ptr<ServerEndpoint>> _endpoints;
+		std::vector<ServerEndpoint*> _endpoint_ids; //IDs aren't reused, so stale ones from a disconnected client stay invalid
 		pid_t _self_pid;
 	};
 }
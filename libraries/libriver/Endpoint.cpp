@@ -22,22 +22,34 @@
 
 using namespace River;
 
-Endpoint::Endpoint(std::shared_ptr<BusConnection> bus, const std::string& name, ConnectionType type): _bus(std::move(bus)), _type(type), _name(name) {
+Endpoint::Endpoint(std::shared_ptr<BusConnection> bus, const std::string& name, ConnectionType type, uint32_t id): _bus(std::move(bus)), _type(type), _name(name), _id(id) {
 
 }
 
-std::shared_ptr<IFunction> Endpoint::get_ifunction(const std::string& path) {
-	return _functions[path];
+IFunction* Endpoint::get_ifunction(uint32_t id) {
+	return id < _function_ids.size() ? _function_ids[id].get() : nullptr;
 }
 
-std::shared_ptr<IMessage> Endpoint::get_imessage(const std::string& path) {
-	return _messages[path];
+IMessage* Endpoint::get_imessage(uint32_t id) {
+	return id < _message_ids.size() ? _message_ids[id].get() : nullptr;
+}
+
+bool Endpoint::is_prefetched(PacketType type, const std::string& stringname) const {
+	if(type == GET_FUNCTION)
+		return _prefetched_functions.count(stringname);
+	if(type == GET_MESSAGE)
+		return _prefetched_messages.count(stringname);
+	return false;
 }
 
 const std::string& Endpoint::name() {
 	return _name;
 }
 
+uint32_t Endpoint::id() const {
+	return _id;
+}
+
 Endpoint::ConnectionType Endpoint::type() const {
 	return _type;
 }
@@ -45,3 +57,15 @@ Endpoint::ConnectionType Endpoint::type() const {
 const std::shared_ptr<BusConnection>& Endpoint::bus() {
 	return _bus;
 }
+
+void Endpoint::set_function_id(uint32_t id, std::shared_ptr<IFunction> function) {
+	if(id >= _function_ids.size())
+		_function_ids.resize(id + 1);
+	_function_ids[id] = std::move(function);
+}
+
+void Endpoint::set_message_id(uint32_t id, std::shared_ptr<IMessage> message) {
+	if(id >= _message_ids.size())
+		_message_ids.resize(id + 1);
+	_message_ids[id] = std::move(message);
+}
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include <string>
 #include <functional>
 #include <optional>
+#include <set>
 #include "BusConnection.h"
 
 namespace River {
@@ -43,14 +44,14 @@ namespace River {
 	public:
 		enum ConnectionType { PROXY, HOST };
 
-		Endpoint(std::shared_ptr<BusConnection> bus, const std::string& name, ConnectionType type);
+		Endpoint(std::shared_ptr<BusConnection> bus, const std::string& name, ConnectionType type, uint32_t id);
 
 		template<typename RetT, typename... ParamTs>
 		ResultRet<Function<RetT, ParamTs...>> register_function(const std::string& path, typename type_identity<std::function<RetT(sockid_t, ParamTs...)>>::type callback) {
 			auto stringname = Function<RetT, ParamTs...>::stringname_of(path);
 
 			if(_functions[stringname])
-				return *std::dynamic_pointer_cast<Function<RetT, ParamTs...>>(_functions[path]);
+				return *std::dynamic_pointer_cast<Function<RetT, ParamTs...>>(_functions[stringname]);
 
 			_bus->send_packet({
 				REGISTER_FUNCTION,
@@ -64,8 +65,9 @@ namespace River {
 				return Result(packet.error);
 			}
 
-			auto ret = std::make_shared<Function<RetT, ParamTs...>>(path, shared_from_this(), callback);
+			auto ret = std::make_shared<Function<RetT, ParamTs...>>(path, shared_from_this(), packet.path_id, callback);
 			_functions[stringname] = ret;
+			set_function_id(packet.path_id, ret);
 			return *ret;
 		}
 
@@ -74,13 +76,15 @@ namespace River {
 			auto stringname = Function<RetT, ParamTs...>::stringname_of(path);
 
 			if(_functions[stringname])
-				return *std::dynamic_pointer_cast<Function<RetT, ParamTs...>>(_functions[path]);
-
-			_bus->send_packet({
-				GET_FUNCTION,
-				_name,
-				stringname
-			});
+				return *std::dynamic_pointer_cast<Function<RetT, ParamTs...>>(_functions[stringname]);
+
+			if(!_prefetched_functions.erase(stringname)) {
+				_bus->send_packet({
+					GET_FUNCTION,
+					_name,
+					stringname
+				});
+			}
 
 			auto packet = _bus->await_packet(River::GET_FUNCTION, _name, stringname);
 			if(packet.error) {
@@ -88,17 +92,32 @@ namespace River {
 				return Result(packet.error);
 			}
 
-			auto ret = std::make_shared<Function<RetT, ParamTs...>>(path, shared_from_this());
+			auto ret = std::make_shared<Function<RetT, ParamTs...>>(path, shared_from_this(), packet.path_id);
 			_functions[stringname] = ret;
 			return *ret;
 		}
 
+		//Sends the request for get_function() without waiting for the reply, so several can be in flight at once. If the
+		//reply is read before get_function() is called, it's kept until then.
+		template<typename RetT, typename... ParamTs>
+		void prefetch_function(const std::string& path) {
+			auto stringname = Function<RetT, ParamTs...>::stringname_of(path);
+			if(_functions[stringname] || !_prefetched_functions.insert(stringname).second)
+				return;
+
+			_bus->send_packet({
+				GET_FUNCTION,
+				_name,
+				stringname
+			});
+		}
+
 		template<typename T>
 		ResultRet<Message<T>> register_message(const std::string& path) {
 			auto stringname = Message<T>::stringname_of(path);
 
 			if(_messages[stringname])
-				return *std::dynamic_pointer_cast<Message<T>>(_messages[path]);
+				return *std::dynamic_pointer_cast<Message<T>>(_messages[stringname]);
 
 			_bus->send_packet({
 				REGISTER_MESSAGE,
@@ -112,7 +131,7 @@ namespace River {
 				return Result(packet.error);
 			}
 
-			auto ret = std::make_shared<Message<T>>(path, shared_from_this());
+			auto ret = std::make_shared<Message<T>>(path, shared_from_this(), packet.path_id);
 			_messages[stringname] = ret;
 			return *ret;
 		}
@@ -136,11 +155,13 @@ namespace River {
 			if(_messages[stringname])
 				return Result(MESSAGE_HANDLER_ALREADY_SET);
 
-			_bus->send_packet({
-				GET_MESSAGE,
-				_name,
-				stringname
-			});
+			if(!_prefetched_messages.erase(stringname)) {
+				_bus->send_packet({
+					GET_MESSAGE,
+					_name,
+					stringname
+				});
+			}
 
 			auto packet = _bus->await_packet(River::GET_MESSAGE, _name, stringname);
 			if(packet.error) {
@@ -148,24 +169,52 @@ namespace River {
 				return Result(packet.error);
 			}
 
-			auto ret = std::make_shared<Message<T>>(path, shared_from_this(), callback);
+			auto ret = std::make_shared<Message<T>>(path, shared_from_this(), packet.path_id, callback);
 			_messages[stringname] = ret;
+			set_message_id(packet.path_id, ret);
 			return Result(SUCCESS);
 		}
 
-		std::shared_ptr<IFunction> get_ifunction(const std::string& path);
-		std::shared_ptr<IMessage> get_imessage(const std::string& path);
+		//Like prefetch_function(), for set_message_handler().
+		template<typename T>
+		void prefetch_message_handler(const std::string& path) {
+			auto stringname = Message<T>::stringname_of(path);
+			if(_messages[stringname] || !_prefetched_messages.insert(stringname).second)
+				return;
+
+			_bus->send_packet({
+				GET_MESSAGE,
+				_name,
+				stringname
+			});
+		}
+
+		//Whether a GET_FUNCTION or GET_MESSAGE request for the given path was prefetched and is still waiting to be used
+		bool is_prefetched(PacketType type, const std::string& stringname) const;
+
+		IFunction* get_ifunction(uint32_t id);
+		IMessage* get_imessage(uint32_t id);
 
 		const std::string& name();
+		uint32_t id() const;
 		ConnectionType type() const;
 		const std::shared_ptr<BusConnection>& bus();
 
 		std::function<void(sockid_t, pid_t)> on_client_connect = nullptr;
 		std::function<void(sockid_t, pid_t)> on_client_disconnect = nullptr;
 	private:
+		void set_function_id(uint32_t id, std::shared_ptr<IFunction> function);
+		void set_message_id(uint32_t id, std::shared_ptr<IMessage> message);
+
 		std::map<std::string, std::shared_ptr<IFunction>> _functions;
 		std::map<std::string, std::shared_ptr<IMessage>> _messages;
+		//Indexed by the IDs the server assigned, so incoming calls and messages can be dispatched without a lookup
+		std::vector<std::shared_ptr<IFunction>> _function_ids;
+		std::vector<std::shared_ptr<IMessage>> _message_ids;
+		std::set<std::string> _prefetched_functions;
+		std::set<std::string> _prefetched_messages;
 		std::string _name;
+		uint32_t _id;
 		ConnectionType _type;
 		std::shared_ptr<BusConnection> _bus;
 	};
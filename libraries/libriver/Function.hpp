@@ -19,18 +19,29 @@
 
 #include <utility>
 #include <vector>
+#include <tuple>
+#include <algorithm>
+#include <type_traits>
 #include <string>
 #include <functional>
 #include <sys/socketfs.h>
 #include "packet.h"
 #include <cstring>
 #include "BusConnection.h"
+#include "Future.hpp"
 
 #ifndef DUCKOS_LIBRIVER_FUNCTION_H
 #define DUCKOS_LIBRIVER_FUNCTION_H
 
 namespace River {
 
+	//A parameter with a serialized_size() member only has that many bytes sent (eg. a list with its length in front of
+	//it), and the rest of it is zeroed when it's received. This only works for functions that take one parameter.
+	template<typename T, typename = void>
+	struct has_serialized_size: std::false_type {};
+	template<typename T>
+	struct has_serialized_size<T, std::void_t<decltype(std::declval<const T&>().serialized_size())>>: std::true_type {};
+
 	class IFunction {
 	public:
 		virtual void remote_call(const RiverPacket& packet) = 0;
@@ -43,11 +54,12 @@ namespace River {
 		static_assert((std::is_pod<ParamTs>() && ...), "Function arguments must be plain-old datatypes!");
 
 	public:
-		Function(const std::string& path): _path(path), _endpoint(nullptr), _callback(nullptr) {}
+		Function(const std::string& path): _path(path), _endpoint(nullptr), _id(0), _callback(nullptr) {}
 
-		Function(const std::string& path, std::shared_ptr<Endpoint> endpoint, std::function<RetT(sockid_t, ParamTs...)> callback = nullptr):
+		Function(const std::string& path, std::shared_ptr<Endpoint> endpoint, uint32_t id, std::function<RetT(sockid_t, ParamTs...)> callback = nullptr):
 				_path(stringname_of(path)),
 				_endpoint(std::move(endpoint)),
+				_id(id),
 				_callback(callback) {}
 
 		static std::string stringname_of(const std::string& path) {
@@ -67,68 +79,96 @@ namespace River {
 			}
 
 			if(_endpoint->type() == Endpoint::PROXY) {
-				RiverPacket packet = {
-						FUNCTION_CALL,
-						_endpoint->name(),
-						_path
-				};
-
-				//Serialize function call data (tuple {arg1, arg2, arg3...})
-				std::tuple<ParamTs...> data_tuple = {args...};
-				packet.data.resize(sizeof(data_tuple));
-				memcpy(packet.data.data(), &data_tuple, sizeof(data_tuple));
-
 				//Send the function call packet and await a reply (if the function has a non-void return type)
-				_endpoint->bus()->send_packet(packet);
-				if constexpr(!std::is_void<RetT>()) {
-					auto pkt = _endpoint->bus()->await_packet(FUNCTION_RETURN, _endpoint->name(), _path);
-					if(pkt.error) {
-						fprintf(stderr, "[River] Remote function call %s:%s failed: %s\n", _endpoint->name().c_str(), _path.c_str(),
-								error_str(pkt.error));
-						if constexpr(!std::is_void<RetT>())
-							return RetT();
-					}
-
-					//Deserialize and return the return value
-					RetT ret;
-					if(pkt.data.size() == sizeof(RetT))
-						memcpy(&ret, pkt.data.data(), sizeof(RetT));
-					return ret;
-				}
+				if constexpr(!std::is_void<RetT>())
+					return async(args...).get();
+				else
+					_endpoint->bus()->send_packet(call_packet(args...));
 			} else {
 				return _callback(0, args...);
 			}
 		}
 
+		/**
+		 * Calls the function without waiting for it to return, so that other calls can be made in the meantime.
+		 * @return A future that can be used to wait for the return value.
+		 */
+		Future<RetT> async(ParamTs... args) const {
+			static_assert(!std::is_void<RetT>(), "Functions that return void don't need to be called asynchronously!");
+			if(!_endpoint || _endpoint->type() != Endpoint::PROXY) {
+				fprintf(stderr, "[River] WARN: Tried asynchronously calling uninitialized or local function %s!\n", _path.c_str());
+				return {};
+			}
+
+			auto packet = call_packet(args...);
+			auto request_id = _endpoint->bus()->send_call(packet);
+			return {_endpoint->bus(), request_id};
+		}
+
+		/**
+		 * Calls the function without waiting for it to return.
+		 * @param callback The callback to call with the return value (RetT) once it's received while handling packets.
+		 *                 If the call fails, it's called with a default-constructed RetT.
+		 */
+		template<typename CallbackT>
+		void async(CallbackT callback, ParamTs... args) const {
+			static_assert(!std::is_void<RetT>(), "Functions that return void don't need to be called asynchronously!");
+			if(!_endpoint || _endpoint->type() != Endpoint::PROXY) {
+				fprintf(stderr, "[River] WARN: Tried asynchronously calling uninitialized or local function %s!\n", _path.c_str());
+				return;
+			}
+
+			auto packet = call_packet(args...);
+			_endpoint->bus()->send_call(packet, [callback](const RiverPacket& reply) {
+				callback(Future<RetT>::value_of(reply));
+			});
+		}
+
 		const std::string& path() override {
 			return _path;
 		}
 
 		void remote_call(const RiverPacket& packet) override {
 			//Make sure the data is the correct size
-			if(packet.data.size() != sizeof(std::tuple<ParamTs...>)) {
-				_endpoint->bus()->send_packet({
+			std::tuple<ParamTs...> data_tuple;
+			bool malformed;
+			if constexpr(has_variable_size) {
+				auto& param = std::get<0>(data_tuple);
+				malformed = packet.data.size() > sizeof(param);
+				if(!malformed) {
+					memset(&param, 0, sizeof(param));
+					memcpy(&param, packet.data.data(), packet.data.size());
+					malformed = param.serialized_size() != packet.data.size();
+				}
+			} else {
+				malformed = packet.data.size() != sizeof(data_tuple);
+				if(!malformed)
+					memcpy(&data_tuple, packet.data.data(), sizeof(data_tuple));
+			}
+
+			if(malformed) {
+				RiverPacket resp {
 					FUNCTION_RETURN,
-					packet.endpoint,
-					packet.path,
+					"",
+					"",
 					MALFORMED_DATA,
 					packet.sender
-				});
+				};
+				resp.endpoint_id = packet.endpoint_id;
+				resp.path_id = packet.path_id;
+				resp.request_id = packet.request_id;
+				_endpoint->bus()->send_packet(resp);
+				return;
 			}
 
-			//Deserialize the parameters
-			std::tuple<ParamTs...> data_tuple;
-			memcpy(&data_tuple, packet.data.data(), sizeof(data_tuple));
-
 			//Call the function
 			if constexpr(!std::is_void<RetT>()) {
 				//Serialize the return value and send the response
-				RiverPacket resp {
-						FUNCTION_RETURN,
-						packet.endpoint,
-						packet.path
-				};
+				RiverPacket resp {FUNCTION_RETURN};
 				resp.recipient = packet.sender;
+				resp.endpoint_id = packet.endpoint_id;
+				resp.path_id = packet.path_id;
+				resp.request_id = packet.request_id;
 				RetT ret = _callback(packet.sender, std::get<ParamTs>(data_tuple)...);
 				resp.data.resize(sizeof(RetT));
 				memcpy(resp.data.data(), &ret, sizeof(RetT));
@@ -139,8 +179,31 @@ namespace River {
 		}
 
 	private:
+		static constexpr bool has_variable_size = sizeof...(ParamTs) == 1 && (has_serialized_size<ParamTs>::value && ...);
+
+		RiverPacket call_packet(ParamTs... args) const {
+			//Calls are addressed by ID, so they don't carry the endpoint name or path
+			RiverPacket packet = {FUNCTION_CALL};
+			packet.endpoint_id = _endpoint->id();
+			packet.path_id = _id;
+
+			//Serialize function call data (tuple {arg1, arg2, arg3...})
+			std::tuple<ParamTs...> data_tuple = {args...};
+			if constexpr(has_variable_size) {
+				auto& param = std::get<0>(data_tuple);
+				size_t size = std::min(param.serialized_size(), sizeof(param));
+				packet.data.resize(size);
+				memcpy(packet.data.data(), &param, size);
+			} else {
+				packet.data.resize(sizeof(data_tuple));
+				memcpy(packet.data.data(), &data_tuple, sizeof(data_tuple));
+			}
+			return packet;
+		}
+
 		std::string _path;
 		std::shared_ptr<Endpoint> _endpoint;
+		uint32_t _id;
 		std::function<RetT(sockid_t, ParamTs...)> _callback;
 	};
 }
@@ -0,0 +1,99 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBRIVER_FUTURE_HPP
+#define DUCKOS_LIBRIVER_FUTURE_HPP
+
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include "BusConnection.h"
+
+namespace River {
+	/**
+	 * The return value of a function call that hasn't been waited on yet.
+	 * Any number of these can be outstanding at once, and they can be waited on in any order.
+	 */
+	template<typename RetT>
+	class Future {
+		static_assert(std::is_pod<RetT>(), "Future type must be a plain-old datatype!");
+	public:
+		Future(): _bus(nullptr), _request_id(0) {}
+		Future(std::shared_ptr<BusConnection> bus, uint32_t request_id): _bus(std::move(bus)), _request_id(request_id) {}
+		Future(const Future& other) = delete;
+		Future(Future&& other) noexcept: _bus(std::move(other._bus)), _request_id(other._request_id) {}
+
+		~Future() {
+			//If nobody's going to wait for the reply, don't hold onto it when it arrives
+			if(_bus)
+				_bus->cancel_reply(_request_id);
+		}
+
+		Future& operator=(const Future& other) = delete;
+		Future& operator=(Future&& other) noexcept {
+			if(_bus)
+				_bus->cancel_reply(_request_id);
+			_bus = std::move(other._bus);
+			_request_id = other._request_id;
+			return *this;
+		}
+
+		/**
+		 * Whether or not this future is still waiting to be retrieved with get().
+		 */
+		bool valid() const {
+			return _bus != nullptr;
+		}
+
+		/**
+		 * Waits for the function to return, if it hasn't already, and returns its return value.
+		 * This can only be called once.
+		 * @return The return value, or a default-constructed RetT if the call failed.
+		 */
+		RetT get() {
+			if(!_bus) {
+				fprintf(stderr, "[River] WARN: Tried getting the value of an invalid future!\n");
+				return RetT();
+			}
+
+			auto pkt = _bus->await_reply(_request_id);
+			_bus = nullptr;
+			return value_of(pkt);
+		}
+
+		static RetT value_of(const RiverPacket& pkt) {
+			if(pkt.error) {
+				fprintf(stderr, "[River] Remote function call failed: %s\n", error_str(pkt.error));
+				return RetT();
+			}
+
+			//Deserialize and return the return value
+			RetT ret;
+			if(pkt.data.size() == sizeof(RetT))
+				memcpy(&ret, pkt.data.data(), sizeof(RetT));
+			return ret;
+		}
+
+	private:
+		std::shared_ptr<BusConnection> _bus;
+		uint32_t _request_id;
+	};
+}
+
+#endif //DUCKOS_LIBRIVER_FUTURE_HPP
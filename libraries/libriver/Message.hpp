@@ -36,15 +36,17 @@ namespace River {
 		static_assert(std::is_pod<T>(), "Message type must be a plain-old datatype!");
 
 	public:
-		Message(const std::string& path): _path(path), _endpoint(nullptr), _callback(nullptr) {}
+		Message(const std::string& path): _path(path), _endpoint(nullptr), _id(0), _callback(nullptr) {}
 
-		Message(const std::string& path, std::shared_ptr<Endpoint> endpoint):
+		Message(const std::string& path, std::shared_ptr<Endpoint> endpoint, uint32_t id):
 				_path(stringname_of(path)),
-				_endpoint(std::move(endpoint)) {}
+				_endpoint(std::move(endpoint)),
+				_id(id) {}
 
-		Message(const std::string& path, std::shared_ptr<Endpoint> endpoint, std::function<void(T)> callback):
+		Message(const std::string& path, std::shared_ptr<Endpoint> endpoint, uint32_t id, std::function<void(T)> callback):
 				_path(stringname_of(path)),
 				_endpoint(std::move(endpoint)),
+				_id(id),
 				_callback(callback) {}
 
 		static std::string stringname_of(const std::string& path) {
@@ -58,12 +60,11 @@ namespace River {
 			}
 
 			if(_endpoint->type() == Endpoint::HOST) {
-				RiverPacket packet = {
-						SEND_MESSAGE,
-						_endpoint->name(),
-						_path
-				};
+				//Messages are addressed by ID, so they don't carry the endpoint name or path
+				RiverPacket packet = {SEND_MESSAGE};
 				packet.recipient = recipient;
+				packet.endpoint_id = _endpoint->id();
+				packet.path_id = _id;
 
 				//Serialize message data
 				packet.data.resize(sizeof(T));
@@ -108,6 +109,7 @@ namespace River {
 	private:
 		std::string _path;
 		std::shared_ptr<Endpoint> _endpoint;
+		uint32_t _id;
 		std::function<void(T)> _callback = nullptr;
 	};
 }
@@ -0,0 +1,167 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#include "ShmRing.h"
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+
+using namespace River;
+
+//Messages are stored as a length followed by the data, padded so that every length is aligned
+#define RING_ALIGN(size) (((size) + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+
+ResultRet<std::unique_ptr<ShmRing>> ShmRing::create(size_t capacity) {
+	//The capacity has to be a power of two so positions can wrap around without a division
+	size_t pow2 = sizeof(uint32_t);
+	while(pow2 < capacity)
+		pow2 <<= 1;
+
+	struct shm shm;
+	if(shmcreate(NULL, sizeof(Header) + pow2, &shm) < 0) {
+		fprintf(stderr, "[River] Failed to create shared memory ring: %s\n", strerror(errno));
+		return Result(errno);
+	}
+
+	auto* header = (Header*) shm.ptr;
+	header->capacity = pow2;
+	header->head = 0;
+	header->tail = 0;
+	//Start out asleep so the first message always rings the doorbell
+	header->consumer_sleeping = 1;
+	__atomic_store_n(&header->magic, LIBRIVER_RING_MAGIC, __ATOMIC_RELEASE);
+	return std::unique_ptr<ShmRing>(new ShmRing(shm, pow2));
+}
+
+ResultRet<std::unique_ptr<ShmRing>> ShmRing::attach(int shm_id) {
+	struct shm shm;
+	if(shmattach(shm_id, NULL, &shm) < 0) {
+		fprintf(stderr, "[River] Failed to attach shared memory ring: %s\n", strerror(errno));
+		return Result(errno);
+	}
+
+	//Make sure what we attached is actually a ring and its capacity fits in it
+	auto* header = (Header*) shm.ptr;
+	uint32_t capacity = header->capacity;
+	if(
+			shm.size < sizeof(Header) ||
+			__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != LIBRIVER_RING_MAGIC ||
+			!capacity || (capacity & (capacity - 1)) ||
+			capacity > shm.size - sizeof(Header)
+	) {
+		fprintf(stderr, "[River] Shared memory %d is not a valid ring!\n", shm_id);
+		shmdetach(shm_id);
+		return Result(EINVAL);
+	}
+
+	return std::unique_ptr<ShmRing>(new ShmRing(shm, capacity));
+}
+
+ShmRing::ShmRing(struct shm shm, uint32_t capacity): _shm(shm), _header((Header*) shm.ptr), _capacity(capacity) {}
+
+ShmRing::~ShmRing() {
+	if(shmdetach(_shm.id) < 0)
+		perror("[River] Failed to detach shared memory ring");
+}
+
+int ShmRing::shm_id() const {
+	return _shm.id;
+}
+
+Result ShmRing::allow(pid_t pid) {
+	if(shmallow(_shm.id, pid, SHM_READ | SHM_WRITE) < 0)
+		return Result(errno);
+	return Result::SUCCESS;
+}
+
+bool ShmRing::write(const struct iovec* iov, int iovcnt) {
+	uint32_t length = 0;
+	for(int i = 0; i < iovcnt; i++)
+		length += iov[i].iov_len;
+	uint32_t record_size = sizeof(uint32_t) + RING_ALIGN(length);
+
+	uint32_t head = _header->head;
+	uint32_t tail = __atomic_load_n(&_header->tail, __ATOMIC_ACQUIRE);
+	if(head - tail > _capacity || _capacity - (head - tail) < record_size)
+		return false;
+
+	copy_in(head, &length, sizeof(uint32_t));
+	uint32_t pos = head + sizeof(uint32_t);
+	for(int i = 0; i < iovcnt; i++) {
+		copy_in(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+
+	//This has to be sequentially consistent with the consumer's check in prepare_to_sleep() so that a doorbell can't be missed
+	__atomic_store_n(&_header->head, head + record_size, __ATOMIC_SEQ_CST);
+	return true;
+}
+
+bool ShmRing::take_doorbell() {
+	return __atomic_exchange_n(&_header->consumer_sleeping, 0, __ATOMIC_SEQ_CST);
+}
+
+size_t ShmRing::max_message_size() const {
+	return _capacity - sizeof(uint32_t);
+}
+
+bool ShmRing::read(std::vector<uint8_t>& message) {
+	uint32_t tail = _header->tail;
+	uint32_t head = __atomic_load_n(&_header->head, __ATOMIC_ACQUIRE);
+	if(head == tail)
+		return false;
+
+	//The producer can write anything to the header, so don't trust it to stay inside the ring
+	uint32_t length = 0;
+	bool valid = head - tail <= _capacity && head - tail >= sizeof(uint32_t);
+	if(valid) {
+		copy_out(tail, &length, sizeof(uint32_t));
+		valid = length <= _capacity - sizeof(uint32_t) && length <= head - tail - sizeof(uint32_t);
+	}
+	if(!valid) {
+		//The producer wrote garbage, so there's no telling where the next message starts. Throw everything out.
+		fprintf(stderr, "[River] WARN: Malformed message in shared memory ring, dropping its contents\n");
+		__atomic_store_n(&_header->tail, head, __ATOMIC_RELEASE);
+		return false;
+	}
+
+	message.resize(length);
+	copy_out(tail + sizeof(uint32_t), message.data(), length);
+	__atomic_store_n(&_header->tail, tail + sizeof(uint32_t) + RING_ALIGN(length), __ATOMIC_RELEASE);
+	return true;
+}
+
+bool ShmRing::prepare_to_sleep() {
+	__atomic_store_n(&_header->consumer_sleeping, 1, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&_header->head, __ATOMIC_SEQ_CST) == _header->tail;
+}
+
+void ShmRing::copy_in(uint32_t pos, const void* data, size_t count) {
+	uint32_t offset = pos & (_capacity - 1);
+	size_t first = count < _capacity - offset ? count : _capacity - offset;
+	memcpy(_header->data + offset, data, first);
+	memcpy(_header->data, (const uint8_t*) data + first, count - first);
+}
+
+void ShmRing::copy_out(uint32_t pos, void* data, size_t count) {
+	uint32_t offset = pos & (_capacity - 1);
+	size_t first = count < _capacity - offset ? count : _capacity - offset;
+	memcpy(data, _header->data + offset, first);
+	memcpy((uint8_t*) data + first, _header->data, count - first);
+}
@@ -0,0 +1,78 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+#ifndef DUCKOS_LIBRIVER_SHMRING_H
+#define DUCKOS_LIBRIVER_SHMRING_H
+
+#include <memory>
+#include <vector>
+#include <libduck/Result.hpp>
+#include <sys/mem.h>
+#include <sys/uio.h>
+
+#define LIBRIVER_RING_MAGIC 0x52494E47
+#define LIBRIVER_RING_DEFAULT_SIZE 65536
+#define LIBRIVER_RING_MIN_SIZE 4096
+#define LIBRIVER_RING_MAX_SIZE (1024 * 1024)
+
+namespace River {
+	/**
+	 * A single-producer, single-consumer ring of messages in shared memory. The producer and consumer never take a lock
+	 * or make a syscall to pass a message; the consumer only has to be woken up (by a doorbell sent some other way) if
+	 * it went to sleep after finding the ring empty, so a burst of messages only needs one doorbell.
+	 */
+	class ShmRing {
+	public:
+		static ResultRet<std::unique_ptr<ShmRing>> create(size_t capacity = LIBRIVER_RING_DEFAULT_SIZE);
+		static ResultRet<std::unique_ptr<ShmRing>> attach(int shm_id);
+		~ShmRing();
+
+		int shm_id() const;
+		Result allow(pid_t pid);
+
+		//Producer
+		bool write(const struct iovec* iov, int iovcnt);
+		bool take_doorbell();
+		size_t max_message_size() const;
+
+		//Consumer
+		bool read(std::vector<uint8_t>& message);
+		bool prepare_to_sleep();
+
+	private:
+		struct Header {
+			uint32_t magic;
+			uint32_t capacity; //The size of the data area, which is a power of two
+			uint32_t head; //The total number of bytes ever written
+			uint32_t tail; //The total number of bytes ever read
+			uint32_t consumer_sleeping; //Set by the consumer when it wants a doorbell for the next message
+			uint8_t data[];
+		};
+
+		ShmRing(struct shm shm, uint32_t capacity);
+		void copy_in(uint32_t pos, const void* data, size_t count);
+		void copy_out(uint32_t pos, void* data, size_t count);
+
+		struct shm _shm;
+		Header* _header;
+		uint32_t _capacity; //Kept separately, since the other side of the ring can change the one in the header
+	};
+}
+
+#endif //DUCKOS_LIBRIVER_SHMRING_H
@@ -18,6 +18,7 @@
 */
 
 #include "packet.h"
+#include <unistd.h>
 using namespace River;
 
 const char* River::error_str(int error) {
@@ -44,14 +45,18 @@ const char* River::error_str(int error) {
 	}
 }
 
-ResultRet<RiverPacket> River::receive_packet(int fd, bool block)  {
+ResultRet<RiverPacket> River::receive_packet(int fd, bool block, PacketBuffer& buffer)  {
 	if(block) {
 		struct pollfd pfd = {fd, POLLIN, 0};
 		poll(&pfd, 1, -1);
 	}
 
-	socketfs_packet* raw_socketfs_packet;
-	if((raw_socketfs_packet = ::read_packet(fd))) {
+	ssize_t nread = read_packet_into(fd, &buffer.packet, &buffer.size);
+	if(nread < 0 && errno != EAGAIN && errno != EINTR)
+		return Result(CONNECTION_LOST);
+	if(nread > 0) {
+		socketfs_packet* raw_socketfs_packet = buffer.packet;
+
 		//Handle SocketFS connect and disconnect messages
 		if(raw_socketfs_packet->type != SOCKETFS_TYPE_MSG) {
 			if(raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_CONNECT || raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_DISCONNECT) {
@@ -64,100 +69,152 @@ ResultRet<RiverPacket> River::receive_packet(int fd, bool block)  {
 					raw_socketfs_packet->connected_id,
 					raw_socketfs_packet->connected_pid
 				};
-				free(raw_socketfs_packet);
 				return ret;
 			}
 
 			return Result(SOCKETFS_MESSAGE);
 		}
 
-		//Check if the packet is at least the size of the RawPacket header
-		if(raw_socketfs_packet->length < sizeof(RawPacket)) {
-			fprintf(stderr, "[River] WARN: Foreign packet received from %x\n", raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+		return parse_packet(raw_socketfs_packet->data, raw_socketfs_packet->length, raw_socketfs_packet->sender, raw_socketfs_packet->sender_pid);
+	}
 
-		auto* raw_packet = (RawPacket*) raw_socketfs_packet->data;
+	return Result(NO_PACKET);
+}
 
-		//Check if the RawPacket magic checks out
-		if(raw_packet->__river_magic != LIBRIVER_PACKET_MAGIC) {
-			fprintf(stderr, "[River] WARN: RawPacket with invalid magic received from %x\n", raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+ResultRet<RiverPacket> River::parse_packet(const uint8_t* data, size_t length, sockid_t sender, pid_t sender_pid) {
+	//Check if the packet is at least the size of the RawPacket header
+	if(length < sizeof(RawPacket)) {
+		fprintf(stderr, "[River] WARN: Foreign packet received from %x\n", sender);
+		return Result(PACKET_ERR);
+	}
 
-		//Make sure the data and path lengths specified in the RawPacket are valid
-		if(
-				raw_packet->data_length + raw_packet->path_length != raw_socketfs_packet->length - sizeof(RawPacket) ||
-				raw_packet->data_length > SOCKETFS_MAX_BUFFER_SIZE ||
-				raw_packet->path_length > SOCKETFS_MAX_BUFFER_SIZE ||
-				raw_packet->path_length < 1
-				) {
-			fprintf(stderr, "[River] WARN: Malformed packet received from %x\n", raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+	auto* raw_packet = (RawPacket*) data;
 
-		//Create a new RiverPacket and add it to the deque
-		RiverPacket packet {
-			raw_packet->type,
-			"",
-			"",
-			raw_packet->error,
-			raw_packet->id,
-			raw_socketfs_packet->sender,
-			raw_socketfs_packet->sender_pid
-		};
-
-		//Get the target from the RawPacket
-		auto* target_cstr = new char[raw_packet->path_length];
-		strncpy(target_cstr, (const char*) raw_packet->data, raw_packet->path_length);
-		std::string target = target_cstr;
-		delete[] target_cstr;
-
-		//Get the data from the RawPacket
-		if(raw_packet->data_length) {
-			packet.data.resize(raw_packet->data_length);
-			memcpy(packet.data.data(), raw_packet->data + raw_packet->path_length, raw_packet->data_length);
-		}
+	//Check if the RawPacket magic checks out
+	if(raw_packet->__river_magic != LIBRIVER_PACKET_MAGIC) {
+		fprintf(stderr, "[River] WARN: RawPacket with invalid magic received from %x\n", sender);
+		return Result(PACKET_ERR);
+	}
 
-		//Free the socketFS packet
-		free(raw_socketfs_packet);
+	//Make sure the data and path lengths specified in the RawPacket are valid
+	if(
+			raw_packet->data_length + raw_packet->path_length != length - sizeof(RawPacket) ||
+			raw_packet->data_length > SOCKETFS_MAX_BUFFER_SIZE ||
+			raw_packet->path_length > SOCKETFS_MAX_BUFFER_SIZE
+			) {
+		fprintf(stderr, "[River] WARN: Malformed packet received from %x\n", sender);
+		return Result(PACKET_ERR);
+	}
 
-		//Parse the target
-		auto colon = target.find(':');
-		if(colon == std::string::npos) {
-			packet.endpoint = target;
-		} else {
-			packet.endpoint = target.substr(0, colon);
-			packet.path = target.substr(colon + 1);
-		}
+	//Create a new RiverPacket and add it to the deque
+	RiverPacket packet {
+		raw_packet->type,
+		"",
+		"",
+		raw_packet->error,
+		raw_packet->id,
+		sender,
+		sender_pid,
+		raw_packet->endpoint_id,
+		raw_packet->path_id,
+		raw_packet->request_id
+	};
+
+	//Get the data from the RawPacket
+	if(raw_packet->data_length) {
+		packet.data.resize(raw_packet->data_length);
+		memcpy(packet.data.data(), raw_packet->data + raw_packet->path_length, raw_packet->data_length);
+	}
 
+	//Packets addressed by ID don't have a target to parse
+	if(!raw_packet->path_length)
 		return packet;
+
+	//Get the target from the RawPacket
+	auto* target_cstr = (const char*) raw_packet->data;
+	auto* target_end = (const char*) memchr(target_cstr, '\0', raw_packet->path_length);
+	std::string target(target_cstr, target_end ? target_end - target_cstr : raw_packet->path_length);
+
+	//Parse the target
+	auto colon = target.find(':');
+	if(colon == std::string::npos) {
+		packet.endpoint = target;
+	} else {
+		packet.endpoint = target.substr(0, colon);
+		packet.path = target.substr(colon + 1);
 	}
 
-	return Result(NO_PACKET);
+	return packet;
 }
 
-void River::send_packet(int fd, sockid_t recipient, const RiverPacket& packet) {
-	auto full_name = packet.endpoint + ":" + packet.path;
-	size_t n_bytes = full_name.length() + 1 + packet.data.size();
+bool River::send_packet(int fd, sockid_t recipient, const RiverPacket& packet, ShmRing* ring, bool doorbell, bool wait_for_room) {
+	//Only send a target if there is one, since packets addressed by ID don't need it
+	std::string full_name;
+	if(!packet.endpoint.empty() || !packet.path.empty())
+		full_name = packet.endpoint + ":" + packet.path;
+
+	RawPacket raw_packet;
+	raw_packet.__river_magic = LIBRIVER_PACKET_MAGIC;
+	raw_packet.type = packet.type;
+	raw_packet.error = packet.error;
+	raw_packet.data_length = packet.data.size();
+	raw_packet.path_length = full_name.empty() ? 0 : full_name.length() + 1;
+	raw_packet.id = packet.recipient;
+	raw_packet.endpoint_id = packet.endpoint_id;
+	raw_packet.path_id = packet.path_id;
+	raw_packet.request_id = packet.request_id;
+
+	//Gather the header, path, and data straight into the packet instead of copying them into one buffer first
+	struct iovec iov[3] = {{&raw_packet, sizeof(RawPacket)}};
+	int iovcnt = 1;
+	if(raw_packet.path_length)
+		iov[iovcnt++] = {(void*) full_name.c_str(), raw_packet.path_length};
+	if(!packet.data.empty())
+		iov[iovcnt++] = {(void*) packet.data.data(), packet.data.size()};
 
-	auto* raw_packet = (RawPacket*) malloc(sizeof(RawPacket) + n_bytes);
-	raw_packet->__river_magic = LIBRIVER_PACKET_MAGIC;
-	raw_packet->type = packet.type;
-	raw_packet->error = packet.error;
-	raw_packet->data_length = packet.data.size();
-	raw_packet->path_length = full_name.length() + 1;
-	raw_packet->id = packet.recipient;
+	if(!ring) {
+		if(::writev_packet(fd, recipient, iov, iovcnt))
+			fprintf(stderr, "[River] Error writing packet: %s\n", strerror(errno));
+		return true;
+	}
 
-	memcpy(raw_packet->data, full_name.c_str(), full_name.length() + 1);
-	if(!packet.data.empty())
-		memcpy(raw_packet->data + full_name.length() + 1, packet.data.data(), packet.data.size());
+	//Packets can't be split between the ring and the socket or they could arrive out of order. If it doesn't go in the
+	//ring, ring the doorbell so the other end reads what's already there before whatever the caller sends instead.
+	size_t length = sizeof(RawPacket) + raw_packet.path_length + packet.data.size();
+	if(length > ring->max_message_size()) {
+		ring_doorbell(fd, recipient, ring);
+		return false;
+	}
 
-	if(::write_packet(fd, recipient, sizeof(RawPacket) + n_bytes, raw_packet))
-		fprintf(stderr, "[River] Error writing packet: %s\n", strerror(errno));
+	//If the ring is full, wait for the other end to make room. If we've been holding back the doorbell, ring it now.
+	int retries = 0;
+	while(!ring->write(iov, iovcnt)) {
+		ring_doorbell(fd, recipient, ring);
+		if(!wait_for_room || ++retries > LIBRIVER_RING_FULL_RETRIES)
+			return false;
+		usleep(LIBRIVER_RING_FULL_WAIT);
+	}
 
-	free(raw_packet);
+	if(doorbell)
+		ring_doorbell(fd, recipient, ring);
+	return true;
+}
+
+void River::ring_doorbell(int fd, sockid_t recipient, ShmRing* ring) {
+	//Only ring the doorbell if the other end is waiting for one
+	if(ring->take_doorbell()) {
+		RawPacket doorbell;
+		doorbell.__river_magic = LIBRIVER_PACKET_MAGIC;
+		doorbell.type = RING_DOORBELL;
+		doorbell.error = SUCCESS;
+		doorbell.data_length = 0;
+		doorbell.path_length = 0;
+		doorbell.id = 0;
+		doorbell.endpoint_id = 0;
+		doorbell.path_id = 0;
+		doorbell.request_id = 0;
+		struct iovec doorbell_iov = {&doorbell, sizeof(RawPacket)};
+		if(::writev_packet(fd, recipient, &doorbell_iov, 1))
+			fprintf(stderr, "[River] Error writing doorbell: %s\n", strerror(errno));
+	}
 }
\ No newline at end of file
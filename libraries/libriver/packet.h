@@ -26,9 +26,13 @@
 #include <sys/socketfs.h>
 #include <poll.h>
 #include <cstring>
+#include <cstdlib>
+#include "ShmRing.h"
 
 #define LIBRIVER_PACKET_MAGIC 0xBEEF420
 #define LIBRIVER_MAX_TARGET_NAME_LEN 1024
+#define LIBRIVER_RING_FULL_WAIT 1000 //Microseconds
+#define LIBRIVER_RING_FULL_RETRIES 5000
 
 namespace River {
 	enum PacketType {
@@ -50,7 +54,10 @@ namespace River {
 		GET_MESSAGE = 26,
 		SEND_MESSAGE = 25,
 
-		DEREGISTER_PATH = 30
+		DEREGISTER_PATH = 30,
+
+		OPEN_RING = 40,
+		RING_DOORBELL = 41
 	};
 
 	enum ErrorType {
@@ -70,13 +77,18 @@ namespace River {
 
 	const char* error_str(int type);
 
+	//Function calls, returns, and messages are addressed only by the endpoint and path IDs the server handed out when
+	//they were registered or looked up, and have a path_length of zero
 	struct RawPacket {
 		int __river_magic = LIBRIVER_PACKET_MAGIC;
 		PacketType type;
-		size_t path_length; //Incl. null terminator
+		size_t path_length; //Incl. null terminator, or zero if there is no path
 		size_t data_length;
 		ErrorType error;
 		sockid_t id;
+		uint32_t endpoint_id;
+		uint32_t path_id;
+		uint32_t request_id;
 		uint8_t data[];
 	};
 
@@ -97,18 +109,44 @@ namespace River {
 		};
 		sockid_t __socketfs_from_id;
 		pid_t __socketfs_from_pid;
+		uint32_t endpoint_id = 0;
+		uint32_t path_id = 0;
+		uint32_t request_id = 0; //Copied from a function call to its return, so calls can be outstanding at the same time
 		std::vector<uint8_t> data;
 	};
 
+	//The shared memory rings set up by OPEN_RING, from the point of view of the client
+	struct RingInfo {
+		int send_shm_id;
+		int receive_shm_id;
+	};
+
 	enum PacketReadResult {
 		PACKET_READ = 0,
 		NO_PACKET,
 		PACKET_ERR,
 		SOCKETFS_MESSAGE,
+		CONNECTION_LOST, //Reading from the socket failed, so nothing more will come from it
+	};
+
+	//A buffer that's reused for every packet read from a socket, so that reading a packet doesn't allocate
+	struct PacketBuffer {
+		PacketBuffer() = default;
+		PacketBuffer(const PacketBuffer& other) = delete;
+		PacketBuffer& operator=(const PacketBuffer& other) = delete;
+		~PacketBuffer() { free(packet); }
+
+		socketfs_packet* packet = nullptr;
+		size_t size = 0;
 	};
 
-	ResultRet<RiverPacket> receive_packet(int fd, bool block);
-	void send_packet(int fd, sockid_t recipient, const RiverPacket& packet);
+	ResultRet<RiverPacket> receive_packet(int fd, bool block, PacketBuffer& buffer);
+	ResultRet<RiverPacket> parse_packet(const uint8_t* data, size_t length, sockid_t sender, pid_t sender_pid);
+	//Returns false if the packet couldn't be put in the ring, either because it's too big or the ring stayed full. If
+	//wait_for_room is false, a full ring fails right away instead of waiting for the other end to read from it. Nothing
+	//is sent when it fails, so the caller has to send the packet some other way (ie. through the socket).
+	bool send_packet(int fd, sockid_t recipient, const RiverPacket& packet, ShmRing* ring = nullptr, bool doorbell = true, bool wait_for_room = true);
+	void ring_doorbell(int fd, sockid_t recipient, ShmRing* ring);
 }
 
 #endif //DUCKOS_LIBRIVER_PACKET_H
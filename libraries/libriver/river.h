@@ -24,6 +24,7 @@
 #include "BusServer.h"
 #include "Endpoint.h"
 #include "Function.hpp"
+#include "Future.hpp"
 #include "Message.hpp"
 #include "packet.h"
 
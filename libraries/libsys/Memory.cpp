@@ -43,7 +43,8 @@ ResultRet<Mem::Info> Mem::get_info(std::istream& file) {
 		strtoul(cfg["kvirt"].c_str(), nullptr, 0),
 		strtoul(cfg["kphys"].c_str(), nullptr, 0),
 		strtoul(cfg["kheap"].c_str(), nullptr, 0),
-		strtoul(cfg["kcache"].c_str(), nullptr, 0)
+		strtoul(cfg["kcache"].c_str(), nullptr, 0),
+		strtoul(cfg["ktmpfs"].c_str(), nullptr, 0)
 	};
 }
 
@@ -186,6 +186,15 @@ bool Theme::load() {
 	}
 
 	fclose(theme_info);
+
+	//Start loading the fonts now, so they're ready by the time something needs them
+	if(UI::pond_context) {
+		if(!_font.empty())
+			UI::pond_context->prefetch_font(_font.c_str());
+		if(!_font_mono.empty())
+			UI::pond_context->prefetch_font(_font_mono.c_str());
+	}
+
 	return true;
 }
 
@@ -113,9 +113,12 @@ void Window::repaint() {
 }
 
 void Window::repaint_now() {
-	if(!_needs_repaint)
+	//Repaints that happen before the last one is on the screen are saved up for the next frame
+	if(!_needs_repaint || _waiting_for_frame)
 		return;
 	_needs_repaint = false;
+	_waiting_for_frame = true;
+	_window->request_frame();
 
 	//Next, draw the window frame
 	auto framebuffer = _window->framebuffer();
@@ -166,7 +169,7 @@ void Window::repaint_now() {
 	//Then, draw widgets
 	if(_contents)
 		blit_widget(_contents);
-	_window->invalidate();
+	_window->damage({-1, -1, -1, -1});
 }
 
 void Window::close() {
@@ -295,6 +298,10 @@ void Window::on_resize(const Rect& old_rect) {
 	calculate_layout();
 }
 
+void Window::on_frame() {
+	_waiting_for_frame = false;
+}
+
 void Window::calculate_layout() {
 	if(!_contents)
 		return;
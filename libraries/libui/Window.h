@@ -72,6 +72,7 @@ namespace UI {
 		void on_mouse_scroll(Pond::MouseScrollEvent evt);
 		void on_mouse_leave(Pond::MouseLeaveEvent evt);
 		void on_resize(const Rect& old_rect);
+		void on_frame();
 
 		//UI
 		void calculate_layout();
@@ -95,6 +96,7 @@ namespace UI {
 		bool _uses_alpha = false;
 		bool _resizable = false;
 		bool _needs_repaint = false;
+		bool _waiting_for_frame = false;
 
 		struct TitleButton {
 			std::string image;
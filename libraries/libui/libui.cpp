@@ -20,14 +20,15 @@
 #include "libui.h"
 #include "Theme.h"
 #include "UIException.h"
-#include <poll.h>
+#include <sys/epoll.h>
 #include <map>
 #include <libduck/Config.h>
 
 using namespace UI;
 
 Pond::Context* UI::pond_context = nullptr;
-std::vector<pollfd> pollfds;
+int epoll_fd = -1;
+std::vector<epoll_event> epoll_events;
 std::map<int, Poll> polls;
 std::map<int, std::shared_ptr<Window>> windows;
 int num_windows = 0;
@@ -38,7 +39,10 @@ void handle_pond_events();
 
 void UI::init(char** argv, char** envp) {
 	pond_context = Pond::Context::init();
-	pollfds.clear();
+	if(epoll_fd < 0)
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd < 0)
+		throw UIException("Failed to create epoll instance");
 
 	auto app_res = App::Info::from_current_app();
 	if(app_res.has_value())
@@ -125,6 +129,13 @@ void handle_pond_events() {
 				}
 				break;
 			}
+
+			case PEVENT_WINDOW_FRAME: {
+				auto window = find_window(event.window_frame.window->id());
+				if(window)
+					window->on_frame();
+				break;
+			}
 		}
 	}
 }
@@ -140,22 +151,22 @@ void UI::run() {
 }
 
 void UI::update(int timeout) {
-	//Perform needed repaints
+	//Perform needed repaints (at most one per frame for each window), and send all of the damage to pond at once
 	for(auto window : windows) {
 		if(window.second)
 			window.second->repaint_now();
 	}
-
-	//Read and process events
-	poll(pollfds.data(), pollfds.size(), timeout);
-	for(auto& pollfd : pollfds) {
-		if(pollfd.revents) {
-			auto& poll = polls[pollfd.fd];
-			if(poll.on_ready_to_read && pollfd.revents & POLLIN)
-				poll.on_ready_to_read();
-			if(poll.on_ready_to_write && pollfd.revents & POLLOUT)
-				poll.on_ready_to_write();
-		}
+	pond_context->commit();
+
+	//Wait for events, and handle every file descriptor that's ready
+	int nevents = epoll_wait(epoll_fd, epoll_events.data(), epoll_events.size(), timeout);
+	for(int i = 0; i < nevents; i++) {
+		auto& event = epoll_events[i];
+		auto& poll = polls[event.data.fd];
+		if(poll.on_ready_to_read && event.events & EPOLLIN)
+			poll.on_ready_to_read();
+		if(poll.on_ready_to_write && event.events & EPOLLOUT)
+			poll.on_ready_to_write();
 	}
 }
 
@@ -177,13 +188,17 @@ App::Info& UI::app_info() {
 void UI::add_poll(const Poll& poll) {
 	if(!poll.on_ready_to_read && !poll.on_ready_to_write)
 		return;
-	pollfd pfd = {.fd = poll.fd, .events = 0, .revents = 0};
+	epoll_event event = {.events = 0, .data = {.fd = poll.fd}};
 	if(poll.on_ready_to_read)
-		pfd.events |= POLLIN;
+		event.events |= EPOLLIN;
 	if(poll.on_ready_to_write)
-		pfd.events |= POLLOUT;
+		event.events |= EPOLLOUT;
+	bool exists = polls.find(poll.fd) != polls.end();
+	if(epoll_ctl(epoll_fd, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, poll.fd, &event) < 0)
+		return;
 	polls[poll.fd] = poll;
-	pollfds.push_back(pfd);
+	if(!exists)
+		epoll_events.emplace_back();
 }
 
 void UI::__register_window(const std::shared_ptr<Window>& window, int id) {
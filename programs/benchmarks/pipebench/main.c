@@ -0,0 +1,100 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+// A program that measures how quickly data can be pushed through a pipe.
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+
+int main(int argc, char** argv) {
+	long megabytes = argc > 1 ? strtol(argv[1], NULL, 10) : 64;
+	long block_size = argc > 2 ? strtol(argv[2], NULL, 10) : 65536;
+	long pipe_size = argc > 3 ? strtol(argv[3], NULL, 10) : 0;
+	if(megabytes <= 0 || block_size <= 0 || pipe_size < 0) {
+		printf("Invalid argument\nUsage: pipebench [MEGABYTES] [BLOCK_SIZE] [PIPE_SIZE]\n");
+		return 1;
+	}
+
+	int fds[2];
+	if(pipe(fds) < 0) {
+		perror("pipe");
+		return errno;
+	}
+
+	if(pipe_size && fcntl(fds[1], F_SETPIPE_SZ, (int) pipe_size) < 0) {
+		perror("fcntl");
+		return errno;
+	}
+
+	char* buf = malloc(block_size);
+	if(!buf) {
+		perror("malloc");
+		return errno;
+	}
+	memset(buf, 'd', block_size);
+	size_t total = (size_t) megabytes * 1024 * 1024;
+
+	pid_t pid = fork();
+	if(pid < 0) {
+		perror("fork");
+		return errno;
+	}
+
+	if(pid == 0) {
+		//Child: write everything into the pipe
+		close(fds[0]);
+		size_t nwritten = 0;
+		while(nwritten < total) {
+			size_t count = total - nwritten < (size_t) block_size ? total - nwritten : (size_t) block_size;
+			ssize_t res = write(fds[1], buf, count);
+			if(res <= 0) {
+				perror("write");
+				exit(errno);
+			}
+			nwritten += res;
+		}
+		exit(0);
+	}
+
+	//Parent: read everything out of the pipe and time it
+	close(fds[1]);
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	size_t nread = 0;
+	ssize_t res;
+	while((res = read(fds[0], buf, block_size)) > 0)
+		nread += res;
+	gettimeofday(&end, NULL);
+	if(res < 0)
+		perror("read");
+	waitpid(pid, NULL, 0);
+
+	long millis = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+	if(millis <= 0)
+		millis = 1;
+	printf("Transferred %lu bytes in %ldms with %ld byte blocks (%ld KiB/s)\n", (unsigned long) nread, millis, block_size, (long) ((nread / 1024) * 1000 / millis));
+	free(buf);
+	return nread == total ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+    This file is part of duckOS.
+
+    duckOS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    duckOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with duckOS.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (c) Byteduck 2016-2021. All rights reserved.
+*/
+
+// A program that measures the throughput and latency of River function calls, over the socket and over a shared memory ring.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <vector>
+#include <libriver/river.h>
+
+using namespace River;
+
+#define BENCH_SOCKET "riverbench"
+#define BENCH_PIPELINE_DEPTH 32
+
+static long millis_since(const struct timeval& start) {
+	struct timeval end;
+	gettimeofday(&end, NULL);
+	long millis = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+	return millis > 0 ? millis : 1;
+}
+
+int run_host() {
+	auto server_res = BusServer::create(BENCH_SOCKET);
+	if(server_res.is_error())
+		return server_res.code();
+	server_res.value()->spawn_thread();
+
+	auto conn_res = BusConnection::connect(BENCH_SOCKET);
+	if(conn_res.is_error())
+		return conn_res.code();
+	auto endpoint_res = conn_res.value()->register_endpoint("riverbench");
+	if(endpoint_res.is_error())
+		return endpoint_res.code();
+	auto endpoint = endpoint_res.value();
+
+	bool done = false;
+	long posts = 0;
+	endpoint->register_function<int, int>("ping", [&](sockid_t, int value) { return value; });
+	endpoint->register_function<void, int>("post", [&](sockid_t, int value) { posts++; });
+	endpoint->register_function<void, int>("done", [&](sockid_t, int value) { done = true; });
+
+	while(!done)
+		conn_res.value()->read_and_handle_packets(true);
+	return 0;
+}
+
+int run_client(long calls, bool use_ring) {
+	//Wait for the host to set up the socket
+	ResultRet<std::shared_ptr<BusConnection>> conn_res = Result(ENOENT);
+	for(int tries = 0; tries < 100 && conn_res.is_error(); tries++) {
+		conn_res = BusConnection::connect(BENCH_SOCKET);
+		if(conn_res.is_error())
+			usleep(50000);
+	}
+	if(conn_res.is_error())
+		return conn_res.code();
+	auto connection = conn_res.value();
+	if(use_ring && connection->open_ring().is_error())
+		return 1;
+
+	auto endpoint_res = connection->get_endpoint("riverbench");
+	if(endpoint_res.is_error())
+		return endpoint_res.code();
+	auto endpoint = endpoint_res.value();
+	auto ping = endpoint->get_function<int, int>("ping");
+	auto post = endpoint->get_function<void, int>("post");
+	if(ping.is_error() || post.is_error())
+		return 1;
+
+	//Throughput: one-way calls, followed by a round trip to make sure they've all been handled
+	struct timeval start;
+	gettimeofday(&start, NULL);
+	for(long i = 0; i < calls; i++)
+		post.value()(i);
+	ping.value()(0);
+	long millis = millis_since(start);
+	printf("%s: %ld one-way calls in %ldms (%ld calls/s)\n", use_ring ? "Ring" : "Socket", calls, millis, calls * 1000 / millis);
+
+	//Latency: round trips, one at a time
+	gettimeofday(&start, NULL);
+	for(long i = 0; i < calls; i++)
+		ping.value()(i);
+	millis = millis_since(start);
+	printf("%s: %ld round trips in %ldms (%ldus each)\n", use_ring ? "Ring" : "Socket", calls, millis, millis * 1000 / calls);
+
+	//Pipelined: round trips, with a window of calls outstanding at once
+	std::vector<Future<int>> pending;
+	gettimeofday(&start, NULL);
+	for(long i = 0; i < calls; i++) {
+		pending.push_back(ping.value().async(i));
+		if(pending.size() == BENCH_PIPELINE_DEPTH || i == calls - 1) {
+			for(auto& future : pending)
+				future.get();
+			pending.clear();
+		}
+	}
+	millis = millis_since(start);
+	printf("%s: %ld pipelined round trips in %ldms (%ld calls/s)\n", use_ring ? "Ring" : "Socket", calls, millis, calls * 1000 / millis);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	long calls = argc > 1 ? strtol(argv[1], NULL, 10) : 10000;
+	if(calls <= 0) {
+		printf("Invalid argument\nUsage: riverbench [CALLS]\n");
+		return 1;
+	}
+
+	pid_t pid = fork();
+	if(pid < 0) {
+		perror("fork");
+		return errno;
+	}
+
+	if(pid == 0)
+		exit(run_host());
+
+	int ret = run_client(calls, false);
+	if(!ret)
+		ret = run_client(calls, true);
+	if(ret)
+		fprintf(stderr, "riverbench: Benchmark failed (%d)\n", ret);
+
+	//Tell the host to stop
+	auto conn_res = BusConnection::connect(BENCH_SOCKET);
+	if(!conn_res.is_error()) {
+		auto endpoint_res = conn_res.value()->get_endpoint("riverbench");
+		if(!endpoint_res.is_error()) {
+			auto done = endpoint_res.value()->get_function<void, int>("done");
+			if(!done.is_error())
+				done.value()(0);
+		}
+	}
+	waitpid(pid, NULL, 0);
+	return ret;
+}
@@ -24,6 +24,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/sendfile.h>
+
+#define CAT_CHUNK_SIZE 65536
 
 int main(int argc, char** argv) {
 	int f;
@@ -37,20 +40,38 @@ int main(int argc, char** argv) {
 		f = open(argv[1], O_RDONLY);
 	}
 
-	if(f != -1) {
-		char buf[512];
-		int nread;
-		while((nread = read(f, buf, 512)) > 0) {
-			if(write(STDOUT_FILENO, buf, nread) < 0) {
-				perror("cat");
-				return errno;
-			}
+	if(f == -1) {
+		perror("cat");
+		return errno;
+	}
+
+	//Let the kernel move the data straight to stdout if it can (sendfile for files, splice for pipes)
+	ssize_t nsent;
+	int use_splice = 0;
+	while((nsent = use_splice ? splice(f, NULL, STDOUT_FILENO, NULL, CAT_CHUNK_SIZE, 0) : sendfile(STDOUT_FILENO, f, NULL, CAT_CHUNK_SIZE)) != 0) {
+		if(nsent > 0)
+			continue;
+		if(errno != EINVAL) {
+			perror("cat");
+			return errno;
 		}
-		if(nread < 0 && errno){
+		if(use_splice)
+			break;
+		use_splice = 1;
+	}
+	if(nsent == 0)
+		return 0;
+
+	//Fall back to copying through a buffer
+	char buf[512];
+	int nread;
+	while((nread = read(f, buf, 512)) > 0) {
+		if(write(STDOUT_FILENO, buf, nread) < 0) {
 			perror("cat");
 			return errno;
 		}
-	} else {
+	}
+	if(nread < 0 && errno){
 		perror("cat");
 		return errno;
 	}
@@ -27,6 +27,9 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <sys/sendfile.h>
+
+#define CP_CHUNK_SIZE 65536
 
 int main(int argc, char** argv) {
 	if(argc < 3) {
@@ -54,9 +57,17 @@ int main(int argc, char** argv) {
 
 	errno = 0;
 
+	//Copy the file inside of the kernel, falling back to copying through a buffer if that isn't supported
+	ssize_t nsent;
+	while((nsent = sendfile(to_fd, from_fd, NULL, CP_CHUNK_SIZE)) > 0);
+	if(nsent < 0 && errno != EINVAL) {
+		perror("cp");
+		return errno;
+	}
+
 	ssize_t nread;
-	char* buf = malloc(1024);
-	while((nread = read(from_fd, buf, 1024))) {
+	char* buf = malloc(CP_CHUNK_SIZE);
+	while(nsent < 0 && (nread = read(from_fd, buf, CP_CHUNK_SIZE))) {
 		ssize_t nwrote;
 		nwrote = write(to_fd, buf, nread);
 		if(nwrote <= 0) {
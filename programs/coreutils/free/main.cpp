@@ -50,6 +50,7 @@ int main(int argc, char** argv, char** envp) {
 			printf("Kernel virtual: %s\n", info.kernel_virt.readable().c_str());
 			printf("Kernel heap: %s\n", info.kernel_heap.readable().c_str());
 			printf("Kernel disk cache: %s\n", info.kernel_disk_cache.readable().c_str());
+			printf("Kernel tmpfs: %s\n", info.kernel_tmpfs.readable().c_str());
 		}
 	} else {
 		printf("Total: %lu\n", info.usable.bytes);
@@ -60,6 +61,7 @@ int main(int argc, char** argv, char** envp) {
 			printf("Kernel virtual: %lu\n", info.kernel_virt.bytes);
 			printf("Kernel heap: %lu\n", info.kernel_heap.bytes);
 			printf("Kernel disk cache: %lu\n", info.kernel_disk_cache.bytes);
+			printf("Kernel tmpfs: %lu\n", info.kernel_tmpfs.bytes);
 		}
 	}
 
@@ -48,6 +48,12 @@ msg "Setting up /sock/..."
 mkdir -p "$FS_DIR"/sock
 chmod 777 "$FS_DIR"/sock
 
+msg "Setting up /tmp/ and /run/..."
+mkdir -p "$FS_DIR"/tmp
+chmod 1777 "$FS_DIR"/tmp
+mkdir -p "$FS_DIR"/run
+chmod 755 "$FS_DIR"/run
+
 msg "Setting up /etc/..."
 chown -R 0:0 "$FS_DIR"/etc
 
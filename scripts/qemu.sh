@@ -40,6 +40,11 @@ else
 	DUCKOS_QEMU="qemu-system-x86_64"
 fi
 
+# Determine which interface the disk should be attached with (ide or virtio)
+if [ -z "$DUCKOS_DISK_INTERFACE" ]; then
+	DUCKOS_DISK_INTERFACE="ide"
+fi
+
 DUCKOS_QEMU_DISPLAY=""
 
 if "$DUCKOS_QEMU" --display help | grep -iq sdl; then
@@ -53,7 +58,7 @@ DUCKOS_QEMU_ARGS="
 	-s
 	-kernel kernel/duckk32
 	-append \"\"
-	-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=ide
+	-drive file=$DUCKOS_IMAGE,cache=directsync,format=raw,id=disk,if=$DUCKOS_DISK_INTERFACE
 	-m 512M
 	-serial stdio
 	$DUCKOS_QEMU_DISPLAY
@@ -26,11 +26,7 @@
 
 using namespace Pond;
 
-#define SEND_MESSAGE(name, data) { \
-auto __msgsend_res = server->endpoint()->send_message(name, id, data); \
-if(__msgsend_res.is_error()) { \
-	KLog::logf("Failed to send message %s to client %d: %s", name, id, River::error_str(__msgsend_res.code())); \
-}} \
+#define SEND_MESSAGE(name, data) server->__river_##name.send(id, data)
 
 Client::Client(Server* server, sockid_t id, pid_t pid): server(server), id(id), pid(pid) {
 
@@ -53,23 +49,23 @@ Client::~Client() {
 }
 
 void Client::mouse_moved(Window* window, Point delta, Point relative_pos, Point absolute_pos) {
-	SEND_MESSAGE("mouse_moved", (MouseMovePkt {window->id(), delta, relative_pos, absolute_pos}));
+	SEND_MESSAGE(mouse_moved, (MouseMovePkt {window->id(), delta, relative_pos, absolute_pos}));
 }
 
 void Client::mouse_buttons_changed(Window* window, uint8_t new_buttons) {
-	SEND_MESSAGE("mouse_button", (MouseButtonPkt {window->id(), new_buttons}));
+	SEND_MESSAGE(mouse_button, (MouseButtonPkt {window->id(), new_buttons}));
 }
 
 void Client::mouse_scrolled(Window* window, int scroll) {
-	SEND_MESSAGE("mouse_scrolled", (MouseScrollPkt {window->id(), scroll}));
+	SEND_MESSAGE(mouse_scrolled, (MouseScrollPkt {window->id(), scroll}));
 }
 
 void Client::mouse_left(Window* window) {
-	SEND_MESSAGE("mouse_left", (MouseLeavePkt {window->id()}));
+	SEND_MESSAGE(mouse_left, (MouseLeavePkt {window->id()}));
 }
 
 void Client::keyboard_event(Window* window, const KeyboardEvent& event) {
-	SEND_MESSAGE("key_event", (KeyEventPkt {window->id(), event.scancode, event.key, event.character, event.modifiers}));
+	SEND_MESSAGE(key_event, (KeyEventPkt {window->id(), event.scancode, event.key, event.character, event.modifiers}));
 }
 
 void Client::window_destroyed(Window* window) {
@@ -80,23 +76,29 @@ void Client::window_destroyed(Window* window) {
 	if(disconnected)
 		return;
 
-	SEND_MESSAGE("window_destroyed", (WindowDestroyPkt {window->id(), window->framebuffer_shm().id}));
+	SEND_MESSAGE(window_destroyed, (WindowDestroyPkt {window->id(), window->framebuffer_shm().id}));
 }
 
 void Client::window_moved(Window *window) {
-	SEND_MESSAGE("window_moved", (WindowMovePkt {window->id(), window->rect().position()}));
+	SEND_MESSAGE(window_moved, (WindowMovePkt {window->id(), window->rect().position()}));
 }
 
 void Client::window_resized(Window *window) {
 	shmallow(window->framebuffer_shm().id, pid, SHM_WRITE | SHM_READ);
-	SEND_MESSAGE("window_resized", (WindowResizedPkt {window->id(), window->framebuffer_shm().id, window->rect()}));
+	SEND_MESSAGE(window_resized, (WindowResizedPkt {window->id(), window->framebuffer_shm().id, window->rect(), window->num_buffers()}));
+}
+
+void Client::window_frame(Window* window) {
+	if(disconnected)
+		return;
+	SEND_MESSAGE(window_frame, (WindowFramePkt {window->id(), window->front_buffer()}));
 }
 
 WindowOpenedPkt Client::open_window(OpenWindowPkt& params) {
 	Window* window;
 
 	if(!params.parent) {
-		window = new Window(Display::inst().root_window(), params.rect, params.hidden);
+		window = new Window(Display::inst().root_window(), params.rect, params.hidden, params.buffers);
 	} else {
 		auto parent_window = windows.find(params.parent);
 		if(parent_window == windows.end()) {
@@ -104,7 +106,7 @@ WindowOpenedPkt Client::open_window(OpenWindowPkt& params) {
 			return {-1};
 		} else {
 			//Make the window with the requested parent
-			window = new Window(parent_window->second, params.rect, params.hidden);
+			window = new Window(parent_window->second, params.rect, params.hidden, params.buffers);
 		}
 	}
 
@@ -115,7 +117,7 @@ WindowOpenedPkt Client::open_window(OpenWindowPkt& params) {
 	shmallow(window->framebuffer_shm().id, pid, SHM_WRITE | SHM_READ);
 
 	//Return opened window
-	return {window->id(), window->framebuffer_shm().id, window->rect()};
+	return {window->id(), window->framebuffer_shm().id, window->rect(), window->num_buffers()};
 }
 
 void Client::destroy_window(WindowDestroyPkt& params) {
@@ -143,17 +145,23 @@ WindowResizedPkt Client::resize_window(WindowResizePkt& params) {
 	window->set_dimensions(params.dims, false);
 	shmallow(window->framebuffer_shm().id, pid, SHM_WRITE | SHM_READ);
 
-	return {window->id(), window->framebuffer_shm().id, window->rect()};
+	return {window->id(), window->framebuffer_shm().id, window->rect(), window->num_buffers()};
 }
 
-void Client::invalidate_window(WindowInvalidatePkt& params) {
+void Client::damage_window(WindowDamagePkt& params) {
 	auto window = windows.find(params.window_id);
-	if(window != windows.end()) {
-		if(params.area.x < 0 || params.area.y < 0)
-			window->second->invalidate();
-		else
-			window->second->invalidate(params.area);
-	}
+	if(window == windows.end() || params.num_rects < 0 || params.num_rects > POND_MAX_DAMAGE_RECTS)
+		return;
+	if(params.buffer >= 0)
+		window->second->present(params.buffer);
+	for(int i = 0; i < params.num_rects; i++)
+		window->second->invalidate(params.rects[i]);
+}
+
+void Client::request_frame(RequestFramePkt& params) {
+	auto window = windows.find(params.window_id);
+	if(window != windows.end())
+		Display::inst().request_frame(window->second);
 }
 
 FontResponsePkt Client::get_font(GetFontPkt& params) {
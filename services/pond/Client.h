@@ -42,12 +42,14 @@ public:
 	void window_destroyed(Window* window);
 	void window_moved(Window* window);
 	void window_resized(Window* window);
+	void window_frame(Window* window);
 
 	Pond::WindowOpenedPkt open_window(Pond::OpenWindowPkt& packet);
 	void destroy_window(Pond::WindowDestroyPkt& packet);
 	void move_window(Pond::WindowMovePkt& packet);
 	Pond::WindowResizedPkt resize_window(Pond::WindowResizePkt& packet);
-	void invalidate_window(Pond::WindowInvalidatePkt& packet);
+	void damage_window(Pond::WindowDamagePkt& packet);
+	void request_frame(Pond::RequestFramePkt& packet);
 	Pond::FontResponsePkt get_font(Pond::GetFontPkt& packet);
 	void set_title(Pond::SetTitlePkt& packet);
 	void reparent(Pond::WindowReparentPkt& packet);
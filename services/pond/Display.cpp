@@ -29,6 +29,7 @@
 #include <cstring>
 #include <sys/input.h>
 #include <libgraphics/memory.h>
+#include <algorithm>
 
 using namespace Gfx;
 
@@ -138,6 +139,9 @@ void Display::remove_window(Window* window) {
 		_resize_window = nullptr;
 	if(window == _mousedown_window)
 		_mousedown_window = nullptr;
+	auto frame_it = std::find(_frame_windows.begin(), _frame_windows.end(), window);
+	if(frame_it != _frame_windows.end())
+		_frame_windows.erase(frame_it);
 	for(size_t i = 0; i < _windows.size(); i++) {
 		if(_windows[i] == window) {
 			_windows.erase(_windows.begin() + i);
@@ -147,8 +151,19 @@ void Display::remove_window(Window* window) {
 }
 
 void Display::invalidate(const Rect& rect) {
-	if(!rect.empty())
-		invalid_areas.push_back(rect);
+	if(rect.empty())
+		return;
+
+	//Damage that's already covered doesn't need to be added, and damage that this covers can be dropped
+	for(auto it = invalid_areas.begin(); it != invalid_areas.end();) {
+		if(rect.inside(*it))
+			return;
+		if(it->inside(rect))
+			it = invalid_areas.erase(it);
+		else
+			it++;
+	}
+	invalid_areas.push_back(rect);
 }
 
 //#define DEBUG_REPAINT_PERF
@@ -160,7 +175,7 @@ void Display::repaint() {
 
 	if(!invalid_areas.empty())
 		display_buffer_dirty = true;
-	else
+	else if(_frame_windows.empty())
 		return;
 
 	//If it hasn't been 1/60 of a second since the last repaint, don't bother
@@ -168,6 +183,12 @@ void Display::repaint() {
 		return;
 	gettimeofday(&paint_time, NULL);
 
+	//If nothing changed on screen (ie the window is hidden), the frame still counts as shown
+	if(invalid_areas.empty()) {
+		send_frame_events();
+		return;
+	}
+
 	auto& fb = _root_window->framebuffer();
 
 	//Combine areas that overlap
@@ -196,30 +217,62 @@ void Display::repaint() {
 			_invalid_buffer_area = _invalid_buffer_area.combine(area);
 	}
 
+	std::vector<Rect> uncovered;
+	std::vector<Rect> next_uncovered;
+	std::vector<std::pair<Window*, Rect>> blend_areas;
 	for(auto& area : invalid_areas) {
-		// Fill the invalid area with the background.
-		if(_wallpaper)
-			fb.copy_tiled(*_wallpaper, area, area.position());
-		else
-			fb.fill(area, RGB(50, 50, 50));
+		//Go through the windows from front to back, so each pixel is only drawn by the frontmost opaque window covering it.
+		//Alpha windows need what's behind them drawn first, so the parts of them that can be seen are blended in last.
+		uncovered.assign(1, area);
+		blend_areas.clear();
+		for(auto it = _windows.rbegin(); it != _windows.rend() && !uncovered.empty(); it++) {
+			auto* window = *it;
 
-		// See if each window overlaps the invalid area.
-		for(auto window : _windows) {
 			//Don't bother with the mouse window or hidden windows, we draw it separately so it's always on top
 			if(window == _mouse_window || window->hidden())
 				continue;
 
 			Rect window_vabs = window->visible_absolute_rect();
-			if(window_vabs.collides(area)) {
-				//If it does, redraw the intersection of the window in question and the invalid area
-				Rect window_abs = window->absolute_rect();
-				Rect overlap_abs = area.overlapping_area(window_vabs);
-				auto transformed_overlap = overlap_abs.transform({-window_abs.x, -window_abs.y});
-				if(window->uses_alpha())
-					fb.copy_blitting(window->framebuffer(), transformed_overlap, overlap_abs.position());
-				else
-					fb.copy(window->framebuffer(), transformed_overlap, overlap_abs.position());
+			if(!window_vabs.collides(area))
+				continue;
+
+			if(window->uses_alpha()) {
+				for(auto& rect : uncovered) {
+					if(rect.collides(window_vabs))
+						blend_areas.emplace_back(window, rect.overlapping_area(window_vabs));
+				}
+				continue;
+			}
+
+			//Draw the parts of the window that nothing in front of it covers, and cut them out of what's left to draw
+			Rect window_abs = window->absolute_rect();
+			next_uncovered.clear();
+			for(auto& rect : uncovered) {
+				if(!rect.collides(window_vabs)) {
+					next_uncovered.push_back(rect);
+					continue;
+				}
+				Rect overlap_abs = rect.overlapping_area(window_vabs);
+				fb.copy(window->framebuffer(), overlap_abs.transform({-window_abs.x, -window_abs.y}), overlap_abs.position());
+				Rect pieces[4];
+				int num_pieces = rect.subtract(window_vabs, pieces);
+				next_uncovered.insert(next_uncovered.end(), pieces, pieces + num_pieces);
 			}
+			std::swap(uncovered, next_uncovered);
+		}
+
+		// Fill whatever no opaque window covers with the background.
+		for(auto& rect : uncovered) {
+			if(_wallpaper)
+				fb.copy_tiled(*_wallpaper, rect, rect.position());
+			else
+				fb.fill(rect, RGB(50, 50, 50));
+		}
+
+		//Then blend the alpha windows on top, back to front
+		for(auto it = blend_areas.rbegin(); it != blend_areas.rend(); it++) {
+			Rect window_abs = it->first->absolute_rect();
+			fb.copy_blitting(it->first->framebuffer(), it->second.transform({-window_abs.x, -window_abs.y}), it->second.position());
 		}
 	}
 	invalid_areas.resize(0);
@@ -248,6 +301,24 @@ void Display::repaint() {
 
 	//Flip the display buffers.
 	flip_buffers();
+	send_frame_events();
+}
+
+void Display::send_frame_events() {
+	//Swap the list out first, since a client may request another frame in response
+	auto windows = std::move(_frame_windows);
+	_frame_windows.clear();
+	for(auto window : windows)
+		window->frame_presented();
+}
+
+void Display::request_frame(Window* window) {
+	if(std::find(_frame_windows.begin(), _frame_windows.end(), window) == _frame_windows.end())
+		_frame_windows.push_back(window);
+}
+
+bool Display::frame_requested() {
+	return !_frame_windows.empty();
 }
 
 bool flipped = false;
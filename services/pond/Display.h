@@ -92,6 +92,16 @@ public:
 	 */
 	int millis_until_next_flip() const;
 
+	/**
+	 * Tells a window when the next frame is on the screen, even if nothing needed to be redrawn.
+	 */
+	void request_frame(Window* window);
+
+	/**
+	 * Whether or not any windows are waiting to be told about the next frame.
+	 */
+	bool frame_requested();
+
 	/**
 	 * Moves a window to the front.
 	 */
@@ -143,12 +153,18 @@ private:
 	 */
 	Rect calculate_resize_rect();
 
+	/**
+	 * Tells every window waiting on a frame that it's been shown.
+	 */
+	void send_frame_events();
+
 	int framebuffer_fd = 0; ///The file descriptor of the framebuffer.
 	Gfx::Framebuffer _framebuffer; ///The framebuffer framebuffer.
 	Gfx::Image* _wallpaper = nullptr; ///The framebuffer representing the wallpaper.
 	Rect _dimensions; ///The dimensions of the display.
 	std::vector<Rect> invalid_areas; ///The invalidated areas that need to be redrawn.
 	std::vector<Window*> _windows; ///The windows on the display.
+	std::vector<Window*> _frame_windows; ///The windows waiting to be told about the next frame.
 	Mouse* _mouse_window = nullptr; ///The window representing the mouse cursor.
 	Window* _prev_mouse_window = nullptr; ///The previous window that the mouse cursor was in.
 	Window* _drag_window = nullptr; ///The current window being dragged.
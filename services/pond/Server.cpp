@@ -47,7 +47,8 @@ auto __msgres_##name = _endpoint->register_message<arg>(#name); \
 if(__msgres_##name.is_error()) { \
 	KLog::logf("Couldn't register message %s: %s\n", error_str(__msgres_##name.code())); \
 	exit(__msgres_##name.code()); \
-}
+} \
+__river_##name = __msgres_##name.value();
 
 Server::Server() {
 	KLog::logf("Creating bus server...\n");
@@ -97,7 +98,8 @@ Server::Server() {
 	REGISTER_FUNC(destroy_window, void, WindowDestroyPkt, destroy_window);
 	REGISTER_FUNC(move_window, void, WindowMovePkt, move_window);
 	REGISTER_FUNC(resize_window, WindowResizedPkt, WindowResizePkt, resize_window);
-	REGISTER_FUNC(invalidate_window, void, WindowInvalidatePkt, invalidate_window);
+	REGISTER_FUNC(damage_window, void, WindowDamagePkt, damage_window);
+	REGISTER_FUNC(request_frame, void, RequestFramePkt, request_frame);
 	REGISTER_FUNC(get_font, FontResponsePkt, GetFontPkt, get_font);
 	REGISTER_FUNC(set_title, void, SetTitlePkt, set_title);
 	REGISTER_FUNC(reparent, void, WindowReparentPkt, reparent);
@@ -115,6 +117,7 @@ Server::Server() {
 	REGISTER_MSG(mouse_scrolled, MouseScrollPkt);
 	REGISTER_MSG(mouse_left, MouseLeavePkt);
 	REGISTER_MSG(key_event, KeyEventPkt);
+	REGISTER_MSG(window_frame, WindowFramePkt);
 }
 
 int Server::fd() {
@@ -23,6 +23,7 @@
 #include <sys/types.h>
 #include <map>
 #include <libriver/river.h>
+#include <libpond/packet.h>
 
 class Client;
 class Server {
@@ -33,6 +34,18 @@ public:
 	void handle_packets();
 	const std::shared_ptr<River::Endpoint>& endpoint();
 
+	//Messages are kept around so sending one doesn't have to look it up by name
+#define PONDMSG(name, data_t) River::Message<data_t> __river_##name = {#name}
+	PONDMSG(window_moved, Pond::WindowMovePkt);
+	PONDMSG(window_resized, Pond::WindowResizedPkt);
+	PONDMSG(window_destroyed, Pond::WindowDestroyPkt);
+	PONDMSG(mouse_moved, Pond::MouseMovePkt);
+	PONDMSG(mouse_button, Pond::MouseButtonPkt);
+	PONDMSG(mouse_scrolled, Pond::MouseScrollPkt);
+	PONDMSG(mouse_left, Pond::MouseLeavePkt);
+	PONDMSG(key_event, Pond::KeyEventPkt);
+	PONDMSG(window_frame, Pond::WindowFramePkt);
+
 private:
 	std::map<sockid_t, Client*> clients;
 	River::BusServer* _server;
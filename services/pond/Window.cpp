@@ -29,11 +29,13 @@ using namespace Gfx;
 
 int Window::current_id = 0;
 
-Window::Window(Window* parent, const Rect& rect, bool hidden): _parent(parent), _rect(rect), _display(parent->_display), _id(++current_id), _hidden(hidden) {
+Window::Window(Window* parent, const Rect& rect, bool hidden, int buffers): _parent(parent), _rect(rect), _display(parent->_display), _id(++current_id), _hidden(hidden) {
 	if(_rect.width < 1)
 		_rect.width = 1;
 	if(_rect.height < 1)
 		_rect.height = 1;
+	if(buffers > 1)
+		_num_buffers = buffers > POND_MAX_WINDOW_BUFFERS ? POND_MAX_WINDOW_BUFFERS : buffers;
 	alloc_framebuffer();
 	_parent->_children.push_back(this);
 	_display->add_window(this);
@@ -293,11 +295,13 @@ void Window::alloc_framebuffer() {
 		}
 	}
 
-	if(shmcreate(NULL, IMGSIZE(_rect.width, _rect.height), &_framebuffer_shm) < 0) {
+	//Every buffer lives in the same shm, one after another
+	if(shmcreate(NULL, IMGSIZE(_rect.width, _rect.height) * _num_buffers, &_framebuffer_shm) < 0) {
 		perror("Failed to allocate framebuffer for window");
 		return;
 	}
 
+	_front_buffer = 0;
 	_framebuffer = {(uint32_t*) _framebuffer_shm.ptr, _rect.width, _rect.height};
 }
 
@@ -315,6 +319,27 @@ shm Window::framebuffer_shm() {
 	return _framebuffer_shm;
 }
 
+int Window::num_buffers() const {
+	return _num_buffers;
+}
+
+int Window::front_buffer() const {
+	return _front_buffer;
+}
+
+void Window::present(int buffer) {
+	if(buffer < 0 || buffer >= _num_buffers)
+		return;
+	_front_buffer = buffer;
+	_framebuffer = {(uint32_t*) _framebuffer_shm.ptr + (size_t) buffer * _rect.width * _rect.height, _rect.width, _rect.height};
+	_display->request_frame(this);
+}
+
+void Window::frame_presented() {
+	if(_client)
+		_client->window_frame(this);
+}
+
 const char* Window::title() {
 	return _title ? _title : "";
 }
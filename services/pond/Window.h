@@ -44,7 +44,7 @@ class Display;
 class Client;
 class Window {
 public:
-	Window(Window* parent, const Rect& rect, bool hidden);
+	Window(Window* parent, const Rect& rect, bool hidden, int buffers = 1);
 	explicit Window(Display* display);
 	~Window();
 
@@ -116,6 +116,27 @@ public:
 	 */
 	shm framebuffer_shm();
 
+	/**
+	 * The number of buffers in the window's framebuffer shm.
+	 */
+	int num_buffers() const;
+
+	/**
+	 * The buffer that the window is currently composited from.
+	 */
+	int front_buffer() const;
+
+	/**
+	 * Switches the buffer that the window is composited from. The client will be told once it's on the screen.
+	 * @param buffer The index of the buffer to present.
+	 */
+	void present(int buffer);
+
+	/**
+	 * Called by the display once the window's presented buffer is on the screen.
+	 */
+	void frame_presented();
+
 	/**
 	 * Called to tell the window that the mouse moved within it.
 	 * @param relative_pos The new position of the mouse relative to the window.
@@ -231,6 +252,8 @@ private:
 
 	Gfx::Framebuffer _framebuffer = {nullptr, 0, 0};
 	shm _framebuffer_shm;
+	int _num_buffers = 1;
+	int _front_buffer = 0;
 	Rect _rect;
 	Rect _absolute_rect;
 	Rect _visible_absolute_rect;
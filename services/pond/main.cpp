@@ -60,7 +60,7 @@ int main(int argc, char** argv, char** envp) {
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
 	while(true) {
-		poll(polls, 3, display->buffer_is_dirty() ? display->millis_until_next_flip() : -1);
+		poll(polls, 3, display->buffer_is_dirty() || display->frame_requested() ? display->millis_until_next_flip() : -1);
 		mouse->update();
 		display->update_keyboard();
 		server->handle_packets();